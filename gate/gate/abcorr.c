@@ -0,0 +1,150 @@
+#include "abcorr.h"
+#include <math.h>
+
+#define EARTH_BODY_ID 399
+
+// Mean elements of the Earth-Moon barycenter referred to
+// the ecliptic and equinox of J2000, from the approximate
+// positions of the major planets by E. M. Standish
+#define EMB_SEMI_MAJOR_AXIS_AU 1.00000261
+#define EMB_ECCENTRICITY 0.01671123
+#define EMB_MEAN_LONGITUDE_DEG 100.46457166
+#define EMB_MEAN_LONGITUDE_RATE_DEG 35999.37244981
+#define EMB_PERIHELION_DEG 102.93768193
+#define EMB_PERIHELION_RATE_DEG 0.32327364
+
+#define AU_KM 149597870.7
+#define SUN_GM 132712440041.9394
+#define J2000_OBLIQUITY_DEG 23.43928
+#define KEPLER_ITERATIONS 4
+
+static ConstSpiceChar *const ABCORR_STRINGS[GATE_ABCORR_LEN] = {
+        "NONE", "ANNUAL", "LT", "LT+S", "CN", "CN+S"
+};
+
+SpiceBoolean gate_abcorr_parse(ConstSpiceChar *string, gate_abcorr *abcorr) {
+    for (int i = 0; i < GATE_ABCORR_LEN; ++i) {
+        if (eqstr_c(string, ABCORR_STRINGS[i])) {
+            *abcorr = i;
+            return SPICETRUE;
+        }
+    }
+
+    return SPICEFALSE;
+}
+
+ConstSpiceChar *gate_abcorr_string(gate_abcorr abcorr) {
+    if (abcorr < 0 || abcorr >= GATE_ABCORR_LEN) {
+        return "unknown";
+    }
+
+    return ABCORR_STRINGS[abcorr];
+}
+
+ConstSpiceChar *gate_abcorr_spice(gate_abcorr abcorr) {
+    if (abcorr == GATE_ABCORR_ANNUAL) {
+        return "NONE";
+    }
+
+    return gate_abcorr_string(abcorr);
+}
+
+SpiceInt gate_abcorr_light_time_iterations(gate_abcorr abcorr) {
+    switch (abcorr) {
+        case GATE_ABCORR_LT:
+        case GATE_ABCORR_LT_S:
+            return 1;
+        case GATE_ABCORR_CN:
+        case GATE_ABCORR_CN_S:
+            return 3;
+        default:
+            return 0;
+    }
+}
+
+SpiceBoolean gate_abcorr_stellar(gate_abcorr abcorr) {
+    return abcorr == GATE_ABCORR_ANNUAL || abcorr == GATE_ABCORR_LT_S || abcorr == GATE_ABCORR_CN_S;
+}
+
+void gate_earth_velocity(SpiceDouble et, SpiceDouble velocity[3]) {
+    SpiceDouble centuries = et / (36525.0 * 86400.0);
+    SpiceDouble mean_longitude = (EMB_MEAN_LONGITUDE_DEG + EMB_MEAN_LONGITUDE_RATE_DEG * centuries) * M_PI / 180;
+    SpiceDouble perihelion = (EMB_PERIHELION_DEG + EMB_PERIHELION_RATE_DEG * centuries) * M_PI / 180;
+    SpiceDouble e = EMB_ECCENTRICITY;
+
+    SpiceDouble mean_anomaly = fmod(mean_longitude - perihelion, 2 * M_PI);
+    SpiceDouble eccentric_anomaly = mean_anomaly;
+    for (int i = 0; i < KEPLER_ITERATIONS; ++i) {
+        eccentric_anomaly -= (eccentric_anomaly - e * sin(eccentric_anomaly) - mean_anomaly) /
+                             (1 - e * cos(eccentric_anomaly));
+    }
+
+    // Velocity in the plane of the orbit, with the x axis
+    // towards the perihelion
+    SpiceDouble a = EMB_SEMI_MAJOR_AXIS_AU * AU_KM;
+    SpiceDouble speed = sqrt(SUN_GM / a) / (1 - e * cos(eccentric_anomaly));
+    SpiceDouble vx = -speed * sin(eccentric_anomaly);
+    SpiceDouble vy = speed * sqrt(1 - e * e) * cos(eccentric_anomaly);
+
+    // The inclination of the orbit to the ecliptic of J2000
+    // is negligible, leaving a rotation by the longitude
+    // of the perihelion and then by the obliquity
+    SpiceDouble ecliptic_x = vx * cos(perihelion) - vy * sin(perihelion);
+    SpiceDouble ecliptic_y = vx * sin(perihelion) + vy * cos(perihelion);
+    SpiceDouble obliquity = J2000_OBLIQUITY_DEG * M_PI / 180;
+    velocity[0] = ecliptic_x;
+    velocity[1] = ecliptic_y * cos(obliquity);
+    velocity[2] = ecliptic_y * sin(obliquity);
+}
+
+void gate_observer_velocity(SpiceInt observer, SpiceDouble et, SpiceDouble velocity[3]) {
+    if (observer == EARTH_BODY_ID) {
+        gate_earth_velocity(et, velocity);
+        return;
+    }
+
+    // Left at rest if the body is not covered, in which
+    // case the error has been signalled
+    SpiceDouble state[6] = {0};
+    spkssb_c(observer, et, "J2000", state);
+    vequ_c(&state[3], velocity);
+}
+
+void gate_apparent_state(ConstSpiceChar *target, SpiceDouble et, ConstSpiceChar *frame, gate_abcorr abcorr,
+                         ConstSpiceChar *observer, SpiceDouble state[6]) {
+    SpiceDouble lt;
+    if (abcorr != GATE_ABCORR_ANNUAL) {
+        spkezr_c(target, et, frame, gate_abcorr_spice(abcorr), observer, state, &lt);
+        return;
+    }
+
+    SpiceDouble j2000_state[6];
+    spkezr_c(target, et, "J2000", "NONE", observer, j2000_state, &lt);
+    if (failed_c()) {
+        return;
+    }
+
+    SpiceInt observer_id;
+    SpiceBoolean observer_found;
+    bodn2c_c(observer, &observer_id, &observer_found);
+    if (!observer_found) {
+        setmsg_c("No NAIF ID was found for observer '#'");
+        errch_c("#", observer);
+        sigerr_c("SPICE(IDCODENOTFOUND)");
+        return;
+    }
+
+    SpiceDouble velocity[3];
+    gate_observer_velocity(observer_id, et, velocity);
+    if (failed_c()) {
+        return;
+    }
+
+    SpiceDouble apparent[6];
+    stelab_c(j2000_state, velocity, apparent);
+    vequ_c(&j2000_state[3], &apparent[3]);
+
+    SpiceDouble xform[6][6];
+    sxform_c("J2000", frame, et, xform);
+    mxvg_c(xform, apparent, 6, 6, state);
+}
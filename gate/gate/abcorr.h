@@ -0,0 +1,154 @@
+/**
+ * @file
+ * Levels of aberration correction, from geometric
+ * positions up to the converged light time and stellar
+ * aberration corrections of spkezr_c().
+ *
+ * The apparent direction to an object is displaced from
+ * its geometric direction by the time its light takes to
+ * reach the observer, and by the motion of the observer
+ * itself. For the planets, correcting for both shifts
+ * their positions by up to about a minute of arc, but the
+ * corrections account for most of the cost of looking
+ * them up. Wide-field pointing can get by with less, so
+ * the level is chosen by the caller.
+ *
+ * Besides the levels known to SPICE, GATE_ABCORR_ANNUAL
+ * takes the geometric position and only corrects for
+ * stellar aberration due to the orbital motion of the
+ * body of the observer. For observers on the Earth, a
+ * closed-form velocity of the Earth is used, which does
+ * not need any kernels and accounts for nearly all of the
+ * stellar aberration seen from its surface.
+ */
+
+#ifndef GATE_ABCORR_H
+#define GATE_ABCORR_H
+
+#include <cspice/SpiceUsr.h>
+
+/**
+ * A level of aberration correction, in order of
+ * increasing cost.
+ */
+typedef enum {
+    GATE_ABCORR_NONE = 0,
+    GATE_ABCORR_ANNUAL,
+    GATE_ABCORR_LT,
+    GATE_ABCORR_LT_S,
+    GATE_ABCORR_CN,
+    GATE_ABCORR_CN_S,
+    GATE_ABCORR_LEN
+} gate_abcorr;
+
+/**
+ * Parses the name of a level of aberration correction,
+ * which is one of NONE, ANNUAL, LT, LT+S, CN or CN+S
+ * ignoring case.
+ *
+ * @param string the name (input)
+ * @param abcorr the level (output)
+ * @return SPICETRUE if the name was recognized
+ */
+SpiceBoolean gate_abcorr_parse(ConstSpiceChar *string, gate_abcorr *abcorr);
+
+/**
+ * Obtains the name of a level of aberration correction.
+ *
+ * @param abcorr the level (input)
+ * @return a static string naming the level, see
+ * gate_abcorr_parse()
+ */
+ConstSpiceChar *gate_abcorr_string(gate_abcorr abcorr);
+
+/**
+ * Obtains the part of a level of aberration correction
+ * which is passed to SPICE, which is NONE for
+ * GATE_ABCORR_ANNUAL since stellar aberration is then
+ * applied separately.
+ *
+ * @param abcorr the level (input)
+ * @return a static string accepted by spkezr_c()
+ */
+ConstSpiceChar *gate_abcorr_spice(gate_abcorr abcorr);
+
+/**
+ * Obtains the number of light time iterations of a level
+ * of aberration correction, which is 0 for none, 1 for a
+ * single iteration and 3 for a converged solution.
+ *
+ * @param abcorr the level (input)
+ * @return the number of iterations
+ */
+SpiceInt gate_abcorr_light_time_iterations(gate_abcorr abcorr);
+
+/**
+ * Determines whether a level of aberration correction
+ * includes stellar aberration.
+ *
+ * @param abcorr the level (input)
+ * @return SPICETRUE if stellar aberration is corrected for
+ */
+SpiceBoolean gate_abcorr_stellar(gate_abcorr abcorr);
+
+/**
+ * Computes the velocity of the Earth relative to the solar
+ * system barycenter from the mean orbital elements of the
+ * Earth-Moon barycenter.
+ *
+ * The velocity is off by about 0.02 km/s, mostly due to the
+ * motion of the Sun about the barycenter and of the Earth
+ * about the Moon, which changes the annual aberration by
+ * less than 0.02 seconds of arc.
+ *
+ * This procedure does not call into SPICE and may be used
+ * concurrently from any number of threads.
+ *
+ * @param et the ephemeris time (input)
+ * @param velocity the velocity in the J2000 frame in
+ * kilometers per second (output)
+ */
+void gate_earth_velocity(SpiceDouble et, SpiceDouble velocity[3]);
+
+/**
+ * Computes the velocity of the body of an observer
+ * relative to the solar system barycenter, which stellar
+ * aberration is corrected for.
+ *
+ * The velocity of the Earth is computed with
+ * gate_earth_velocity(), so that no kernels are needed for
+ * observers on the Earth. The velocity of any other body
+ * is looked up with spkssb_c(), which requires an SPK
+ * covering it.
+ *
+ * @param observer the NAIF ID of the body of the observer
+ * (input)
+ * @param et the ephemeris time (input)
+ * @param velocity the velocity in the J2000 frame in
+ * kilometers per second (output)
+ */
+void gate_observer_velocity(SpiceInt observer, SpiceDouble et, SpiceDouble velocity[3]);
+
+/**
+ * Computes the apparent state of a body relative to an
+ * observer at a level of aberration correction.
+ *
+ * Levels known to SPICE are passed to spkezr_c() as is.
+ * GATE_ABCORR_ANNUAL looks up the geometric state in the
+ * J2000 frame, corrects its position for stellar
+ * aberration with gate_observer_velocity(), and then
+ * transforms it to the output frame.
+ *
+ * @param target the name of the target body (input)
+ * @param et the ephemeris time (input)
+ * @param frame the name of the frame of the output state
+ * (input)
+ * @param abcorr the level of aberration correction (input)
+ * @param observer the name of the observing body (input)
+ * @param state the state of the target relative to the
+ * observer, see spkezr_c() (output)
+ */
+void gate_apparent_state(ConstSpiceChar *target, SpiceDouble et, ConstSpiceChar *frame, gate_abcorr abcorr,
+                         ConstSpiceChar *observer, SpiceDouble state[6]);
+
+#endif // GATE_ABCORR_H
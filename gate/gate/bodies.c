@@ -0,0 +1,260 @@
+#include "bodies.h"
+#include <stdlib.h>
+#include <string.h>
+#include <cspice/SpiceZfc.h>
+
+// Lengths of the built-in name/ID table entries, see
+// zzbodtrn.inc. The table holds under a thousand entries,
+// so the room here leaves plenty for future toolkits
+#define BUILT_IN_NAME_LEN 36
+#define BUILT_IN_ROOM 4096
+
+// The number of kernel pool values or names fetched at a
+// time
+#define POOL_ROOM 256
+#define POOL_NAME_LEN 33
+
+// The maximum number of distinct objects covered by the
+// loaded SPK and binary PCK files
+#define MAX_OBJECTS 10000
+
+#define FILE_NAME_MAX_LEN 256
+#define FILE_TYPE_MAX_LEN 32
+#define FRAME_NAME_MAX_LEN 33
+#define PCK_FRAME_CLASS 2
+
+/**
+ * Private SPICE routine which copies the built-in body
+ * name/ID table, called the same way as by bodc2n_c() and
+ * bodn2c_c() internally.
+ */
+extern int zzidmap_(integer *bltcod, char *bltnam, ftnlen bltnam_len);
+
+typedef struct {
+    SpiceInt len;
+    SpiceInt cap;
+    SpiceInt *codes;
+} code_list;
+
+static void add_code(code_list *codes, SpiceInt code) {
+    if (codes->len == codes->cap) {
+        SpiceInt new_cap = codes->cap == 0 ? 1024 : codes->cap * 2;
+        SpiceInt *new_codes = realloc(codes->codes, new_cap * sizeof(*new_codes));
+        if (new_codes == NULL) {
+            setmsg_c("Failed to allocate memory for the body codes");
+            sigerr_c("alloc");
+            return;
+        }
+
+        codes->codes = new_codes;
+        codes->cap = new_cap;
+    }
+
+    codes->codes[codes->len] = code;
+    codes->len++;
+}
+
+static int compare_codes(const void *a, const void *b) {
+    SpiceInt first = *(const SpiceInt *) a;
+    SpiceInt second = *(const SpiceInt *) b;
+    return (first > second) - (first < second);
+}
+
+static void add_built_in_codes(code_list *codes) {
+    integer *built_in_codes = calloc(BUILT_IN_ROOM, sizeof(*built_in_codes));
+    char *built_in_names = calloc(BUILT_IN_ROOM, BUILT_IN_NAME_LEN);
+    if (built_in_codes == NULL || built_in_names == NULL) {
+        free(built_in_codes);
+        free(built_in_names);
+        setmsg_c("Failed to allocate memory for the built-in body table");
+        sigerr_c("alloc");
+        return;
+    }
+
+    // The routine fills its table without reporting how
+    // long it is, but every entry has a blank padded name,
+    // so the table ends at the first name left untouched
+    zzidmap_(built_in_codes, built_in_names, BUILT_IN_NAME_LEN);
+    for (SpiceInt i = 0; i < BUILT_IN_ROOM; ++i) {
+        if (built_in_names[i * BUILT_IN_NAME_LEN] == '\0') {
+            break;
+        }
+
+        add_code(codes, built_in_codes[i]);
+        if (failed_c()) {
+            break;
+        }
+    }
+
+    free(built_in_codes);
+    free(built_in_names);
+}
+
+static void add_pool_codes(code_list *codes) {
+    SpiceInt values[POOL_ROOM];
+    SpiceInt start = 0;
+    SpiceInt n;
+    SpiceBoolean found;
+
+    do {
+        gipool_c("NAIF_BODY_CODE", start, POOL_ROOM, &n, values, &found);
+        if (!found || failed_c()) {
+            return;
+        }
+
+        for (SpiceInt i = 0; i < n; ++i) {
+            add_code(codes, values[i]);
+        }
+        start += n;
+    } while (n == POOL_ROOM && !failed_c());
+}
+
+/**
+ * Adds the bodies which have constants in a text PCK, which
+ * are named BODY<ID>_<ITEM>, such as BODY399_RADII.
+ */
+static void add_constant_codes(code_list *codes) {
+    SpiceChar names[POOL_ROOM][POOL_NAME_LEN];
+    SpiceInt start = 0;
+    SpiceInt n;
+    SpiceBoolean found;
+
+    do {
+        gnpool_c("BODY*", start, POOL_ROOM, POOL_NAME_LEN, &n, names, &found);
+        if (!found || failed_c()) {
+            return;
+        }
+
+        for (SpiceInt i = 0; i < n; ++i) {
+            SpiceChar *end;
+            long code = strtol(names[i] + 4, &end, 10);
+            if (end != names[i] + 4 && *end == '_') {
+                add_code(codes, (SpiceInt) code);
+            }
+        }
+        start += n;
+    } while (n == POOL_ROOM && !failed_c());
+}
+
+/**
+ * Adds the objects covered by the loaded SPK files, as well
+ * as the centers of the frames of the loaded binary PCK
+ * files.
+ */
+static void add_file_codes(code_list *codes) {
+    SPICEINT_CELL(ids, MAX_OBJECTS);
+    SpiceChar file[FILE_NAME_MAX_LEN];
+    SpiceChar type[FILE_TYPE_MAX_LEN];
+    SpiceChar source[FILE_NAME_MAX_LEN];
+    SpiceInt handle;
+    SpiceBoolean found;
+
+    SpiceInt count;
+    scard_c(0, &ids);
+    ktotal_c("SPK", &count);
+    for (SpiceInt i = 0; i < count && !failed_c(); ++i) {
+        kdata_c(i, "SPK", FILE_NAME_MAX_LEN, FILE_TYPE_MAX_LEN, FILE_NAME_MAX_LEN, file, type, source, &handle,
+                &found);
+        if (found) {
+            spkobj_c(file, &ids);
+        }
+    }
+
+    for (SpiceInt i = 0; i < card_c(&ids) && !failed_c(); ++i) {
+        add_code(codes, SPICE_CELL_ELEM_I(&ids, i));
+    }
+
+    scard_c(0, &ids);
+    ktotal_c("PCK", &count);
+    for (SpiceInt i = 0; i < count && !failed_c(); ++i) {
+        kdata_c(i, "PCK", FILE_NAME_MAX_LEN, FILE_TYPE_MAX_LEN, FILE_NAME_MAX_LEN, file, type, source, &handle,
+                &found);
+        if (found) {
+            pckfrm_c(file, &ids);
+        }
+    }
+
+    for (SpiceInt i = 0; i < card_c(&ids) && !failed_c(); ++i) {
+        SpiceInt frame_code;
+        SpiceChar frame_name[FRAME_NAME_MAX_LEN];
+        SpiceInt center;
+        ccifrm_c(PCK_FRAME_CLASS, SPICE_CELL_ELEM_I(&ids, i), FRAME_NAME_MAX_LEN, &frame_code, frame_name, &center,
+                 &found);
+        if (found) {
+            add_code(codes, center);
+        }
+    }
+}
+
+void gate_list_bodies(gate_body_list *list) {
+    memset(list, 0, sizeof(*list));
+
+    code_list codes = {0};
+    add_built_in_codes(&codes);
+    if (!failed_c()) {
+        add_pool_codes(&codes);
+    }
+    if (!failed_c()) {
+        add_constant_codes(&codes);
+    }
+    if (!failed_c()) {
+        add_file_codes(&codes);
+    }
+    if (failed_c() || codes.len == 0) {
+        free(codes.codes);
+        return;
+    }
+
+    qsort(codes.codes, codes.len, sizeof(*codes.codes), compare_codes);
+
+    list->bodies = malloc(codes.len * sizeof(*list->bodies));
+    if (list->bodies == NULL) {
+        free(codes.codes);
+        setmsg_c("Failed to allocate memory for the body list");
+        sigerr_c("alloc");
+        return;
+    }
+
+    for (SpiceInt i = 0; i < codes.len; ++i) {
+        if (i > 0 && codes.codes[i] == codes.codes[i - 1]) {
+            continue;
+        }
+
+        gate_body *body = &list->bodies[list->len];
+        body->code = codes.codes[i];
+
+        SpiceBoolean found;
+        bodc2n_c(body->code, GATE_BODY_NAME_MAX_LEN, body->name, &found);
+        if (!found) {
+            body->name[0] = '\0';
+        }
+
+        list->len++;
+    }
+
+    free(codes.codes);
+}
+
+const gate_body *gate_body_list_find(const gate_body_list *list, SpiceInt code) {
+    SpiceInt low = 0;
+    SpiceInt high = list->len;
+    while (low < high) {
+        SpiceInt mid = low + (high - low) / 2;
+        if (list->bodies[mid].code < code) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+
+    if (low < list->len && list->bodies[low].code == code) {
+        return &list->bodies[low];
+    }
+
+    return NULL;
+}
+
+void gate_body_list_free(gate_body_list *list) {
+    free(list->bodies);
+    memset(list, 0, sizeof(*list));
+}
@@ -0,0 +1,82 @@
+/**
+ * @file
+ * Enumeration of the bodies known to SPICE.
+ *
+ * SPICE can translate between body names and NAIF IDs, but
+ * has no procedure which lists every known body. Probing
+ * every plausible ID with bodc2n_c() takes minutes, so the
+ * list is instead assembled from the places that bodies
+ * are actually defined:
+ *
+ * - the built-in name/ID table of the toolkit
+ * - the NAIF_BODY_CODE variables of loaded text kernels
+ * - the BODY<ID>_* constants of loaded text PCKs
+ * - the objects covered by each loaded SPK
+ * - the centers of the frames of each loaded binary PCK
+ *
+ * The list only changes when kernels are loaded or
+ * unloaded, so it is meant to be built once and kept until
+ * then.
+ */
+
+#ifndef GATE_BODIES_H
+#define GATE_BODIES_H
+
+#include <cspice/SpiceUsr.h>
+
+/**
+ * The maximum length of a body name, including the NULL
+ * terminator.
+ */
+#define GATE_BODY_NAME_MAX_LEN 37
+
+/**
+ * A body known to SPICE.
+ */
+typedef struct {
+    SpiceInt code;
+
+    /**
+     * The name that bodc2n_c() translates the code to, or
+     * an empty string if the code has no name, as is the
+     * case for objects which only appear in an SPK.
+     */
+    SpiceChar name[GATE_BODY_NAME_MAX_LEN];
+} gate_body;
+
+/**
+ * Represents a list of bodies sorted by NAIF ID, without
+ * duplicates.
+ */
+typedef struct {
+    SpiceInt len;
+    gate_body *bodies;
+} gate_body_list;
+
+/**
+ * Lists every body which is built into SPICE or defined by
+ * a loaded kernel.
+ *
+ * @param list the bodies (output)
+ *
+ * @throws alloc if memory could not be allocated
+ */
+void gate_list_bodies(gate_body_list *list);
+
+/**
+ * Finds a body in a list by its NAIF ID.
+ *
+ * @param list the list to search (input)
+ * @param code the NAIF ID (input)
+ * @return the body, or NULL if it is not in the list
+ */
+const gate_body *gate_body_list_find(const gate_body_list *list, SpiceInt code);
+
+/**
+ * Frees all memory held by a list.
+ *
+ * @param list the list to free (input/output)
+ */
+void gate_body_list_free(gate_body_list *list);
+
+#endif // GATE_BODIES_H
@@ -0,0 +1,52 @@
+#include "bodystates.h"
+
+// The step in seconds over which the acceleration of the
+// observer is differenced, the same as spkezr_c() uses
+#define ACCELERATION_STEP 1.0
+
+const SpiceInt GATE_SOLAR_SYSTEM_BODIES[GATE_SOLAR_SYSTEM_BODIES_LEN] = {
+        10, 301, 199, 299, 4, 5, 6, 7, 8, 9
+};
+
+void gate_body_states(SpiceInt len, const SpiceInt *targets, SpiceInt observer, ConstSpiceChar *frame,
+                      gate_abcorr abcorr, SpiceDouble et, SpiceDouble (*states)[6], SpiceDouble *lts) {
+    SpiceDouble observer_state[6];
+    SpiceDouble before[6];
+    SpiceDouble after[6];
+    spkssb_c(observer, et, "J2000", observer_state);
+    spkssb_c(observer, et - ACCELERATION_STEP, "J2000", before);
+    spkssb_c(observer, et + ACCELERATION_STEP, "J2000", after);
+
+    SpiceDouble observer_acceleration[3];
+    for (int i = 0; i < 3; ++i) {
+        observer_acceleration[i] = (after[i + 3] - before[i + 3]) / (2 * ACCELERATION_STEP);
+    }
+
+    SpiceDouble xform[6][6];
+    sxform_c("J2000", frame, et, xform);
+    if (failed_c()) {
+        return;
+    }
+
+    for (SpiceInt i = 0; i < len; ++i) {
+        SpiceDouble state[6];
+        SpiceDouble lt;
+        SpiceDouble dlt;
+        spkaps_c(targets[i], et, "J2000", gate_abcorr_spice(abcorr), observer_state, observer_acceleration, state,
+                 &lt, &dlt);
+        if (failed_c()) {
+            return;
+        }
+
+        if (abcorr == GATE_ABCORR_ANNUAL) {
+            SpiceDouble apparent[3];
+            stelab_c(state, &observer_state[3], apparent);
+            vequ_c(apparent, state);
+        }
+
+        mxvg_c(xform, state, 6, 6, states[i]);
+        if (lts != NULL) {
+            lts[i] = lt;
+        }
+    }
+}
@@ -0,0 +1,66 @@
+/**
+ * @file
+ * The apparent states of several bodies as seen from the
+ * same observer at the same epoch.
+ *
+ * Calling spkezr_c() once per body repeats the work which
+ * only depends on the observer: resolving its name,
+ * looking up its state and acceleration relative to the
+ * solar system barycenter and evaluating the rotation into
+ * the output frame. gate_body_states() does that work once
+ * per epoch and shares it between every target, leaving
+ * only the light time solution and the aberration
+ * corrections to be done per target by spkaps_c(), which
+ * is what spkezr_c() itself does with them.
+ */
+
+#ifndef GATE_BODYSTATES_H
+#define GATE_BODYSTATES_H
+
+#include <cspice/SpiceUsr.h>
+#include "abcorr.h"
+
+/**
+ * The number of bodies in GATE_SOLAR_SYSTEM_BODIES.
+ */
+#define GATE_SOLAR_SYSTEM_BODIES_LEN 10
+
+/**
+ * The NAIF IDs of the Sun, the Moon, the planets other
+ * than the Earth and Pluto, for showing the whole sky at
+ * once. Barycenters are used from Mars outwards, since
+ * those are what general purpose planetary SPKs such as
+ * de430.bsp cover.
+ */
+extern const SpiceInt GATE_SOLAR_SYSTEM_BODIES[GATE_SOLAR_SYSTEM_BODIES_LEN];
+
+/**
+ * Computes the apparent states of a set of bodies relative
+ * to an observer at one epoch.
+ *
+ * The results are the same as calling spkezr_c() for each
+ * target, as long as the output frame is centered at the
+ * observer or is inertial, as topocentric frames of the
+ * observer are.
+ *
+ * @param len the number of targets (input)
+ * @param targets the NAIF IDs of the targets (input)
+ * @param observer the NAIF ID of the observer (input)
+ * @param frame the name of the frame of the output states
+ * (input)
+ * @param abcorr the level of aberration correction. The
+ * stellar aberration of GATE_ABCORR_ANNUAL uses the
+ * velocity of the observer looked up from the loaded SPKs
+ * rather than gate_earth_velocity(), since it is needed
+ * anyways (input)
+ * @param et the ephemeris time (input)
+ * @param states the state of each target relative to the
+ * observer in kilometers and kilometers per second
+ * (output)
+ * @param lts the one way light time between each target
+ * and the observer in seconds, or NULL (output)
+ */
+void gate_body_states(SpiceInt len, const SpiceInt *targets, SpiceInt observer, ConstSpiceChar *frame,
+                      gate_abcorr abcorr, SpiceDouble et, SpiceDouble (*states)[6], SpiceDouble *lts);
+
+#endif // GATE_BODYSTATES_H
@@ -0,0 +1,142 @@
+#include "bodytrack.h"
+#include <math.h>
+#include <string.h>
+
+#define NODES_LEN (GATE_BODY_TRACK_DEGREE + 1)
+
+// The error between the check points can be somewhat
+// larger than at them, so fits are held to a fraction of
+// the tolerance
+#define CHECK_MARGIN 0.5
+
+// Windows are never made shorter than this many seconds,
+// below which fitting would cost more lookups than it
+// saves
+#define MIN_WINDOW_LEN 60.0
+
+static void evaluate(ConstSpiceDouble *coefficients, SpiceDouble x, SpiceDouble state[6]) {
+    SpiceDouble t[NODES_LEN];
+    t[0] = 1.0;
+    t[1] = x;
+    for (int j = 2; j < NODES_LEN; ++j) {
+        t[j] = 2.0 * x * t[j - 1] - t[j - 2];
+    }
+
+    SpiceDouble sum[6] = {0.0};
+    for (int j = 0; j < NODES_LEN; ++j) {
+        for (int i = 0; i < 6; ++i) {
+            sum[i] += coefficients[j * 6 + i] * t[j];
+        }
+    }
+    memcpy(state, sum, sizeof(sum));
+}
+
+static void look_up(gate_body_track *track, SpiceDouble et, SpiceDouble state[6]) {
+    gate_apparent_state(track->target, et, track->frame, track->abcorr, track->observer, state);
+    track->lookups++;
+}
+
+/**
+ * Fits the window starting at the given time.
+ *
+ * @return the largest error in degrees found at the check
+ * points
+ */
+static SpiceDouble fit_window(gate_body_track *track, SpiceDouble start_et, SpiceDouble window) {
+    SpiceDouble mid = start_et + 0.5 * window;
+
+    SpiceDouble values[NODES_LEN][6];
+    for (int k = 0; k < NODES_LEN; ++k) {
+        look_up(track, mid + 0.5 * window * cos(pi_c() * (k + 0.5) / NODES_LEN), values[k]);
+    }
+    if (failed_c()) {
+        return HUGE_VAL;
+    }
+
+    for (int j = 0; j < NODES_LEN; ++j) {
+        for (int i = 0; i < 6; ++i) {
+            SpiceDouble sum = 0.0;
+            for (int k = 0; k < NODES_LEN; ++k) {
+                sum += values[k][i] * cos(pi_c() * j * (k + 0.5) / NODES_LEN);
+            }
+            track->coefficients[j * 6 + i] = sum * (j == 0 ? 1.0 : 2.0) / NODES_LEN;
+        }
+    }
+
+    SpiceDouble max_error = 0.0;
+    for (int k = 0; k < NODES_LEN; ++k) {
+        SpiceDouble x = cos(pi_c() * k / GATE_BODY_TRACK_DEGREE);
+        SpiceDouble expected[6];
+        SpiceDouble fitted[6];
+        look_up(track, mid + 0.5 * window * x, expected);
+        if (failed_c()) {
+            return HUGE_VAL;
+        }
+        evaluate(track->coefficients, x, fitted);
+
+        // The angle subtended by the error, which is what
+        // an azimuth or elevation is off by
+        SpiceDouble error = vdist_c(fitted, expected) / vnorm_c(expected) * dpr_c();
+        if (error > max_error) {
+            max_error = error;
+        }
+    }
+
+    return max_error;
+}
+
+static void refresh(gate_body_track *track, SpiceDouble et) {
+    track->refreshes++;
+    track->fitted = SPICEFALSE;
+
+    SpiceDouble window = track->window;
+    while (SPICETRUE) {
+        track->start_et = et;
+        track->end_et = et + window;
+        track->max_error = fit_window(track, et, window);
+        if (failed_c()) {
+            track->end_et = track->start_et;
+            return;
+        }
+
+        if (track->max_error <= track->tolerance * CHECK_MARGIN) {
+            track->fitted = SPICETRUE;
+            return;
+        }
+
+        if (window * 0.5 < MIN_WINDOW_LEN) {
+            return;
+        }
+        window *= 0.5;
+    }
+}
+
+void gate_body_track_init(ConstSpiceChar *target, ConstSpiceChar *frame, gate_abcorr abcorr,
+                          ConstSpiceChar *observer, SpiceDouble window, SpiceDouble tolerance,
+                          gate_body_track *track) {
+    memset(track, 0, sizeof(*track));
+    track->target = target;
+    track->frame = frame;
+    track->abcorr = abcorr;
+    track->observer = observer;
+    track->window = window;
+    track->tolerance = tolerance;
+    track->fitted = SPICEFALSE;
+}
+
+void gate_body_track_state(gate_body_track *track, SpiceDouble et, SpiceDouble state[6]) {
+    if (et < track->start_et || et > track->end_et || track->start_et == track->end_et) {
+        refresh(track, et);
+        if (failed_c()) {
+            return;
+        }
+    }
+
+    if (!track->fitted) {
+        look_up(track, et, state);
+        return;
+    }
+
+    SpiceDouble x = 2.0 * (et - track->start_et) / (track->end_et - track->start_et) - 1.0;
+    evaluate(track->coefficients, x, state);
+}
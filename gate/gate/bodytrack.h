@@ -0,0 +1,119 @@
+/**
+ * @file
+ * A cache of the apparent state of a body as seen from an
+ * observer, for tracking loops which ask for it over and
+ * over.
+ *
+ * spkezr_c() resolves the names of the target, observer
+ * and frame, iterates the light time solution, corrects
+ * for stellar aberration and walks the frame chain on
+ * every call, even though the apparent position of a
+ * planet changes smoothly from one second to the next. A
+ * gate_body_track instead looks up the corrected state
+ * at the Chebyshev nodes of a window of time starting at
+ * the first query, fits a polynomial to each component,
+ * and answers every query in the window by evaluating the
+ * polynomials. The window is only refitted once a query
+ * falls outside of it.
+ *
+ * Every fit is checked against looked up states at the
+ * extrema of the Chebyshev polynomial of the fit's degree,
+ * and the window is halved until the direction to the body
+ * agrees to within a tolerance. Windows which cannot be
+ * fitted are served by looking up each state instead.
+ */
+
+#ifndef GATE_BODYTRACK_H
+#define GATE_BODYTRACK_H
+
+#include <cspice/SpiceUsr.h>
+#include "abcorr.h"
+
+/**
+ * The degree of the polynomial fitted to each component of
+ * the state.
+ */
+#define GATE_BODY_TRACK_DEGREE 8
+
+/**
+ * Represents the fitted state of a body over the current
+ * window.
+ *
+ * The track keeps pointers to the names it was
+ * initialized with, which must outlive it.
+ */
+typedef struct {
+    ConstSpiceChar *target;
+    ConstSpiceChar *frame;
+    gate_abcorr abcorr;
+    ConstSpiceChar *observer;
+
+    /**
+     * The length in seconds of the windows to fit, and the
+     * largest error in degrees to accept in the direction
+     * to the body.
+     */
+    SpiceDouble window;
+    SpiceDouble tolerance;
+
+    /**
+     * The current window, which is empty before the first
+     * query, and whether it is served by the polynomials.
+     */
+    SpiceDouble start_et;
+    SpiceDouble end_et;
+    SpiceBoolean fitted;
+
+    /**
+     * The largest error in degrees found when checking the
+     * fit of the current window.
+     */
+    SpiceDouble max_error;
+
+    /**
+     * The number of times a window has been fitted, and
+     * the number of states looked up in doing so.
+     */
+    SpiceInt refreshes;
+    SpiceInt lookups;
+
+    /**
+     * The coefficients of the same degree for all six
+     * components are stored together.
+     */
+    SpiceDouble coefficients[6 * (GATE_BODY_TRACK_DEGREE + 1)];
+} gate_body_track;
+
+/**
+ * Prepares to track a body. Nothing is looked up until the
+ * first query.
+ *
+ * @param target the name of the target body (input)
+ * @param frame the name of the frame of the output states
+ * (input)
+ * @param abcorr the level of aberration correction, see
+ * gate_apparent_state() (input)
+ * @param observer the name of the observing body (input)
+ * @param window the length in seconds of the windows to
+ * fit (input)
+ * @param tolerance the largest error in degrees to accept
+ * in the direction to the body (input)
+ * @param track the track (output)
+ */
+void gate_body_track_init(ConstSpiceChar *target, ConstSpiceChar *frame, gate_abcorr abcorr,
+                          ConstSpiceChar *observer, SpiceDouble window, SpiceDouble tolerance,
+                          gate_body_track *track);
+
+/**
+ * Obtains the state of the body at a time, refitting the
+ * window first if the time falls outside of it.
+ *
+ * @param track the track (input/output)
+ * @param et the ephemeris time (input)
+ * @param state the state of the target relative to the
+ * observer in kilometers and kilometers per second, see
+ * spkezr_c() (output)
+ */
+void gate_body_track_state(gate_body_track *track, SpiceDouble et, SpiceDouble state[6]);
+
+#endif // GATE_BODYTRACK_H
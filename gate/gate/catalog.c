@@ -0,0 +1,131 @@
+#include "catalog.h"
+
+typedef struct {
+    const gate_sgp4 *sats;
+    const gate_sgp4_status *init_status;
+    SpiceInt ets_len;
+    ConstSpiceDouble *ets;
+    SpiceDouble (*states)[6];
+    gate_sgp4_status *status;
+    SpiceInt failed;
+} propagate_job;
+
+static void propagate_grid_chunk(void *user_data, SpiceInt begin, SpiceInt end) {
+    propagate_job *job = user_data;
+    SpiceInt failed = 0;
+
+    for (SpiceInt i = begin; i < end; ++i) {
+        SpiceInt offset = i * job->ets_len;
+        gate_sgp4_status init_status = job->init_status[i];
+
+        for (SpiceInt j = 0; j < job->ets_len; ++j) {
+            gate_sgp4_status status = init_status;
+            if (status == GATE_SGP4_OK) {
+                status = gate_sgp4_propagate(&job->sats[i], job->ets[j], job->states[offset + j]);
+            }
+
+            job->status[offset + j] = status;
+            if (status != GATE_SGP4_OK) {
+                failed++;
+            }
+        }
+    }
+
+    __sync_fetch_and_add(&job->failed, failed);
+}
+
+typedef struct {
+    const gate_sgp4 *sats;
+    const gate_sgp4_batch *batch;
+    SpiceInt near_groups;
+    SpiceDouble et;
+    SpiceDouble (*states)[6];
+    gate_sgp4_status *status;
+    SpiceInt failed;
+} batch_job;
+
+static void propagate_batch_chunk(void *user_data, SpiceInt begin, SpiceInt end) {
+    batch_job *job = user_data;
+    SpiceInt failed = 0;
+
+    // The near-Earth lane groups come first, followed by
+    // one work item per deep space satellite
+    SpiceInt near_end = end < job->near_groups ? end : job->near_groups;
+    if (begin < near_end) {
+        failed += gate_sgp4_batch_propagate_near(job->batch, begin, near_end, job->et, job->states, job->status);
+    }
+
+    for (SpiceInt item = begin > job->near_groups ? begin : job->near_groups; item < end; ++item) {
+        SpiceInt i = job->batch->deep_index[item - job->near_groups];
+        job->status[i] = gate_sgp4_propagate(&job->sats[i], job->et, job->states[i]);
+        if (job->status[i] != GATE_SGP4_OK) {
+            failed++;
+        }
+    }
+
+    __sync_fetch_and_add(&job->failed, failed);
+}
+
+SpiceInt gate_catalog_init(const gate_sat_store *store, gate_sgp4 *sats, gate_sgp4_status *status) {
+    SpiceInt failed = 0;
+    SpiceDouble elements[GATE_TLE_ELEMENTS_LEN];
+
+    for (gate_sat_handle handle = 0; handle < store->len; ++handle) {
+        gate_sat_store_get_elements(store, handle, elements);
+        status[handle] = gate_sgp4_init(elements, &sats[handle]);
+        if (status[handle] != GATE_SGP4_OK) {
+            failed++;
+        }
+    }
+
+    return failed;
+}
+
+SpiceInt gate_catalog_propagate(gate_pool *pool, SpiceInt len, const gate_sgp4 *sats,
+                                const gate_sgp4_status *init_status, SpiceDouble et,
+                                SpiceDouble (*states)[6], gate_sgp4_status *status) {
+    return gate_catalog_propagate_grid(pool, len, sats, init_status, 1, &et, states, status);
+}
+
+SpiceInt gate_catalog_propagate_grid(gate_pool *pool, SpiceInt len, const gate_sgp4 *sats,
+                                     const gate_sgp4_status *init_status, SpiceInt ets_len,
+                                     ConstSpiceDouble *ets, SpiceDouble (*states)[6],
+                                     gate_sgp4_status *status) {
+    propagate_job job = {
+            .sats = sats,
+            .init_status = init_status,
+            .ets_len = ets_len,
+            .ets = ets,
+            .states = states,
+            .status = status,
+            .failed = 0
+    };
+    gate_pool_run(pool, len, 0, propagate_grid_chunk, &job);
+
+    return job.failed;
+}
+
+SpiceInt gate_catalog_propagate_batch(gate_pool *pool, SpiceInt len, const gate_sgp4 *sats,
+                                      const gate_sgp4_status *init_status, const gate_sgp4_batch *batch,
+                                      SpiceDouble et, SpiceDouble (*states)[6], gate_sgp4_status *status) {
+    SpiceInt init_failed = 0;
+    for (SpiceInt i = 0; i < len; ++i) {
+        if (init_status[i] != GATE_SGP4_OK) {
+            status[i] = init_status[i];
+            init_failed++;
+        }
+    }
+
+    batch_job job = {
+            .sats = sats,
+            .batch = batch,
+            .near_groups = batch->lane_cap / GATE_SGP4_LANES,
+            .et = et,
+            .states = states,
+            .status = status,
+            .failed = 0
+    };
+    gate_pool_run(pool, job.near_groups + batch->deep_len, 0, propagate_batch_chunk, &job);
+
+    return init_failed + job.failed;
+}
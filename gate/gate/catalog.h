@@ -0,0 +1,123 @@
+/**
+ * @file
+ * Propagation of whole satellite catalogs.
+ *
+ * These procedures initialize a gate_sgp4 state for every
+ * satellite in a gate_sat_store once, and then propagate
+ * the whole catalog to an epoch or over a grid of epochs,
+ * split across the threads of a gate_pool.
+ *
+ * The output arrays are indexed by satellite handle, and
+ * propagation failures are reported per satellite rather
+ * than by signaling a SPICE error, so that one decayed
+ * object does not abort the rest of the catalog.
+ */
+
+#ifndef GATE_CATALOG_H
+#define GATE_CATALOG_H
+
+#include <cspice/SpiceUsr.h>
+#include "pool.h"
+#include "satstore.h"
+#include "sgp4.h"
+#include "sgp4batch.h"
+
+/**
+ * Initializes the propagator state of every satellite in a
+ * store.
+ *
+ * Requires a leapseconds kernel to be loaded. See
+ * gate_sgp4_init().
+ *
+ * @param store the satellites to initialize (input)
+ * @param sats the initialized propagator states, with room
+ * for store->len entries (output)
+ * @param status the result of initializing each satellite,
+ * with room for store->len entries (output)
+ * @return the number of satellites which failed to
+ * initialize
+ */
+SpiceInt gate_catalog_init(const gate_sat_store *store, gate_sgp4 *sats, gate_sgp4_status *status);
+
+/**
+ * Propagates every satellite in a catalog to the same
+ * epoch.
+ *
+ * Satellites which failed to initialize are skipped and
+ * keep their initialization status.
+ *
+ * @param pool the threads to propagate on, or NULL to use
+ * the calling thread (input)
+ * @param len the number of satellites (input)
+ * @param sats the initialized propagator states (input)
+ * @param init_status the initialization status of each
+ * satellite (input)
+ * @param et the ephemeris time to propagate to (input)
+ * @param states the state of each satellite, see
+ * gate_sgp4_propagate() (output)
+ * @param status the result of propagating each satellite
+ * (output)
+ * @return the number of satellites which failed to
+ * propagate
+ */
+SpiceInt gate_catalog_propagate(gate_pool *pool, SpiceInt len, const gate_sgp4 *sats,
+                                const gate_sgp4_status *init_status, SpiceDouble et,
+                                SpiceDouble (*states)[6], gate_sgp4_status *status);
+
+/**
+ * Propagates every satellite in a catalog over a grid of
+ * epochs.
+ *
+ * The output is laid out satellite by satellite, so the
+ * state of satellite `i` at epoch `j` is at index
+ * `i * ets_len + j`. Work is split by satellite so that
+ * each thread keeps the state of one satellite in cache
+ * while it steps through the grid.
+ *
+ * @param pool the threads to propagate on, or NULL to use
+ * the calling thread (input)
+ * @param len the number of satellites (input)
+ * @param sats the initialized propagator states (input)
+ * @param init_status the initialization status of each
+ * satellite (input)
+ * @param ets_len the number of epochs (input)
+ * @param ets the ephemeris times to propagate to (input)
+ * @param states the state of each satellite at each epoch,
+ * with room for len * ets_len entries (output)
+ * @param status the result of each propagation, with room
+ * for len * ets_len entries (output)
+ * @return the number of propagations which failed
+ */
+SpiceInt gate_catalog_propagate_grid(gate_pool *pool, SpiceInt len, const gate_sgp4 *sats,
+                                     const gate_sgp4_status *init_status, SpiceInt ets_len,
+                                     ConstSpiceDouble *ets, SpiceDouble (*states)[6],
+                                     gate_sgp4_status *status);
+
+/**
+ * Propagates every satellite in a batch to the same epoch,
+ * using the batched kernel for near-Earth satellites and
+ * gate_sgp4_propagate() for deep space satellites.
+ *
+ * @param pool the threads to propagate on, or NULL to use
+ * the calling thread (input)
+ * @param len the number of satellites the batch was
+ * created from (input)
+ * @param sats the initialized propagator states that the
+ * batch was created from (input)
+ * @param init_status the initialization status of each
+ * satellite (input)
+ * @param batch the batch created from the satellites
+ * (input)
+ * @param et the ephemeris time to propagate to (input)
+ * @param states the state of each satellite, see
+ * gate_sgp4_propagate() (output)
+ * @param status the result of propagating each satellite
+ * (output)
+ * @return the number of satellites which failed to
+ * propagate
+ */
+SpiceInt gate_catalog_propagate_batch(gate_pool *pool, SpiceInt len, const gate_sgp4 *sats,
+                                      const gate_sgp4_status *init_status, const gate_sgp4_batch *batch,
+                                      SpiceDouble et, SpiceDouble (*states)[6], gate_sgp4_status *status);
+
+#endif // GATE_CATALOG_H
@@ -0,0 +1,574 @@
+#include "conjunction.h"
+#include <math.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sgp4batch.h"
+
+#define BLOCK_STEPS 64
+#define INITIAL_CAP 64
+#define REFINE_SAMPLES 4
+#define REFINE_MAX_ITERATIONS 50
+
+// WGS-72 gravitational parameter of the Earth in km^3/s^2,
+// matching the constants of sgp4.h
+#define MU_EARTH 398600.8
+
+// Margins on the perigee and apogee radii covering the
+// short period perturbations of the mean elements
+#define SHELL_MARGIN_KM 50.0
+#define SHELL_MARGIN_FACTOR 0.02
+
+/**
+ * Close approaches found by one chunk of work, which are
+ * merged into the job once the chunk is done.
+ */
+typedef struct {
+    SpiceInt len;
+    SpiceInt cap;
+    gate_conjunction *conjunctions;
+} conjunction_list;
+
+typedef struct {
+    const gate_sgp4 *sats;
+    const gate_sgp4_status *init_status;
+    const gate_sgp4_batch *batch;
+    SpiceInt sats_len;
+    SpiceInt near_groups;
+    SpiceDouble *perigee;
+    SpiceDouble *apogee;
+
+    SpiceDouble start_et;
+    SpiceDouble end_et;
+    SpiceDouble step;
+    SpiceDouble threshold;
+    SpiceInt block_begin;
+    SpiceInt buckets_len;
+
+    pthread_mutex_t lock;
+    conjunction_list found;
+    SpiceDouble pairs;
+    SpiceInt candidates;
+    SpiceBoolean out_of_memory;
+} conjunction_job;
+
+/**
+ * The positions of the whole catalog at one step, binned
+ * into a spatial hash.
+ *
+ * The satellites are sorted by bucket with a counting
+ * sort, and their states, cells and shells are copied
+ * into that order, so that comparing a satellite against
+ * the satellites in a neighboring cell streams through
+ * memory rather than chasing a linked list.
+ */
+typedef struct {
+    SpiceDouble (*states)[6];
+    gate_sgp4_status *status;
+    SpiceInt *buckets;
+
+    SpiceInt *starts;
+    SpiceInt *order;
+    SpiceDouble (*sorted_states)[6];
+    int64_t (*sorted_cells)[3];
+    SpiceDouble (*sorted_shells)[2];
+} step_grid;
+
+static SpiceBoolean append_conjunction(conjunction_list *list, const gate_conjunction *conjunction) {
+    if (list->len == list->cap) {
+        SpiceInt cap = list->cap == 0 ? INITIAL_CAP : list->cap * 2;
+        gate_conjunction *conjunctions = realloc(list->conjunctions, cap * sizeof(*conjunctions));
+        if (conjunctions == NULL) {
+            return SPICEFALSE;
+        }
+
+        list->cap = cap;
+        list->conjunctions = conjunctions;
+    }
+
+    list->conjunctions[list->len++] = *conjunction;
+    return SPICETRUE;
+}
+
+static SpiceDouble step_et(const conjunction_job *job, SpiceInt k) {
+    SpiceDouble et = job->start_et + k * job->step;
+    return et < job->end_et ? et : job->end_et;
+}
+
+/**
+ * Obtains the time halfway between steps k and k + 1,
+ * which ends the span of time screened at step k and
+ * starts the span screened at step k + 1.
+ */
+static SpiceDouble boundary_et(const conjunction_job *job, SpiceInt k) {
+    SpiceDouble et = job->start_et + (k + 0.5) * job->step;
+    return et < job->end_et ? et : job->end_et;
+}
+
+static uint64_t hash_cell(const int64_t cell[3], SpiceInt buckets_len) {
+    uint64_t h = (uint64_t) cell[0] * 73856093u ^ (uint64_t) cell[1] * 19349663u ^ (uint64_t) cell[2] * 83492791u;
+    return (h ^ h >> 29) & (uint64_t) (buckets_len - 1);
+}
+
+static SpiceDouble dot(ConstSpiceDouble a[3], ConstSpiceDouble b[3]) {
+    return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+}
+
+/**
+ * Interpolates the relative position and velocity of a
+ * pair between two relative states span seconds apart
+ * with a cubic Hermite spline, where s is the fraction of
+ * the span, and returns their dot product, which is half
+ * the rate of change of the squared distance.
+ */
+static SpiceDouble approach_rate(ConstSpiceDouble from[6], ConstSpiceDouble to[6], SpiceDouble span,
+                                 SpiceDouble s) {
+    SpiceDouble s2 = s * s;
+    SpiceDouble s3 = s2 * s;
+    SpiceDouble h00 = 2.0 * s3 - 3.0 * s2 + 1.0;
+    SpiceDouble h10 = (s3 - 2.0 * s2 + s) * span;
+    SpiceDouble h01 = -2.0 * s3 + 3.0 * s2;
+    SpiceDouble h11 = (s3 - s2) * span;
+    SpiceDouble d00 = (6.0 * s2 - 6.0 * s) / span;
+    SpiceDouble d10 = 3.0 * s2 - 4.0 * s + 1.0;
+    SpiceDouble d01 = (-6.0 * s2 + 6.0 * s) / span;
+    SpiceDouble d11 = 3.0 * s2 - 2.0 * s;
+
+    SpiceDouble pos[3];
+    SpiceDouble vel[3];
+    for (int i = 0; i < 3; ++i) {
+        pos[i] = h00 * from[i] + h10 * from[i + 3] + h01 * to[i] + h11 * to[i + 3];
+        vel[i] = d00 * from[i] + d10 * from[i + 3] + d01 * to[i] + d11 * to[i + 3];
+    }
+
+    return dot(pos, vel);
+}
+
+/**
+ * Locates the time between t0 and t1 at which the approach
+ * rate changes from negative to positive.
+ */
+static SpiceDouble refine_approach(ConstSpiceDouble from[6], ConstSpiceDouble to[6], SpiceDouble from_et,
+                                   SpiceDouble span, SpiceDouble t0, SpiceDouble t1, SpiceDouble g0,
+                                   SpiceDouble g1) {
+    SpiceDouble t = t1;
+    int side = 0;
+
+    for (int i = 0; i < REFINE_MAX_ITERATIONS; ++i) {
+        SpiceDouble next = (t0 * g1 - t1 * g0) / (g1 - g0);
+        if (fabs(next - t) < GATE_CONJUNCTION_TIME_TOLERANCE) {
+            return next;
+        }
+        t = next;
+
+        SpiceDouble g = approach_rate(from, to, span, (t - from_et) / span);
+
+        // Halve the value kept at the end that did not move
+        // so that convergence is not one-sided
+        if ((g < 0.0) == (g1 < 0.0)) {
+            t1 = t;
+            g1 = g;
+            if (side == -1) {
+                g0 *= 0.5;
+            }
+            side = -1;
+        } else if ((g < 0.0) == (g0 < 0.0)) {
+            t0 = t;
+            g0 = g;
+            if (side == 1) {
+                g1 *= 0.5;
+            }
+            side = 1;
+        } else {
+            break;
+        }
+    }
+
+    return t;
+}
+
+/**
+ * Finds the closest approaches of a pair between two of
+ * its relative states, and appends those within the
+ * threshold to the list.
+ */
+static SpiceBoolean find_approaches(const conjunction_job *job, SpiceInt a, SpiceInt b,
+                                    ConstSpiceDouble from[6], SpiceDouble from_et,
+                                    ConstSpiceDouble to[6], SpiceDouble to_et, conjunction_list *list) {
+    SpiceDouble span = to_et - from_et;
+    if (span <= 0) {
+        return SPICETRUE;
+    }
+
+    SpiceDouble t0 = from_et;
+    SpiceDouble g0 = dot(from, &from[3]);
+    for (int i = 1; i <= REFINE_SAMPLES; ++i) {
+        SpiceDouble t1 = i == REFINE_SAMPLES ? to_et : from_et + span * i / REFINE_SAMPLES;
+        SpiceDouble g1 = i == REFINE_SAMPLES ? dot(to, &to[3]) : approach_rate(from, to, span,
+                                                                                 (SpiceDouble) i / REFINE_SAMPLES);
+
+        // The distance has a minimum where it stops
+        // shrinking and starts growing
+        if (g0 < 0.0 && g1 >= 0.0) {
+            SpiceDouble tca = refine_approach(from, to, from_et, span, t0, t1, g0, g1);
+
+            SpiceDouble state_a[6];
+            SpiceDouble state_b[6];
+            if (gate_sgp4_propagate(&job->sats[a], tca, state_a) == GATE_SGP4_OK &&
+                gate_sgp4_propagate(&job->sats[b], tca, state_b) == GATE_SGP4_OK) {
+                SpiceDouble rel[6];
+                for (int j = 0; j < 6; ++j) {
+                    rel[j] = state_b[j] - state_a[j];
+                }
+
+                SpiceDouble miss_distance = sqrt(dot(rel, rel));
+                if (miss_distance <= job->threshold) {
+                    gate_conjunction conjunction = {a, b, tca, miss_distance, sqrt(dot(&rel[3], &rel[3]))};
+                    if (!append_conjunction(list, &conjunction)) {
+                        return SPICEFALSE;
+                    }
+                }
+            }
+        }
+
+        t0 = t1;
+        g0 = g1;
+    }
+
+    return SPICETRUE;
+}
+
+/**
+ * Propagates a pair to both ends of the span of time
+ * screened at step k and finds its closest approaches on
+ * either side of the step.
+ */
+static SpiceBoolean refine_pair(const conjunction_job *job, const step_grid *grid, SpiceInt a, SpiceInt b,
+                                SpiceInt k, conjunction_list *list) {
+    SpiceDouble et = step_et(job, k);
+    SpiceDouble lo = k == 0 ? job->start_et : boundary_et(job, k - 1);
+    SpiceDouble hi = boundary_et(job, k);
+
+    SpiceDouble mid[6];
+    for (int j = 0; j < 6; ++j) {
+        mid[j] = grid->states[b][j] - grid->states[a][j];
+    }
+
+    SpiceDouble ets[2] = {lo, hi};
+    for (int side = 0; side < 2; ++side) {
+        if (ets[side] == et) {
+            continue;
+        }
+
+        SpiceDouble state_a[6];
+        SpiceDouble state_b[6];
+        if (gate_sgp4_propagate(&job->sats[a], ets[side], state_a) != GATE_SGP4_OK ||
+            gate_sgp4_propagate(&job->sats[b], ets[side], state_b) != GATE_SGP4_OK) {
+            continue;
+        }
+
+        SpiceDouble end[6];
+        for (int j = 0; j < 6; ++j) {
+            end[j] = state_b[j] - state_a[j];
+        }
+
+        SpiceBoolean ok = side == 0 ? find_approaches(job, a, b, end, lo, mid, et, list)
+                                    : find_approaches(job, a, b, mid, et, end, hi, list);
+        if (!ok) {
+            return SPICEFALSE;
+        }
+    }
+
+    return SPICETRUE;
+}
+
+/**
+ * Propagates the catalog to step k, bins it into the
+ * spatial hash and refines every pair which could come
+ * within the threshold during the span of the step.
+ */
+static SpiceBoolean screen_step(conjunction_job *job, step_grid *grid, SpiceInt k, conjunction_list *list,
+                                SpiceDouble *pairs, SpiceInt *candidates) {
+    SpiceInt sats_len = job->sats_len;
+    SpiceInt buckets_len = job->buckets_len;
+    SpiceDouble et = step_et(job, k);
+    SpiceDouble lo = k == 0 ? job->start_et : boundary_et(job, k - 1);
+    SpiceDouble hi = boundary_et(job, k);
+    SpiceDouble half = et - lo > hi - et ? et - lo : hi - et;
+
+    memcpy(grid->status, job->init_status, sats_len * sizeof(*grid->status));
+    gate_sgp4_batch_propagate_near(job->batch, 0, job->near_groups, et, grid->states, grid->status);
+    for (SpiceInt d = 0; d < job->batch->deep_len; ++d) {
+        SpiceInt i = job->batch->deep_index[d];
+        grid->status[i] = gate_sgp4_propagate(&job->sats[i], et, grid->states[i]);
+    }
+
+    SpiceDouble max_speed_sq = 0;
+    for (SpiceInt i = 0; i < sats_len; ++i) {
+        SpiceDouble speed_sq = dot(&grid->states[i][3], &grid->states[i][3]);
+        if (grid->status[i] == GATE_SGP4_OK && speed_sq > max_speed_sq) {
+            max_speed_sq = speed_sq;
+        }
+    }
+
+    // Over the span, the relative position of a pair moves
+    // away from its linear extrapolation by at most half
+    // the largest relative acceleration, that of two
+    // satellites at the surface, times the span squared
+    SpiceDouble max_accel = 2.0 * MU_EARTH / (GATE_SGP4_RADIUS_EARTH_KM * GATE_SGP4_RADIUS_EARTH_KM);
+    SpiceDouble curvature = 0.5 * max_accel * half * half;
+    SpiceDouble cell_size = job->threshold + 2.0 * sqrt(max_speed_sq) * half + curvature;
+    if (cell_size <= 0) {
+        cell_size = 1.0;
+    }
+
+    memset(grid->starts, 0, (buckets_len + 1) * sizeof(*grid->starts));
+    for (SpiceInt i = 0; i < sats_len; ++i) {
+        if (grid->status[i] != GATE_SGP4_OK) {
+            continue;
+        }
+
+        int64_t cell[3];
+        for (int c = 0; c < 3; ++c) {
+            cell[c] = (int64_t) floor(grid->states[i][c] / cell_size);
+        }
+        grid->buckets[i] = (SpiceInt) hash_cell(cell, buckets_len);
+        grid->starts[grid->buckets[i] + 1]++;
+    }
+    for (SpiceInt b = 0; b < buckets_len; ++b) {
+        grid->starts[b + 1] += grid->starts[b];
+    }
+
+    // Scatter into bucket order, using the start of each
+    // bucket as its insertion point and then shifting the
+    // starts back
+    for (SpiceInt i = 0; i < sats_len; ++i) {
+        if (grid->status[i] != GATE_SGP4_OK) {
+            continue;
+        }
+
+        SpiceInt p = grid->starts[grid->buckets[i]]++;
+        grid->order[p] = i;
+        memcpy(grid->sorted_states[p], grid->states[i], sizeof(grid->sorted_states[p]));
+        for (int c = 0; c < 3; ++c) {
+            grid->sorted_cells[p][c] = (int64_t) floor(grid->states[i][c] / cell_size);
+        }
+        grid->sorted_shells[p][0] = job->perigee[i] - job->threshold;
+        grid->sorted_shells[p][1] = job->apogee[i];
+    }
+    memmove(&grid->starts[1], grid->starts, buckets_len * sizeof(*grid->starts));
+    grid->starts[0] = 0;
+
+    SpiceInt sorted_len = grid->starts[buckets_len];
+    SpiceDouble max_screen_sq = cell_size * cell_size * 12.0;
+    for (SpiceInt p = 0; p < sorted_len; ++p) {
+        const int64_t *own_cell = grid->sorted_cells[p];
+        const SpiceDouble *own_state = grid->sorted_states[p];
+
+        for (int n = 0; n < 27; ++n) {
+            int64_t cell[3] = {own_cell[0] + n % 3 - 1, own_cell[1] + n / 3 % 3 - 1, own_cell[2] + n / 9 - 1};
+            SpiceInt bucket = (SpiceInt) hash_cell(cell, buckets_len);
+
+            for (SpiceInt q = grid->starts[bucket]; q < grid->starts[bucket + 1]; ++q) {
+                // Each pair is only visited from the first
+                // of the two in sorted order, and only from
+                // the cell that the second is in
+                if (q <= p || grid->sorted_cells[q][0] != cell[0] || grid->sorted_cells[q][1] != cell[1] ||
+                    grid->sorted_cells[q][2] != cell[2]) {
+                    continue;
+                }
+
+                if (grid->sorted_shells[p][0] > grid->sorted_shells[q][1] ||
+                    grid->sorted_shells[q][0] > grid->sorted_shells[p][1]) {
+                    continue;
+                }
+                (*pairs)++;
+
+                SpiceDouble rel[6];
+                for (int j = 0; j < 6; ++j) {
+                    rel[j] = grid->sorted_states[q][j] - own_state[j];
+                }
+
+                SpiceDouble distance_sq = dot(rel, rel);
+                if (distance_sq > max_screen_sq) {
+                    continue;
+                }
+
+                SpiceDouble screen = job->threshold + sqrt(dot(&rel[3], &rel[3])) * half + curvature;
+                if (distance_sq > screen * screen) {
+                    continue;
+                }
+                (*candidates)++;
+
+                SpiceInt a = grid->order[p];
+                SpiceInt b = grid->order[q];
+                if (!refine_pair(job, grid, a < b ? a : b, a < b ? b : a, k, list)) {
+                    return SPICEFALSE;
+                }
+            }
+        }
+    }
+
+    return SPICETRUE;
+}
+
+static void conjunction_chunk(void *user_data, SpiceInt begin, SpiceInt end) {
+    conjunction_job *job = user_data;
+    SpiceInt len = job->sats_len;
+    conjunction_list list = {0};
+    SpiceDouble pairs = 0;
+    SpiceInt candidates = 0;
+
+    step_grid grid;
+    grid.states = malloc(len * sizeof(*grid.states) + 1);
+    grid.status = malloc(len * sizeof(*grid.status) + 1);
+    grid.buckets = malloc(len * sizeof(*grid.buckets) + 1);
+    grid.starts = malloc((job->buckets_len + 1) * sizeof(*grid.starts));
+    grid.order = malloc(len * sizeof(*grid.order) + 1);
+    grid.sorted_states = malloc(len * sizeof(*grid.sorted_states) + 1);
+    grid.sorted_cells = malloc(len * sizeof(*grid.sorted_cells) + 1);
+    grid.sorted_shells = malloc(len * sizeof(*grid.sorted_shells) + 1);
+    SpiceBoolean ok = grid.states != NULL && grid.status != NULL && grid.buckets != NULL && grid.starts != NULL &&
+                      grid.order != NULL && grid.sorted_states != NULL && grid.sorted_cells != NULL &&
+                      grid.sorted_shells != NULL;
+
+    for (SpiceInt k = job->block_begin + begin; ok && k < job->block_begin + end; ++k) {
+        ok = screen_step(job, &grid, k, &list, &pairs, &candidates);
+    }
+
+    pthread_mutex_lock(&job->lock);
+    conjunction_list *found = &job->found;
+    if (ok && found->len + list.len > found->cap) {
+        SpiceInt cap = found->cap == 0 ? INITIAL_CAP : found->cap;
+        while (cap < found->len + list.len) {
+            cap *= 2;
+        }
+
+        gate_conjunction *conjunctions = realloc(found->conjunctions, cap * sizeof(*conjunctions));
+        if (conjunctions != NULL) {
+            found->cap = cap;
+            found->conjunctions = conjunctions;
+        } else {
+            ok = SPICEFALSE;
+        }
+    }
+    if (ok) {
+        memcpy(&found->conjunctions[found->len], list.conjunctions, list.len * sizeof(*list.conjunctions));
+        found->len += list.len;
+        job->pairs += pairs;
+        job->candidates += candidates;
+    } else {
+        job->out_of_memory = SPICETRUE;
+    }
+    pthread_mutex_unlock(&job->lock);
+
+    free(list.conjunctions);
+    free(grid.states);
+    free(grid.status);
+    free(grid.buckets);
+    free(grid.starts);
+    free(grid.order);
+    free(grid.sorted_states);
+    free(grid.sorted_cells);
+    free(grid.sorted_shells);
+}
+
+static int compare_conjunctions(const void *a, const void *b) {
+    const gate_conjunction *ca = a;
+    const gate_conjunction *cb = b;
+    if (ca->tca != cb->tca) {
+        return ca->tca < cb->tca ? -1 : 1;
+    }
+    if (ca->sat_a != cb->sat_a) {
+        return ca->sat_a < cb->sat_a ? -1 : 1;
+    }
+    return ca->sat_b < cb->sat_b ? -1 : ca->sat_b > cb->sat_b;
+}
+
+void gate_screen_conjunctions(gate_pool *pool, SpiceInt sats_len, const gate_sgp4 *sats,
+                              const gate_sgp4_status *init_status, SpiceDouble start_et, SpiceDouble end_et,
+                              SpiceDouble step, SpiceDouble threshold, gate_conjunction_callback callback,
+                              void *user_data, gate_conjunction_stats *stats) {
+    gate_conjunction_stats local_stats = {0};
+    if (stats == NULL) {
+        stats = &local_stats;
+    }
+    memset(stats, 0, sizeof(*stats));
+    if (sats_len <= 0 || end_et <= start_et || step <= 0) {
+        return;
+    }
+
+    gate_sgp4_batch batch;
+    gate_sgp4_batch_init(sats_len, sats, init_status, &batch);
+    if (failed_c()) {
+        return;
+    }
+
+    conjunction_job job = {
+            .sats = sats,
+            .init_status = init_status,
+            .batch = &batch,
+            .sats_len = sats_len,
+            .near_groups = batch.lane_cap / GATE_SGP4_LANES,
+            .start_et = start_et,
+            .end_et = end_et,
+            .step = step,
+            .threshold = threshold,
+            .buckets_len = 1,
+            .out_of_memory = SPICEFALSE
+    };
+    while (job.buckets_len < 2 * sats_len) {
+        job.buckets_len *= 2;
+    }
+
+    job.perigee = malloc(sats_len * sizeof(*job.perigee));
+    job.apogee = malloc(sats_len * sizeof(*job.apogee));
+    if (job.perigee == NULL || job.apogee == NULL) {
+        free(job.perigee);
+        free(job.apogee);
+        gate_sgp4_batch_free(&batch);
+        setmsg_c("Failed to allocate memory for the conjunction job");
+        sigerr_c("alloc");
+        return;
+    }
+
+    for (SpiceInt i = 0; i < sats_len; ++i) {
+        SpiceDouble a = sats[i].ao * GATE_SGP4_RADIUS_EARTH_KM;
+        job.perigee[i] = a * (1.0 - sats[i].ecco) * (1.0 - SHELL_MARGIN_FACTOR) - SHELL_MARGIN_KM;
+        job.apogee[i] = a * (1.0 + sats[i].ecco) * (1.0 + SHELL_MARGIN_FACTOR) + SHELL_MARGIN_KM;
+    }
+
+    SpiceInt steps_len = (SpiceInt) ceil((end_et - start_et) / step) + 1;
+    pthread_mutex_init(&job.lock, NULL);
+    for (SpiceInt block = 0; block < steps_len && !job.out_of_memory; block += BLOCK_STEPS) {
+        SpiceInt block_len = steps_len - block < BLOCK_STEPS ? steps_len - block : BLOCK_STEPS;
+        job.block_begin = block;
+        job.found.len = 0;
+        gate_pool_run(pool, block_len, 1, conjunction_chunk, &job);
+        if (job.out_of_memory) {
+            break;
+        }
+
+        qsort(job.found.conjunctions, job.found.len, sizeof(*job.found.conjunctions), compare_conjunctions);
+        stats->steps += block_len;
+        stats->conjunctions += job.found.len;
+        if (!callback(user_data, job.found.len, job.found.conjunctions)) {
+            break;
+        }
+    }
+    pthread_mutex_destroy(&job.lock);
+
+    stats->pairs = job.pairs;
+    stats->candidates = job.candidates;
+
+    free(job.found.conjunctions);
+    free(job.perigee);
+    free(job.apogee);
+    gate_sgp4_batch_free(&batch);
+
+    if (job.out_of_memory) {
+        setmsg_c("Failed to allocate memory for the close approaches");
+        sigerr_c("alloc");
+    }
+}
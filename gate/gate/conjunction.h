@@ -0,0 +1,150 @@
+/**
+ * @file
+ * Screening of a whole satellite catalog for close
+ * approaches between pairs of satellites.
+ *
+ * Checking every pair of satellites at every time step
+ * is quadratic in the size of the catalog, so pairs are
+ * screened in stages:
+ *
+ * 1. Two satellites can only come close if the spherical
+ * shells between their perigee and apogee radii overlap.
+ * 2. The catalog is propagated on a coarse time step and
+ * the positions at each step are binned into a spatial
+ * hash, so that only satellites in neighboring cells are
+ * compared. A pair is kept if it is close enough that the
+ * two satellites could reach the screening distance within
+ * half a step, given their relative velocity.
+ * 3. The remaining pairs are propagated to both ends of
+ * the half step on either side, and the time of closest
+ * approach is located on a cubic Hermite interpolation of
+ * their relative motion. The miss distance is then
+ * computed from the propagated states at that time.
+ *
+ * Steps are split across the threads of a gate_pool.
+ * Close approaches are handed back to the caller in
+ * blocks of steps as the screening progresses, each block
+ * sorted by the time of closest approach, so that a long
+ * screening can report encounters as they are found.
+ */
+
+#ifndef GATE_CONJUNCTION_H
+#define GATE_CONJUNCTION_H
+
+#include <cspice/SpiceUsr.h>
+#include "pool.h"
+#include "sgp4.h"
+
+/**
+ * The precision in seconds to which the time of closest
+ * approach is located.
+ */
+#define GATE_CONJUNCTION_TIME_TOLERANCE 1e-3
+
+/**
+ * A close approach between two satellites.
+ */
+typedef struct {
+    /**
+     * The indices of the two satellites, where sat_a is
+     * less than sat_b.
+     */
+    SpiceInt sat_a;
+    SpiceInt sat_b;
+
+    /**
+     * The ephemeris time of closest approach.
+     */
+    SpiceDouble tca;
+
+    /**
+     * The distance between the satellites at the time of
+     * closest approach in kilometers.
+     */
+    SpiceDouble miss_distance;
+
+    /**
+     * The relative speed of the satellites at the time of
+     * closest approach in kilometers per second.
+     */
+    SpiceDouble relative_speed;
+} gate_conjunction;
+
+/**
+ * Counts of the pairs which made it through each stage of
+ * the screening.
+ */
+typedef struct {
+    SpiceInt steps;
+
+    /**
+     * The number of pairs compared by distance after the
+     * shell and spatial hash stages, summed over every
+     * step.
+     */
+    SpiceDouble pairs;
+
+    /**
+     * The number of pairs whose closest approach was
+     * refined.
+     */
+    SpiceInt candidates;
+
+    SpiceInt conjunctions;
+} gate_conjunction_stats;
+
+/**
+ * Receives a block of close approaches.
+ *
+ * The callback is invoked on the thread which called
+ * gate_screen_conjunctions(), and so may call into SPICE.
+ *
+ * @param user_data the pointer passed to
+ * gate_screen_conjunctions()
+ * @param len the number of close approaches in the block
+ * @param conjunctions the close approaches, sorted by time
+ * of closest approach
+ * @return SPICETRUE to continue screening, or SPICEFALSE
+ * to stop
+ */
+typedef SpiceBoolean (*gate_conjunction_callback)(void *user_data, SpiceInt len,
+                                                  const gate_conjunction *conjunctions);
+
+/**
+ * Finds every pair of satellites in a catalog which come
+ * within a given distance of each other during a span of
+ * time.
+ *
+ * Satellites which failed to initialize are skipped. A
+ * satellite which fails to propagate at a step is skipped
+ * for that step.
+ *
+ * @param pool the threads to compute on, or NULL to use
+ * the calling thread (input)
+ * @param sats_len the number of satellites (input)
+ * @param sats the initialized propagator states (input)
+ * @param init_status the initialization status of each
+ * satellite (input)
+ * @param start_et the ephemeris time at which to start
+ * (input)
+ * @param end_et the ephemeris time at which to end
+ * (input)
+ * @param step the coarse time step in seconds (input)
+ * @param threshold the miss distance in kilometers under
+ * which a close approach is reported (input)
+ * @param callback the procedure which receives each block
+ * of close approaches, with satellites identified by
+ * their index in sats (input)
+ * @param user_data an arbitrary pointer passed to the
+ * callback (input)
+ * @param stats the number of pairs which made it through
+ * each stage, or NULL if not desired (output)
+ *
+ * @throws alloc if memory could not be allocated
+ */
+void gate_screen_conjunctions(gate_pool *pool, SpiceInt sats_len, const gate_sgp4 *sats,
+                              const gate_sgp4_status *init_status, SpiceDouble start_et, SpiceDouble end_et,
+                              SpiceDouble step, SpiceDouble threshold, gate_conjunction_callback callback,
+                              void *user_data, gate_conjunction_stats *stats);
+
+#endif // GATE_CONJUNCTION_H
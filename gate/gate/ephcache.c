@@ -0,0 +1,262 @@
+#include "ephcache.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define NODES_LEN (GATE_EPH_DEGREE + 1)
+
+// The first fit splits each revolution into this many
+// segments, and the number of segments is doubled until
+// the fit is within the tolerance
+#define SEGMENTS_PER_REV 4
+
+// The error between the check points can be somewhat
+// larger than at them, so fits are held to a fraction of
+// the tolerance
+#define CHECK_MARGIN 0.5
+
+// Segments are never made shorter than this many seconds
+#define MIN_SEGMENT_LEN 30.0
+
+typedef struct {
+    const gate_sgp4 *sats;
+    const gate_sgp4_status *init_status;
+    SpiceDouble start_et;
+    SpiceDouble end_et;
+    SpiceDouble tolerance;
+    size_t memory_budget;
+    gate_eph_entry *entries;
+
+    // The Chebyshev nodes and the cosines used to turn
+    // the values at the nodes into coefficients
+    SpiceDouble nodes[NODES_LEN];
+    SpiceDouble transform[NODES_LEN][NODES_LEN];
+
+    // The extrema of the polynomial of the fit's degree,
+    // at which each fit is checked
+    SpiceDouble checks[NODES_LEN];
+
+    size_t bytes;
+    SpiceInt cached_len;
+    SpiceBoolean out_of_memory;
+} fit_job;
+
+/**
+ * Evaluates the fitted state of a satellite at a time
+ * within its segment.
+ *
+ * The Chebyshev polynomials are evaluated once and shared
+ * by all six components, so that the sums over the
+ * coefficients are independent of each other and can be
+ * vectorized.
+ */
+static void evaluate_segment(ConstSpiceDouble *coefficients, SpiceDouble x, SpiceDouble state[6]) {
+    SpiceDouble t[NODES_LEN];
+    t[0] = 1.0;
+    t[1] = x;
+    for (int j = 2; j < NODES_LEN; ++j) {
+        t[j] = 2.0 * x * t[j - 1] - t[j - 2];
+    }
+
+    SpiceDouble sum[6] = {0.0};
+    for (int j = 0; j < NODES_LEN; ++j) {
+        for (int i = 0; i < 6; ++i) {
+            sum[i] += coefficients[j * 6 + i] * t[j];
+        }
+    }
+    memcpy(state, sum, sizeof(sum));
+}
+
+/**
+ * Fits every segment of a satellite when the span is split
+ * into the given number of segments.
+ *
+ * @return the largest position error found at the check
+ * points, or a negative number if the satellite failed to
+ * propagate
+ */
+static SpiceDouble fit_satellite(const fit_job *job, const gate_sgp4 *sat, SpiceInt segments,
+                                 SpiceDouble *coefficients) {
+    SpiceDouble segment_len = (job->end_et - job->start_et) / segments;
+    SpiceDouble max_error = 0.0;
+
+    for (SpiceInt s = 0; s < segments; ++s) {
+        SpiceDouble mid = job->start_et + (s + 0.5) * segment_len;
+        SpiceDouble *segment = &coefficients[s * GATE_EPH_SEGMENT_LEN];
+
+        SpiceDouble values[NODES_LEN][6];
+        for (int k = 0; k < NODES_LEN; ++k) {
+            if (gate_sgp4_propagate(sat, mid + 0.5 * segment_len * job->nodes[k], values[k]) != GATE_SGP4_OK) {
+                return -1.0;
+            }
+        }
+
+        for (int j = 0; j < NODES_LEN; ++j) {
+            for (int i = 0; i < 6; ++i) {
+                SpiceDouble sum = 0.0;
+                for (int k = 0; k < NODES_LEN; ++k) {
+                    sum += values[k][i] * job->transform[j][k];
+                }
+                segment[j * 6 + i] = sum * (j == 0 ? 1.0 : 2.0) / NODES_LEN;
+            }
+        }
+
+        for (int k = 0; k < NODES_LEN; ++k) {
+            SpiceDouble expected[6];
+            SpiceDouble fitted[6];
+            if (gate_sgp4_propagate(sat, mid + 0.5 * segment_len * job->checks[k], expected) != GATE_SGP4_OK) {
+                return -1.0;
+            }
+            evaluate_segment(segment, job->checks[k], fitted);
+
+            SpiceDouble dx = fitted[0] - expected[0];
+            SpiceDouble dy = fitted[1] - expected[1];
+            SpiceDouble dz = fitted[2] - expected[2];
+            SpiceDouble error = sqrt(dx * dx + dy * dy + dz * dz);
+            if (error > max_error) {
+                max_error = error;
+            }
+        }
+    }
+
+    return max_error;
+}
+
+static void fit_chunk(void *user_data, SpiceInt begin, SpiceInt end) {
+    fit_job *job = user_data;
+    SpiceDouble span = job->end_et - job->start_et;
+    SpiceInt max_segments = (SpiceInt) ceil(span / MIN_SEGMENT_LEN);
+
+    for (SpiceInt i = begin; i < end; ++i) {
+        gate_eph_entry *entry = &job->entries[i];
+        if (job->init_status[i] != GATE_SGP4_OK) {
+            continue;
+        }
+
+        SpiceDouble period = twopi_c() / job->sats[i].no * 60.0;
+        SpiceInt segments = (SpiceInt) ceil(span * SEGMENTS_PER_REV / period);
+        if (segments < 1) {
+            segments = 1;
+        }
+
+        SpiceDouble *coefficients = NULL;
+        SpiceDouble error = -1.0;
+        while (segments <= max_segments) {
+            SpiceDouble *grown = realloc(coefficients, segments * GATE_EPH_SEGMENT_LEN * sizeof(*grown));
+            if (grown == NULL) {
+                job->out_of_memory = SPICETRUE;
+                break;
+            }
+            coefficients = grown;
+
+            error = fit_satellite(job, &job->sats[i], segments, coefficients);
+            if (error < 0.0 || error <= job->tolerance * CHECK_MARGIN) {
+                break;
+            }
+            segments *= 2;
+        }
+
+        if (error < 0.0 || error > job->tolerance * CHECK_MARGIN || segments > max_segments || job->out_of_memory) {
+            free(coefficients);
+            continue;
+        }
+
+        // Claim the memory, and give it back if it does not
+        // fit in the budget
+        size_t bytes = segments * GATE_EPH_SEGMENT_LEN * sizeof(*coefficients);
+        if (__sync_add_and_fetch(&job->bytes, bytes) > job->memory_budget) {
+            __sync_fetch_and_sub(&job->bytes, bytes);
+            free(coefficients);
+            continue;
+        }
+        __sync_fetch_and_add(&job->cached_len, 1);
+
+        entry->segments = segments;
+        entry->segment_len = span / segments;
+        entry->max_error = error;
+        entry->coefficients = coefficients;
+    }
+}
+
+void gate_eph_cache_build(gate_pool *pool, SpiceInt sats_len, const gate_sgp4 *sats,
+                          const gate_sgp4_status *init_status, SpiceDouble start_et, SpiceDouble end_et,
+                          SpiceDouble tolerance, size_t memory_budget, gate_eph_cache *cache) {
+    memset(cache, 0, sizeof(*cache));
+    cache->start_et = start_et;
+    cache->end_et = end_et;
+    cache->tolerance = tolerance;
+    cache->len = sats_len;
+    cache->sats = sats;
+    cache->init_status = init_status;
+
+    cache->entries = calloc(sats_len + 1, sizeof(*cache->entries));
+    if (cache->entries == NULL) {
+        setmsg_c("Failed to allocate memory for the ephemeris cache");
+        sigerr_c("alloc");
+        return;
+    }
+    if (end_et <= start_et) {
+        return;
+    }
+
+    fit_job job = {
+            .sats = sats,
+            .init_status = init_status,
+            .start_et = start_et,
+            .end_et = end_et,
+            .tolerance = tolerance,
+            .memory_budget = memory_budget,
+            .entries = cache->entries,
+            .bytes = 0,
+            .cached_len = 0,
+            .out_of_memory = SPICEFALSE
+    };
+    for (int k = 0; k < NODES_LEN; ++k) {
+        job.nodes[k] = cos(pi_c() * (k + 0.5) / NODES_LEN);
+        job.checks[k] = cos(pi_c() * k / GATE_EPH_DEGREE);
+        for (int j = 0; j < NODES_LEN; ++j) {
+            job.transform[j][k] = cos(pi_c() * j * (k + 0.5) / NODES_LEN);
+        }
+    }
+
+    gate_pool_run(pool, sats_len, 0, fit_chunk, &job);
+
+    cache->bytes = job.bytes;
+    cache->cached_len = job.cached_len;
+    if (job.out_of_memory) {
+        gate_eph_cache_free(cache);
+        setmsg_c("Failed to allocate memory for the ephemeris cache");
+        sigerr_c("alloc");
+    }
+}
+
+gate_sgp4_status gate_eph_cache_state(const gate_eph_cache *cache, SpiceInt sat, SpiceDouble et,
+                                      SpiceDouble state[6]) {
+    const gate_eph_entry *entry = &cache->entries[sat];
+    if (entry->segments == 0 || et < cache->start_et || et > cache->end_et) {
+        if (cache->init_status[sat] != GATE_SGP4_OK) {
+            return cache->init_status[sat];
+        }
+        return gate_sgp4_propagate(&cache->sats[sat], et, state);
+    }
+
+    SpiceDouble offset = (et - cache->start_et) / entry->segment_len;
+    SpiceInt s = (SpiceInt) offset;
+    if (s >= entry->segments) {
+        s = entry->segments - 1;
+    }
+
+    SpiceDouble x = 2.0 * (offset - s) - 1.0;
+    evaluate_segment(&entry->coefficients[s * GATE_EPH_SEGMENT_LEN], x, state);
+    return GATE_SGP4_OK;
+}
+
+void gate_eph_cache_free(gate_eph_cache *cache) {
+    if (cache->entries != NULL) {
+        for (SpiceInt i = 0; i < cache->len; ++i) {
+            free(cache->entries[i].coefficients);
+        }
+    }
+    free(cache->entries);
+    memset(cache, 0, sizeof(*cache));
+}
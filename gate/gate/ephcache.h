@@ -0,0 +1,155 @@
+/**
+ * @file
+ * A cache of satellite trajectories compressed into
+ * piecewise Chebyshev polynomials.
+ *
+ * Queries which repeatedly ask for the same satellites
+ * over the same span of time, such as a dashboard that is
+ * redrawn every second or a pass replayed for several
+ * stations, spend most of their time re-running SGP4. A
+ * gate_eph_cache instead propagates each satellite once
+ * at the Chebyshev nodes of a set of equal segments
+ * covering the span, and afterwards serves any time in the
+ * span by evaluating the fitted polynomials.
+ *
+ * The number of segments of each satellite is chosen so
+ * that the fitted positions agree with the propagator to
+ * within half of a tolerance at the extrema of the
+ * Chebyshev polynomial of the fit's degree in every
+ * segment, which is where the error of the fit peaks.
+ * Satellites which cannot be fitted, or which no longer
+ * fit within the memory budget of the cache, are served by
+ * propagating them instead.
+ */
+
+#ifndef GATE_EPHCACHE_H
+#define GATE_EPHCACHE_H
+
+#include <cspice/SpiceUsr.h>
+#include <stddef.h>
+#include "pool.h"
+#include "sgp4.h"
+
+/**
+ * The degree of the polynomial fitted to each coordinate
+ * over each segment.
+ */
+#define GATE_EPH_DEGREE 9
+
+/**
+ * The number of doubles stored per segment. Positions and
+ * velocities are fitted separately, rather than velocities
+ * being derived from the position polynomials, and the
+ * coefficients of the same degree for all six components
+ * are stored together.
+ */
+#define GATE_EPH_SEGMENT_LEN (6 * (GATE_EPH_DEGREE + 1))
+
+/**
+ * The fitted trajectory of a single satellite.
+ */
+typedef struct {
+    /**
+     * The number of equal segments the span is split
+     * into, or 0 if the satellite is not cached.
+     */
+    SpiceInt segments;
+    SpiceDouble segment_len;
+
+    /**
+     * The largest position error in kilometers found when
+     * checking the fit.
+     */
+    SpiceDouble max_error;
+
+    /**
+     * GATE_EPH_SEGMENT_LEN coefficients per segment.
+     */
+    SpiceDouble *coefficients;
+} gate_eph_entry;
+
+/**
+ * Represents the cached trajectories of a set of
+ * satellites over a span of time.
+ *
+ * The cache keeps pointers to the propagator states that
+ * it was built from, which must outlive it.
+ */
+typedef struct {
+    SpiceDouble start_et;
+    SpiceDouble end_et;
+    SpiceDouble tolerance;
+
+    SpiceInt len;
+    const gate_sgp4 *sats;
+    const gate_sgp4_status *init_status;
+    gate_eph_entry *entries;
+
+    /**
+     * The number of satellites that are cached, and the
+     * number of bytes of coefficients that they use.
+     */
+    SpiceInt cached_len;
+    size_t bytes;
+} gate_eph_cache;
+
+/**
+ * Fits the trajectories of a set of satellites over a span
+ * of time.
+ *
+ * Satellites are fitted in parallel, and each claims its
+ * share of the memory budget once it has been fitted, so
+ * which satellites are left out when the budget runs out
+ * depends on the order in which the threads finish.
+ *
+ * @param pool the threads to fit on, or NULL to use the
+ * calling thread (input)
+ * @param sats_len the number of satellites (input)
+ * @param sats the initialized propagator states (input)
+ * @param init_status the initialization status of each
+ * satellite (input)
+ * @param start_et the ephemeris time at which the span
+ * starts (input)
+ * @param end_et the ephemeris time at which the span ends
+ * (input)
+ * @param tolerance the largest position error in
+ * kilometers to accept from a fit (input)
+ * @param memory_budget the largest number of bytes of
+ * coefficients to store (input)
+ * @param cache the cache (output)
+ *
+ * @throws alloc if memory could not be allocated
+ */
+void gate_eph_cache_build(gate_pool *pool, SpiceInt sats_len, const gate_sgp4 *sats,
+                          const gate_sgp4_status *init_status, SpiceDouble start_et, SpiceDouble end_et,
+                          SpiceDouble tolerance, size_t memory_budget, gate_eph_cache *cache);
+
+/**
+ * Obtains the state of a satellite from the cache, or by
+ * propagating it if it is not cached or the time is
+ * outside of the span of the cache.
+ *
+ * Like gate_sgp4_propagate(), this procedure does not call
+ * into SPICE and may be used concurrently from any number
+ * of threads.
+ *
+ * @param cache the cache (input)
+ * @param sat the index of the satellite (input)
+ * @param et the ephemeris time (input)
+ * @param state the state of the satellite, see
+ * gate_sgp4_propagate() (output)
+ * @return the result of propagating the satellite, which
+ * is always GATE_SGP4_OK when the state comes from the
+ * cache
+ */
+gate_sgp4_status gate_eph_cache_state(const gate_eph_cache *cache, SpiceInt sat, SpiceDouble et,
+                                      SpiceDouble state[6]);
+
+/**
+ * Frees all memory held by a cache.
+ *
+ * @param cache the cache to free (input/output)
+ */
+void gate_eph_cache_free(gate_eph_cache *cache);
+
+#endif // GATE_EPHCACHE_H
@@ -0,0 +1,422 @@
+#include "events.h"
+#include <float.h>
+#include <math.h>
+
+// Rotation rate of the Earth relative to the stars in
+// radians per second
+#define SIDEREAL_RATE 7.2921158553e-5
+
+// The coarse search for the events of bodies steps by this
+// many seconds, which is well below the time between
+// consecutive events of the Moon
+#define BODY_STEP_SEC 3600.0
+
+#define ROOT_MAX_ITERATIONS 100
+
+/**
+ * The position of an object in the sky of the observer at
+ * a point in time.
+ */
+typedef struct {
+    SpiceDouble et;
+    SpiceDouble azimuth;
+    SpiceDouble elevation;
+
+    /**
+     * The rate of change of the elevation in degrees per
+     * second.
+     */
+    SpiceDouble elevation_rate;
+
+    /**
+     * The local hour angle in radians between -pi and pi,
+     * increasing to the west, and the declination in
+     * radians.
+     */
+    SpiceDouble hour_angle;
+    SpiceDouble declination;
+} look;
+
+typedef struct {
+    gate_topo_frame observer;
+    SpiceDouble horizon;
+    SpiceDouble start_et;
+    SpiceDouble end_et;
+
+    gate_radec_fn radec;
+    void *user_data;
+    gate_abcorr abcorr;
+    gate_body_track *track;
+
+    SpiceInt events_len;
+    SpiceInt found;
+    gate_event *events;
+} event_search;
+
+typedef enum {
+    ROOT_ELEVATION,
+    ROOT_ELEVATION_RATE
+} root_kind;
+
+/**
+ * Fills in a look from the state of an object in the
+ * topographic frame of the observer, which has its x axis
+ * to the north, its y axis to the west and its z axis to
+ * the zenith.
+ */
+static void to_look(const event_search *search, SpiceDouble et, ConstSpiceDouble state[6], look *out) {
+    SpiceDouble horizontal = sqrt(state[0] * state[0] + state[1] * state[1]);
+    SpiceDouble horizontal_rate = (state[0] * state[3] + state[1] * state[4]) / horizontal;
+    SpiceDouble range = vnorm_c(state);
+
+    out->et = et;
+    gate_conv_rec_azel((SpiceDouble *) state, NULL, &out->azimuth, &out->elevation);
+    out->elevation_rate = (state[5] * horizontal - state[2] * horizontal_rate) / (range * range) * dpr_c();
+
+    // Tilting the frame about its y axis by the colatitude
+    // turns the z axis towards the celestial pole
+    SpiceDouble latitude = search->observer.latitude * rpd_c();
+    SpiceDouble towards_pole = state[0] * cos(latitude) + state[2] * sin(latitude);
+    SpiceDouble towards_equator = -state[0] * sin(latitude) + state[2] * cos(latitude);
+    out->hour_angle = atan2(state[1], towards_equator);
+    out->declination = asin(towards_pole / range);
+}
+
+static void add_event(event_search *search, gate_event_kind kind, const look *l) {
+    if (search->found == search->events_len || l->et < search->start_et || l->et > search->end_et) {
+        return;
+    }
+
+    gate_event *event = &search->events[search->found++];
+    event->kind = kind;
+    event->et = l->et;
+    event->azimuth = l->azimuth;
+    event->elevation = l->elevation;
+}
+
+static void look_fixed(const event_search *search, SpiceDouble et, look *out) {
+    SpiceDouble ra;
+    SpiceDouble dec;
+    search->radec(search->user_data, et, &ra, &dec);
+
+    SpiceDouble state_j2000[6] = {0.0};
+    radrec_c(1.0, ra * rpd_c(), dec * rpd_c(), state_j2000);
+    if (gate_abcorr_stellar(search->abcorr)) {
+        SpiceDouble velocity[3];
+        gate_observer_velocity(search->observer.body_id, et, velocity);
+
+        SpiceDouble apparent[3];
+        stelab_c(state_j2000, velocity, apparent);
+        vequ_c(apparent, state_j2000);
+    }
+
+    SpiceDouble transform[6][6];
+    SpiceDouble state[6];
+    sxform_c("J2000", search->observer.frame_name, et, transform);
+    mxvg_c(transform, state_j2000, 6, 6, state);
+    to_look(search, et, state, out);
+}
+
+/**
+ * Refines the time at which a fixed object crosses the
+ * horizon with a Newton step on its exact elevation.
+ */
+static void refine_crossing(const event_search *search, SpiceDouble et, look *out) {
+    look l;
+    look_fixed(search, et, &l);
+    if (l.elevation_rate != 0.0) {
+        et -= (l.elevation - search->horizon) / l.elevation_rate;
+    }
+
+    look_fixed(search, et, out);
+}
+
+/**
+ * Refines the time at which a fixed object transits with a
+ * Newton step on its exact hour angle.
+ */
+static void refine_transit(const event_search *search, SpiceDouble et, look *out) {
+    look l;
+    look_fixed(search, et, &l);
+    look_fixed(search, et - l.hour_angle / SIDEREAL_RATE, out);
+}
+
+SpiceInt gate_fixed_events(gate_topo_frame observer, gate_radec_fn radec, void *user_data, gate_abcorr abcorr,
+                           SpiceDouble start_et, SpiceDouble end_et, SpiceDouble horizon, SpiceInt events_len,
+                           gate_event *events) {
+    event_search search = {
+            .observer = observer,
+            .horizon = horizon,
+            .start_et = start_et,
+            .end_et = end_et,
+            .radec = radec,
+            .user_data = user_data,
+            .abcorr = abcorr,
+            .track = NULL,
+            .events_len = events_len,
+            .found = 0,
+            .events = events
+    };
+    if (events_len <= 0) {
+        return 0;
+    }
+
+    look start;
+    look_fixed(&search, start_et, &start);
+    if (failed_c()) {
+        return 0;
+    }
+
+    SpiceDouble sidereal_day = twopi_c() / SIDEREAL_RATE;
+    SpiceDouble latitude = observer.latitude * rpd_c();
+    SpiceDouble sin_horizon = sin(horizon * rpd_c());
+
+    // The transit of the current turn, which may already
+    // have passed while the object is yet to set
+    SpiceDouble transit_et = start_et - start.hour_angle / SIDEREAL_RATE;
+    while (transit_et - 0.5 * sidereal_day <= end_et && search.found < events_len) {
+        look transit;
+        refine_transit(&search, transit_et, &transit);
+        if (failed_c()) {
+            break;
+        }
+
+        // The hour angle at which the object crosses the
+        // horizon on either side of the meridian
+        SpiceDouble cos_half_arc = (sin_horizon - sin(latitude) * sin(transit.declination)) /
+                                   (cos(latitude) * cos(transit.declination));
+        SpiceBoolean crosses = cos_half_arc > -1.0 && cos_half_arc < 1.0;
+        SpiceDouble half_arc = crosses ? acos(cos_half_arc) / SIDEREAL_RATE : 0.0;
+
+        if (crosses) {
+            look rise;
+            refine_crossing(&search, transit.et - half_arc, &rise);
+            add_event(&search, GATE_EVENT_RISE, &rise);
+        }
+
+        add_event(&search, GATE_EVENT_TRANSIT, &transit);
+
+        if (crosses) {
+            look set;
+            refine_crossing(&search, transit.et + half_arc, &set);
+            add_event(&search, GATE_EVENT_SET, &set);
+        }
+
+        transit_et = transit.et + sidereal_day;
+    }
+
+    return search.found;
+}
+
+static SpiceBoolean look_body(event_search *search, SpiceDouble et, look *out) {
+    SpiceDouble state_j2000[6];
+    gate_body_track_state(search->track, et, state_j2000);
+
+    SpiceDouble transform[6][6];
+    SpiceDouble state[6];
+    sxform_c("J2000", search->observer.frame_name, et, transform);
+    if (failed_c()) {
+        return SPICEFALSE;
+    }
+    mxvg_c(transform, state_j2000, 6, 6, state);
+    gate_adjust_topo_rec(search->observer, state);
+
+    to_look(search, et, state, out);
+    return SPICETRUE;
+}
+
+static SpiceDouble root_value(const event_search *search, root_kind kind, const look *l) {
+    if (kind == ROOT_ELEVATION) {
+        return l->elevation - search->horizon;
+    }
+
+    return l->elevation_rate;
+}
+
+/**
+ * Locates the time between two looks at which the
+ * elevation crosses the horizon, or at which the elevation
+ * rate crosses zero, using Brent's method.
+ *
+ * @return SPICEFALSE if the body could not be looked up
+ */
+static SpiceBoolean find_root(event_search *search, root_kind kind, const look *lower, const look *upper,
+                              look *root) {
+    SpiceDouble a = lower->et;
+    SpiceDouble b = upper->et;
+    SpiceDouble fa = root_value(search, kind, lower);
+    SpiceDouble fb = root_value(search, kind, upper);
+    SpiceDouble c = b;
+    SpiceDouble fc = fb;
+    SpiceDouble d = b - a;
+    SpiceDouble e = d;
+
+    for (int i = 0; i < ROOT_MAX_ITERATIONS; ++i) {
+        if ((fb > 0.0 && fc > 0.0) || (fb < 0.0 && fc < 0.0)) {
+            c = a;
+            fc = fa;
+            d = b - a;
+            e = d;
+        }
+        if (fabs(fc) < fabs(fb)) {
+            a = b;
+            b = c;
+            c = a;
+            fa = fb;
+            fb = fc;
+            fc = fa;
+        }
+
+        SpiceDouble tol = 2.0 * DBL_EPSILON * fabs(b) + 0.5 * GATE_EVENT_TIME_TOLERANCE;
+        SpiceDouble xm = 0.5 * (c - b);
+        if (fabs(xm) <= tol || fb == 0.0) {
+            break;
+        }
+
+        if (fabs(e) >= tol && fabs(fa) > fabs(fb)) {
+            // Inverse quadratic interpolation, or the secant
+            // method if only two points are known
+            SpiceDouble p;
+            SpiceDouble q;
+            SpiceDouble s = fb / fa;
+            if (a == c) {
+                p = 2.0 * xm * s;
+                q = 1.0 - s;
+            } else {
+                SpiceDouble r = fb / fc;
+                q = fa / fc;
+                p = s * (2.0 * xm * q * (q - r) - (b - a) * (r - 1.0));
+                q = (q - 1.0) * (r - 1.0) * (s - 1.0);
+            }
+            if (p > 0.0) {
+                q = -q;
+            }
+            p = fabs(p);
+
+            SpiceDouble min1 = 3.0 * xm * q - fabs(tol * q);
+            SpiceDouble min2 = fabs(e * q);
+            if (2.0 * p < (min1 < min2 ? min1 : min2)) {
+                e = d;
+                d = p / q;
+            } else {
+                d = xm;
+                e = d;
+            }
+        } else {
+            d = xm;
+            e = d;
+        }
+
+        a = b;
+        fa = fb;
+        b += fabs(d) > tol ? d : (xm > 0.0 ? tol : -tol);
+
+        look next;
+        if (!look_body(search, b, &next)) {
+            return SPICEFALSE;
+        }
+        fb = root_value(search, kind, &next);
+    }
+
+    return look_body(search, b, root);
+}
+
+/**
+ * Finds a rise or set between two looks, between which the
+ * elevation is assumed to be monotonic.
+ */
+static SpiceBoolean search_crossing(event_search *search, const look *from, const look *to) {
+    SpiceBoolean from_above = from->elevation >= search->horizon;
+    SpiceBoolean to_above = to->elevation >= search->horizon;
+    if (from_above == to_above) {
+        return SPICETRUE;
+    }
+
+    look crossing;
+    if (!find_root(search, ROOT_ELEVATION, from, to, &crossing)) {
+        return SPICEFALSE;
+    }
+
+    add_event(search, to_above ? GATE_EVENT_RISE : GATE_EVENT_SET, &crossing);
+    return SPICETRUE;
+}
+
+/**
+ * Finds the events between two consecutive looks of the
+ * coarse search, splitting the step where the elevation
+ * peaks or bottoms out.
+ */
+static SpiceBoolean search_step(event_search *search, const look *from, const look *to) {
+    SpiceBoolean peaks = from->elevation_rate > 0.0 && to->elevation_rate <= 0.0;
+    SpiceBoolean bottoms = from->elevation_rate < 0.0 && to->elevation_rate >= 0.0;
+    if (!peaks && !bottoms) {
+        return search_crossing(search, from, to);
+    }
+
+    look turn;
+    if (!find_root(search, ROOT_ELEVATION_RATE, from, to, &turn)) {
+        return SPICEFALSE;
+    }
+
+    if (!search_crossing(search, from, &turn)) {
+        return SPICEFALSE;
+    }
+    if (peaks) {
+        add_event(search, GATE_EVENT_TRANSIT, &turn);
+    }
+
+    return search_crossing(search, &turn, to);
+}
+
+SpiceInt gate_body_events(gate_body_track *track, gate_topo_frame observer, SpiceDouble start_et,
+                          SpiceDouble end_et, SpiceDouble horizon, SpiceInt events_len, gate_event *events) {
+    event_search search = {
+            .observer = observer,
+            .horizon = horizon,
+            .start_et = start_et,
+            .end_et = end_et,
+            .radec = NULL,
+            .user_data = NULL,
+            .track = track,
+            .events_len = events_len,
+            .found = 0,
+            .events = events
+    };
+    if (events_len <= 0) {
+        return 0;
+    }
+
+    look prev;
+    if (!look_body(&search, start_et, &prev)) {
+        return 0;
+    }
+
+    while (prev.et < end_et && search.found < events_len) {
+        SpiceDouble next_et = prev.et + BODY_STEP_SEC;
+        if (next_et > end_et) {
+            next_et = end_et;
+        }
+
+        look next;
+        if (!look_body(&search, next_et, &next) || !search_step(&search, &prev, &next)) {
+            break;
+        }
+
+        prev = next;
+    }
+
+    return search.found;
+}
+
+ConstSpiceChar *gate_event_kind_string(gate_event_kind kind) {
+    switch (kind) {
+        case GATE_EVENT_RISE:
+            return "RISE";
+        case GATE_EVENT_TRANSIT:
+            return "TRANSIT";
+        case GATE_EVENT_SET:
+            return "SET";
+        default:
+            return "UNKNOWN";
+    }
+}
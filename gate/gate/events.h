@@ -0,0 +1,154 @@
+/**
+ * @file
+ * Rising, transit and setting times of stars, custom
+ * objects and bodies as seen by an observer.
+ *
+ * An object rises when its elevation climbs above a given
+ * horizon elevation, transits when it crosses the meridian
+ * at its highest elevation, and sets when its elevation
+ * falls below the horizon again.
+ *
+ * Objects which are practically fixed on the celestial
+ * sphere, such as stars, turn about the celestial pole at
+ * the sidereal rate, so the hour angles at which they rise
+ * and set follow in closed form from their declination
+ * and the latitude of the observer. Each predicted time is
+ * then refined once with a Newton step on the exact
+ * elevation or hour angle, which leaves an error of a few
+ * milliseconds.
+ *
+ * Bodies move too far over a day for that, so their
+ * apparent states are looked up from a gate_body_track
+ * fitted over windows of several days. The elevation and
+ * its rate are stepped through hourly to bracket each
+ * event, which is then located to within
+ * GATE_EVENT_TIME_TOLERANCE seconds by Brent's method.
+ *
+ * Elevations are geometric, so refraction and the size of
+ * the disk of a body should be accounted for in the
+ * horizon elevation.
+ */
+
+#ifndef GATE_EVENTS_H
+#define GATE_EVENTS_H
+
+#include <cspice/SpiceUsr.h>
+#include "abcorr.h"
+#include "bodytrack.h"
+#include "topo.h"
+
+/**
+ * The precision in seconds to which the times of the
+ * events of bodies are located.
+ */
+#define GATE_EVENT_TIME_TOLERANCE 1e-3
+
+/**
+ * The kinds of events of an object in the sky.
+ */
+typedef enum {
+    GATE_EVENT_RISE = 0,
+    GATE_EVENT_TRANSIT,
+    GATE_EVENT_SET
+} gate_event_kind;
+
+/**
+ * An event of an object in the sky.
+ *
+ * Azimuths and elevations are in degrees, following
+ * gate_conv_rec_azel().
+ */
+typedef struct {
+    gate_event_kind kind;
+    SpiceDouble et;
+    SpiceDouble azimuth;
+    SpiceDouble elevation;
+} gate_event;
+
+/**
+ * Obtains the right ascension and declination of an
+ * object in the J2000 frame at a time, such as
+ * gate_calc_star_pos().
+ *
+ * @param user_data the user data passed along to the
+ * event search (input)
+ * @param et the ephemeris time (input)
+ * @param ra the right ascension in degrees (output)
+ * @param dec the declination in degrees (output)
+ */
+typedef void (*gate_radec_fn)(void *user_data, SpiceDouble et, SpiceDouble *ra, SpiceDouble *dec);
+
+/**
+ * Finds the events of an object at a practically infinite
+ * distance within a span of time.
+ *
+ * Transits are found even when the object stays below the
+ * horizon, while objects which never rise or never set
+ * only have transits.
+ *
+ * If more events occur than there is room for, the search
+ * stops at the last event that fits and may be continued
+ * from shortly after it.
+ *
+ * @param observer the topographic frame of the observer
+ * (input)
+ * @param radec the position of the object (input)
+ * @param user_data passed along to radec (input)
+ * @param abcorr the level of aberration correction, of
+ * which only stellar aberration applies, see
+ * gate_calc_star_topo() (input)
+ * @param start_et the ephemeris time at which to start
+ * searching (input)
+ * @param end_et the ephemeris time at which to stop
+ * searching (input)
+ * @param horizon the elevation of the horizon in degrees
+ * (input)
+ * @param events_len the maximum number of events to find
+ * (input)
+ * @param events the events found, in order of time
+ * (output)
+ * @return the number of events found
+ */
+SpiceInt gate_fixed_events(gate_topo_frame observer, gate_radec_fn radec, void *user_data, gate_abcorr abcorr,
+                           SpiceDouble start_et, SpiceDouble end_et, SpiceDouble horizon, SpiceInt events_len,
+                           gate_event *events);
+
+/**
+ * Finds the events of a body within a span of time.
+ *
+ * The track must have been initialized for the J2000 frame
+ * with the body of the observer as the observer, so that
+ * the windows it fits are several days long. Its window
+ * length and tolerance should be chosen accordingly.
+ *
+ * If more events occur than there is room for, the search
+ * stops at the last event that fits and may be continued
+ * from shortly after it.
+ *
+ * @param track the track of the body (input/output)
+ * @param observer the topographic frame of the observer
+ * (input)
+ * @param start_et the ephemeris time at which to start
+ * searching (input)
+ * @param end_et the ephemeris time at which to stop
+ * searching (input)
+ * @param horizon the elevation of the horizon in degrees
+ * (input)
+ * @param events_len the maximum number of events to find
+ * (input)
+ * @param events the events found, in order of time
+ * (output)
+ * @return the number of events found
+ */
+SpiceInt gate_body_events(gate_body_track *track, gate_topo_frame observer, SpiceDouble start_et,
+                          SpiceDouble end_et, SpiceDouble horizon, SpiceInt events_len, gate_event *events);
+
+/**
+ * Obtains a human readable name of a kind of event.
+ *
+ * @param kind the kind of event (input)
+ * @return a static string naming the kind of event
+ */
+ConstSpiceChar *gate_event_kind_string(gate_event_kind kind);
+
+#endif // GATE_EVENTS_H
@@ -0,0 +1,165 @@
+#include "groundtrack.h"
+#include <math.h>
+#include <stdlib.h>
+
+#define EARTH_BODY_ID 399
+#define FRAME_NAME_MAX_LEN 33
+
+// Iterations of the fixed point latitude solution, which
+// converges to well under a millimeter from the surface to
+// beyond geostationary altitude
+#define LATITUDE_ITERATIONS 4
+
+typedef struct {
+    const gate_sgp4 *sats;
+    const gate_sgp4_status *init_status;
+    SpiceInt ets_len;
+    ConstSpiceDouble *ets;
+    SpiceDouble (*rotations)[3][3];
+
+    SpiceDouble equatorial_radius;
+    SpiceDouble e2;
+    SpiceBoolean footprint;
+    SpiceDouble min_elevation;
+
+    gate_ground_point *points;
+    gate_sgp4_status *status;
+    SpiceInt failed;
+} track_job;
+
+/**
+ * Converts a body-fixed position to geodetic coordinates,
+ * equivalent to recgeo_c() without going through SPICE so
+ * that it may run on any thread.
+ */
+static void to_geodetic(const track_job *job, ConstSpiceDouble pos[3], gate_ground_point *point) {
+    SpiceDouble a = job->equatorial_radius;
+    SpiceDouble e2 = job->e2;
+    SpiceDouble p = sqrt(pos[0] * pos[0] + pos[1] * pos[1]);
+
+    SpiceDouble latitude = atan2(pos[2], p * (1 - e2));
+    for (int i = 0; i < LATITUDE_ITERATIONS; ++i) {
+        SpiceDouble sin_lat = sin(latitude);
+        SpiceDouble n = a / sqrt(1 - e2 * sin_lat * sin_lat);
+        latitude = atan2(pos[2] + e2 * n * sin_lat, p);
+    }
+
+    // Stable at the poles, unlike p / cos(latitude) - n
+    SpiceDouble sin_lat = sin(latitude);
+    point->altitude = p * cos(latitude) + pos[2] * sin_lat - a * sqrt(1 - e2 * sin_lat * sin_lat);
+    point->latitude = latitude * dpr_c();
+    point->longitude = atan2(pos[1], pos[0]) * dpr_c();
+}
+
+/**
+ * Computes the radius along the surface of the Earth of
+ * the circle within which a satellite at the given
+ * distance from the center of the Earth is above the
+ * minimum elevation, treating the Earth as a sphere of its
+ * equatorial radius.
+ */
+static SpiceDouble footprint_radius(const track_job *job, SpiceDouble distance) {
+    SpiceDouble ratio = job->equatorial_radius * cos(job->min_elevation) / distance;
+    if (ratio >= 1) {
+        return 0;
+    }
+
+    return job->equatorial_radius * (acos(ratio) - job->min_elevation);
+}
+
+static void track_chunk(void *user_data, SpiceInt begin, SpiceInt end) {
+    track_job *job = user_data;
+    SpiceInt failed = 0;
+
+    for (SpiceInt i = begin; i < end; ++i) {
+        SpiceInt offset = i * job->ets_len;
+
+        for (SpiceInt j = 0; j < job->ets_len; ++j) {
+            SpiceDouble state[6];
+            gate_sgp4_status status = job->init_status[i];
+            if (status == GATE_SGP4_OK) {
+                status = gate_sgp4_propagate(&job->sats[i], job->ets[j], state);
+            }
+
+            job->status[offset + j] = status;
+            if (status != GATE_SGP4_OK) {
+                failed++;
+                continue;
+            }
+
+            SpiceDouble pos[3];
+            for (int r = 0; r < 3; ++r) {
+                pos[r] = job->rotations[j][r][0] * state[0] + job->rotations[j][r][1] * state[1] +
+                         job->rotations[j][r][2] * state[2];
+            }
+
+            gate_ground_point *point = &job->points[offset + j];
+            to_geodetic(job, pos, point);
+            point->footprint_radius = 0;
+            if (job->footprint) {
+                SpiceDouble distance = sqrt(pos[0] * pos[0] + pos[1] * pos[1] + pos[2] * pos[2]);
+                point->footprint_radius = footprint_radius(job, distance);
+            }
+        }
+    }
+
+    __sync_fetch_and_add(&job->failed, failed);
+}
+
+SpiceInt gate_ground_tracks(gate_pool *pool, SpiceInt len, const gate_sgp4 *sats,
+                            const gate_sgp4_status *init_status, SpiceInt ets_len, ConstSpiceDouble *ets,
+                            SpiceBoolean footprint, SpiceDouble min_elevation, gate_ground_point *points,
+                            gate_sgp4_status *status) {
+    SpiceInt earth_frame_id;
+    SpiceChar earth_frame[FRAME_NAME_MAX_LEN];
+    SpiceBoolean earth_frame_found;
+    cidfrm_c(EARTH_BODY_ID, FRAME_NAME_MAX_LEN, &earth_frame_id, earth_frame, &earth_frame_found);
+    if (!earth_frame_found) {
+        setmsg_c("Earth fixed frame cannot be found");
+        sigerr_c("resolve_rel_frame");
+        return 0;
+    }
+
+    SpiceInt returned_count;
+    SpiceDouble radii[3];
+    bodvcd_c(EARTH_BODY_ID, "RADII", 3, &returned_count, radii);
+    if (failed_c()) {
+        return 0;
+    }
+
+    track_job job = {
+            .sats = sats,
+            .init_status = init_status,
+            .ets_len = ets_len,
+            .ets = ets,
+            .equatorial_radius = radii[0],
+            .footprint = footprint,
+            .min_elevation = min_elevation * rpd_c(),
+            .points = points,
+            .status = status,
+            .failed = 0
+    };
+    SpiceDouble flattening = (radii[0] - radii[2]) / radii[0];
+    job.e2 = flattening * (2 - flattening);
+
+    job.rotations = malloc(ets_len * sizeof(*job.rotations) + 1);
+    if (job.rotations == NULL) {
+        setmsg_c("Failed to allocate memory for the ground track rotations");
+        sigerr_c("alloc");
+        return 0;
+    }
+
+    // One rotation per epoch, shared by the whole catalog
+    for (SpiceInt j = 0; j < ets_len; ++j) {
+        pxform_c("J2000", earth_frame, ets[j], job.rotations[j]);
+    }
+    if (failed_c()) {
+        free(job.rotations);
+        return 0;
+    }
+
+    gate_pool_run(pool, len, 0, track_chunk, &job);
+
+    free(job.rotations);
+    return job.failed;
+}
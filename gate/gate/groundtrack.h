@@ -0,0 +1,98 @@
+/**
+ * @file
+ * Ground tracks and coverage footprints of satellite
+ * catalogs.
+ *
+ * The ground track of a satellite is the path of the
+ * point on the surface of the Earth directly below it. It
+ * is computed by propagating the satellite, rotating its
+ * position into the body-fixed frame of the Earth and
+ * converting it to geodetic coordinates on the reference
+ * ellipsoid.
+ *
+ * The rotation into the body-fixed frame only depends on
+ * the epoch, so it is computed once per epoch of the time
+ * grid on the calling thread, and then shared by every
+ * satellite while the catalog is split across the threads
+ * of a gate_pool.
+ */
+
+#ifndef GATE_GROUNDTRACK_H
+#define GATE_GROUNDTRACK_H
+
+#include <cspice/SpiceUsr.h>
+#include "pool.h"
+#include "sgp4.h"
+
+/**
+ * A point of the ground track of a satellite.
+ */
+typedef struct {
+    /**
+     * The geodetic latitude and longitude in degrees of
+     * the sub-satellite point, with the longitude between
+     * -180 and 180 degrees.
+     */
+    SpiceDouble latitude;
+    SpiceDouble longitude;
+
+    /**
+     * The height in kilometers of the satellite above the
+     * reference ellipsoid.
+     */
+    SpiceDouble altitude;
+
+    /**
+     * The radius in kilometers, measured along the surface
+     * of the Earth from the sub-satellite point, of the
+     * circle from within which the satellite is above the
+     * minimum elevation, or 0 if footprints were not
+     * requested.
+     */
+    SpiceDouble footprint_radius;
+} gate_ground_point;
+
+/**
+ * Computes the ground tracks of every satellite in a
+ * catalog over a grid of epochs.
+ *
+ * The output is laid out satellite by satellite, as in
+ * gate_catalog_propagate_grid(), so the point of
+ * satellite `i` at epoch `j` is at index
+ * `i * ets_len + j`. Points which could not be computed
+ * are left unmodified and have a failure status.
+ *
+ * Requires a kernel providing the body-fixed frame of the
+ * Earth, such as a high precision binary PCK for ITRF93
+ * along with the frame kernel associating it with the
+ * Earth, or a text PCK for IAU_EARTH.
+ *
+ * @param pool the threads to compute on, or NULL to use
+ * the calling thread (input)
+ * @param len the number of satellites (input)
+ * @param sats the initialized propagator states (input)
+ * @param init_status the initialization status of each
+ * satellite (input)
+ * @param ets_len the number of epochs (input)
+ * @param ets the ephemeris times of the grid (input)
+ * @param footprint whether to compute the footprint
+ * radius of each point (input)
+ * @param min_elevation the minimum elevation in degrees
+ * which bounds the footprint (input)
+ * @param points the point of each satellite at each
+ * epoch, with room for len * ets_len entries (output)
+ * @param status the result of each propagation, with room
+ * for len * ets_len entries (output)
+ * @return the number of points which could not be
+ * computed
+ *
+ * @throws resolve_rel_frame if the body-fixed frame of the
+ * Earth cannot be found
+ * @throws alloc if memory could not be allocated
+ */
+SpiceInt gate_ground_tracks(gate_pool *pool, SpiceInt len, const gate_sgp4 *sats,
+                            const gate_sgp4_status *init_status, SpiceInt ets_len, ConstSpiceDouble *ets,
+                            SpiceBoolean footprint, SpiceDouble min_elevation, gate_ground_point *points,
+                            gate_sgp4_status *status);
+
+#endif // GATE_GROUNDTRACK_H
@@ -0,0 +1,103 @@
+#include "idindex.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define INITIAL_CAP 16
+
+uint64_t gate_id_index_hash(ConstSpiceChar *id) {
+    uint64_t h = 14695981039346656037ULL;
+    for (const unsigned char *c = (const unsigned char *) id; *c != '\0'; ++c) {
+        h ^= *c;
+        h *= 1099511628211ULL;
+    }
+
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+
+    return h;
+}
+
+SpiceInt gate_id_index_find_slot(const gate_id_index *index, ConstSpiceChar *ids, size_t id_stride,
+                                 ConstSpiceChar *id, uint64_t hash) {
+    SpiceInt mask = index->cap - 1;
+    for (SpiceInt slot = (SpiceInt) (hash & mask);; slot = (slot + 1) & mask) {
+        SpiceInt handle = index->handles[slot];
+        if (handle == -1) {
+            return slot;
+        }
+
+        if (index->hashes[slot] == hash && strcmp(ids + handle * id_stride, id) == 0) {
+            return slot;
+        }
+    }
+}
+
+SpiceBoolean gate_id_index_reserve(gate_id_index *index, ConstSpiceChar *ids, size_t id_stride, SpiceInt len,
+                                   SpiceInt cap) {
+    // Keep the index at most half full so that linear
+    // probe sequences stay short
+    SpiceInt new_cap = index->cap == 0 ? INITIAL_CAP : index->cap;
+    while (new_cap < cap * 2) {
+        new_cap *= 2;
+    }
+
+    if (new_cap == index->cap) {
+        return SPICETRUE;
+    }
+
+    uint64_t *hashes = malloc(new_cap * sizeof(*hashes));
+    SpiceInt *handles = malloc(new_cap * sizeof(*handles));
+    if (hashes == NULL || handles == NULL) {
+        free(hashes);
+        free(handles);
+        return SPICEFALSE;
+    }
+
+    for (SpiceInt i = 0; i < new_cap; ++i) {
+        handles[i] = -1;
+    }
+
+    free(index->hashes);
+    free(index->handles);
+    index->cap = new_cap;
+    index->hashes = hashes;
+    index->handles = handles;
+
+    for (SpiceInt handle = 0; handle < len; ++handle) {
+        ConstSpiceChar *id = ids + handle * id_stride;
+        uint64_t hash = gate_id_index_hash(id);
+        SpiceInt slot = gate_id_index_find_slot(index, ids, id_stride, id, hash);
+        index->hashes[slot] = hash;
+        index->handles[slot] = handle;
+    }
+
+    return SPICETRUE;
+}
+
+void gate_id_index_remove_slot(gate_id_index *index, SpiceInt slot) {
+    // Backward shift deletion for linear probing: move any
+    // following entry that would no longer be reachable
+    // into the hole
+    SpiceInt mask = index->cap - 1;
+    SpiceInt hole = slot;
+    for (SpiceInt next = (hole + 1) & mask; index->handles[next] != -1; next = (next + 1) & mask) {
+        SpiceInt home = (SpiceInt) (index->hashes[next] & mask);
+        if (((next - home) & mask) >= ((next - hole) & mask)) {
+            index->hashes[hole] = index->hashes[next];
+            index->handles[hole] = index->handles[next];
+            hole = next;
+        }
+    }
+
+    index->handles[hole] = -1;
+}
+
+void gate_id_index_free(gate_id_index *index) {
+    free(index->hashes);
+    free(index->handles);
+
+    memset(index, 0, sizeof(*index));
+}
@@ -0,0 +1,105 @@
+/**
+ * @file
+ * An open addressing index from string IDs to dense
+ * handles, shared by the stores which keep their records in
+ * contiguous arrays, such as gate_sat_store and
+ * gate_small_body_store.
+ *
+ * The index holds only the hash and the handle of each
+ * record. The IDs themselves stay with the records of the
+ * store, and are found from the handle using the address of
+ * the ID of the first record and the distance in bytes
+ * between consecutive records. Slots are probed linearly
+ * and the index is kept at most half full, so that lookups
+ * usually touch a single cache line.
+ */
+
+#ifndef GATE_IDINDEX_H
+#define GATE_IDINDEX_H
+
+#include <cspice/SpiceUsr.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Represents an index of IDs.
+ *
+ * The arrays may be read directly, but a slot should only
+ * be filled with the hash and handle of an ID at the slot
+ * returned for that ID by gate_id_index_find_slot().
+ */
+typedef struct {
+    /**
+     * The number of slots, which is 0 or a power of 2.
+     */
+    SpiceInt cap;
+    uint64_t *hashes;
+    /**
+     * The handle of the record in each slot, or -1 if the
+     * slot is empty.
+     */
+    SpiceInt *handles;
+} gate_id_index;
+
+/**
+ * Hashes an ID using 64-bit FNV-1a followed by the
+ * MurmurHash3 finalizer, which spreads the entropy into the
+ * low bits used to pick a slot.
+ *
+ * @param id the NULL terminated ID (input)
+ * @return the hash
+ */
+uint64_t gate_id_index_hash(ConstSpiceChar *id);
+
+/**
+ * Finds the slot holding the given ID, or the empty slot
+ * where it would be inserted.
+ *
+ * @param index the index to search, which must have at
+ * least one slot (input)
+ * @param ids the ID of the record with handle 0 (input)
+ * @param id_stride the number of bytes between the IDs of
+ * consecutive records (input)
+ * @param id the ID to find (input)
+ * @param hash the hash of the ID (input)
+ * @return the slot
+ */
+SpiceInt gate_id_index_find_slot(const gate_id_index *index, ConstSpiceChar *ids, size_t id_stride,
+                                 ConstSpiceChar *id, uint64_t hash);
+
+/**
+ * Ensures that the index has room for the given number of
+ * records, rebuilding it from the IDs of the records in the
+ * store if it needs to grow.
+ *
+ * @param index the index to grow (input/output)
+ * @param ids the ID of the record with handle 0 (input)
+ * @param id_stride the number of bytes between the IDs of
+ * consecutive records (input)
+ * @param len the number of records in the store (input)
+ * @param cap the number of records to make room for
+ * (input)
+ * @return SPICEFALSE if memory could not be allocated, in
+ * which case the index is left as it was
+ */
+SpiceBoolean gate_id_index_reserve(gate_id_index *index, ConstSpiceChar *ids, size_t id_stride, SpiceInt len,
+                                   SpiceInt cap);
+
+/**
+ * Empties a slot, moving any following entries which would
+ * otherwise no longer be found into the gap.
+ *
+ * @param index the index to remove from (input/output)
+ * @param slot the slot to empty (input)
+ */
+void gate_id_index_remove_slot(gate_id_index *index, SpiceInt slot);
+
+/**
+ * Frees all memory held by the given index, leaving it
+ * with no slots.
+ *
+ * @param index the index to free (input/output)
+ */
+void gate_id_index_free(gate_id_index *index);
+
+#endif // GATE_IDINDEX_H
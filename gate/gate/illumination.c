@@ -0,0 +1,163 @@
+#include "illumination.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define EARTH_RADIUS_KM 6378.137
+#define SUN_RADIUS_KM 695700.0
+
+// The number of states transposed into separate arrays of
+// coordinates at a time by gate_illumination_batch()
+#define BLOCK_LEN 64
+
+/**
+ * Computes the illumination of each satellite from the
+ * cosine of the angle between the centers of the Earth and
+ * the Sun as seen from the satellite, compared against the
+ * cosines of the sum and difference of their angular
+ * radii. Comparing cosines rather than angles only takes
+ * square roots, and the coordinates and results are kept
+ * in separate arrays of doubles, so the loop vectorizes.
+ */
+static void shadow_levels(SpiceInt len, ConstSpiceDouble *xs, ConstSpiceDouble *ys, ConstSpiceDouble *zs,
+                          ConstSpiceDouble sun[3], SpiceDouble *levels) {
+    SpiceDouble sun_x = sun[0];
+    SpiceDouble sun_y = sun[1];
+    SpiceDouble sun_z = sun[2];
+
+    for (SpiceInt i = 0; i < len; ++i) {
+        SpiceDouble x = xs[i];
+        SpiceDouble y = ys[i];
+        SpiceDouble z = zs[i];
+        SpiceDouble dx = sun_x - x;
+        SpiceDouble dy = sun_y - y;
+        SpiceDouble dz = sun_z - z;
+        SpiceDouble sat_dist2 = x * x + y * y + z * z;
+        SpiceDouble sun_dist2 = dx * dx + dy * dy + dz * dz;
+
+        SpiceDouble cos_separation = -(x * dx + y * dy + z * dz) / sqrt(sat_dist2 * sun_dist2);
+
+        // Sines and cosines of the angular radii of the
+        // Earth and the Sun
+        SpiceDouble sin_earth = EARTH_RADIUS_KM / sqrt(sat_dist2);
+        SpiceDouble sin_sun = SUN_RADIUS_KM / sqrt(sun_dist2);
+        SpiceDouble cos_earth2 = 1.0 - sin_earth * sin_earth;
+        SpiceDouble cos_earth = sqrt(cos_earth2 > 0.0 ? cos_earth2 : 0.0);
+        SpiceDouble cos_sun = sqrt(1.0 - sin_sun * sin_sun);
+
+        SpiceDouble cos_sum = cos_earth * cos_sun - sin_earth * sin_sun;
+        SpiceDouble cos_difference = cos_earth * cos_sun + sin_earth * sin_sun;
+
+        // Past the tip of the umbra the Earth no longer
+        // covers the whole Sun, which only leaves a
+        // penumbra
+        SpiceDouble penumbra = cos_separation > cos_sum ? 1.0 : 0.0;
+        SpiceDouble umbra = (cos_separation > cos_difference ? 1.0 : 0.0) * (sin_earth > sin_sun ? 1.0 : 0.0);
+        levels[i] = penumbra + umbra;
+    }
+}
+
+void gate_sun_position(SpiceDouble et, SpiceDouble sun[3]) {
+    SpiceDouble lt;
+    spkpos_c("SUN", et, "J2000", "LT", "EARTH", sun, &lt);
+}
+
+void gate_sun_table_build(SpiceDouble start_et, SpiceDouble end_et, SpiceDouble step, gate_sun_table *table) {
+    memset(table, 0, sizeof(*table));
+    table->start_et = start_et;
+    table->step = step;
+
+    SpiceInt len = (SpiceInt) ceil((end_et - start_et) / step) + 1;
+    if (len < 2) {
+        len = 2;
+    }
+
+    table->positions = malloc(len * sizeof(*table->positions));
+    if (table->positions == NULL) {
+        setmsg_c("Failed to allocate memory for the Sun table");
+        sigerr_c("alloc");
+        return;
+    }
+    table->len = len;
+
+    for (SpiceInt i = 0; i < len; ++i) {
+        gate_sun_position(start_et + i * step, table->positions[i]);
+    }
+}
+
+void gate_sun_table_position(const gate_sun_table *table, SpiceDouble et, SpiceDouble sun[3]) {
+    SpiceDouble offset = (et - table->start_et) / table->step;
+    if (offset < 0) {
+        offset = 0;
+    }
+
+    SpiceInt i = (SpiceInt) offset;
+    if (i > table->len - 2) {
+        i = table->len - 2;
+    }
+
+    SpiceDouble t = offset - i;
+    if (t > 1) {
+        t = 1;
+    }
+
+    for (int k = 0; k < 3; ++k) {
+        sun[k] = table->positions[i][k] + (table->positions[i + 1][k] - table->positions[i][k]) * t;
+    }
+}
+
+void gate_sun_table_free(gate_sun_table *table) {
+    free(table->positions);
+    memset(table, 0, sizeof(*table));
+}
+
+gate_illumination gate_sat_illumination(ConstSpiceDouble pos[3], ConstSpiceDouble sun[3]) {
+    SpiceDouble level;
+    shadow_levels(1, &pos[0], &pos[1], &pos[2], sun, &level);
+
+    return (gate_illumination) level;
+}
+
+void gate_illumination_batch(SpiceInt len, ConstSpiceDouble (*states)[6], const gate_sgp4_status *status,
+                             ConstSpiceDouble sun[3], gate_illumination *illumination) {
+    SpiceDouble xs[BLOCK_LEN];
+    SpiceDouble ys[BLOCK_LEN];
+    SpiceDouble zs[BLOCK_LEN];
+    SpiceDouble levels[BLOCK_LEN];
+
+    for (SpiceInt first = 0; first < len; first += BLOCK_LEN) {
+        SpiceInt block_len = len - first < BLOCK_LEN ? len - first : BLOCK_LEN;
+        for (SpiceInt i = 0; i < block_len; ++i) {
+            xs[i] = states[first + i][0];
+            ys[i] = states[first + i][1];
+            zs[i] = states[first + i][2];
+        }
+
+        shadow_levels(block_len, xs, ys, zs, sun, levels);
+
+        for (SpiceInt i = 0; i < block_len; ++i) {
+            illumination[first + i] = (gate_illumination) levels[i];
+        }
+    }
+
+    if (status != NULL) {
+        for (SpiceInt i = 0; i < len; ++i) {
+            if (status[i] != GATE_SGP4_OK) {
+                illumination[i] = GATE_SUNLIT;
+            }
+        }
+    }
+}
+
+ConstSpiceChar *gate_illumination_string(gate_illumination illumination) {
+    switch (illumination) {
+        case GATE_SUNLIT:
+            return "sunlit";
+        case GATE_PENUMBRA:
+            return "penumbra";
+        case GATE_UMBRA:
+            return "umbra";
+        default:
+            return "unknown";
+    }
+}
@@ -0,0 +1,151 @@
+/**
+ * @file
+ * Whether satellites are lit by the Sun or in the shadow of
+ * the Earth.
+ *
+ * A satellite can only be seen with the naked eye or a
+ * telescope when it reflects sunlight while the observer
+ * is in darkness. The position of the Sun is the only part
+ * of the computation which requires SPICE, and it is the
+ * same for every satellite at a given epoch, so it is
+ * looked up once per epoch, or interpolated from a
+ * gate_sun_table built once for a span of time, and then
+ * shared by a shadow test which runs over whole arrays of
+ * satellite states.
+ *
+ * The shadow of the Earth is modeled as a cone, which
+ * distinguishes the umbra, where the Sun is completely
+ * hidden, from the penumbra, where it is partially hidden.
+ * The Earth is treated as a sphere of its equatorial
+ * radius and refraction by the atmosphere is ignored.
+ */
+
+#ifndef GATE_ILLUMINATION_H
+#define GATE_ILLUMINATION_H
+
+#include <cspice/SpiceUsr.h>
+#include "sgp4.h"
+
+/**
+ * The illumination of a satellite by the Sun.
+ */
+typedef enum {
+    GATE_SUNLIT = 0,
+    GATE_PENUMBRA,
+    GATE_UMBRA
+} gate_illumination;
+
+/**
+ * The positions of the Sun relative to the Earth at equal
+ * steps over a span of time, which are interpolated in
+ * order to avoid calling into SPICE for every epoch.
+ */
+typedef struct {
+    SpiceDouble start_et;
+    SpiceDouble step;
+    SpiceInt len;
+    SpiceDouble (*positions)[3];
+} gate_sun_table;
+
+/**
+ * Computes the position of the Sun relative to the center
+ * of the Earth, corrected for light time.
+ *
+ * Requires an SPK kernel covering the Sun and the Earth,
+ * such as de430.bsp.
+ *
+ * @param et the ephemeris time (input)
+ * @param sun the position of the Sun in the J2000 frame in
+ * kilometers (output)
+ */
+void gate_sun_position(SpiceDouble et, SpiceDouble sun[3]);
+
+/**
+ * Looks up the position of the Sun at equal steps over a
+ * span of time.
+ *
+ * Over a step of 10 minutes, interpolating linearly
+ * between positions of the Sun is off by less than a
+ * kilometer, which moves the edge of the shadow by far
+ * less than the width of the penumbra.
+ *
+ * @param start_et the ephemeris time at which the span
+ * starts (input)
+ * @param end_et the ephemeris time at which the span ends
+ * (input)
+ * @param step the step between positions in seconds
+ * (input)
+ * @param table the table (output)
+ *
+ * @throws alloc if memory could not be allocated
+ */
+void gate_sun_table_build(SpiceDouble start_et, SpiceDouble end_et, SpiceDouble step, gate_sun_table *table);
+
+/**
+ * Interpolates the position of the Sun from a table. Times
+ * outside of the span of the table are clamped to it.
+ *
+ * This procedure does not call into SPICE and may be used
+ * concurrently from any number of threads.
+ *
+ * @param table the table (input)
+ * @param et the ephemeris time (input)
+ * @param sun the position of the Sun, see
+ * gate_sun_position() (output)
+ */
+void gate_sun_table_position(const gate_sun_table *table, SpiceDouble et, SpiceDouble sun[3]);
+
+/**
+ * Frees all memory held by a table.
+ *
+ * @param table the table to free (input/output)
+ */
+void gate_sun_table_free(gate_sun_table *table);
+
+/**
+ * Determines whether a satellite is in the shadow of the
+ * Earth.
+ *
+ * This procedure does not call into SPICE and may be used
+ * concurrently from any number of threads.
+ *
+ * @param pos the position of the satellite relative to the
+ * center of the Earth in kilometers (input)
+ * @param sun the position of the Sun relative to the
+ * center of the Earth in the same frame (input)
+ * @return the illumination of the satellite
+ */
+gate_illumination gate_sat_illumination(ConstSpiceDouble pos[3], ConstSpiceDouble sun[3]);
+
+/**
+ * Determines whether each of a set of satellites at the
+ * same epoch is in the shadow of the Earth.
+ *
+ * The states are transposed into separate arrays of
+ * coordinates in small blocks, over which the shadow test
+ * is vectorized.
+ *
+ * @param len the number of satellites (input)
+ * @param states the states of the satellites relative to
+ * the center of the Earth, see gate_sgp4_propagate()
+ * (input)
+ * @param status the result of propagating each satellite,
+ * or NULL if every state is valid. Satellites which failed
+ * to propagate are reported as GATE_SUNLIT (input)
+ * @param sun the position of the Sun relative to the
+ * center of the Earth in the same frame (input)
+ * @param illumination the illumination of each satellite
+ * (output)
+ */
+void gate_illumination_batch(SpiceInt len, ConstSpiceDouble (*states)[6], const gate_sgp4_status *status,
+                             ConstSpiceDouble sun[3], gate_illumination *illumination);
+
+/**
+ * Obtains a human readable name of an illumination.
+ *
+ * @param illumination the illumination (input)
+ * @return a static string naming the illumination
+ */
+ConstSpiceChar *gate_illumination_string(gate_illumination illumination);
+
+#endif // GATE_ILLUMINATION_H
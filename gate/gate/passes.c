@@ -0,0 +1,345 @@
+#include "passes.h"
+#include <float.h>
+#include <math.h>
+
+// The coarse search takes at least this many steps per
+// orbit, and never steps by less than MIN_STEP_SEC
+#define STEPS_PER_PERIOD 24
+#define MIN_STEP_SEC 10.0
+
+#define ROOT_MAX_ITERATIONS 100
+#define SEC_PER_MIN 60.0
+
+// Rotation rate of the Earth in radians per second
+#define EARTH_ROTATION_RATE 7.292115e-5
+
+/**
+ * The position of the satellite in the sky of the
+ * observer at a point in time.
+ */
+typedef struct {
+    SpiceDouble et;
+    SpiceDouble range;
+    SpiceDouble azimuth;
+    SpiceDouble elevation;
+
+    /**
+     * The rate of change of the elevation in degrees per
+     * second.
+     */
+    SpiceDouble elevation_rate;
+} look;
+
+typedef enum {
+    ROOT_ELEVATION,
+    ROOT_ELEVATION_RATE
+} root_kind;
+
+typedef struct {
+    gate_sat_propagator *propagator;
+    gate_topo_frame observer;
+    SpiceDouble min_elevation;
+    SpiceDouble max_step;
+
+    /**
+     * An upper bound on the speed of the satellite
+     * relative to the observer in kilometers per second.
+     */
+    SpiceDouble max_speed;
+
+    gate_sgp4_status status;
+
+    SpiceBoolean in_pass;
+    gate_sat_pass pass;
+
+    SpiceInt passes_len;
+    SpiceInt found;
+    gate_sat_pass *passes;
+} pass_search;
+
+static SpiceBoolean look_at(pass_search *search, SpiceDouble et, look *out) {
+    SpiceDouble state_j2000[6];
+    gate_sgp4_status status = gate_sat_propagate(search->propagator, et, state_j2000);
+    if (status != GATE_SGP4_OK) {
+        search->status = status;
+        return SPICEFALSE;
+    }
+
+    SpiceDouble transform[6][6];
+    SpiceDouble state[6];
+    sxform_c("J2000", search->observer.frame_name, et, transform);
+    mxvg_c(transform, state_j2000, 6, 6, state);
+    gate_adjust_topo_rec(search->observer, state);
+
+    SpiceDouble horizontal = sqrt(state[0] * state[0] + state[1] * state[1]);
+    SpiceDouble horizontal_rate = (state[0] * state[3] + state[1] * state[4]) / horizontal;
+    SpiceDouble range = vnorm_c(state);
+
+    out->et = et;
+    out->range = range;
+    gate_conv_rec_azel(state, NULL, &out->azimuth, &out->elevation);
+    out->elevation_rate = (state[5] * horizontal - state[2] * horizontal_rate) / (range * range) * dpr_c();
+
+    return SPICETRUE;
+}
+
+static SpiceDouble root_value(const pass_search *search, root_kind kind, const look *l) {
+    if (kind == ROOT_ELEVATION) {
+        return l->elevation - search->min_elevation;
+    }
+
+    return l->elevation_rate;
+}
+
+/**
+ * Locates the time between two looks at which the
+ * elevation crosses the minimum elevation, or at which
+ * the elevation rate crosses zero, using Brent's method.
+ *
+ * @return SPICEFALSE if the satellite could not be
+ * propagated
+ */
+static SpiceBoolean find_root(pass_search *search, root_kind kind, const look *lower, const look *upper,
+                              look *root) {
+    SpiceDouble a = lower->et;
+    SpiceDouble b = upper->et;
+    SpiceDouble fa = root_value(search, kind, lower);
+    SpiceDouble fb = root_value(search, kind, upper);
+    SpiceDouble c = b;
+    SpiceDouble fc = fb;
+    SpiceDouble d = b - a;
+    SpiceDouble e = d;
+
+    for (int i = 0; i < ROOT_MAX_ITERATIONS; ++i) {
+        if ((fb > 0.0 && fc > 0.0) || (fb < 0.0 && fc < 0.0)) {
+            c = a;
+            fc = fa;
+            d = b - a;
+            e = d;
+        }
+        if (fabs(fc) < fabs(fb)) {
+            a = b;
+            b = c;
+            c = a;
+            fa = fb;
+            fb = fc;
+            fc = fa;
+        }
+
+        SpiceDouble tol = 2.0 * DBL_EPSILON * fabs(b) + 0.5 * GATE_PASS_TIME_TOLERANCE;
+        SpiceDouble xm = 0.5 * (c - b);
+        if (fabs(xm) <= tol || fb == 0.0) {
+            break;
+        }
+
+        if (fabs(e) >= tol && fabs(fa) > fabs(fb)) {
+            // Inverse quadratic interpolation, or the secant
+            // method if only two points are known
+            SpiceDouble p;
+            SpiceDouble q;
+            SpiceDouble s = fb / fa;
+            if (a == c) {
+                p = 2.0 * xm * s;
+                q = 1.0 - s;
+            } else {
+                SpiceDouble r = fb / fc;
+                q = fa / fc;
+                p = s * (2.0 * xm * q * (q - r) - (b - a) * (r - 1.0));
+                q = (q - 1.0) * (r - 1.0) * (s - 1.0);
+            }
+            if (p > 0.0) {
+                q = -q;
+            }
+            p = fabs(p);
+
+            SpiceDouble min1 = 3.0 * xm * q - fabs(tol * q);
+            SpiceDouble min2 = fabs(e * q);
+            if (2.0 * p < (min1 < min2 ? min1 : min2)) {
+                e = d;
+                d = p / q;
+            } else {
+                d = xm;
+                e = d;
+            }
+        } else {
+            d = xm;
+            e = d;
+        }
+
+        a = b;
+        fa = fb;
+        b += fabs(d) > tol ? d : (xm > 0.0 ? tol : -tol);
+
+        look next;
+        if (!look_at(search, b, &next)) {
+            return SPICEFALSE;
+        }
+        fb = root_value(search, kind, &next);
+    }
+
+    return look_at(search, b, root);
+}
+
+static void begin_pass(pass_search *search, const look *aos, SpiceBoolean at_start) {
+    search->in_pass = SPICETRUE;
+    search->pass.aos_et = aos->et;
+    search->pass.aos_azimuth = aos->azimuth;
+    search->pass.culmination_et = aos->et;
+    search->pass.culmination_azimuth = aos->azimuth;
+    search->pass.culmination_elevation = aos->elevation;
+    search->pass.aos_at_start = at_start;
+    search->pass.los_at_end = SPICEFALSE;
+}
+
+static void update_culmination(pass_search *search, const look *l) {
+    if (search->in_pass && l->elevation > search->pass.culmination_elevation) {
+        search->pass.culmination_et = l->et;
+        search->pass.culmination_azimuth = l->azimuth;
+        search->pass.culmination_elevation = l->elevation;
+    }
+}
+
+static void end_pass(pass_search *search, const look *los, SpiceBoolean at_end) {
+    update_culmination(search, los);
+
+    search->in_pass = SPICEFALSE;
+    search->pass.los_et = los->et;
+    search->pass.los_azimuth = los->azimuth;
+    search->pass.los_at_end = at_end;
+    search->passes[search->found++] = search->pass;
+}
+
+/**
+ * Finds an AOS or LOS between two looks, between which the
+ * elevation is assumed to be monotonic.
+ */
+static SpiceBoolean search_crossing(pass_search *search, const look *from, const look *to) {
+    SpiceBoolean from_above = from->elevation >= search->min_elevation;
+    SpiceBoolean to_above = to->elevation >= search->min_elevation;
+    if (from_above == to_above) {
+        update_culmination(search, to);
+        return SPICETRUE;
+    }
+
+    look crossing;
+    if (!find_root(search, ROOT_ELEVATION, from, to, &crossing)) {
+        return SPICEFALSE;
+    }
+
+    if (to_above) {
+        begin_pass(search, &crossing, SPICEFALSE);
+        update_culmination(search, to);
+    } else {
+        end_pass(search, &crossing, SPICEFALSE);
+    }
+
+    return SPICETRUE;
+}
+
+/**
+ * Finds the events between two consecutive looks of the
+ * coarse search.
+ */
+static SpiceBoolean search_step(pass_search *search, const look *from, const look *to) {
+    if (from->elevation_rate > 0.0 && to->elevation_rate <= 0.0) {
+        // The elevation peaks in between, which may be a
+        // pass even if both looks are below the minimum
+        look peak;
+        if (!find_root(search, ROOT_ELEVATION_RATE, from, to, &peak)) {
+            return SPICEFALSE;
+        }
+
+        if (!search_crossing(search, from, &peak)) {
+            return SPICEFALSE;
+        }
+        if (search->found == search->passes_len) {
+            return SPICETRUE;
+        }
+        return search_crossing(search, &peak, to);
+    }
+
+    return search_crossing(search, from, to);
+}
+
+/**
+ * Determines how far the search may step from a look
+ * without the satellite possibly rising above the minimum
+ * elevation and setting again in between.
+ */
+static SpiceDouble safe_step(const pass_search *search, const look *l) {
+    SpiceDouble step = search->max_step;
+    SpiceDouble deficit = (search->min_elevation - l->elevation) * rpd_c();
+    if (deficit > 0.0) {
+        // The line of sight turns at most by v / range, and
+        // the range shrinks at most by v, so turning by the
+        // deficit takes at least range * (1 - e^-deficit) / v
+        SpiceDouble bound = l->range * (1.0 - exp(-deficit)) / search->max_speed;
+        if (bound < step) {
+            step = bound;
+        }
+    }
+
+    return step < MIN_STEP_SEC ? MIN_STEP_SEC : step;
+}
+
+SpiceInt gate_sat_find_passes(gate_sat_propagator *propagator, gate_topo_frame observer,
+                              SpiceDouble start_et, SpiceDouble end_et, SpiceDouble min_elevation,
+                              SpiceInt passes_len, gate_sat_pass *passes, gate_sgp4_status *status) {
+    *status = propagator->init_status;
+    if (*status != GATE_SGP4_OK || passes_len <= 0 || start_et >= end_et) {
+        return 0;
+    }
+
+    // The speed of the satellite at perigee plus the
+    // speed of a point at apogee co-rotating with the
+    // Earth bounds its speed relative to the rotating frame
+    // of the observer
+    const gate_sgp4 *sgp4 = &propagator->sgp4;
+    SpiceDouble perigee = sgp4->ao * (1.0 - sgp4->ecco);
+    SpiceDouble apogee = sgp4->ao * (1.0 + sgp4->ecco);
+    SpiceDouble perigee_speed = GATE_SGP4_RADIUS_EARTH_KM * GATE_SGP4_XKE / SEC_PER_MIN *
+                                sqrt((1.0 + sgp4->ecco) / perigee);
+    SpiceDouble period = 2.0 * M_PI / sgp4->no * SEC_PER_MIN;
+
+    pass_search search = {
+            .propagator = propagator,
+            .observer = observer,
+            .min_elevation = min_elevation,
+            .max_step = period / STEPS_PER_PERIOD,
+            .max_speed = perigee_speed + EARTH_ROTATION_RATE * apogee * GATE_SGP4_RADIUS_EARTH_KM,
+            .status = GATE_SGP4_OK,
+            .in_pass = SPICEFALSE,
+            .passes_len = passes_len,
+            .found = 0,
+            .passes = passes
+    };
+
+    look prev;
+    if (!look_at(&search, start_et, &prev)) {
+        *status = search.status;
+        return 0;
+    }
+    if (prev.elevation >= min_elevation) {
+        begin_pass(&search, &prev, SPICETRUE);
+    }
+
+    while (prev.et < end_et && search.found < passes_len) {
+        SpiceDouble next_et = prev.et + safe_step(&search, &prev);
+        if (next_et > end_et) {
+            next_et = end_et;
+        }
+
+        look next;
+        if (!look_at(&search, next_et, &next) || !search_step(&search, &prev, &next)) {
+            break;
+        }
+        prev = next;
+    }
+
+    if (search.in_pass && search.found < passes_len && search.status == GATE_SGP4_OK) {
+        end_pass(&search, &prev, SPICETRUE);
+    }
+
+    *status = search.status;
+    return search.found;
+}
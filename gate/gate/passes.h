@@ -0,0 +1,109 @@
+/**
+ * @file
+ * Prediction of satellite passes over an observer.
+ *
+ * A pass begins at acquisition of signal (AOS), when the
+ * satellite rises above a minimum elevation, reaches its
+ * highest elevation at culmination and ends at loss of
+ * signal (LOS), when it sets below the minimum elevation
+ * again.
+ *
+ * Rather than sampling the elevation at a fixed rate, the
+ * search steps through time as far as the satellite could
+ * possibly have risen since the last sample. That step is
+ * bounded by the fastest the satellite can move across the
+ * sky, given its speed at perigee and its range, and by a
+ * fraction of the orbital period. The elevation and its
+ * rate of change are evaluated at each step, and each AOS,
+ * LOS and culmination is then located to within
+ * GATE_PASS_TIME_TOLERANCE seconds by Brent's method on
+ * the elevation or its rate. A culmination between two
+ * steps is found even if the satellite is below the
+ * minimum elevation at both of them, so brief passes that
+ * only just clear the minimum elevation are not missed.
+ *
+ * Elevations are computed in the same way as by the SAT
+ * AZEL command of gatecli, by rotating the state of the
+ * satellite into a topographic frame loaded with
+ * gate_load_topo_frame() and adjusting for the radius of
+ * the observer with gate_adjust_topo_rec().
+ */
+
+#ifndef GATE_PASSES_H
+#define GATE_PASSES_H
+
+#include <cspice/SpiceUsr.h>
+#include "propagator.h"
+#include "topo.h"
+
+/**
+ * The precision in seconds to which the times of a pass
+ * are located.
+ */
+#define GATE_PASS_TIME_TOLERANCE 1e-3
+
+/**
+ * A single pass of a satellite over an observer.
+ *
+ * Azimuths and elevations are in degrees, following
+ * gate_conv_rec_azel().
+ */
+typedef struct {
+    SpiceDouble aos_et;
+    SpiceDouble aos_azimuth;
+
+    SpiceDouble culmination_et;
+    SpiceDouble culmination_azimuth;
+    SpiceDouble culmination_elevation;
+
+    SpiceDouble los_et;
+    SpiceDouble los_azimuth;
+
+    /**
+     * Whether the satellite was already above the minimum
+     * elevation at the start of the search, in which case
+     * aos_et is the start of the search.
+     */
+    SpiceBoolean aos_at_start;
+
+    /**
+     * Whether the satellite was still above the minimum
+     * elevation at the end of the search, in which case
+     * los_et is the end of the search.
+     */
+    SpiceBoolean los_at_end;
+} gate_sat_pass;
+
+/**
+ * Finds the passes of a satellite over an observer within
+ * a span of time.
+ *
+ * If more passes occur than there is room for, the search
+ * stops at the last pass that fits and may be continued
+ * from shortly after its los_et.
+ *
+ * @param propagator the propagator of the satellite
+ * (input/output)
+ * @param observer the topographic frame of the observer
+ * (input)
+ * @param start_et the ephemeris time at which to start
+ * searching (input)
+ * @param end_et the ephemeris time at which to stop
+ * searching (input)
+ * @param min_elevation the minimum elevation of a pass in
+ * degrees (input)
+ * @param passes_len the maximum number of passes to find
+ * (input)
+ * @param passes the passes found, in order of time
+ * (output)
+ * @param status GATE_SGP4_OK if the satellite could be
+ * propagated over the whole search, otherwise the reason
+ * that the search stopped early (output)
+ * @return the number of passes found, which is 0 if the
+ * start time is not before the end time
+ */
+SpiceInt gate_sat_find_passes(gate_sat_propagator *propagator, gate_topo_frame observer,
+                              SpiceDouble start_et, SpiceDouble end_et, SpiceDouble min_elevation,
+                              SpiceInt passes_len, gate_sat_pass *passes, gate_sgp4_status *status);
+
+#endif // GATE_PASSES_H
@@ -0,0 +1,180 @@
+#include "pool.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+// Aim for this many chunks per thread so that the load
+// stays balanced without contending on the counter
+#define CHUNKS_PER_THREAD 16
+
+struct gate_pool {
+    SpiceInt threads;
+    pthread_t *workers;
+
+    pthread_mutex_t lock;
+    pthread_cond_t work_ready;
+    pthread_cond_t work_done;
+
+    /**
+     * Incremented each time a loop is started, so that
+     * workers can tell a new loop from a spurious wakeup.
+     */
+    unsigned long generation;
+    SpiceBoolean stopping;
+    SpiceInt busy;
+
+    gate_pool_task task;
+    void *user_data;
+    SpiceInt len;
+    SpiceInt chunk;
+    SpiceInt next;
+};
+
+/**
+ * Executes chunks of the current loop until none are left.
+ */
+static void run_chunks(gate_pool *pool) {
+    for (;;) {
+        SpiceInt begin = __sync_fetch_and_add(&pool->next, pool->chunk);
+        if (begin >= pool->len) {
+            return;
+        }
+
+        SpiceInt end = begin + pool->chunk;
+        if (end > pool->len) {
+            end = pool->len;
+        }
+
+        pool->task(pool->user_data, begin, end);
+    }
+}
+
+static void *worker_main(void *arg) {
+    gate_pool *pool = arg;
+    unsigned long seen = 0;
+
+    pthread_mutex_lock(&pool->lock);
+    for (;;) {
+        while (!pool->stopping && pool->generation == seen) {
+            pthread_cond_wait(&pool->work_ready, &pool->lock);
+        }
+        if (pool->stopping) {
+            break;
+        }
+        seen = pool->generation;
+        pthread_mutex_unlock(&pool->lock);
+
+        run_chunks(pool);
+
+        pthread_mutex_lock(&pool->lock);
+        if (--pool->busy == 0) {
+            pthread_cond_signal(&pool->work_done);
+        }
+    }
+    pthread_mutex_unlock(&pool->lock);
+
+    return NULL;
+}
+
+gate_pool *gate_pool_new(SpiceInt threads) {
+    if (threads <= 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = cpus > 0 ? (SpiceInt) cpus : 1;
+    }
+
+    gate_pool *pool = calloc(1, sizeof(*pool));
+    if (pool == NULL) {
+        setmsg_c("Failed to allocate memory for the thread pool");
+        sigerr_c("alloc");
+        return NULL;
+    }
+
+    pool->workers = malloc((threads - 1) * sizeof(*pool->workers) + 1);
+    if (pool->workers == NULL) {
+        free(pool);
+        setmsg_c("Failed to allocate memory for the thread pool");
+        sigerr_c("alloc");
+        return NULL;
+    }
+
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->work_ready, NULL);
+    pthread_cond_init(&pool->work_done, NULL);
+
+    // The calling thread acts as the last worker
+    pool->threads = 1;
+    for (SpiceInt i = 0; i < threads - 1; ++i) {
+        if (pthread_create(&pool->workers[i], NULL, worker_main, pool) != 0) {
+            gate_pool_free(pool);
+            setmsg_c("Failed to start worker thread #");
+            errint_c("#", i + 1);
+            sigerr_c("thread");
+            return NULL;
+        }
+        pool->threads++;
+    }
+
+    return pool;
+}
+
+SpiceInt gate_pool_threads(const gate_pool *pool) {
+    return pool == NULL ? 1 : pool->threads;
+}
+
+void gate_pool_run(gate_pool *pool, SpiceInt len, SpiceInt chunk, gate_pool_task task, void *user_data) {
+    if (len <= 0) {
+        return;
+    }
+
+    if (pool == NULL || pool->threads == 1) {
+        task(user_data, 0, len);
+        return;
+    }
+
+    if (chunk <= 0) {
+        chunk = len / (pool->threads * CHUNKS_PER_THREAD);
+        if (chunk < 1) {
+            chunk = 1;
+        }
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    pool->task = task;
+    pool->user_data = user_data;
+    pool->len = len;
+    pool->chunk = chunk;
+    pool->next = 0;
+    pool->busy = pool->threads - 1;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->work_ready);
+    pthread_mutex_unlock(&pool->lock);
+
+    run_chunks(pool);
+
+    pthread_mutex_lock(&pool->lock);
+    while (pool->busy > 0) {
+        pthread_cond_wait(&pool->work_done, &pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+}
+
+void gate_pool_free(gate_pool *pool) {
+    if (pool == NULL) {
+        return;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    pool->stopping = SPICETRUE;
+    pthread_cond_broadcast(&pool->work_ready);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (SpiceInt i = 0; i < pool->threads - 1; ++i) {
+        pthread_join(pool->workers[i], NULL);
+    }
+
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->work_ready);
+    pthread_cond_destroy(&pool->work_done);
+    free(pool->workers);
+    free(pool);
+}
@@ -0,0 +1,85 @@
+/**
+ * @file
+ * A minimal pool of worker threads for splitting loops
+ * over large arrays, such as a satellite catalog, across
+ * every available core.
+ *
+ * A pool runs one loop at a time. The calling thread takes
+ * part in the loop and gate_pool_run() only returns once
+ * every iteration has completed, so a pool behaves like a
+ * parallel for-loop rather than a task queue.
+ *
+ * Iterations are handed out in chunks from a shared
+ * counter so that threads which finish early, for example
+ * because their satellites use the cheaper near-Earth
+ * model, take over remaining work instead of idling.
+ *
+ * The SPICE Toolkit is not thread-safe, so the body of a
+ * loop must not call into SPICE or signal SPICE errors.
+ */
+
+#ifndef GATE_POOL_H
+#define GATE_POOL_H
+
+#include <cspice/SpiceUsr.h>
+
+/**
+ * The body of a parallel loop.
+ *
+ * @param user_data the pointer passed to gate_pool_run()
+ * (input)
+ * @param begin the first iteration to execute (input)
+ * @param end one past the last iteration to execute
+ * (input)
+ */
+typedef void (*gate_pool_task)(void *user_data, SpiceInt begin, SpiceInt end);
+
+/**
+ * An opaque pool of worker threads.
+ */
+typedef struct gate_pool gate_pool;
+
+/**
+ * Creates a new pool of worker threads.
+ *
+ * @param threads the total number of threads that run
+ * each loop, including the calling thread, or 0 to use one
+ * thread per online processor (input)
+ * @return the new pool
+ *
+ * @throws alloc if the pool could not be allocated
+ * @throws thread if a worker thread could not be started
+ */
+gate_pool *gate_pool_new(SpiceInt threads);
+
+/**
+ * Obtains the total number of threads that run each loop
+ * of the given pool, including the calling thread.
+ *
+ * @param pool the pool (input)
+ * @return the number of threads
+ */
+SpiceInt gate_pool_threads(const gate_pool *pool);
+
+/**
+ * Runs a parallel loop and waits for it to complete.
+ *
+ * @param pool the pool to run the loop on, or NULL to run
+ * the loop on the calling thread (input)
+ * @param len the number of iterations (input)
+ * @param chunk the number of iterations handed to a thread
+ * at once, or 0 to choose automatically (input)
+ * @param task the body of the loop (input)
+ * @param user_data an arbitrary pointer passed to each
+ * invocation of the task (input)
+ */
+void gate_pool_run(gate_pool *pool, SpiceInt len, SpiceInt chunk, gate_pool_task task, void *user_data);
+
+/**
+ * Stops the worker threads of a pool and frees it.
+ *
+ * @param pool the pool to free, or NULL (input)
+ */
+void gate_pool_free(gate_pool *pool);
+
+#endif // GATE_POOL_H
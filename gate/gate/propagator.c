@@ -0,0 +1,26 @@
+#include "propagator.h"
+#include <string.h>
+
+gate_sgp4_status gate_sat_propagator_init(const gate_sat_store *store, gate_sat_handle handle,
+                                          gate_sat_propagator *propagator) {
+    SpiceDouble elements[GATE_TLE_ELEMENTS_LEN];
+    gate_sat_store_get_elements(store, handle, elements);
+
+    return gate_sat_propagator_init_elements(elements, propagator);
+}
+
+gate_sgp4_status gate_sat_propagator_init_elements(ConstSpiceDouble elements[GATE_TLE_ELEMENTS_LEN],
+                                                   gate_sat_propagator *propagator) {
+    memset(propagator, 0, sizeof(*propagator));
+    propagator->init_status = gate_sgp4_init(elements, &propagator->sgp4);
+
+    return propagator->init_status;
+}
+
+gate_sgp4_status gate_sat_propagate(gate_sat_propagator *propagator, SpiceDouble et, SpiceDouble state[6]) {
+    if (propagator->init_status != GATE_SGP4_OK) {
+        return propagator->init_status;
+    }
+
+    return gate_sgp4_propagate_resume(&propagator->sgp4, &propagator->resonance, et, state);
+}
@@ -0,0 +1,102 @@
+/**
+ * @file
+ * Per-satellite propagator handles.
+ *
+ * ev2lin_() and dpspce_() keep the initialization derived
+ * from the last element set they were given, so a loop
+ * which alternates between satellites initializes every
+ * satellite again on every call. A gate_sat_propagator
+ * instead owns the initialized model of one satellite,
+ * along with the point that its deep space resonance
+ * integration has reached, so that tracking any number of
+ * satellites side by side only costs the evaluation at
+ * each epoch.
+ *
+ * A propagator is a plain value which does not refer back
+ * to the store that it was created from, so it stays valid
+ * when satellites are added to or removed from the store.
+ */
+
+#ifndef GATE_PROPAGATOR_H
+#define GATE_PROPAGATOR_H
+
+#include <cspice/SpiceUsr.h>
+#include "satstore.h"
+#include "sgp4.h"
+
+/**
+ * The propagation state of a single satellite.
+ */
+typedef struct {
+    /**
+     * The initialized model of the satellite.
+     */
+    gate_sgp4 sgp4;
+
+    /**
+     * Where the resonance integration of a deep space
+     * satellite was last left.
+     */
+    gate_sgp4_resonance resonance;
+
+    /**
+     * The result of initializing the model. Propagating a
+     * satellite which failed to initialize returns this
+     * status.
+     */
+    gate_sgp4_status init_status;
+} gate_sat_propagator;
+
+/**
+ * Creates a propagator for a satellite in a store.
+ *
+ * Requires a leapseconds kernel to be loaded. See
+ * gate_sgp4_init().
+ *
+ * @param store the store containing the satellite (input)
+ * @param handle the handle of the satellite (input)
+ * @param propagator the propagator (output)
+ * @return GATE_SGP4_OK if the satellite can be propagated,
+ * otherwise the reason it cannot
+ */
+gate_sgp4_status gate_sat_propagator_init(const gate_sat_store *store, gate_sat_handle handle,
+                                          gate_sat_propagator *propagator);
+
+/**
+ * Creates a propagator for a satellite from an element set
+ * that is not in a store, such as one taken from a
+ * gate_tle_history.
+ *
+ * Requires a leapseconds kernel to be loaded. See
+ * gate_sgp4_init().
+ *
+ * @param elements the elements of the satellite, in the
+ * layout produced by getelm_c() (input)
+ * @param propagator the propagator (output)
+ * @return GATE_SGP4_OK if the satellite can be propagated,
+ * otherwise the reason it cannot
+ */
+gate_sgp4_status gate_sat_propagator_init_elements(ConstSpiceDouble elements[GATE_TLE_ELEMENTS_LEN],
+                                                   gate_sat_propagator *propagator);
+
+/**
+ * Computes the state of a satellite at the given time.
+ *
+ * Calls for a series of times moving away from the epoch
+ * of the elements, as when tracking a satellite, are the
+ * cheapest. A propagator must only be used by one thread
+ * at a time.
+ *
+ * @param propagator the propagator of the satellite
+ * (input/output)
+ * @param et the ephemeris time at which to compute the
+ * state (input)
+ * @param state the position in kilometers and velocity in
+ * kilometers per second of the satellite relative to the
+ * center of the Earth (output)
+ * @return GATE_SGP4_OK if the state was computed,
+ * otherwise the reason it could not be
+ */
+gate_sgp4_status gate_sat_propagate(gate_sat_propagator *propagator, SpiceDouble et, SpiceDouble state[6]);
+
+#endif // GATE_PROPAGATOR_H
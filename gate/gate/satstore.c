@@ -0,0 +1,170 @@
+#include "satstore.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define INITIAL_CAP 16
+
+static void signal_alloc() {
+    setmsg_c("Failed to allocate memory for the satellite store");
+    sigerr_c("alloc");
+}
+
+/**
+ * Finds the index slot holding the given ID, or the empty
+ * slot where it would be inserted.
+ */
+static SpiceInt find_slot(const gate_sat_store *store, ConstSpiceChar *id, uint64_t hash) {
+    return gate_id_index_find_slot(&store->index, store->text->id, sizeof(*store->text), id, hash);
+}
+
+void gate_sat_store_init(SpiceInt cap, gate_sat_store *store) {
+    memset(store, 0, sizeof(*store));
+    if (cap > 0) {
+        gate_sat_store_reserve(store, cap);
+    }
+}
+
+void gate_sat_store_reserve(gate_sat_store *store, SpiceInt cap) {
+    if (cap > store->cap) {
+        for (int i = 0; i < GATE_TLE_ELEMENTS_LEN; ++i) {
+            SpiceDouble *column = realloc(store->elements[i], cap * sizeof(*column));
+            if (column == NULL) {
+                signal_alloc();
+                return;
+            }
+            store->elements[i] = column;
+        }
+
+        SpiceBoolean *is_deep_space = realloc(store->is_deep_space, cap * sizeof(*is_deep_space));
+        if (is_deep_space == NULL) {
+            signal_alloc();
+            return;
+        }
+        store->is_deep_space = is_deep_space;
+
+        gate_sat_text *text = realloc(store->text, cap * sizeof(*text));
+        if (text == NULL) {
+            signal_alloc();
+            return;
+        }
+        store->text = text;
+
+        store->cap = cap;
+    }
+
+    if (store->cap > 0 &&
+        !gate_id_index_reserve(&store->index, store->text->id, sizeof(*store->text), store->len, cap)) {
+        signal_alloc();
+    }
+}
+
+/**
+ * Truncates an ID to the length stored in the text of a
+ * satellite, so that IDs which are too long are looked up
+ * the same way that they were stored.
+ */
+static void truncate_id(ConstSpiceChar *id, SpiceChar truncated_id[GATE_SAT_ID_MAX_LEN]) {
+    strncpy(truncated_id, id, GATE_SAT_ID_MAX_LEN - 1);
+    truncated_id[GATE_SAT_ID_MAX_LEN - 1] = '\0';
+}
+
+static void set_sat(gate_sat_store *store, gate_sat_handle handle, ConstSpiceChar *id, const gate_tle *tle) {
+    for (int i = 0; i < GATE_TLE_ELEMENTS_LEN; ++i) {
+        store->elements[i][handle] = tle->elements[i];
+    }
+    store->is_deep_space[handle] = tle->is_deep_space;
+
+    gate_sat_text *text = &store->text[handle];
+    strncpy(text->id, id, GATE_SAT_ID_MAX_LEN - 1);
+    text->id[GATE_SAT_ID_MAX_LEN - 1] = '\0';
+    memcpy(text->name, tle->name, sizeof(text->name));
+    memcpy(text->lines, tle->lines, sizeof(text->lines));
+    text->catalog_number = tle->catalog_number;
+}
+
+gate_sat_handle gate_sat_store_put(gate_sat_store *store, ConstSpiceChar *id, const gate_tle *tle,
+                                   SpiceBoolean *replaced) {
+    SpiceChar truncated_id[GATE_SAT_ID_MAX_LEN];
+    truncate_id(id, truncated_id);
+
+    if (store->len == store->cap || store->index.cap == 0) {
+        SpiceInt new_cap = store->cap == 0 ? INITIAL_CAP : store->cap * 2;
+        gate_sat_store_reserve(store, new_cap);
+        if (store->cap < new_cap) {
+            return -1;
+        }
+    }
+
+    uint64_t hash = gate_id_index_hash(truncated_id);
+    SpiceInt slot = find_slot(store, truncated_id, hash);
+    gate_sat_handle handle = store->index.handles[slot];
+
+    if (replaced != NULL) {
+        *replaced = handle != -1;
+    }
+
+    if (handle == -1) {
+        handle = store->len++;
+        store->index.hashes[slot] = hash;
+        store->index.handles[slot] = handle;
+    }
+
+    set_sat(store, handle, truncated_id, tle);
+    return handle;
+}
+
+gate_sat_handle gate_sat_store_find(const gate_sat_store *store, ConstSpiceChar *id) {
+    if (store->index.cap == 0) {
+        return -1;
+    }
+
+    SpiceChar truncated_id[GATE_SAT_ID_MAX_LEN];
+    truncate_id(id, truncated_id);
+
+    SpiceInt slot = find_slot(store, truncated_id, gate_id_index_hash(truncated_id));
+    return store->index.handles[slot];
+}
+
+SpiceBoolean gate_sat_store_rem(gate_sat_store *store, ConstSpiceChar *id) {
+    gate_sat_handle handle = gate_sat_store_find(store, id);
+    if (handle == -1) {
+        return SPICEFALSE;
+    }
+
+    SpiceChar truncated_id[GATE_SAT_ID_MAX_LEN];
+    truncate_id(id, truncated_id);
+    gate_id_index_remove_slot(&store->index, find_slot(store, truncated_id, gate_id_index_hash(truncated_id)));
+
+    gate_sat_handle last = store->len - 1;
+    if (handle != last) {
+        for (int i = 0; i < GATE_TLE_ELEMENTS_LEN; ++i) {
+            store->elements[i][handle] = store->elements[i][last];
+        }
+        store->is_deep_space[handle] = store->is_deep_space[last];
+        store->text[handle] = store->text[last];
+
+        SpiceInt moved_slot = find_slot(store, store->text[handle].id, gate_id_index_hash(store->text[handle].id));
+        store->index.handles[moved_slot] = handle;
+    }
+
+    store->len--;
+    return SPICETRUE;
+}
+
+void gate_sat_store_get_elements(const gate_sat_store *store, gate_sat_handle handle,
+                                 SpiceDouble elements[GATE_TLE_ELEMENTS_LEN]) {
+    for (int i = 0; i < GATE_TLE_ELEMENTS_LEN; ++i) {
+        elements[i] = store->elements[i][handle];
+    }
+}
+
+void gate_sat_store_free(gate_sat_store *store) {
+    for (int i = 0; i < GATE_TLE_ELEMENTS_LEN; ++i) {
+        free(store->elements[i]);
+    }
+    free(store->is_deep_space);
+    free(store->text);
+    gate_id_index_free(&store->index);
+
+    memset(store, 0, sizeof(*store));
+}
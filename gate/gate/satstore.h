@@ -0,0 +1,172 @@
+/**
+ * @file
+ * Compact storage for a catalog of satellites.
+ *
+ * Satellites are referred to by dense integer handles from
+ * 0 up to the number of stored satellites, which index
+ * directly into the arrays of the store. Each orbital
+ * element is stored in its own contiguous array (a
+ * structure-of-arrays layout), so that procedures which
+ * operate on the whole catalog, such as propagating every
+ * satellite to the same epoch, stream through memory
+ * rather than chasing a pointer per satellite.
+ *
+ * Data which is only needed to display a satellite, such
+ * as its ID, name and the original TLE text, is kept in a
+ * separate "cold" array so that it does not dilute the
+ * element arrays. A hash index maps IDs to handles.
+ *
+ * Removing a satellite moves the last satellite of the
+ * store into the freed handle, so handles should not be
+ * held across removals.
+ */
+
+#ifndef GATE_SATSTORE_H
+#define GATE_SATSTORE_H
+
+#include <cspice/SpiceUsr.h>
+#include "idindex.h"
+#include "tle.h"
+
+/**
+ * The maximum length of a satellite ID, including the NULL
+ * terminator. Longer IDs are truncated when storing,
+ * finding and removing satellites alike.
+ */
+#define GATE_SAT_ID_MAX_LEN 32
+
+/**
+ * A dense index of a satellite in a gate_sat_store, or -1
+ * to represent no satellite.
+ */
+typedef SpiceInt gate_sat_handle;
+
+/**
+ * Infrequently accessed data describing a satellite.
+ */
+typedef struct {
+    SpiceChar id[GATE_SAT_ID_MAX_LEN];
+    SpiceChar name[GATE_TLE_NAME_MAX_LEN];
+    SpiceChar lines[2][GATE_TLE_LINE_LEN + 1];
+    SpiceInt catalog_number;
+} gate_sat_text;
+
+/**
+ * Represents a catalog of satellites.
+ *
+ * The arrays may be read directly using a handle as the
+ * index, but should only be modified through the
+ * procedures in this file.
+ */
+typedef struct {
+    /**
+     * The number of satellites in the store.
+     */
+    SpiceInt len;
+    /**
+     * The number of satellites that the store has room for
+     * before needing to grow.
+     */
+    SpiceInt cap;
+
+    /**
+     * One array per element, indexed first by
+     * gate_tle_element and then by handle, e.g.
+     * `elements[GATE_TLE_INCL][handle]`.
+     */
+    SpiceDouble *elements[GATE_TLE_ELEMENTS_LEN];
+    SpiceBoolean *is_deep_space;
+
+    gate_sat_text *text;
+
+    gate_id_index index;
+} gate_sat_store;
+
+/**
+ * Initializes an empty satellite store.
+ *
+ * @param cap the number of satellites for which to
+ * allocate room up front, or 0 (input)
+ * @param store the store to initialize (output)
+ *
+ * @throws alloc if memory could not be allocated
+ */
+void gate_sat_store_init(SpiceInt cap, gate_sat_store *store);
+
+/**
+ * Ensures that the given store has room for at least the
+ * given number of satellites without needing to grow.
+ *
+ * @param store the store for which to reserve space
+ * (input/output)
+ * @param cap the total number of satellites to make room
+ * for (input)
+ *
+ * @throws alloc if memory could not be allocated
+ */
+void gate_sat_store_reserve(gate_sat_store *store, SpiceInt cap);
+
+/**
+ * Adds a satellite to the store, or replaces the element
+ * set of the satellite with the same ID if one is already
+ * stored.
+ *
+ * @param store the store to add the satellite to
+ * (input/output)
+ * @param id the ID under which to store the satellite
+ * (input)
+ * @param tle the element set of the satellite (input)
+ * @param replaced set to whether a satellite with the
+ * same ID was replaced, or NULL if not desired (output)
+ * @return the handle of the satellite, or -1 if it could
+ * not be added
+ *
+ * @throws alloc if memory could not be allocated
+ */
+gate_sat_handle gate_sat_store_put(gate_sat_store *store, ConstSpiceChar *id, const gate_tle *tle,
+                                   SpiceBoolean *replaced);
+
+/**
+ * Finds the handle of the satellite with the given ID.
+ *
+ * @param store the store to search (input)
+ * @param id the ID of the satellite (input)
+ * @return the handle of the satellite, or -1 if there is
+ * no satellite with the given ID
+ */
+gate_sat_handle gate_sat_store_find(const gate_sat_store *store, ConstSpiceChar *id);
+
+/**
+ * Removes the satellite with the given ID.
+ *
+ * The last satellite in the store takes over the handle
+ * of the removed satellite.
+ *
+ * @param store the store to remove the satellite from
+ * (input/output)
+ * @param id the ID of the satellite (input)
+ * @return SPICETRUE if a satellite was removed
+ */
+SpiceBoolean gate_sat_store_rem(gate_sat_store *store, ConstSpiceChar *id);
+
+/**
+ * Gathers the elements of a satellite into the layout
+ * produced by getelm_c(), which is the layout expected by
+ * the ev2lin_() and dpspce_() propagators.
+ *
+ * @param store the store containing the satellite (input)
+ * @param handle the handle of the satellite (input)
+ * @param elements the elements of the satellite (output)
+ */
+void gate_sat_store_get_elements(const gate_sat_store *store, gate_sat_handle handle,
+                                 SpiceDouble elements[GATE_TLE_ELEMENTS_LEN]);
+
+/**
+ * Frees all memory held by the given store, leaving it
+ * empty.
+ *
+ * @param store the store to free (input/output)
+ */
+void gate_sat_store_free(gate_sat_store *store);
+
+#endif // GATE_SATSTORE_H
@@ -0,0 +1,928 @@
+#include "sgp4.h"
+#include <math.h>
+#include <string.h>
+
+#define J2 GATE_SGP4_J2
+#define J3 GATE_SGP4_J3
+#define J4 GATE_SGP4_J4
+#define J3OJ2 (J3 / J2)
+#define XKE GATE_SGP4_XKE
+#define RADIUS_EARTH_KM GATE_SGP4_RADIUS_EARTH_KM
+#define VKMPERSEC (RADIUS_EARTH_KM * XKE / 60.0)
+
+#define TWOPI (2.0 * M_PI)
+#define X2O3 (2.0 / 3.0)
+#define TEMP4 1.5e-12
+
+// Offset between Julian dates and the "days since 1950
+// January 0.0" epoch used by the model
+#define JD_1950 2433281.5
+#define SEC_PER_DAY 86400.0
+#define SEC_PER_MIN 60.0
+
+// Lunar and solar constants
+#define ZNS 1.19459e-5
+#define ZES 0.01675
+#define ZNL 1.5835218e-4
+#define ZEL 0.05490
+
+// Earth rotation rate in radians per minute
+#define RPTIM 4.37526908801129966e-3
+
+/**
+ * Intermediate values shared between the deep space
+ * initialization procedures.
+ */
+typedef struct {
+    SpiceDouble snodm, cnodm, sinim, cosim, sinomm, cosomm, day, em, emsq, gam, rtemsq, nm;
+    SpiceDouble s1, s2, s3, s4, s5, s6, s7;
+    SpiceDouble ss1, ss2, ss3, ss4, ss5, ss6, ss7;
+    SpiceDouble sz1, sz2, sz3, sz11, sz12, sz13, sz21, sz22, sz23, sz31, sz32, sz33;
+    SpiceDouble z1, z2, z3, z11, z12, z13, z21, z22, z23, z31, z32, z33;
+} deep_space_common;
+
+/**
+ * Mean elements which are updated in turn by each step of
+ * the propagation.
+ */
+typedef struct {
+    SpiceDouble em, argpm, inclm, mm, nm, nodem;
+} mean_elements;
+
+/**
+ * Computes the lunar and solar terms of the deep space
+ * model (the "dscom" procedure of the reference
+ * implementation).
+ */
+static void init_deep_space_common(SpiceDouble epoch, gate_sgp4 *sat, deep_space_common *c) {
+    const SpiceDouble c1ss = 2.9864797e-6;
+    const SpiceDouble c1l = 4.7968065e-7;
+    const SpiceDouble zsinis = 0.39785416;
+    const SpiceDouble zcosis = 0.91744867;
+    const SpiceDouble zcosgs = 0.1945905;
+    const SpiceDouble zsings = -0.98088458;
+
+    c->nm = sat->no;
+    c->em = sat->ecco;
+    c->snodm = sin(sat->nodeo);
+    c->cnodm = cos(sat->nodeo);
+    c->sinomm = sin(sat->argpo);
+    c->cosomm = cos(sat->argpo);
+    c->sinim = sin(sat->inclo);
+    c->cosim = cos(sat->inclo);
+    c->emsq = c->em * c->em;
+    SpiceDouble betasq = 1.0 - c->emsq;
+    c->rtemsq = sqrt(betasq);
+
+    sat->peo = 0.0;
+    sat->pinco = 0.0;
+    sat->plo = 0.0;
+    sat->pgho = 0.0;
+    sat->pho = 0.0;
+    c->day = epoch + 18261.5;
+    SpiceDouble xnodce = fmod(4.5236020 - 9.2422029e-4 * c->day, TWOPI);
+    SpiceDouble stem = sin(xnodce);
+    SpiceDouble ctem = cos(xnodce);
+    SpiceDouble zcosil = 0.91375164 - 0.03568096 * ctem;
+    SpiceDouble zsinil = sqrt(1.0 - zcosil * zcosil);
+    SpiceDouble zsinhl = 0.089683511 * stem / zsinil;
+    SpiceDouble zcoshl = sqrt(1.0 - zsinhl * zsinhl);
+    c->gam = 5.8351514 + 0.0019443680 * c->day;
+    SpiceDouble zx = 0.39785416 * stem / zsinil;
+    SpiceDouble zy = zcoshl * ctem + 0.91744867 * zsinhl * stem;
+    zx = atan2(zx, zy);
+    zx = c->gam + zx - xnodce;
+    SpiceDouble zcosgl = cos(zx);
+    SpiceDouble zsingl = sin(zx);
+
+    // Solar terms first, then lunar terms
+    SpiceDouble zcosg = zcosgs;
+    SpiceDouble zsing = zsings;
+    SpiceDouble zcosi = zcosis;
+    SpiceDouble zsini = zsinis;
+    SpiceDouble zcosh = c->cnodm;
+    SpiceDouble zsinh = c->snodm;
+    SpiceDouble cc = c1ss;
+    SpiceDouble xnoi = 1.0 / c->nm;
+
+    for (int lsflg = 1; lsflg <= 2; ++lsflg) {
+        SpiceDouble a1 = zcosg * zcosh + zsing * zcosi * zsinh;
+        SpiceDouble a3 = -zsing * zcosh + zcosg * zcosi * zsinh;
+        SpiceDouble a7 = -zcosg * zsinh + zsing * zcosi * zcosh;
+        SpiceDouble a8 = zsing * zsini;
+        SpiceDouble a9 = zsing * zsinh + zcosg * zcosi * zcosh;
+        SpiceDouble a10 = zcosg * zsini;
+        SpiceDouble a2 = c->cosim * a7 + c->sinim * a8;
+        SpiceDouble a4 = c->cosim * a9 + c->sinim * a10;
+        SpiceDouble a5 = -c->sinim * a7 + c->cosim * a8;
+        SpiceDouble a6 = -c->sinim * a9 + c->cosim * a10;
+
+        SpiceDouble x1 = a1 * c->cosomm + a2 * c->sinomm;
+        SpiceDouble x2 = a3 * c->cosomm + a4 * c->sinomm;
+        SpiceDouble x3 = -a1 * c->sinomm + a2 * c->cosomm;
+        SpiceDouble x4 = -a3 * c->sinomm + a4 * c->cosomm;
+        SpiceDouble x5 = a5 * c->sinomm;
+        SpiceDouble x6 = a6 * c->sinomm;
+        SpiceDouble x7 = a5 * c->cosomm;
+        SpiceDouble x8 = a6 * c->cosomm;
+
+        c->z31 = 12.0 * x1 * x1 - 3.0 * x3 * x3;
+        c->z32 = 24.0 * x1 * x2 - 6.0 * x3 * x4;
+        c->z33 = 12.0 * x2 * x2 - 3.0 * x4 * x4;
+        c->z1 = 3.0 * (a1 * a1 + a2 * a2) + c->z31 * c->emsq;
+        c->z2 = 6.0 * (a1 * a3 + a2 * a4) + c->z32 * c->emsq;
+        c->z3 = 3.0 * (a3 * a3 + a4 * a4) + c->z33 * c->emsq;
+        c->z11 = -6.0 * a1 * a5 + c->emsq * (-24.0 * x1 * x7 - 6.0 * x3 * x5);
+        c->z12 = -6.0 * (a1 * a6 + a3 * a5) + c->emsq *
+                (-24.0 * (x2 * x7 + x1 * x8) - 6.0 * (x3 * x6 + x4 * x5));
+        c->z13 = -6.0 * a3 * a6 + c->emsq * (-24.0 * x2 * x8 - 6.0 * x4 * x6);
+        c->z21 = 6.0 * a2 * a5 + c->emsq * (24.0 * x1 * x5 - 6.0 * x3 * x7);
+        c->z22 = 6.0 * (a4 * a5 + a2 * a6) + c->emsq *
+                (24.0 * (x2 * x5 + x1 * x6) - 6.0 * (x4 * x7 + x3 * x8));
+        c->z23 = 6.0 * a4 * a6 + c->emsq * (24.0 * x2 * x6 - 6.0 * x4 * x8);
+        c->z1 = c->z1 + c->z1 + betasq * c->z31;
+        c->z2 = c->z2 + c->z2 + betasq * c->z32;
+        c->z3 = c->z3 + c->z3 + betasq * c->z33;
+        c->s3 = cc * xnoi;
+        c->s2 = -0.5 * c->s3 / c->rtemsq;
+        c->s4 = c->s3 * c->rtemsq;
+        c->s1 = -15.0 * c->em * c->s4;
+        c->s5 = x1 * x3 + x2 * x4;
+        c->s6 = x2 * x3 + x1 * x4;
+        c->s7 = x2 * x4 - x1 * x3;
+
+        if (lsflg == 1) {
+            c->ss1 = c->s1;
+            c->ss2 = c->s2;
+            c->ss3 = c->s3;
+            c->ss4 = c->s4;
+            c->ss5 = c->s5;
+            c->ss6 = c->s6;
+            c->ss7 = c->s7;
+            c->sz1 = c->z1;
+            c->sz2 = c->z2;
+            c->sz3 = c->z3;
+            c->sz11 = c->z11;
+            c->sz12 = c->z12;
+            c->sz13 = c->z13;
+            c->sz21 = c->z21;
+            c->sz22 = c->z22;
+            c->sz23 = c->z23;
+            c->sz31 = c->z31;
+            c->sz32 = c->z32;
+            c->sz33 = c->z33;
+            zcosg = zcosgl;
+            zsing = zsingl;
+            zcosi = zcosil;
+            zsini = zsinil;
+            zcosh = zcoshl * c->cnodm + zsinhl * c->snodm;
+            zsinh = c->snodm * zcoshl - c->cnodm * zsinhl;
+            cc = c1l;
+        }
+    }
+
+    sat->zmol = fmod(4.7199672 + 0.22997150 * c->day - c->gam, TWOPI);
+    sat->zmos = fmod(6.2565837 + 0.017201977 * c->day, TWOPI);
+
+    // Solar terms
+    sat->se2 = 2.0 * c->ss1 * c->ss6;
+    sat->se3 = 2.0 * c->ss1 * c->ss7;
+    sat->si2 = 2.0 * c->ss2 * c->sz12;
+    sat->si3 = 2.0 * c->ss2 * (c->sz13 - c->sz11);
+    sat->sl2 = -2.0 * c->ss3 * c->sz2;
+    sat->sl3 = -2.0 * c->ss3 * (c->sz3 - c->sz1);
+    sat->sl4 = -2.0 * c->ss3 * (-21.0 - 9.0 * c->emsq) * ZES;
+    sat->sgh2 = 2.0 * c->ss4 * c->sz32;
+    sat->sgh3 = 2.0 * c->ss4 * (c->sz33 - c->sz31);
+    sat->sgh4 = -18.0 * c->ss4 * ZES;
+    sat->sh2 = -2.0 * c->ss2 * c->sz22;
+    sat->sh3 = -2.0 * c->ss2 * (c->sz23 - c->sz21);
+
+    // Lunar terms
+    sat->ee2 = 2.0 * c->s1 * c->s6;
+    sat->e3 = 2.0 * c->s1 * c->s7;
+    sat->xi2 = 2.0 * c->s2 * c->z12;
+    sat->xi3 = 2.0 * c->s2 * (c->z13 - c->z11);
+    sat->xl2 = -2.0 * c->s3 * c->z2;
+    sat->xl3 = -2.0 * c->s3 * (c->z3 - c->z1);
+    sat->xl4 = -2.0 * c->s3 * (-21.0 - 9.0 * c->emsq) * ZEL;
+    sat->xgh2 = 2.0 * c->s4 * c->z32;
+    sat->xgh3 = 2.0 * c->s4 * (c->z33 - c->z31);
+    sat->xgh4 = -18.0 * c->s4 * ZEL;
+    sat->xh2 = -2.0 * c->s2 * c->z22;
+    sat->xh3 = -2.0 * c->s2 * (c->z23 - c->z21);
+}
+
+/**
+ * Computes the secular rates and resonance coefficients of
+ * the deep space model (the "dsinit" procedure of the
+ * reference implementation).
+ */
+static void init_deep_space(const deep_space_common *c, SpiceDouble eccsq, SpiceDouble xpidot, gate_sgp4 *sat) {
+    const SpiceDouble q22 = 1.7891679e-6;
+    const SpiceDouble q31 = 2.1460748e-6;
+    const SpiceDouble q33 = 2.2123015e-7;
+    const SpiceDouble root22 = 1.7891679e-6;
+    const SpiceDouble root44 = 7.3636953e-9;
+    const SpiceDouble root54 = 2.1765803e-9;
+    const SpiceDouble root32 = 3.7393792e-7;
+    const SpiceDouble root52 = 1.1428639e-7;
+
+    SpiceDouble nm = c->nm;
+    SpiceDouble em = c->em;
+    SpiceDouble emsq = c->emsq;
+    SpiceDouble sinim = c->sinim;
+    SpiceDouble cosim = c->cosim;
+    SpiceDouble inclm = sat->inclo;
+
+    sat->irez = 0;
+    if (nm < 0.0052359877 && nm > 0.0034906585) {
+        sat->irez = 1;
+    }
+    if (nm >= 8.26e-3 && nm <= 9.24e-3 && em >= 0.5) {
+        sat->irez = 2;
+    }
+
+    // Solar terms
+    SpiceDouble ses = c->ss1 * ZNS * c->ss5;
+    SpiceDouble sis = c->ss2 * ZNS * (c->sz11 + c->sz13);
+    SpiceDouble sls = -ZNS * c->ss3 * (c->sz1 + c->sz3 - 14.0 - 6.0 * emsq);
+    SpiceDouble sghs = c->ss4 * ZNS * (c->sz31 + c->sz33 - 6.0);
+    SpiceDouble shs = -ZNS * c->ss2 * (c->sz21 + c->sz23);
+    if (inclm < 5.2359877e-2 || inclm > M_PI - 5.2359877e-2) {
+        shs = 0.0;
+    }
+    if (sinim != 0.0) {
+        shs = shs / sinim;
+    }
+    SpiceDouble sgs = sghs - cosim * shs;
+
+    // Lunar terms
+    sat->dedt = ses + c->s1 * ZNL * c->s5;
+    sat->didt = sis + c->s2 * ZNL * (c->z11 + c->z13);
+    sat->dmdt = sls - ZNL * c->s3 * (c->z1 + c->z3 - 14.0 - 6.0 * emsq);
+    SpiceDouble sghl = c->s4 * ZNL * (c->z31 + c->z33 - 6.0);
+    SpiceDouble shll = -ZNL * c->s2 * (c->z21 + c->z23);
+    if (inclm < 5.2359877e-2 || inclm > M_PI - 5.2359877e-2) {
+        shll = 0.0;
+    }
+    sat->domdt = sgs + sghl;
+    sat->dnodt = shs;
+    if (sinim != 0.0) {
+        sat->domdt = sat->domdt - cosim / sinim * shll;
+        sat->dnodt = sat->dnodt + shll / sinim;
+    }
+
+    if (sat->irez == 0) {
+        return;
+    }
+
+    SpiceDouble theta = fmod(sat->gsto, TWOPI);
+    SpiceDouble aonv = pow(nm / XKE, X2O3);
+
+    if (sat->irez == 2) {
+        // Geopotential resonance for 12 hour orbits
+        SpiceDouble cosisq = cosim * cosim;
+        em = sat->ecco;
+        emsq = eccsq;
+        SpiceDouble eoc = em * emsq;
+        SpiceDouble g201 = -0.306 - (em - 0.64) * 0.440;
+        SpiceDouble g211, g310, g322, g410, g422, g520, g521, g532, g533;
+
+        if (em <= 0.65) {
+            g211 = 3.616 - 13.2470 * em + 16.2900 * emsq;
+            g310 = -19.302 + 117.3900 * em - 228.4190 * emsq + 156.5910 * eoc;
+            g322 = -18.9068 + 109.7927 * em - 214.6334 * emsq + 146.5816 * eoc;
+            g410 = -41.122 + 242.6940 * em - 471.0940 * emsq + 313.9530 * eoc;
+            g422 = -146.407 + 841.8800 * em - 1629.014 * emsq + 1083.4350 * eoc;
+            g520 = -532.114 + 3017.977 * em - 5740.032 * emsq + 3708.2760 * eoc;
+        } else {
+            g211 = -72.099 + 331.819 * em - 508.738 * emsq + 266.724 * eoc;
+            g310 = -346.844 + 1582.851 * em - 2415.925 * emsq + 1246.113 * eoc;
+            g322 = -342.585 + 1554.908 * em - 2366.899 * emsq + 1215.972 * eoc;
+            g410 = -1052.797 + 4758.686 * em - 7193.992 * emsq + 3651.957 * eoc;
+            g422 = -3581.690 + 16178.110 * em - 24462.770 * emsq + 12422.520 * eoc;
+            if (em > 0.715) {
+                g520 = -5149.66 + 29936.92 * em - 54087.36 * emsq + 31324.56 * eoc;
+            } else {
+                g520 = 1464.74 - 4664.75 * em + 3763.64 * emsq;
+            }
+        }
+        if (em < 0.7) {
+            g533 = -919.22770 + 4988.6100 * em - 9064.7700 * emsq + 5542.21 * eoc;
+            g521 = -822.71072 + 4568.6173 * em - 8491.4146 * emsq + 5337.524 * eoc;
+            g532 = -853.66600 + 4690.2500 * em - 8624.7700 * emsq + 5341.4 * eoc;
+        } else {
+            g533 = -37995.780 + 161616.52 * em - 229838.20 * emsq + 109377.94 * eoc;
+            g521 = -51752.104 + 218913.95 * em - 309468.16 * emsq + 146349.42 * eoc;
+            g532 = -40023.880 + 170470.89 * em - 242699.48 * emsq + 115605.82 * eoc;
+        }
+
+        SpiceDouble sini2 = sinim * sinim;
+        SpiceDouble f220 = 0.75 * (1.0 + 2.0 * cosim + cosisq);
+        SpiceDouble f221 = 1.5 * sini2;
+        SpiceDouble f321 = 1.875 * sinim * (1.0 - 2.0 * cosim - 3.0 * cosisq);
+        SpiceDouble f322 = -1.875 * sinim * (1.0 + 2.0 * cosim - 3.0 * cosisq);
+        SpiceDouble f441 = 35.0 * sini2 * f220;
+        SpiceDouble f442 = 39.3750 * sini2 * sini2;
+        SpiceDouble f522 = 9.84375 * sinim * (sini2 * (1.0 - 2.0 * cosim - 5.0 * cosisq) +
+                                              0.33333333 * (-2.0 + 4.0 * cosim + 6.0 * cosisq));
+        SpiceDouble f523 = sinim * (4.92187512 * sini2 * (-2.0 - 4.0 * cosim + 10.0 * cosisq) +
+                                    6.56250012 * (1.0 + 2.0 * cosim - 3.0 * cosisq));
+        SpiceDouble f542 = 29.53125 * sinim * (2.0 - 8.0 * cosim + cosisq *
+                                                                   (-12.0 + 8.0 * cosim + 10.0 * cosisq));
+        SpiceDouble f543 = 29.53125 * sinim * (-2.0 - 8.0 * cosim + cosisq *
+                                                                    (12.0 + 8.0 * cosim - 10.0 * cosisq));
+        SpiceDouble xno2 = nm * nm;
+        SpiceDouble ainv2 = aonv * aonv;
+        SpiceDouble temp1 = 3.0 * xno2 * ainv2;
+        SpiceDouble temp = temp1 * root22;
+        sat->d2201 = temp * f220 * g201;
+        sat->d2211 = temp * f221 * g211;
+        temp1 = temp1 * aonv;
+        temp = temp1 * root32;
+        sat->d3210 = temp * f321 * g310;
+        sat->d3222 = temp * f322 * g322;
+        temp1 = temp1 * aonv;
+        temp = 2.0 * temp1 * root44;
+        sat->d4410 = temp * f441 * g410;
+        sat->d4422 = temp * f442 * g422;
+        temp1 = temp1 * aonv;
+        temp = temp1 * root52;
+        sat->d5220 = temp * f522 * g520;
+        sat->d5232 = temp * f523 * g532;
+        temp = 2.0 * temp1 * root54;
+        sat->d5421 = temp * f542 * g521;
+        sat->d5433 = temp * f543 * g533;
+        sat->xlamo = fmod(sat->mo + sat->nodeo + sat->nodeo - theta - theta, TWOPI);
+        sat->xfact = sat->mdot + sat->dmdt + 2.0 * (sat->nodedot + sat->dnodt - RPTIM) - sat->no;
+    } else {
+        // Synchronous resonance terms
+        SpiceDouble g200 = 1.0 + emsq * (-2.5 + 0.8125 * emsq);
+        SpiceDouble g310 = 1.0 + 2.0 * emsq;
+        SpiceDouble g300 = 1.0 + emsq * (-6.0 + 6.60937 * emsq);
+        SpiceDouble f220 = 0.75 * (1.0 + cosim) * (1.0 + cosim);
+        SpiceDouble f311 = 0.9375 * sinim * sinim * (1.0 + 3.0 * cosim) - 0.75 * (1.0 + cosim);
+        SpiceDouble f330 = 1.0 + cosim;
+        f330 = 1.875 * f330 * f330 * f330;
+        sat->del1 = 3.0 * nm * nm * aonv * aonv;
+        sat->del2 = 2.0 * sat->del1 * f220 * g200 * q22;
+        sat->del3 = 3.0 * sat->del1 * f330 * g300 * q33 * aonv;
+        sat->del1 = sat->del1 * f311 * g310 * q31 * aonv;
+        sat->xlamo = fmod(sat->mo + sat->nodeo + sat->argpo - theta, TWOPI);
+        sat->xfact = sat->mdot + xpidot - RPTIM + sat->dmdt + sat->domdt + sat->dnodt - sat->no;
+    }
+}
+
+/**
+ * Applies the deep space secular effects and integrates
+ * the resonance effects up to the given time (the "dspace"
+ * procedure of the reference implementation).
+ *
+ * The reference implementation caches the state of the
+ * resonance integrator in the satellite between calls.
+ * Here it is kept in the caller's checkpoint instead, so
+ * that propagation does not modify the satellite. The
+ * integration resumes from the checkpoint if it lies
+ * between the epoch and the requested time, and otherwise
+ * restarts at the epoch, as the reference implementation
+ * does whenever the direction of propagation changes. The
+ * checkpoint is then moved to the last step taken. Without
+ * a checkpoint the integration always restarts at the
+ * epoch.
+ */
+static void apply_deep_space_secular(const gate_sgp4 *sat, gate_sgp4_resonance *resonance, SpiceDouble t,
+                                     mean_elements *m) {
+    const SpiceDouble fasx2 = 0.13130908;
+    const SpiceDouble fasx4 = 2.8843198;
+    const SpiceDouble fasx6 = 0.37448087;
+    const SpiceDouble g22 = 5.7686396;
+    const SpiceDouble g32 = 0.95240898;
+    const SpiceDouble g44 = 1.8014998;
+    const SpiceDouble g52 = 1.0508330;
+    const SpiceDouble g54 = 4.4108898;
+    const SpiceDouble stepp = 720.0;
+    const SpiceDouble stepn = -720.0;
+    const SpiceDouble step2 = 259200.0;
+
+    SpiceDouble theta = fmod(sat->gsto + t * RPTIM, TWOPI);
+    m->em = m->em + sat->dedt * t;
+    m->inclm = m->inclm + sat->didt * t;
+    m->argpm = m->argpm + sat->domdt * t;
+    m->nodem = m->nodem + sat->dnodt * t;
+    m->mm = m->mm + sat->dmdt * t;
+
+    if (sat->irez == 0) {
+        return;
+    }
+
+    // Resume from the last integration step if it lies
+    // between the epoch and the requested time
+    SpiceDouble atime = 0.0;
+    SpiceDouble xni = sat->no;
+    SpiceDouble xli = sat->xlamo;
+    if (resonance != NULL && resonance->atime != 0.0 && t * resonance->atime > 0.0 &&
+        fabs(t) >= fabs(resonance->atime)) {
+        atime = resonance->atime;
+        xni = resonance->xni;
+        xli = resonance->xli;
+    }
+
+    SpiceDouble delt = t > 0.0 ? stepp : stepn;
+    SpiceDouble ft;
+    SpiceDouble xndt, xldot, xnddt;
+
+    // Euler-Maclaurin integration in steps of half a day
+    for (;;) {
+        if (sat->irez != 2) {
+            // Near-synchronous resonance terms
+            xndt = sat->del1 * sin(xli - fasx2) + sat->del2 * sin(2.0 * (xli - fasx4)) +
+                   sat->del3 * sin(3.0 * (xli - fasx6));
+            xldot = xni + sat->xfact;
+            xnddt = sat->del1 * cos(xli - fasx2) +
+                    2.0 * sat->del2 * cos(2.0 * (xli - fasx4)) +
+                    3.0 * sat->del3 * cos(3.0 * (xli - fasx6));
+            xnddt = xnddt * xldot;
+        } else {
+            // Near half-day resonance terms
+            SpiceDouble xomi = sat->argpo + sat->argpdot * atime;
+            SpiceDouble x2omi = xomi + xomi;
+            SpiceDouble x2li = xli + xli;
+            xndt = sat->d2201 * sin(x2omi + xli - g22) + sat->d2211 * sin(xli - g22) +
+                   sat->d3210 * sin(xomi + xli - g32) + sat->d3222 * sin(-xomi + xli - g32) +
+                   sat->d4410 * sin(x2omi + x2li - g44) + sat->d4422 * sin(x2li - g44) +
+                   sat->d5220 * sin(xomi + xli - g52) + sat->d5232 * sin(-xomi + xli - g52) +
+                   sat->d5421 * sin(xomi + x2li - g54) + sat->d5433 * sin(-xomi + x2li - g54);
+            xldot = xni + sat->xfact;
+            xnddt = sat->d2201 * cos(x2omi + xli - g22) + sat->d2211 * cos(xli - g22) +
+                    sat->d3210 * cos(xomi + xli - g32) + sat->d3222 * cos(-xomi + xli - g32) +
+                    sat->d5220 * cos(xomi + xli - g52) + sat->d5232 * cos(-xomi + xli - g52) +
+                    2.0 * (sat->d4410 * cos(x2omi + x2li - g44) +
+                           sat->d4422 * cos(x2li - g44) + sat->d5421 * cos(xomi + x2li - g54) +
+                           sat->d5433 * cos(-xomi + x2li - g54));
+            xnddt = xnddt * xldot;
+        }
+
+        if (fabs(t - atime) < stepp) {
+            ft = t - atime;
+            break;
+        }
+
+        xli = xli + xldot * delt + xndt * step2;
+        xni = xni + xndt * delt + xnddt * step2;
+        atime = atime + delt;
+    }
+
+    if (resonance != NULL) {
+        resonance->atime = atime;
+        resonance->xli = xli;
+        resonance->xni = xni;
+    }
+
+    m->nm = xni + xndt * ft + xnddt * ft * ft * 0.5;
+    SpiceDouble xl = xli + xldot * ft + xndt * ft * ft * 0.5;
+    if (sat->irez != 1) {
+        m->mm = xl - 2.0 * m->nodem + 2.0 * theta;
+    } else {
+        m->mm = xl - m->nodem - m->argpm + theta;
+    }
+}
+
+/**
+ * Applies the lunar and solar periodic effects (the
+ * "dpper" procedure of the reference implementation).
+ */
+static void apply_deep_space_periodics(const gate_sgp4 *sat, SpiceDouble t, mean_elements *p) {
+    SpiceDouble zm = sat->zmos + ZNS * t;
+    SpiceDouble zf = zm + 2.0 * ZES * sin(zm);
+    SpiceDouble sinzf = sin(zf);
+    SpiceDouble f2 = 0.5 * sinzf * sinzf - 0.25;
+    SpiceDouble f3 = -0.5 * sinzf * cos(zf);
+    SpiceDouble ses = sat->se2 * f2 + sat->se3 * f3;
+    SpiceDouble sis = sat->si2 * f2 + sat->si3 * f3;
+    SpiceDouble sls = sat->sl2 * f2 + sat->sl3 * f3 + sat->sl4 * sinzf;
+    SpiceDouble sghs = sat->sgh2 * f2 + sat->sgh3 * f3 + sat->sgh4 * sinzf;
+    SpiceDouble shs = sat->sh2 * f2 + sat->sh3 * f3;
+
+    zm = sat->zmol + ZNL * t;
+    zf = zm + 2.0 * ZEL * sin(zm);
+    sinzf = sin(zf);
+    f2 = 0.5 * sinzf * sinzf - 0.25;
+    f3 = -0.5 * sinzf * cos(zf);
+    SpiceDouble sel = sat->ee2 * f2 + sat->e3 * f3;
+    SpiceDouble sil = sat->xi2 * f2 + sat->xi3 * f3;
+    SpiceDouble sll = sat->xl2 * f2 + sat->xl3 * f3 + sat->xl4 * sinzf;
+    SpiceDouble sghl = sat->xgh2 * f2 + sat->xgh3 * f3 + sat->xgh4 * sinzf;
+    SpiceDouble shll = sat->xh2 * f2 + sat->xh3 * f3;
+
+    SpiceDouble pe = ses + sel - sat->peo;
+    SpiceDouble pinc = sis + sil - sat->pinco;
+    SpiceDouble pl = sls + sll - sat->plo;
+    SpiceDouble pgh = sghs + sghl - sat->pgho;
+    SpiceDouble ph = shs + shll - sat->pho;
+
+    p->inclm = p->inclm + pinc;
+    p->em = p->em + pe;
+    SpiceDouble sinip = sin(p->inclm);
+    SpiceDouble cosip = cos(p->inclm);
+
+    if (p->inclm >= 0.2) {
+        ph = ph / sinip;
+        pgh = pgh - cosip * ph;
+        p->argpm = p->argpm + pgh;
+        p->nodem = p->nodem + ph;
+        p->mm = p->mm + pl;
+    } else {
+        // Lyddane modification for low inclinations
+        SpiceDouble sinop = sin(p->nodem);
+        SpiceDouble cosop = cos(p->nodem);
+        SpiceDouble alfdp = sinip * sinop;
+        SpiceDouble betdp = sinip * cosop;
+        SpiceDouble dalf = ph * cosop + pinc * cosip * sinop;
+        SpiceDouble dbet = -ph * sinop + pinc * cosip * cosop;
+        alfdp = alfdp + dalf;
+        betdp = betdp + dbet;
+        p->nodem = fmod(p->nodem, TWOPI);
+        if (p->nodem < 0.0) {
+            p->nodem = p->nodem + TWOPI;
+        }
+        SpiceDouble xls = p->mm + p->argpm + cosip * p->nodem;
+        SpiceDouble dls = pl + pgh - pinc * p->nodem * sinip;
+        xls = xls + dls;
+        SpiceDouble xnoh = p->nodem;
+        p->nodem = atan2(alfdp, betdp);
+        if (p->nodem < 0.0) {
+            p->nodem = p->nodem + TWOPI;
+        }
+        if (fabs(xnoh - p->nodem) > M_PI) {
+            if (p->nodem < xnoh) {
+                p->nodem = p->nodem + TWOPI;
+            } else {
+                p->nodem = p->nodem - TWOPI;
+            }
+        }
+        p->mm = p->mm + pl;
+        p->argpm = xls - p->mm - cosip * p->nodem;
+    }
+}
+
+gate_sgp4_status gate_sgp4_init(ConstSpiceDouble elements[GATE_TLE_ELEMENTS_LEN], gate_sgp4 *sat) {
+    memset(sat, 0, sizeof(*sat));
+    sat->epoch = elements[GATE_TLE_EPOCH];
+    sat->bstar = elements[GATE_TLE_BSTAR];
+    sat->ecco = elements[GATE_TLE_ECC];
+    sat->argpo = elements[GATE_TLE_OMEGA];
+    sat->inclo = elements[GATE_TLE_INCL];
+    sat->mo = elements[GATE_TLE_MO];
+    sat->no = elements[GATE_TLE_NO];
+    sat->nodeo = elements[GATE_TLE_NODE0];
+
+    // The model measures time in UTC days since 1950
+    // January 0.0
+    SpiceDouble delta;
+    deltet_c(sat->epoch, "ET", &delta);
+    SpiceDouble epoch = j2000_c() + (sat->epoch - delta) / SEC_PER_DAY - JD_1950;
+
+    SpiceDouble ss = 78.0 / RADIUS_EARTH_KM + 1.0;
+    SpiceDouble qzms2ttemp = (120.0 - 78.0) / RADIUS_EARTH_KM;
+    SpiceDouble qzms2t = qzms2ttemp * qzms2ttemp * qzms2ttemp * qzms2ttemp;
+
+    // Recover the original mean motion from the Kozai mean
+    // motion given in the element set (the "initl"
+    // procedure of the reference implementation)
+    SpiceDouble eccsq = sat->ecco * sat->ecco;
+    SpiceDouble omeosq = 1.0 - eccsq;
+    SpiceDouble rteosq = sqrt(omeosq);
+    SpiceDouble cosio = cos(sat->inclo);
+    SpiceDouble cosio2 = cosio * cosio;
+
+    SpiceDouble ak = pow(XKE / sat->no, X2O3);
+    SpiceDouble d1 = 0.75 * J2 * (3.0 * cosio2 - 1.0) / (rteosq * omeosq);
+    SpiceDouble del = d1 / (ak * ak);
+    SpiceDouble adel = ak * (1.0 - del * del - del * (1.0 / 3.0 + 134.0 * del * del / 81.0));
+    del = d1 / (adel * adel);
+    sat->no = sat->no / (1.0 + del);
+
+    SpiceDouble ao = pow(XKE / sat->no, X2O3);
+    sat->ao = ao;
+    SpiceDouble sinio = sin(sat->inclo);
+    SpiceDouble po = ao * omeosq;
+    SpiceDouble con42 = 1.0 - 5.0 * cosio2;
+    sat->con41 = -con42 - cosio2 - cosio2;
+    SpiceDouble posq = po * po;
+    SpiceDouble rp = ao * (1.0 - sat->ecco);
+
+    // Sidereal time at the epoch as computed by AFSPC
+    SpiceDouble ts70 = epoch - 7305.0;
+    SpiceDouble ds70 = floor(ts70 + 1.0e-8);
+    SpiceDouble tfrac = ts70 - ds70;
+    SpiceDouble c1 = 1.72027916940703639e-2;
+    SpiceDouble thgr70 = 1.7321343856509374;
+    SpiceDouble fk5r = 5.07551419432269442e-15;
+    SpiceDouble c1p2p = c1 + TWOPI;
+    sat->gsto = fmod(thgr70 + c1 * ds70 + c1p2p * tfrac + ts70 * ts70 * fk5r, TWOPI);
+    if (sat->gsto < 0.0) {
+        sat->gsto = sat->gsto + TWOPI;
+    }
+
+    if (omeosq < 0.0 && sat->no < 0.0) {
+        return GATE_SGP4_ERR_ECCENTRICITY;
+    }
+
+    sat->isimp = rp < 220.0 / RADIUS_EARTH_KM + 1.0;
+    SpiceDouble sfour = ss;
+    SpiceDouble qzms24 = qzms2t;
+    SpiceDouble perige = (rp - 1.0) * RADIUS_EARTH_KM;
+
+    // For perigees below 156 km, s and qoms2t are altered
+    if (perige < 156.0) {
+        sfour = perige - 78.0;
+        if (perige < 98.0) {
+            sfour = 20.0;
+        }
+        qzms24 = pow((120.0 - sfour) / RADIUS_EARTH_KM, 4.0);
+        sfour = sfour / RADIUS_EARTH_KM + 1.0;
+    }
+    SpiceDouble pinvsq = 1.0 / posq;
+
+    SpiceDouble tsi = 1.0 / (ao - sfour);
+    sat->eta = ao * sat->ecco * tsi;
+    SpiceDouble etasq = sat->eta * sat->eta;
+    SpiceDouble eeta = sat->ecco * sat->eta;
+    SpiceDouble psisq = fabs(1.0 - etasq);
+    SpiceDouble coef = qzms24 * pow(tsi, 4.0);
+    SpiceDouble coef1 = coef / pow(psisq, 3.5);
+    SpiceDouble cc2 = coef1 * sat->no * (ao * (1.0 + 1.5 * etasq + eeta * (4.0 + etasq)) +
+                                         0.375 * J2 * tsi / psisq * sat->con41 *
+                                         (8.0 + 3.0 * etasq * (8.0 + etasq)));
+    sat->cc1 = sat->bstar * cc2;
+    SpiceDouble cc3 = 0.0;
+    if (sat->ecco > 1.0e-4) {
+        cc3 = -2.0 * coef * tsi * J3OJ2 * sat->no * sinio / sat->ecco;
+    }
+    sat->x1mth2 = 1.0 - cosio2;
+    sat->cc4 = 2.0 * sat->no * coef1 * ao * omeosq *
+               (sat->eta * (2.0 + 0.5 * etasq) + sat->ecco * (0.5 + 2.0 * etasq) -
+                J2 * tsi / (ao * psisq) *
+                (-3.0 * sat->con41 * (1.0 - 2.0 * eeta + etasq * (1.5 - 0.5 * eeta)) +
+                 0.75 * sat->x1mth2 * (2.0 * etasq - eeta * (1.0 + etasq)) * cos(2.0 * sat->argpo)));
+    sat->cc5 = 2.0 * coef1 * ao * omeosq * (1.0 + 2.75 * (etasq + eeta) + eeta * etasq);
+    SpiceDouble cosio4 = cosio2 * cosio2;
+    SpiceDouble temp1 = 1.5 * J2 * pinvsq * sat->no;
+    SpiceDouble temp2 = 0.5 * temp1 * J2 * pinvsq;
+    SpiceDouble temp3 = -0.46875 * J4 * pinvsq * pinvsq * sat->no;
+    sat->mdot = sat->no + 0.5 * temp1 * rteosq * sat->con41 +
+                0.0625 * temp2 * rteosq * (13.0 - 78.0 * cosio2 + 137.0 * cosio4);
+    sat->argpdot = -0.5 * temp1 * con42 + 0.0625 * temp2 * (7.0 - 114.0 * cosio2 + 395.0 * cosio4) +
+                   temp3 * (3.0 - 36.0 * cosio2 + 49.0 * cosio4);
+    SpiceDouble xhdot1 = -temp1 * cosio;
+    sat->nodedot = xhdot1 + (0.5 * temp2 * (4.0 - 19.0 * cosio2) + 2.0 * temp3 * (3.0 - 7.0 * cosio2)) * cosio;
+    SpiceDouble xpidot = sat->argpdot + sat->nodedot;
+    sat->omgcof = sat->bstar * cc3 * cos(sat->argpo);
+    sat->xmcof = 0.0;
+    if (sat->ecco > 1.0e-4) {
+        sat->xmcof = -X2O3 * coef * sat->bstar / eeta;
+    }
+    sat->nodecf = 3.5 * omeosq * xhdot1 * sat->cc1;
+    sat->t2cof = 1.5 * sat->cc1;
+    if (fabs(cosio + 1.0) > 1.5e-12) {
+        sat->xlcof = -0.25 * J3OJ2 * sinio * (3.0 + 5.0 * cosio) / (1.0 + cosio);
+    } else {
+        sat->xlcof = -0.25 * J3OJ2 * sinio * (3.0 + 5.0 * cosio) / TEMP4;
+    }
+    sat->aycof = -0.5 * J3OJ2 * sinio;
+    SpiceDouble delmotemp = 1.0 + sat->eta * cos(sat->mo);
+    sat->delmo = delmotemp * delmotemp * delmotemp;
+    sat->sinmao = sin(sat->mo);
+    sat->x7thm1 = 7.0 * cosio2 - 1.0;
+
+    if (TWOPI / sat->no >= GATE_TLE_DEEP_SPACE_PERIOD) {
+        sat->is_deep_space = SPICETRUE;
+        sat->isimp = SPICETRUE;
+
+        deep_space_common common = {0};
+        init_deep_space_common(epoch, sat, &common);
+        init_deep_space(&common, eccsq, xpidot, sat);
+    }
+
+    if (!sat->isimp) {
+        SpiceDouble cc1sq = sat->cc1 * sat->cc1;
+        sat->d2 = 4.0 * ao * tsi * cc1sq;
+        SpiceDouble temp = sat->d2 * tsi * sat->cc1 / 3.0;
+        sat->d3 = (17.0 * ao + sfour) * temp;
+        sat->d4 = 0.5 * temp * ao * tsi * (221.0 * ao + 31.0 * sfour) * sat->cc1;
+        sat->t3cof = sat->d2 + 2.0 * cc1sq;
+        sat->t4cof = 0.25 * (3.0 * sat->d3 + sat->cc1 * (12.0 * sat->d2 + 10.0 * cc1sq));
+        sat->t5cof = 0.2 * (3.0 * sat->d4 + 12.0 * sat->cc1 * sat->d3 + 6.0 * sat->d2 * sat->d2 +
+                            15.0 * cc1sq * (2.0 * sat->d2 + cc1sq));
+    }
+
+    // Make sure that the elements can be propagated at all
+    SpiceDouble state[6];
+    return gate_sgp4_propagate(sat, sat->epoch, state);
+}
+
+gate_sgp4_status gate_sgp4_propagate(const gate_sgp4 *sat, SpiceDouble et, SpiceDouble state[6]) {
+    return gate_sgp4_propagate_resume(sat, NULL, et, state);
+}
+
+gate_sgp4_status gate_sgp4_propagate_resume(const gate_sgp4 *sat, gate_sgp4_resonance *resonance, SpiceDouble et,
+                                            SpiceDouble state[6]) {
+    SpiceDouble t = (et - sat->epoch) / SEC_PER_MIN;
+
+    // Secular gravity and atmospheric drag
+    SpiceDouble xmdf = sat->mo + sat->mdot * t;
+    SpiceDouble argpdf = sat->argpo + sat->argpdot * t;
+    SpiceDouble nodedf = sat->nodeo + sat->nodedot * t;
+    SpiceDouble t2 = t * t;
+
+    mean_elements m;
+    m.argpm = argpdf;
+    m.mm = xmdf;
+    m.nodem = nodedf + sat->nodecf * t2;
+    m.nm = sat->no;
+    m.em = sat->ecco;
+    m.inclm = sat->inclo;
+
+    SpiceDouble tempa = 1.0 - sat->cc1 * t;
+    SpiceDouble tempe = sat->bstar * sat->cc4 * t;
+    SpiceDouble templ = sat->t2cof * t2;
+
+    if (!sat->isimp) {
+        SpiceDouble delomg = sat->omgcof * t;
+        SpiceDouble delmtemp = 1.0 + sat->eta * cos(xmdf);
+        SpiceDouble delm = sat->xmcof * (delmtemp * delmtemp * delmtemp - sat->delmo);
+        SpiceDouble temp = delomg + delm;
+        m.mm = xmdf + temp;
+        m.argpm = argpdf - temp;
+        SpiceDouble t3 = t2 * t;
+        SpiceDouble t4 = t3 * t;
+        tempa = tempa - sat->d2 * t2 - sat->d3 * t3 - sat->d4 * t4;
+        tempe = tempe + sat->bstar * sat->cc5 * (sin(m.mm) - sat->sinmao);
+        templ = templ + sat->t3cof * t3 + t4 * (sat->t4cof + t * sat->t5cof);
+    }
+
+    if (sat->is_deep_space) {
+        apply_deep_space_secular(sat, resonance, t, &m);
+    }
+
+    if (m.nm <= 0.0) {
+        return GATE_SGP4_ERR_MEAN_MOTION;
+    }
+
+    // The mean motion only changes for deep space objects
+    SpiceDouble am = (sat->is_deep_space ? pow(XKE / m.nm, X2O3) : sat->ao) * tempa * tempa;
+    SpiceDouble nm = XKE / pow(am, 1.5);
+    m.em = m.em - tempe;
+
+    if (m.em >= 1.0 || m.em < -0.001) {
+        return GATE_SGP4_ERR_ECCENTRICITY;
+    }
+    if (m.em < 1.0e-6) {
+        m.em = 1.0e-6;
+    }
+    m.mm = m.mm + sat->no * templ;
+    SpiceDouble xlm = m.mm + m.argpm + m.nodem;
+
+    m.nodem = fmod(m.nodem, TWOPI);
+    m.argpm = fmod(m.argpm, TWOPI);
+    xlm = fmod(xlm, TWOPI);
+    m.mm = fmod(xlm - m.argpm - m.nodem, TWOPI);
+
+    // Lunar and solar periodics
+    SpiceDouble aycof = sat->aycof;
+    SpiceDouble xlcof = sat->xlcof;
+    SpiceDouble con41 = sat->con41;
+    SpiceDouble x1mth2 = sat->x1mth2;
+    SpiceDouble x7thm1 = sat->x7thm1;
+    if (sat->is_deep_space) {
+        apply_deep_space_periodics(sat, t, &m);
+        if (m.inclm < 0.0) {
+            m.inclm = -m.inclm;
+            m.nodem = m.nodem + M_PI;
+            m.argpm = m.argpm - M_PI;
+        }
+        if (m.em < 0.0 || m.em > 1.0) {
+            return GATE_SGP4_ERR_PERTURBED_ECCENTRICITY;
+        }
+    }
+
+    SpiceDouble sinip = sin(m.inclm);
+    SpiceDouble cosip = cos(m.inclm);
+    if (sat->is_deep_space) {
+        aycof = -0.5 * J3OJ2 * sinip;
+        if (fabs(cosip + 1.0) > 1.5e-12) {
+            xlcof = -0.25 * J3OJ2 * sinip * (3.0 + 5.0 * cosip) / (1.0 + cosip);
+        } else {
+            xlcof = -0.25 * J3OJ2 * sinip * (3.0 + 5.0 * cosip) / TEMP4;
+        }
+    }
+
+    // Long period periodics
+    SpiceDouble axnl = m.em * cos(m.argpm);
+    SpiceDouble temp = 1.0 / (am * (1.0 - m.em * m.em));
+    SpiceDouble aynl = m.em * sin(m.argpm) + temp * aycof;
+    SpiceDouble xl = m.mm + m.argpm + m.nodem + temp * xlcof * axnl;
+
+    // Solve Kepler's equation
+    SpiceDouble u = fmod(xl - m.nodem, TWOPI);
+    SpiceDouble eo1 = u;
+    SpiceDouble tem5 = 9999.9;
+    SpiceDouble sineo1 = 0.0;
+    SpiceDouble coseo1 = 0.0;
+    for (int ktr = 1; fabs(tem5) >= 1.0e-12 && ktr <= 10; ++ktr) {
+        sineo1 = sin(eo1);
+        coseo1 = cos(eo1);
+        tem5 = 1.0 - coseo1 * axnl - sineo1 * aynl;
+        tem5 = (u - aynl * coseo1 + axnl * sineo1 - eo1) / tem5;
+        if (fabs(tem5) >= 0.95) {
+            tem5 = tem5 > 0.0 ? 0.95 : -0.95;
+        }
+        eo1 = eo1 + tem5;
+    }
+
+    // Short period preliminary quantities
+    SpiceDouble ecose = axnl * coseo1 + aynl * sineo1;
+    SpiceDouble esine = axnl * sineo1 - aynl * coseo1;
+    SpiceDouble el2 = axnl * axnl + aynl * aynl;
+    SpiceDouble pl = am * (1.0 - el2);
+    if (pl < 0.0) {
+        return GATE_SGP4_ERR_SEMI_LATUS_RECTUM;
+    }
+
+    SpiceDouble rl = am * (1.0 - ecose);
+    SpiceDouble rdotl = sqrt(am) * esine / rl;
+    SpiceDouble rvdotl = sqrt(pl) / rl;
+    SpiceDouble betal = sqrt(1.0 - el2);
+    temp = esine / (1.0 + betal);
+    SpiceDouble sinu = am / rl * (sineo1 - aynl - axnl * temp);
+    SpiceDouble cosu = am / rl * (coseo1 - axnl + aynl * temp);
+    SpiceDouble su = atan2(sinu, cosu);
+    SpiceDouble sin2u = (cosu + cosu) * sinu;
+    SpiceDouble cos2u = 1.0 - 2.0 * sinu * sinu;
+    temp = 1.0 / pl;
+    SpiceDouble temp1 = 0.5 * J2 * temp;
+    SpiceDouble temp2 = temp1 * temp;
+
+    // Short period periodics
+    if (sat->is_deep_space) {
+        SpiceDouble cosisq = cosip * cosip;
+        con41 = 3.0 * cosisq - 1.0;
+        x1mth2 = 1.0 - cosisq;
+        x7thm1 = 7.0 * cosisq - 1.0;
+    }
+    SpiceDouble mrt = rl * (1.0 - 1.5 * temp2 * betal * con41) + 0.5 * temp1 * x1mth2 * cos2u;
+    su = su - 0.25 * temp2 * x7thm1 * sin2u;
+    SpiceDouble xnode = m.nodem + 1.5 * temp2 * cosip * sin2u;
+    SpiceDouble xinc = m.inclm + 1.5 * temp2 * cosip * sinip * cos2u;
+    SpiceDouble mvt = rdotl - nm * temp1 * x1mth2 * sin2u / XKE;
+    SpiceDouble rvdot = rvdotl + nm * temp1 * (x1mth2 * cos2u + 1.5 * con41) / XKE;
+
+    // Orientation vectors
+    SpiceDouble sinsu = sin(su);
+    SpiceDouble cossu = cos(su);
+    SpiceDouble snod = sin(xnode);
+    SpiceDouble cnod = cos(xnode);
+    SpiceDouble sini = sin(xinc);
+    SpiceDouble cosi = cos(xinc);
+    SpiceDouble xmx = -snod * cosi;
+    SpiceDouble xmy = cnod * cosi;
+    SpiceDouble ux = xmx * sinsu + cnod * cossu;
+    SpiceDouble uy = xmy * sinsu + snod * cossu;
+    SpiceDouble uz = sini * sinsu;
+    SpiceDouble vx = xmx * cossu - cnod * sinsu;
+    SpiceDouble vy = xmy * cossu - snod * sinsu;
+    SpiceDouble vz = sini * cossu;
+
+    state[0] = mrt * ux * RADIUS_EARTH_KM;
+    state[1] = mrt * uy * RADIUS_EARTH_KM;
+    state[2] = mrt * uz * RADIUS_EARTH_KM;
+    state[3] = (mvt * ux + rvdot * vx) * VKMPERSEC;
+    state[4] = (mvt * uy + rvdot * vy) * VKMPERSEC;
+    state[5] = (mvt * uz + rvdot * vz) * VKMPERSEC;
+
+    if (mrt < 1.0) {
+        return GATE_SGP4_ERR_DECAYED;
+    }
+
+    return GATE_SGP4_OK;
+}
+
+ConstSpiceChar *gate_sgp4_status_string(gate_sgp4_status status) {
+    switch (status) {
+        case GATE_SGP4_OK:
+            return "OK";
+        case GATE_SGP4_ERR_ECCENTRICITY:
+            return "Mean eccentricity out of range";
+        case GATE_SGP4_ERR_MEAN_MOTION:
+            return "Mean motion is not positive";
+        case GATE_SGP4_ERR_PERTURBED_ECCENTRICITY:
+            return "Perturbed eccentricity out of range";
+        case GATE_SGP4_ERR_SEMI_LATUS_RECTUM:
+            return "Semi-latus rectum is negative";
+        case GATE_SGP4_ERR_DECAYED:
+            return "Satellite has decayed";
+        default:
+            return "Unknown status";
+    }
+}
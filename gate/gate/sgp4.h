@@ -0,0 +1,222 @@
+/**
+ * @file
+ * Reentrant implementation of the SGP4/SDP4 satellite
+ * propagation models.
+ *
+ * The SPICE Toolkit propagates TLEs using ev2lin_() for
+ * near-Earth objects and dpspce_() for deep space objects.
+ * Both routines are translated from Fortran and keep the
+ * initialization derived from the last element set they
+ * were given in SAVE variables. This means that every
+ * call with a different satellite repeats the whole
+ * initialization, and that they cannot be called from
+ * more than one thread.
+ *
+ * The procedures in this file instead keep everything
+ * derived from an element set in a gate_sgp4 struct that
+ * is computed once by gate_sgp4_init(). Propagating only
+ * reads from that struct, so any number of threads may
+ * propagate the same or different satellites at once.
+ *
+ * The implementation follows "Revisiting Spacetrack Report
+ * #3" by Vallado, Crawford, Hujsak and Kelso (AIAA
+ * 2006-6753) [[1]] in AFSPC compatibility mode, using the
+ * same WGS-72 constants that gatecli passes to ev2lin_().
+ * That paper corrects a few errors in the original
+ * Spacetrack Report #3 Fortran that ev2lin_() and dpspce_()
+ * descend from, and solves Kepler's equation to a tighter
+ * tolerance, so results are not bit-for-bit identical.
+ * Compared to ev2lin_() and dpspce_() within a day of the
+ * element set epoch, positions are expected to agree to
+ * within GATE_SGP4_NEAR_EARTH_TOLERANCE kilometers for
+ * near-Earth objects and GATE_SGP4_DEEP_SPACE_TOLERANCE
+ * kilometers for deep space objects.
+ *
+ * Like ev2lin_() and dpspce_(), the output states are
+ * relative to the center of the Earth in the True Equator,
+ * Mean Equinox (TEME) frame of the model, which gatecli
+ * treats as J2000.
+ *
+ * [1]: https://celestrak.org/publications/AIAA/2006-6753/
+ */
+
+#ifndef GATE_SGP4_H
+#define GATE_SGP4_H
+
+#include <cspice/SpiceUsr.h>
+#include "tle.h"
+
+/**
+ * WGS-72 constants used by the model, which are the same
+ * as the geophysical constants that gatecli passes to
+ * ev2lin_() and dpspce_().
+ */
+#define GATE_SGP4_J2 1.082616e-3
+#define GATE_SGP4_J3 (-2.53881e-6)
+#define GATE_SGP4_J4 (-1.65597e-6)
+#define GATE_SGP4_XKE 7.43669161e-2
+#define GATE_SGP4_RADIUS_EARTH_KM 6378.135
+
+/**
+ * Expected maximum position difference in kilometers from
+ * ev2lin_() within a day of the epoch of the elements.
+ */
+#define GATE_SGP4_NEAR_EARTH_TOLERANCE 0.1
+
+/**
+ * Expected maximum position difference in kilometers from
+ * dpspce_() within a day of the epoch of the elements.
+ */
+#define GATE_SGP4_DEEP_SPACE_TOLERANCE 5.0
+
+/**
+ * Result of initializing or propagating a satellite.
+ *
+ * The values match the error codes of the reference
+ * implementation.
+ */
+typedef enum {
+    GATE_SGP4_OK = 0,
+    /**
+     * The mean eccentricity is outside of [0, 1).
+     */
+    GATE_SGP4_ERR_ECCENTRICITY = 1,
+    /**
+     * The mean motion is not positive.
+     */
+    GATE_SGP4_ERR_MEAN_MOTION = 2,
+    /**
+     * The perturbed eccentricity is outside of [0, 1].
+     */
+    GATE_SGP4_ERR_PERTURBED_ECCENTRICITY = 3,
+    /**
+     * The semi-latus rectum is negative.
+     */
+    GATE_SGP4_ERR_SEMI_LATUS_RECTUM = 4,
+    /**
+     * The satellite has decayed below the surface of the
+     * Earth.
+     */
+    GATE_SGP4_ERR_DECAYED = 6
+} gate_sgp4_status;
+
+/**
+ * The initialized state of a single satellite.
+ *
+ * The fields are named after the variables of the
+ * reference implementation and should be treated as
+ * opaque.
+ */
+typedef struct {
+    /**
+     * The epoch of the elements in ephemeris time.
+     */
+    SpiceDouble epoch;
+
+    SpiceBoolean is_deep_space;
+    SpiceBoolean isimp;
+    SpiceInt irez;
+
+    SpiceDouble bstar, ecco, argpo, inclo, mo, no, nodeo;
+    SpiceDouble ao, gsto;
+
+    // Near-Earth
+    SpiceDouble aycof, con41, cc1, cc4, cc5, d2, d3, d4, delmo, eta, argpdot, omgcof, sinmao,
+            t2cof, t3cof, t4cof, t5cof, x1mth2, x7thm1, mdot, nodedot, xlcof, xmcof, nodecf;
+
+    // Deep space
+    SpiceDouble d2201, d2211, d3210, d3222, d4410, d4422, d5220, d5232, d5421, d5433,
+            dedt, del1, del2, del3, didt, dmdt, dnodt, domdt,
+            e3, ee2, peo, pgho, pho, pinco, plo, se2, se3, sgh2, sgh3, sgh4, sh2, sh3, si2, si3,
+            sl2, sl3, sl4, xfact, xgh2, xgh3, xgh4, xh2, xh3, xi2, xi3, xl2, xl3, xl4, xlamo,
+            zmol, zmos;
+} gate_sgp4;
+
+/**
+ * The point that the integration of the resonance effects
+ * of a deep space satellite last reached.
+ *
+ * A zero initialized checkpoint starts the integration at
+ * the epoch of the elements.
+ */
+typedef struct {
+    SpiceDouble atime, xli, xni;
+} gate_sgp4_resonance;
+
+/**
+ * Initializes the propagator state for a satellite.
+ *
+ * Requires a leapseconds kernel to be loaded in order to
+ * determine the sidereal time at the epoch of the
+ * elements. Because of this, initialization should only
+ * happen on one thread at a time.
+ *
+ * @param elements the elements of the satellite in the
+ * layout produced by getelm_c() or gate_parse_tle()
+ * (input)
+ * @param sat the initialized propagator state (output)
+ * @return GATE_SGP4_OK if the satellite can be propagated,
+ * otherwise the reason it cannot
+ */
+gate_sgp4_status gate_sgp4_init(ConstSpiceDouble elements[GATE_TLE_ELEMENTS_LEN], gate_sgp4 *sat);
+
+/**
+ * Computes the state of a satellite at the given time.
+ *
+ * This procedure does not modify the given propagator
+ * state and does not call into SPICE, so it may be used
+ * concurrently from any number of threads.
+ *
+ * For deep space objects in 12 or 24 hour resonant orbits,
+ * the resonance effects are integrated from the epoch in
+ * half-day steps on every call, so the cost grows with the
+ * distance of the given time from the epoch. Use
+ * gate_sgp4_propagate_resume() to avoid this when
+ * propagating one satellite to a series of times.
+ *
+ * @param sat the initialized propagator state (input)
+ * @param et the ephemeris time at which to compute the
+ * state (input)
+ * @param state the position in kilometers and velocity in
+ * kilometers per second of the satellite relative to the
+ * center of the Earth (output)
+ * @return GATE_SGP4_OK if the state was computed,
+ * otherwise the reason it could not be
+ */
+gate_sgp4_status gate_sgp4_propagate(const gate_sgp4 *sat, SpiceDouble et, SpiceDouble state[6]);
+
+/**
+ * Computes the state of a satellite at the given time,
+ * resuming the integration of resonance effects from a
+ * checkpoint left by an earlier call.
+ *
+ * The integration resumes if the checkpoint lies between
+ * the epoch and the given time, and otherwise restarts
+ * from the epoch, so times moving away from the epoch are
+ * cheapest. The result is identical to that of
+ * gate_sgp4_propagate(). Each thread must use its own
+ * checkpoint.
+ *
+ * @param sat the initialized propagator state (input)
+ * @param resonance the checkpoint, which must only be used
+ * with this satellite (input/output)
+ * @param et the ephemeris time at which to compute the
+ * state (input)
+ * @param state the position in kilometers and velocity in
+ * kilometers per second of the satellite relative to the
+ * center of the Earth (output)
+ * @return GATE_SGP4_OK if the state was computed,
+ * otherwise the reason it could not be
+ */
+gate_sgp4_status gate_sgp4_propagate_resume(const gate_sgp4 *sat, gate_sgp4_resonance *resonance, SpiceDouble et,
+                                            SpiceDouble state[6]);
+
+/**
+ * Obtains a human readable description of a status code.
+ *
+ * @param status the status code (input)
+ * @return a static string describing the status
+ */
+ConstSpiceChar *gate_sgp4_status_string(gate_sgp4_status status);
+
+#endif // GATE_SGP4_H
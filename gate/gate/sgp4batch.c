@@ -0,0 +1,369 @@
+#include "sgp4batch.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define J2 GATE_SGP4_J2
+#define XKE GATE_SGP4_XKE
+#define RADIUS_EARTH_KM GATE_SGP4_RADIUS_EARTH_KM
+#define VKMPERSEC (RADIUS_EARTH_KM * XKE / 60.0)
+
+#define TWOPI (2.0 * M_PI)
+#define SEC_PER_MIN 60.0
+#define KEPLER_ITERATIONS 10
+
+// Cody-Waite split of pi/4 and polynomial coefficients for
+// sine and cosine on [-pi/4, pi/4], from the Cephes library
+#define FOUR_OVER_PI 1.27323954473516268615
+#define DP1 7.85398125648498535156e-1
+#define DP2 3.77489470793079817668e-8
+#define DP3 2.69515142907905952645e-15
+
+// The coefficients copied directly from gate_sgp4
+#define FOREACH_COPIED_COEFFICIENT(X) \
+    X(epoch) X(no) X(ecco) X(argpo) X(nodeo) X(mo) X(inclo) X(bstar) X(ao) \
+    X(mdot) X(argpdot) X(nodedot) X(nodecf) X(cc1) X(cc4) X(cc5) X(d2) X(d3) X(d4) \
+    X(t2cof) X(t3cof) X(t4cof) X(t5cof) X(omgcof) X(xmcof) X(eta) X(delmo) X(sinmao) \
+    X(aycof) X(xlcof) X(con41) X(x1mth2) X(x7thm1)
+
+// Every coefficient array of a batch
+#define FOREACH_COEFFICIENT(X) FOREACH_COPIED_COEFFICIENT(X) X(sinio) X(cosio) X(isimp)
+
+#if defined(__GNUC__) && !defined(__clang__) && defined(__x86_64__) && defined(__linux__)
+#define GATE_SIMD_CLONES __attribute__((target_clones("avx512f", "avx2", "default")))
+#else
+#define GATE_SIMD_CLONES
+#endif
+
+/**
+ * Computes the sine and cosine of an angle using only
+ * operations that the compiler can vectorize.
+ */
+static inline void lane_sincos(SpiceDouble x, SpiceDouble *s, SpiceDouble *c) {
+    SpiceDouble ax = fabs(x);
+
+    // Reduce to [-pi/4, pi/4] around the nearest even
+    // octant, then pick the polynomial and signs for that
+    // octant
+    SpiceDouble y = floor(ax * FOUR_OVER_PI);
+    y = y + (y - 2.0 * floor(y * 0.5));
+    SpiceDouble octant = y - 8.0 * floor(y * 0.125);
+    SpiceDouble z = ((ax - y * DP1) - y * DP2) - y * DP3;
+    SpiceDouble zz = z * z;
+
+    SpiceDouble ps = 1.58962301576546568060e-10;
+    ps = ps * zz - 2.50507477628578072866e-8;
+    ps = ps * zz + 2.75573136213857245213e-6;
+    ps = ps * zz - 1.98412698295895385996e-4;
+    ps = ps * zz + 8.33333333332211858878e-3;
+    ps = ps * zz - 1.66666666666666307295e-1;
+    ps = z + z * zz * ps;
+
+    SpiceDouble pc = -1.13585365213876817300e-11;
+    pc = pc * zz + 2.08757008419747316778e-9;
+    pc = pc * zz - 2.75573141792967388112e-7;
+    pc = pc * zz + 2.48015872888517045348e-5;
+    pc = pc * zz - 1.38888888888730564116e-3;
+    pc = pc * zz + 4.16666666666665929218e-2;
+    pc = 1.0 - 0.5 * zz + zz * zz * pc;
+
+    SpiceDouble swap = octant == 2.0 || octant == 6.0;
+    SpiceDouble sv = swap ? pc : ps;
+    SpiceDouble cv = swap ? ps : pc;
+    sv = octant >= 4.0 ? -sv : sv;
+    cv = octant == 2.0 || octant == 4.0 ? -cv : cv;
+
+    *s = x < 0.0 ? -sv : sv;
+    *c = cv;
+}
+
+/**
+ * Equivalents of fmax() and fmin() without the special
+ * handling of NaN, which prevents vectorization.
+ */
+static inline SpiceDouble lane_max(SpiceDouble x, SpiceDouble y) {
+    return x > y ? x : y;
+}
+
+static inline SpiceDouble lane_min(SpiceDouble x, SpiceDouble y) {
+    return x < y ? x : y;
+}
+
+/**
+ * Equivalent of fmod(x, 2 pi) that the compiler can
+ * vectorize.
+ */
+static inline SpiceDouble lane_mod_twopi(SpiceDouble x) {
+    return x - TWOPI * trunc(x / TWOPI);
+}
+
+/**
+ * Propagates one group of GATE_SGP4_LANES satellites.
+ *
+ * Each stage is written as a loop over the lanes of the
+ * group with no calls to the C library other than those
+ * which compile to single instructions, so that each loop
+ * is vectorized. This follows gate_sgp4_propagate() for
+ * near-Earth satellites step by step.
+ */
+GATE_SIMD_CLONES
+static SpiceInt propagate_group(const gate_sgp4_batch *b, SpiceInt first, SpiceDouble et,
+                                SpiceDouble (*states)[6], gate_sgp4_status *status) {
+    SpiceDouble nm[GATE_SGP4_LANES], am[GATE_SGP4_LANES];
+    SpiceDouble nodem[GATE_SGP4_LANES], axnl[GATE_SGP4_LANES], aynl[GATE_SGP4_LANES];
+    SpiceDouble u[GATE_SGP4_LANES], eo1[GATE_SGP4_LANES], sineo1[GATE_SGP4_LANES], coseo1[GATE_SGP4_LANES];
+    SpiceDouble out[6][GATE_SGP4_LANES];
+    SpiceDouble eccentricity[GATE_SGP4_LANES], semi_latus[GATE_SGP4_LANES], radius[GATE_SGP4_LANES];
+
+    // Secular gravity and atmospheric drag, long period
+    // periodics
+    for (int l = 0; l < GATE_SGP4_LANES; ++l) {
+        SpiceInt i = first + l;
+        SpiceDouble t = (et - b->epoch[i]) / SEC_PER_MIN;
+        SpiceDouble full = 1.0 - b->isimp[i];
+
+        SpiceDouble xmdf = b->mo[i] + b->mdot[i] * t;
+        SpiceDouble argpdf = b->argpo[i] + b->argpdot[i] * t;
+        SpiceDouble nodedf = b->nodeo[i] + b->nodedot[i] * t;
+        SpiceDouble t2 = t * t;
+        SpiceDouble t3 = t2 * t;
+        SpiceDouble t4 = t3 * t;
+        SpiceDouble node = nodedf + b->nodecf[i] * t2;
+
+        SpiceDouble sin_unused, cos_xmdf;
+        lane_sincos(xmdf, &sin_unused, &cos_xmdf);
+        SpiceDouble delomg = b->omgcof[i] * t;
+        SpiceDouble delmtemp = 1.0 + b->eta[i] * cos_xmdf;
+        SpiceDouble delm = b->xmcof[i] * (delmtemp * delmtemp * delmtemp - b->delmo[i]);
+        SpiceDouble temp = (delomg + delm) * full;
+        SpiceDouble mm = xmdf + temp;
+        SpiceDouble argpm = argpdf - temp;
+
+        SpiceDouble sin_mm, cos_unused;
+        lane_sincos(mm, &sin_mm, &cos_unused);
+        SpiceDouble tempa = 1.0 - b->cc1[i] * t - b->d2[i] * t2 - b->d3[i] * t3 - b->d4[i] * t4;
+        SpiceDouble tempe = b->bstar[i] * b->cc4[i] * t + full * b->bstar[i] * b->cc5[i] * (sin_mm - b->sinmao[i]);
+        SpiceDouble templ = b->t2cof[i] * t2 + full * (b->t3cof[i] * t3 + t4 * (b->t4cof[i] + t * b->t5cof[i]));
+
+        SpiceDouble a = b->ao[i] * tempa * tempa;
+        SpiceDouble e = b->ecco[i] - tempe;
+        eccentricity[l] = e;
+        e = lane_max(e, 1.0e-6);
+        mm = mm + b->no[i] * templ;
+        SpiceDouble xlm = mm + argpm + node;
+
+        node = lane_mod_twopi(node);
+        argpm = lane_mod_twopi(argpm);
+        xlm = lane_mod_twopi(xlm);
+        mm = lane_mod_twopi(xlm - argpm - node);
+
+        SpiceDouble sin_argpm, cos_argpm;
+        lane_sincos(argpm, &sin_argpm, &cos_argpm);
+        SpiceDouble ax = e * cos_argpm;
+        temp = 1.0 / (a * (1.0 - e * e));
+        SpiceDouble ay = e * sin_argpm + temp * b->aycof[i];
+        SpiceDouble xl = mm + argpm + node + temp * b->xlcof[i] * ax;
+
+        nm[l] = XKE / (a * sqrt(a));
+        am[l] = a;
+        nodem[l] = node;
+        axnl[l] = ax;
+        aynl[l] = ay;
+        u[l] = lane_mod_twopi(xl - node);
+        eo1[l] = u[l];
+    }
+
+    // Solve Kepler's equation, running the same number of
+    // iterations on every lane until all have converged
+    for (int k = 0; k < KEPLER_ITERATIONS; ++k) {
+        int pending = 0;
+        for (int l = 0; l < GATE_SGP4_LANES; ++l) {
+            lane_sincos(eo1[l], &sineo1[l], &coseo1[l]);
+            SpiceDouble tem5 = 1.0 - coseo1[l] * axnl[l] - sineo1[l] * aynl[l];
+            tem5 = (u[l] - aynl[l] * coseo1[l] + axnl[l] * sineo1[l] - eo1[l]) / tem5;
+            tem5 = lane_max(lane_min(tem5, 0.95), -0.95);
+            eo1[l] = eo1[l] + tem5;
+            pending += fabs(tem5) >= 1.0e-12;
+        }
+
+        if (pending == 0) {
+            break;
+        }
+    }
+
+    // Short period periodics and orientation
+    for (int l = 0; l < GATE_SGP4_LANES; ++l) {
+        SpiceInt i = first + l;
+        SpiceDouble ecose = axnl[l] * coseo1[l] + aynl[l] * sineo1[l];
+        SpiceDouble esine = axnl[l] * sineo1[l] - aynl[l] * coseo1[l];
+        SpiceDouble el2 = axnl[l] * axnl[l] + aynl[l] * aynl[l];
+        SpiceDouble pl = am[l] * (1.0 - el2);
+        semi_latus[l] = pl;
+        pl = lane_max(pl, 0.0);
+
+        SpiceDouble rl = am[l] * (1.0 - ecose);
+        SpiceDouble rdotl = sqrt(am[l]) * esine / rl;
+        SpiceDouble rvdotl = sqrt(pl) / rl;
+        SpiceDouble betal = sqrt(1.0 - el2);
+        SpiceDouble temp = esine / (1.0 + betal);
+        SpiceDouble sinu = am[l] / rl * (sineo1[l] - aynl[l] - axnl[l] * temp);
+        SpiceDouble cosu = am[l] / rl * (coseo1[l] - axnl[l] + aynl[l] * temp);
+        SpiceDouble sin2u = (cosu + cosu) * sinu;
+        SpiceDouble cos2u = 1.0 - 2.0 * sinu * sinu;
+        temp = 1.0 / pl;
+        SpiceDouble temp1 = 0.5 * J2 * temp;
+        SpiceDouble temp2 = temp1 * temp;
+
+        SpiceDouble mrt = rl * (1.0 - 1.5 * temp2 * betal * b->con41[i]) + 0.5 * temp1 * b->x1mth2[i] * cos2u;
+        SpiceDouble xnode = nodem[l] + 1.5 * temp2 * b->cosio[i] * sin2u;
+        SpiceDouble xinc = b->inclo[i] + 1.5 * temp2 * b->cosio[i] * b->sinio[i] * cos2u;
+        SpiceDouble mvt = rdotl - nm[l] * temp1 * b->x1mth2[i] * sin2u / XKE;
+        SpiceDouble rvdot = rvdotl + nm[l] * temp1 * (b->x1mth2[i] * cos2u + 1.5 * b->con41[i]) / XKE;
+
+        // Rather than taking atan2() of the argument of
+        // latitude only to take its sine and cosine again,
+        // rotate the unit vector (cos u, sin u) by the short
+        // period correction
+        SpiceDouble norm = sqrt(sinu * sinu + cosu * cosu);
+        SpiceDouble s0 = sinu / norm;
+        SpiceDouble c0 = cosu / norm;
+        SpiceDouble sin_du, cos_du;
+        lane_sincos(-0.25 * temp2 * b->x7thm1[i] * sin2u, &sin_du, &cos_du);
+        SpiceDouble sinsu = s0 * cos_du + c0 * sin_du;
+        SpiceDouble cossu = c0 * cos_du - s0 * sin_du;
+
+        SpiceDouble snod, cnod, sini, cosi;
+        lane_sincos(xnode, &snod, &cnod);
+        lane_sincos(xinc, &sini, &cosi);
+        SpiceDouble xmx = -snod * cosi;
+        SpiceDouble xmy = cnod * cosi;
+        SpiceDouble ux = xmx * sinsu + cnod * cossu;
+        SpiceDouble uy = xmy * sinsu + snod * cossu;
+        SpiceDouble uz = sini * sinsu;
+        SpiceDouble vx = xmx * cossu - cnod * sinsu;
+        SpiceDouble vy = xmy * cossu - snod * sinsu;
+        SpiceDouble vz = sini * cossu;
+
+        out[0][l] = mrt * ux * RADIUS_EARTH_KM;
+        out[1][l] = mrt * uy * RADIUS_EARTH_KM;
+        out[2][l] = mrt * uz * RADIUS_EARTH_KM;
+        out[3][l] = (mvt * ux + rvdot * vx) * VKMPERSEC;
+        out[4][l] = (mvt * uy + rvdot * vy) * VKMPERSEC;
+        out[5][l] = (mvt * uz + rvdot * vz) * VKMPERSEC;
+        radius[l] = mrt;
+    }
+
+    // Scatter the results back to the original order,
+    // checking for errors in the same order as
+    // gate_sgp4_propagate()
+    SpiceInt failed = 0;
+    for (int l = 0; l < GATE_SGP4_LANES; ++l) {
+        SpiceInt index = b->near_index[first + l];
+        if (index == -1) {
+            continue;
+        }
+
+        for (int j = 0; j < 6; ++j) {
+            states[index][j] = out[j][l];
+        }
+        if (eccentricity[l] >= 1.0 || eccentricity[l] < -0.001) {
+            status[index] = GATE_SGP4_ERR_ECCENTRICITY;
+        } else if (semi_latus[l] < 0.0) {
+            status[index] = GATE_SGP4_ERR_SEMI_LATUS_RECTUM;
+        } else if (radius[l] < 1.0) {
+            status[index] = GATE_SGP4_ERR_DECAYED;
+        } else {
+            status[index] = GATE_SGP4_OK;
+            continue;
+        }
+        failed++;
+    }
+
+    return failed;
+}
+
+SpiceInt gate_sgp4_batch_propagate_near(const gate_sgp4_batch *batch, SpiceInt first_group, SpiceInt end_group,
+                                        SpiceDouble et, SpiceDouble (*states)[6], gate_sgp4_status *status) {
+    SpiceInt failed = 0;
+    for (SpiceInt group = first_group; group < end_group; ++group) {
+        failed += propagate_group(batch, group * GATE_SGP4_LANES, et, states, status);
+    }
+
+    return failed;
+}
+
+
+void gate_sgp4_batch_init(SpiceInt len, const gate_sgp4 *sats, const gate_sgp4_status *init_status,
+                          gate_sgp4_batch *batch) {
+    memset(batch, 0, sizeof(*batch));
+
+    SpiceInt near_len = 0;
+    SpiceInt deep_len = 0;
+    for (SpiceInt i = 0; i < len; ++i) {
+        if (init_status[i] != GATE_SGP4_OK) {
+            continue;
+        }
+
+        if (sats[i].is_deep_space) {
+            deep_len++;
+        } else {
+            near_len++;
+        }
+    }
+
+    SpiceInt lane_cap = (near_len + GATE_SGP4_LANES - 1) / GATE_SGP4_LANES * GATE_SGP4_LANES;
+    SpiceBoolean allocated = SPICETRUE;
+#define ALLOC_COEFFICIENT(name) \
+    batch->name = malloc(lane_cap * sizeof(SpiceDouble) + 1); \
+    allocated = allocated && batch->name != NULL;
+    FOREACH_COEFFICIENT(ALLOC_COEFFICIENT)
+#undef ALLOC_COEFFICIENT
+    batch->near_index = malloc(lane_cap * sizeof(*batch->near_index) + 1);
+    batch->deep_index = malloc(deep_len * sizeof(*batch->deep_index) + 1);
+    if (!allocated || batch->near_index == NULL || batch->deep_index == NULL) {
+        gate_sgp4_batch_free(batch);
+        setmsg_c("Failed to allocate memory for the SGP4 batch");
+        sigerr_c("alloc");
+        return;
+    }
+
+    batch->lane_cap = lane_cap;
+    for (SpiceInt i = 0; i < len; ++i) {
+        if (init_status[i] != GATE_SGP4_OK) {
+            continue;
+        }
+
+        const gate_sgp4 *sat = &sats[i];
+        if (sat->is_deep_space) {
+            batch->deep_index[batch->deep_len++] = i;
+            continue;
+        }
+
+        SpiceInt lane = batch->near_len++;
+        batch->near_index[lane] = i;
+#define COPY_COEFFICIENT(name) batch->name[lane] = sat->name;
+        FOREACH_COPIED_COEFFICIENT(COPY_COEFFICIENT)
+#undef COPY_COEFFICIENT
+        batch->sinio[lane] = sin(sat->inclo);
+        batch->cosio[lane] = cos(sat->inclo);
+        batch->isimp[lane] = sat->isimp ? 1.0 : 0.0;
+    }
+
+    // Fill the last group with copies of the last satellite
+    for (SpiceInt lane = batch->near_len; lane < lane_cap; ++lane) {
+        batch->near_index[lane] = -1;
+#define PAD_COEFFICIENT(name) batch->name[lane] = batch->name[batch->near_len - 1];
+        FOREACH_COEFFICIENT(PAD_COEFFICIENT)
+#undef PAD_COEFFICIENT
+    }
+}
+
+void gate_sgp4_batch_free(gate_sgp4_batch *batch) {
+#define FREE_COEFFICIENT(name) free(batch->name);
+    FOREACH_COEFFICIENT(FREE_COEFFICIENT)
+#undef FREE_COEFFICIENT
+    free(batch->near_index);
+    free(batch->deep_index);
+
+    memset(batch, 0, sizeof(*batch));
+}
@@ -0,0 +1,199 @@
+#include "skyfilter.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define EARTH_BODY_ID 399
+#define FRAME_NAME_MAX_LEN 33
+
+// Rotation rate of the Earth in radians per second
+#define EARTH_ROTATION_RATE 7.292115e-5
+
+// Margins covering the short period perturbations of the
+// mean elements and the angle between the geocentric and
+// geodetic vertical (at most 0.2 degrees)
+#define RADIUS_MARGIN_KM 50.0
+#define RADIUS_MARGIN_FACTOR 1.02
+#define ANGLE_MARGIN_DEG 0.5
+#define NEAR_EARTH_INCLINATION_MARGIN_DEG 0.5
+#define DEEP_SPACE_INCLINATION_MARGIN_DEG 1.5
+#define RATE_MARGIN_FACTOR 1.05
+
+typedef struct {
+    const gate_sgp4 *sats;
+    const SpiceInt *candidates;
+    const SpiceDouble *reach;
+    SpiceBoolean *keep;
+
+    SpiceDouble et;
+    SpiceDouble half_span;
+    SpiceDouble rotation[3][3];
+    SpiceDouble up[3];
+} filter_job;
+
+/**
+ * Computes the largest central angle between the observer
+ * and a satellite at which the satellite can be visible,
+ * or a negative angle if it can never be visible.
+ */
+static SpiceDouble horizon_reach(const gate_sgp4 *sat, SpiceDouble observer_radius, SpiceDouble min_elevation) {
+    SpiceDouble apogee = sat->ao * (1.0 + sat->ecco) * GATE_SGP4_RADIUS_EARTH_KM;
+    apogee = apogee * RADIUS_MARGIN_FACTOR + RADIUS_MARGIN_KM;
+
+    // From the triangle formed by the center of the Earth,
+    // the observer and the satellite at min_elevation
+    SpiceDouble ratio = observer_radius * cos(min_elevation) / apogee;
+    if (ratio >= 1) {
+        return -1;
+    }
+
+    return acos(ratio) - min_elevation + ANGLE_MARGIN_DEG * rpd_c();
+}
+
+/**
+ * Bounds the rate in radians per second at which the
+ * central angle between the observer and a satellite can
+ * change, which is the fastest angular rate of the
+ * satellite, at perigee, plus the rotation of the Earth.
+ */
+static SpiceDouble angular_rate_bound(const gate_sgp4 *sat) {
+    SpiceDouble e = sat->ecco;
+    SpiceDouble n = sat->no / 60.0;
+    SpiceDouble perigee_rate = n * (1 + e) * (1 + e) / pow(1 - e * e, 1.5);
+
+    return perigee_rate * RATE_MARGIN_FACTOR + EARTH_ROTATION_RATE;
+}
+
+static void filter_chunk(void *user_data, SpiceInt begin, SpiceInt end) {
+    filter_job *job = user_data;
+
+    for (SpiceInt k = begin; k < end; ++k) {
+        const gate_sgp4 *sat = &job->sats[job->candidates[k]];
+
+        SpiceDouble state[6];
+        if (gate_sgp4_propagate(sat, job->et, state) != GATE_SGP4_OK) {
+            job->keep[k] = SPICETRUE;
+            continue;
+        }
+
+        SpiceDouble pos[3];
+        SpiceDouble norm = 0;
+        for (int r = 0; r < 3; ++r) {
+            pos[r] = job->rotation[r][0] * state[0] + job->rotation[r][1] * state[1] +
+                     job->rotation[r][2] * state[2];
+            norm += pos[r] * pos[r];
+        }
+        norm = sqrt(norm);
+
+        SpiceDouble cos_angle = (pos[0] * job->up[0] + pos[1] * job->up[1] + pos[2] * job->up[2]) / norm;
+        cos_angle = cos_angle > 1 ? 1 : cos_angle < -1 ? -1 : cos_angle;
+
+        SpiceDouble closest = acos(cos_angle) - angular_rate_bound(sat) * job->half_span;
+        job->keep[k] = closest <= job->reach[k];
+    }
+}
+
+void gate_sky_filter_build(gate_pool *pool, SpiceInt sats_len, const gate_sgp4 *sats,
+                           const gate_sgp4_status *init_status, const gate_station *observer,
+                           SpiceDouble start_et, SpiceDouble end_et, gate_sky_filter *filter) {
+    memset(filter, 0, sizeof(*filter));
+    filter->start_et = start_et;
+    filter->end_et = end_et;
+
+    SpiceInt earth_frame_id;
+    SpiceChar earth_frame[FRAME_NAME_MAX_LEN];
+    SpiceBoolean earth_frame_found;
+    cidfrm_c(EARTH_BODY_ID, FRAME_NAME_MAX_LEN, &earth_frame_id, earth_frame, &earth_frame_found);
+    if (!earth_frame_found) {
+        setmsg_c("Earth fixed frame cannot be found");
+        sigerr_c("resolve_rel_frame");
+        return;
+    }
+
+    filter_job job = {
+            .sats = sats,
+            .et = (start_et + end_et) / 2,
+            .half_span = (end_et - start_et) / 2
+    };
+
+    SpiceInt returned_count;
+    SpiceDouble radii[3];
+    bodvcd_c(EARTH_BODY_ID, "RADII", 3, &returned_count, radii);
+    pxform_c("J2000", earth_frame, job.et, job.rotation);
+    if (failed_c()) {
+        return;
+    }
+
+    SpiceDouble observer_pos[3];
+    georec_c(observer->longitude * rpd_c(), observer->latitude * rpd_c(), observer->altitude, radii[0],
+             (radii[0] - radii[2]) / radii[0], observer_pos);
+    SpiceDouble observer_radius;
+    unorm_c(observer_pos, job.up, &observer_radius);
+    SpiceDouble observer_latitude = fabs(asin(job.up[2]));
+    SpiceDouble min_elevation = observer->min_elevation * rpd_c();
+
+    filter->candidates = malloc(sats_len * sizeof(*filter->candidates) + 1);
+    SpiceDouble *reach = malloc(sats_len * sizeof(*reach) + 1);
+    job.keep = malloc(sats_len * sizeof(*job.keep) + 1);
+    if (filter->candidates == NULL || reach == NULL || job.keep == NULL) {
+        free(filter->candidates);
+        free(reach);
+        free(job.keep);
+        filter->candidates = NULL;
+        setmsg_c("Failed to allocate memory for the sky filter");
+        sigerr_c("alloc");
+        return;
+    }
+
+    // Elements-only stage: whether the ground track ever
+    // comes close enough to the latitude of the observer
+    SpiceInt len = 0;
+    for (SpiceInt i = 0; i < sats_len; ++i) {
+        if (init_status[i] != GATE_SGP4_OK) {
+            continue;
+        }
+
+        SpiceDouble sat_reach = horizon_reach(&sats[i], observer_radius, min_elevation);
+        if (sat_reach < 0) {
+            continue;
+        }
+
+        SpiceDouble max_latitude = sats[i].inclo <= halfpi_c() ? sats[i].inclo : pi_c() - sats[i].inclo;
+        max_latitude += (sats[i].is_deep_space ? DEEP_SPACE_INCLINATION_MARGIN_DEG
+                                               : NEAR_EARTH_INCLINATION_MARGIN_DEG) * rpd_c();
+        if (observer_latitude - max_latitude > sat_reach) {
+            continue;
+        }
+
+        filter->candidates[len] = i;
+        reach[len] = sat_reach;
+        len++;
+    }
+    filter->static_len = len;
+
+    // Motion stage: how close the ground point can come to
+    // the observer from where it is at the middle of the
+    // span
+    job.candidates = filter->candidates;
+    job.reach = reach;
+    gate_pool_run(pool, len, 0, filter_chunk, &job);
+
+    filter->len = 0;
+    for (SpiceInt k = 0; k < len; ++k) {
+        if (job.keep[k]) {
+            filter->candidates[filter->len++] = filter->candidates[k];
+        }
+    }
+
+    free(reach);
+    free(job.keep);
+}
+
+SpiceBoolean gate_sky_filter_covers(const gate_sky_filter *filter, SpiceDouble et) {
+    return filter->candidates != NULL && et >= filter->start_et && et <= filter->end_et;
+}
+
+void gate_sky_filter_free(gate_sky_filter *filter) {
+    free(filter->candidates);
+    memset(filter, 0, sizeof(*filter));
+}
@@ -0,0 +1,122 @@
+/**
+ * @file
+ * A cheap geometric prefilter which rules out satellites
+ * that cannot be above the horizon of an observer during
+ * a short span of time.
+ *
+ * Most of a catalog is below the horizon of any one
+ * observer at any one time, so a "what's overhead" query
+ * can skip propagating most satellites if it can prove
+ * that they are out of view. A filter is built for an
+ * observer and a span of time in two stages:
+ *
+ * 1. Using only the elements, the apogee radius of a
+ * satellite bounds how far from the observer its ground
+ * point may be while it is visible, and its inclination
+ * bounds the latitudes of its ground track. A satellite
+ * whose ground track never comes close enough to the
+ * latitude of the observer is never visible, such as a
+ * low-inclination satellite seen from high latitude.
+ * 2. The remaining satellites are propagated once, at the
+ * middle of the span. The mean motion, eccentricity and
+ * rotation of the Earth bound how fast the ground point
+ * can move, and so how close it can come to the observer
+ * for the rest of the span. This rules out satellites on
+ * the far side of the Earth, such as half of the
+ * geosynchronous belt.
+ *
+ * Both stages are conservative, with margins covering the
+ * short period perturbations of the elements and the
+ * difference between geocentric and geodetic vertical, so
+ * a satellite which is visible is never filtered out.
+ *
+ * The second stage becomes weaker as the span grows, so
+ * filters for spans of a few minutes that are rebuilt as
+ * time moves on cull the most satellites.
+ */
+
+#ifndef GATE_SKYFILTER_H
+#define GATE_SKYFILTER_H
+
+#include <cspice/SpiceUsr.h>
+#include "pool.h"
+#include "sgp4.h"
+#include "visibility.h"
+
+/**
+ * The satellites which may be visible from an observer
+ * during a span of time.
+ */
+typedef struct {
+    SpiceDouble start_et;
+    SpiceDouble end_et;
+
+    /**
+     * The number of satellites which passed the filter.
+     */
+    SpiceInt len;
+
+    /**
+     * The number of satellites which passed the first,
+     * elements-only stage of the filter.
+     */
+    SpiceInt static_len;
+
+    /**
+     * The indices of the satellites which passed the
+     * filter, in increasing order.
+     */
+    SpiceInt *candidates;
+} gate_sky_filter;
+
+/**
+ * Builds a filter for the satellites which may be visible
+ * from an observer during a span of time.
+ *
+ * Requires a PCK defining the Earth-fixed frame and the
+ * radii of the Earth to be loaded.
+ *
+ * Satellites which failed to initialize are filtered out.
+ * Satellites which fail to propagate at the middle of the
+ * span are kept, so that the caller can report them.
+ *
+ * @param pool the threads to propagate on, or NULL to use
+ * the calling thread (input)
+ * @param sats_len the number of satellites (input)
+ * @param sats the initialized propagator states (input)
+ * @param init_status the initialization status of each
+ * satellite (input)
+ * @param observer the observer, where min_elevation is the
+ * elevation in degrees above which a satellite counts as
+ * visible (input)
+ * @param start_et the ephemeris time at which the span
+ * starts (input)
+ * @param end_et the ephemeris time at which the span ends
+ * (input)
+ * @param filter the filter (output)
+ *
+ * @throws alloc if memory could not be allocated
+ */
+void gate_sky_filter_build(gate_pool *pool, SpiceInt sats_len, const gate_sgp4 *sats,
+                           const gate_sgp4_status *init_status, const gate_station *observer,
+                           SpiceDouble start_et, SpiceDouble end_et, gate_sky_filter *filter);
+
+/**
+ * Determines whether a filter may be used at the given
+ * time.
+ *
+ * @param filter the filter (input)
+ * @param et the ephemeris time (input)
+ * @return SPICETRUE if et is within the span of the
+ * filter
+ */
+SpiceBoolean gate_sky_filter_covers(const gate_sky_filter *filter, SpiceDouble et);
+
+/**
+ * Frees all memory held by a filter.
+ *
+ * @param filter the filter to free (input/output)
+ */
+void gate_sky_filter_free(gate_sky_filter *filter);
+
+#endif // GATE_SKYFILTER_H
@@ -0,0 +1,631 @@
+#include "smallbodies.h"
+#include <ctype.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define INITIAL_CAP 16
+
+#define AU_KM 149597870.7
+#define SUN_GM 132712440041.9394
+#define SPEED_OF_LIGHT_KM_S 299792.458
+#define J2000_OBLIQUITY_ARCSEC 84381.448
+#define J2000_JD 2451545.0
+
+// Orbits closer than this to parabolic are solved with
+// Barker's equation, where Kepler's equation in either
+// form loses too much precision
+#define NEAR_PARABOLIC 1e-6
+#define KEPLER_TOLERANCE 1e-12
+#define KEPLER_MAX_ITERATIONS 30
+
+#define FIELD_MAX_LEN 64
+
+/**
+ * The elements of a small body as parsed from one line of
+ * an element file.
+ */
+typedef struct {
+    SpiceChar id[GATE_SMALL_BODY_ID_MAX_LEN];
+    SpiceChar name[GATE_SMALL_BODY_NAME_MAX_LEN];
+    SpiceDouble epoch;
+
+    SpiceDouble perihelion;
+    SpiceDouble eccentricity;
+    SpiceDouble perihelion_et;
+    SpiceDouble arg_perihelion;
+    SpiceDouble node;
+    SpiceDouble inclination;
+
+    SpiceDouble magnitude;
+    SpiceDouble slope;
+    SpiceBoolean is_comet;
+} parsed_elements;
+
+static void signal_alloc() {
+    setmsg_c("Failed to allocate memory for the small body store");
+    sigerr_c("alloc");
+}
+
+/**
+ * Finds the index slot holding the given ID, or the empty
+ * slot where it would be inserted.
+ */
+static SpiceInt find_slot(const gate_small_body_store *store, ConstSpiceChar *id, uint64_t hash) {
+    return gate_id_index_find_slot(&store->index, store->text->id, sizeof(*store->text), id, hash);
+}
+
+static SpiceBoolean grow_column(SpiceDouble **column, SpiceInt cap) {
+    SpiceDouble *new_column = realloc(*column, cap * sizeof(**column));
+    if (new_column == NULL) {
+        return SPICEFALSE;
+    }
+
+    *column = new_column;
+    return SPICETRUE;
+}
+
+static void reserve(gate_small_body_store *store, SpiceInt cap) {
+    if (cap > store->cap) {
+        SpiceBoolean grown = grow_column(&store->perihelion, cap) && grow_column(&store->eccentricity, cap) &&
+                             grow_column(&store->perihelion_et, cap) && grow_column(&store->magnitude, cap) &&
+                             grow_column(&store->slope, cap);
+        for (int i = 0; grown && i < 3; ++i) {
+            grown = grow_column(&store->p_axis[i], cap) && grow_column(&store->q_axis[i], cap);
+        }
+        if (!grown) {
+            signal_alloc();
+            return;
+        }
+
+        SpiceBoolean *is_comet = realloc(store->is_comet, cap * sizeof(*is_comet));
+        if (is_comet == NULL) {
+            signal_alloc();
+            return;
+        }
+        store->is_comet = is_comet;
+
+        gate_small_body_text *text = realloc(store->text, cap * sizeof(*text));
+        if (text == NULL) {
+            signal_alloc();
+            return;
+        }
+        store->text = text;
+
+        store->cap = cap;
+    }
+
+    if (store->cap > 0 &&
+        !gate_id_index_reserve(&store->index, store->text->id, sizeof(*store->text), store->len, cap)) {
+        signal_alloc();
+    }
+}
+
+void gate_small_body_store_init(gate_small_body_store *store) {
+    memset(store, 0, sizeof(*store));
+}
+
+static void set_small_body(gate_small_body_store *store, gate_small_body_handle handle,
+                           const parsed_elements *elements) {
+    store->perihelion[handle] = elements->perihelion;
+    store->eccentricity[handle] = elements->eccentricity;
+    store->perihelion_et[handle] = elements->perihelion_et;
+    store->magnitude[handle] = elements->magnitude;
+    store->slope[handle] = elements->slope;
+    store->is_comet[handle] = elements->is_comet;
+
+    // Orient the orbit in the ecliptic, then rotate it by
+    // the obliquity into the J2000 frame
+    SpiceDouble cos_w = cos(elements->arg_perihelion);
+    SpiceDouble sin_w = sin(elements->arg_perihelion);
+    SpiceDouble cos_node = cos(elements->node);
+    SpiceDouble sin_node = sin(elements->node);
+    SpiceDouble cos_i = cos(elements->inclination);
+    SpiceDouble sin_i = sin(elements->inclination);
+
+    SpiceDouble p[3] = {
+            cos_w * cos_node - sin_w * sin_node * cos_i,
+            cos_w * sin_node + sin_w * cos_node * cos_i,
+            sin_w * sin_i
+    };
+    SpiceDouble q[3] = {
+            -sin_w * cos_node - cos_w * sin_node * cos_i,
+            -sin_w * sin_node + cos_w * cos_node * cos_i,
+            cos_w * sin_i
+    };
+
+    SpiceDouble obliquity = J2000_OBLIQUITY_ARCSEC / 3600 * M_PI / 180;
+    SpiceDouble cos_e = cos(obliquity);
+    SpiceDouble sin_e = sin(obliquity);
+
+    store->p_axis[0][handle] = p[0];
+    store->p_axis[1][handle] = p[1] * cos_e - p[2] * sin_e;
+    store->p_axis[2][handle] = p[1] * sin_e + p[2] * cos_e;
+    store->q_axis[0][handle] = q[0];
+    store->q_axis[1][handle] = q[1] * cos_e - q[2] * sin_e;
+    store->q_axis[2][handle] = q[1] * sin_e + q[2] * cos_e;
+
+    gate_small_body_text *text = &store->text[handle];
+    memcpy(text->id, elements->id, sizeof(text->id));
+    memcpy(text->name, elements->name, sizeof(text->name));
+    text->epoch = elements->epoch;
+}
+
+static gate_small_body_handle put(gate_small_body_store *store, const parsed_elements *elements) {
+    if (store->len == store->cap || store->index.cap == 0) {
+        SpiceInt new_cap = store->cap == 0 ? INITIAL_CAP : store->cap * 2;
+        reserve(store, new_cap);
+        if (store->cap < new_cap) {
+            return -1;
+        }
+    }
+
+    uint64_t hash = gate_id_index_hash(elements->id);
+    SpiceInt slot = find_slot(store, elements->id, hash);
+    gate_small_body_handle handle = store->index.handles[slot];
+    if (handle == -1) {
+        handle = store->len++;
+        store->index.hashes[slot] = hash;
+        store->index.handles[slot] = handle;
+    }
+
+    set_small_body(store, handle, elements);
+    return handle;
+}
+
+/**
+ * Copies the given 1-based, inclusive range of columns of
+ * a line with surrounding spaces removed, or an empty
+ * string if the line is too short.
+ */
+static void get_field(ConstSpiceChar *line, size_t line_len, size_t first, size_t last, SpiceChar *field,
+                      size_t field_len) {
+    field[0] = '\0';
+    if (line_len < first) {
+        return;
+    }
+
+    size_t begin = first - 1;
+    size_t end = last < line_len ? last : line_len;
+    while (begin < end && isspace((unsigned char) line[begin])) {
+        begin++;
+    }
+    while (end > begin && isspace((unsigned char) line[end - 1])) {
+        end--;
+    }
+
+    size_t len = end - begin < field_len - 1 ? end - begin : field_len - 1;
+    memcpy(field, line + begin, len);
+    field[len] = '\0';
+}
+
+static SpiceBoolean get_double(ConstSpiceChar *line, size_t line_len, size_t first, size_t last,
+                               SpiceDouble *value) {
+    SpiceChar field[FIELD_MAX_LEN];
+    get_field(line, line_len, first, last, field, sizeof(field));
+    if (field[0] == '\0') {
+        return SPICEFALSE;
+    }
+
+    char *end;
+    *value = strtod(field, &end);
+    return *end == '\0';
+}
+
+static SpiceBoolean is_digits(ConstSpiceChar *line, size_t line_len, size_t first, size_t last) {
+    if (line_len < last) {
+        return SPICEFALSE;
+    }
+
+    for (size_t i = first - 1; i < last; ++i) {
+        if (!isdigit((unsigned char) line[i])) {
+            return SPICEFALSE;
+        }
+    }
+
+    return SPICETRUE;
+}
+
+/**
+ * Converts a date on the Gregorian calendar with a
+ * fractional day to an ephemeris time, treating TT as TDB.
+ */
+static SpiceDouble civil_to_et(int year, int month, SpiceDouble day) {
+    if (month <= 2) {
+        year--;
+        month += 12;
+    }
+
+    int century = year / 100;
+    int leap_correction = 2 - century + century / 4;
+    SpiceDouble jd = floor(365.25 * (year + 4716)) + floor(30.6001 * (month + 1)) + day + leap_correction - 1524.5;
+    return (jd - J2000_JD) * spd_c();
+}
+
+/**
+ * Decodes one character of a packed MPC date or number,
+ * where digits are followed by the upper and then the
+ * lower case letters.
+ */
+static int unpack_digit(SpiceChar c) {
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    if (c >= 'A' && c <= 'Z') {
+        return c - 'A' + 10;
+    }
+    if (c >= 'a' && c <= 'z') {
+        return c - 'a' + 36;
+    }
+
+    return -1;
+}
+
+static SpiceBoolean unpack_epoch(ConstSpiceChar *packed, SpiceDouble *et) {
+    if (strlen(packed) != 5 || packed[0] < 'I' || packed[0] > 'K' || !isdigit((unsigned char) packed[1]) ||
+        !isdigit((unsigned char) packed[2])) {
+        return SPICEFALSE;
+    }
+
+    int year = 100 * (packed[0] - 'I' + 18) + 10 * (packed[1] - '0') + packed[2] - '0';
+    int month = unpack_digit(packed[3]);
+    int day = unpack_digit(packed[4]);
+    if (month < 1 || month > 12 || day < 1 || day > 31) {
+        return SPICEFALSE;
+    }
+
+    *et = civil_to_et(year, month, day);
+    return SPICETRUE;
+}
+
+/**
+ * Converts the packed designation of a minor planet to its
+ * ID, which is the number of numbered minor planets and
+ * the packed provisional designation otherwise.
+ */
+static void unpack_designation(ConstSpiceChar *packed, SpiceChar id[GATE_SMALL_BODY_ID_MAX_LEN]) {
+    int number = -1;
+    size_t len = strlen(packed);
+    if (len == 5 && packed[0] == '~') {
+        // Numbers from 620000 are the remaining four
+        // characters in base 62
+        number = 0;
+        for (int i = 1; i < 5 && number >= 0; ++i) {
+            int digit = unpack_digit(packed[i]);
+            number = digit < 0 ? -1 : number * 62 + digit;
+        }
+        number = number < 0 ? -1 : number + 620000;
+    } else if (len == 5 && unpack_digit(packed[0]) >= 0 && strspn(packed + 1, "0123456789") == 4) {
+        number = unpack_digit(packed[0]) * 10000 + (int) strtol(packed + 1, NULL, 10);
+    }
+
+    if (number >= 0) {
+        snprintf(id, GATE_SMALL_BODY_ID_MAX_LEN, "%d", number);
+    } else {
+        snprintf(id, GATE_SMALL_BODY_ID_MAX_LEN, "%s", packed);
+    }
+}
+
+/**
+ * Parses a line of MPCORB.DAT, see
+ * https://www.minorplanetcenter.net/iau/info/MPOrbitFormat.html
+ */
+static SpiceBoolean parse_minor_planet(ConstSpiceChar *line, size_t line_len, parsed_elements *elements) {
+    SpiceDouble mean_anomaly, mean_motion, semi_major_axis;
+    if (!get_double(line, line_len, 27, 35, &mean_anomaly) ||
+        !get_double(line, line_len, 38, 46, &elements->arg_perihelion) ||
+        !get_double(line, line_len, 49, 57, &elements->node) ||
+        !get_double(line, line_len, 60, 68, &elements->inclination) ||
+        !get_double(line, line_len, 71, 79, &elements->eccentricity) ||
+        !get_double(line, line_len, 81, 91, &mean_motion) ||
+        !get_double(line, line_len, 93, 103, &semi_major_axis) ||
+        mean_motion <= 0 || semi_major_axis <= 0 || elements->eccentricity < 0 || elements->eccentricity >= 1) {
+        return SPICEFALSE;
+    }
+
+    SpiceChar field[FIELD_MAX_LEN];
+    get_field(line, line_len, 21, 25, field, sizeof(field));
+    if (!unpack_epoch(field, &elements->epoch)) {
+        return SPICEFALSE;
+    }
+
+    get_field(line, line_len, 1, 7, field, sizeof(field));
+    if (field[0] == '\0') {
+        return SPICEFALSE;
+    }
+    unpack_designation(field, elements->id);
+
+    get_field(line, line_len, 167, 194, elements->name, sizeof(elements->name));
+    if (elements->name[0] == '\0') {
+        memcpy(elements->name, elements->id, sizeof(elements->id));
+    }
+
+    if (!get_double(line, line_len, 9, 13, &elements->magnitude)) {
+        elements->magnitude = NAN;
+    }
+    if (!get_double(line, line_len, 15, 19, &elements->slope)) {
+        elements->slope = 0.15;
+    }
+
+    elements->perihelion = semi_major_axis * (1 - elements->eccentricity) * AU_KM;
+    elements->perihelion_et = elements->epoch - mean_anomaly / mean_motion * spd_c();
+    elements->is_comet = SPICEFALSE;
+    return SPICETRUE;
+}
+
+/**
+ * Parses a line of CometEls.txt, see
+ * https://www.minorplanetcenter.net/iau/info/CometOrbitFormat.html
+ */
+static SpiceBoolean parse_comet(ConstSpiceChar *line, size_t line_len, parsed_elements *elements) {
+    SpiceDouble year, month, day;
+    if (!is_digits(line, line_len, 15, 18) || !get_double(line, line_len, 15, 18, &year) ||
+        !get_double(line, line_len, 20, 21, &month) || !get_double(line, line_len, 23, 29, &day) ||
+        !get_double(line, line_len, 31, 39, &elements->perihelion) ||
+        !get_double(line, line_len, 42, 49, &elements->eccentricity) ||
+        !get_double(line, line_len, 52, 59, &elements->arg_perihelion) ||
+        !get_double(line, line_len, 62, 69, &elements->node) ||
+        !get_double(line, line_len, 72, 79, &elements->inclination) ||
+        elements->perihelion <= 0 || elements->eccentricity < 0 || month < 1 || month > 12) {
+        return SPICEFALSE;
+    }
+
+    SpiceChar type = line[4];
+    if (strchr("PCDXAI", type) == NULL) {
+        return SPICEFALSE;
+    }
+
+    SpiceChar number[FIELD_MAX_LEN];
+    SpiceChar provisional[FIELD_MAX_LEN];
+    get_field(line, line_len, 1, 4, number, sizeof(number));
+    get_field(line, line_len, 6, 12, provisional, sizeof(provisional));
+    if (number[0] != '\0') {
+        snprintf(elements->id, sizeof(elements->id), "%d%c", (int) strtol(number, NULL, 10), type);
+    } else if (provisional[0] != '\0') {
+        snprintf(elements->id, sizeof(elements->id), "%c%s", type, provisional);
+    } else {
+        return SPICEFALSE;
+    }
+
+    get_field(line, line_len, 103, 158, elements->name, sizeof(elements->name));
+    if (elements->name[0] == '\0') {
+        memcpy(elements->name, elements->id, sizeof(elements->id));
+    }
+
+    if (!get_double(line, line_len, 92, 95, &elements->magnitude)) {
+        elements->magnitude = NAN;
+    }
+    if (!get_double(line, line_len, 97, 100, &elements->slope)) {
+        elements->slope = 4;
+    }
+
+    elements->perihelion *= AU_KM;
+    elements->perihelion_et = civil_to_et((int) year, (int) month, day);
+
+    SpiceDouble epoch_year, epoch_month, epoch_day;
+    if (is_digits(line, line_len, 82, 89) && get_double(line, line_len, 82, 85, &epoch_year) &&
+        get_double(line, line_len, 86, 87, &epoch_month) && get_double(line, line_len, 88, 89, &epoch_day)) {
+        elements->epoch = civil_to_et((int) epoch_year, (int) epoch_month, epoch_day);
+    } else {
+        elements->epoch = elements->perihelion_et;
+    }
+
+    elements->is_comet = SPICETRUE;
+    return SPICETRUE;
+}
+
+void gate_small_body_store_append_buffer(gate_small_body_store *store, ConstSpiceChar *buffer, size_t len,
+                                         SpiceInt *added, SpiceInt *skipped) {
+    SpiceInt added_count = 0;
+    SpiceInt skipped_count = 0;
+
+    size_t pos = 0;
+    while (pos < len) {
+        ConstSpiceChar *line = buffer + pos;
+        ConstSpiceChar *newline = memchr(line, '\n', len - pos);
+        size_t line_len = newline == NULL ? len - pos : (size_t) (newline - line);
+        pos += line_len + 1;
+
+        if (line_len > 0 && line[line_len - 1] == '\r') {
+            line_len--;
+        }
+        if (line_len == 0) {
+            continue;
+        }
+
+        // Only comet lines have the year of perihelion in
+        // these columns, where minor planet lines have the
+        // slope parameter G
+        parsed_elements elements;
+        memset(&elements, 0, sizeof(elements));
+        SpiceBoolean parsed = is_digits(line, line_len, 15, 18) ? parse_comet(line, line_len, &elements)
+                                                                : parse_minor_planet(line, line_len, &elements);
+        if (!parsed) {
+            skipped_count++;
+            continue;
+        }
+
+        SpiceDouble rpd = M_PI / 180;
+        elements.arg_perihelion *= rpd;
+        elements.node *= rpd;
+        elements.inclination *= rpd;
+
+        if (put(store, &elements) == -1) {
+            break;
+        }
+        added_count++;
+    }
+
+    if (added != NULL) {
+        *added = added_count;
+    }
+    if (skipped != NULL) {
+        *skipped = skipped_count;
+    }
+}
+
+gate_small_body_handle gate_small_body_store_find(const gate_small_body_store *store, ConstSpiceChar *id) {
+    if (store->index.cap == 0) {
+        return -1;
+    }
+
+    SpiceInt slot = find_slot(store, id, gate_id_index_hash(id));
+    return store->index.handles[slot];
+}
+
+/**
+ * Computes the position of a small body in the plane of
+ * its orbit, with x towards the perihelion.
+ *
+ * Only reads its arguments, so that any number of these
+ * may run at once.
+ */
+static void solve_conic(SpiceDouble perihelion, SpiceDouble eccentricity, SpiceDouble dt, SpiceDouble *x,
+                        SpiceDouble *y) {
+    if (fabs(eccentricity - 1) < NEAR_PARABOLIC) {
+        // Barker's equation for s = tan(v / 2), solved in
+        // closed form
+        SpiceDouble w = 3 * sqrt(SUN_GM / (2 * perihelion * perihelion * perihelion)) * dt;
+        SpiceDouble root = cbrt(w / 2 + sqrt(w * w / 4 + 1));
+        SpiceDouble s = root - 1 / root;
+
+        *x = perihelion * (1 - s * s);
+        *y = 2 * perihelion * s;
+        return;
+    }
+
+    if (eccentricity < 1) {
+        SpiceDouble a = perihelion / (1 - eccentricity);
+        SpiceDouble mean_anomaly = remainder(sqrt(SUN_GM / (a * a * a)) * dt, 2 * M_PI);
+
+        // Danby's starting value converges in a few Newton
+        // steps for any eccentricity
+        SpiceDouble e = mean_anomaly + 0.85 * eccentricity * (mean_anomaly < 0 ? -1 : 1);
+        for (int i = 0; i < KEPLER_MAX_ITERATIONS; ++i) {
+            SpiceDouble delta = (e - eccentricity * sin(e) - mean_anomaly) / (1 - eccentricity * cos(e));
+            e -= delta;
+            if (fabs(delta) < KEPLER_TOLERANCE) {
+                break;
+            }
+        }
+
+        *x = a * (cos(e) - eccentricity);
+        *y = a * sqrt(1 - eccentricity * eccentricity) * sin(e);
+        return;
+    }
+
+    SpiceDouble a = perihelion / (eccentricity - 1);
+    SpiceDouble mean_anomaly = sqrt(SUN_GM / (a * a * a)) * dt;
+
+    SpiceDouble h = (mean_anomaly < 0 ? -1 : 1) * log(2 * fabs(mean_anomaly) / eccentricity + 1.8);
+    for (int i = 0; i < KEPLER_MAX_ITERATIONS; ++i) {
+        SpiceDouble delta = (eccentricity * sinh(h) - h - mean_anomaly) / (eccentricity * cosh(h) - 1);
+        h -= delta;
+        if (fabs(delta) < KEPLER_TOLERANCE) {
+            break;
+        }
+    }
+
+    *x = a * (eccentricity - cosh(h));
+    *y = a * sqrt(eccentricity * eccentricity - 1) * sinh(h);
+}
+
+static void conic_position(const gate_small_body_store *store, gate_small_body_handle handle, SpiceDouble et,
+                     SpiceDouble position[3]) {
+    SpiceDouble x;
+    SpiceDouble y;
+    solve_conic(store->perihelion[handle], store->eccentricity[handle], et - store->perihelion_et[handle], &x, &y);
+
+    for (int i = 0; i < 3; ++i) {
+        position[i] = x * store->p_axis[i][handle] + y * store->q_axis[i][handle];
+    }
+}
+
+void gate_small_body_position(const gate_small_body_store *store, gate_small_body_handle handle, SpiceDouble et,
+                              SpiceDouble position[3]) {
+    conic_position(store, handle, et, position);
+}
+
+void gate_small_body_positions(const gate_small_body_store *store, gate_small_body_handle start, SpiceInt len,
+                               SpiceDouble et, ConstSpiceDouble observer_state[6], SpiceInt light_time_iterations,
+                               SpiceBoolean stellar, SpiceDouble (*positions)[3], SpiceDouble *sun_distances) {
+    SpiceDouble beta[3];
+    for (int i = 0; i < 3; ++i) {
+        beta[i] = observer_state[i + 3] / SPEED_OF_LIGHT_KM_S;
+    }
+
+    for (SpiceInt i = 0; i < len; ++i) {
+        gate_small_body_handle handle = start + i;
+
+        SpiceDouble helio[3];
+        conic_position(store, handle, et, helio);
+
+        SpiceDouble rel[3];
+        for (int j = 0; j < 3; ++j) {
+            rel[j] = helio[j] - observer_state[j];
+        }
+
+        for (int k = 0; k < light_time_iterations; ++k) {
+            SpiceDouble light_time = sqrt(rel[0] * rel[0] + rel[1] * rel[1] + rel[2] * rel[2]) / SPEED_OF_LIGHT_KM_S;
+            conic_position(store, handle, et - light_time, helio);
+            for (int j = 0; j < 3; ++j) {
+                rel[j] = helio[j] - observer_state[j];
+            }
+        }
+
+        if (stellar) {
+            // u' = u + beta - (u . beta) u to first order,
+            // keeping the distance
+            SpiceDouble distance = sqrt(rel[0] * rel[0] + rel[1] * rel[1] + rel[2] * rel[2]);
+            SpiceDouble u_beta = (rel[0] * beta[0] + rel[1] * beta[1] + rel[2] * beta[2]) / distance;
+            for (int j = 0; j < 3; ++j) {
+                rel[j] += distance * beta[j] - u_beta * rel[j];
+            }
+        }
+
+        for (int j = 0; j < 3; ++j) {
+            positions[i][j] = rel[j];
+        }
+        if (sun_distances != NULL) {
+            sun_distances[i] = sqrt(helio[0] * helio[0] + helio[1] * helio[1] + helio[2] * helio[2]);
+        }
+    }
+}
+
+SpiceDouble gate_small_body_magnitude(const gate_small_body_store *store, gate_small_body_handle handle,
+                                      SpiceDouble observer_distance, SpiceDouble sun_distance,
+                                      SpiceDouble observer_sun_distance) {
+    SpiceDouble delta = observer_distance / AU_KM;
+    SpiceDouble r = sun_distance / AU_KM;
+    if (store->is_comet[handle]) {
+        return store->magnitude[handle] + 5 * log10(delta) + 2.5 * store->slope[handle] * log10(r);
+    }
+
+    SpiceDouble big_r = observer_sun_distance / AU_KM;
+    SpiceDouble cos_phase = (r * r + delta * delta - big_r * big_r) / (2 * r * delta);
+    cos_phase = cos_phase > 1 ? 1 : cos_phase < -1 ? -1 : cos_phase;
+    SpiceDouble tan_half = tan(acos(cos_phase) / 2);
+
+    SpiceDouble phi1 = exp(-3.33 * pow(tan_half, 0.63));
+    SpiceDouble phi2 = exp(-1.87 * pow(tan_half, 1.22));
+    SpiceDouble g = store->slope[handle];
+    return store->magnitude[handle] + 5 * log10(r * delta) - 2.5 * log10((1 - g) * phi1 + g * phi2);
+}
+
+void gate_small_body_store_free(gate_small_body_store *store) {
+    free(store->perihelion);
+    free(store->eccentricity);
+    free(store->perihelion_et);
+    for (int i = 0; i < 3; ++i) {
+        free(store->p_axis[i]);
+        free(store->q_axis[i]);
+    }
+    free(store->magnitude);
+    free(store->slope);
+    free(store->is_comet);
+    free(store->text);
+    gate_id_index_free(&store->index);
+
+    memset(store, 0, sizeof(*store));
+}
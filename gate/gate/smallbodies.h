@@ -0,0 +1,238 @@
+/**
+ * @file
+ * Minor planets and comets loaded from the orbital element
+ * files of the Minor Planet Center, and a batched two-body
+ * propagator for them.
+ *
+ * Most small bodies have no SPK, but their osculating
+ * elements are published for hundreds of thousands of them
+ * in MPCORB.DAT and CometEls.txt. Over the weeks around
+ * the epoch of the elements the pull of the Sun dominates,
+ * so a heliocentric conic places them to within arcseconds
+ * to arcminutes, which is plenty to find and point at them.
+ *
+ * The elements are converted when loading into the form
+ * used by the propagator: the perihelion distance, the
+ * eccentricity, the time of perihelion and the unit
+ * vectors towards the perihelion (P) and 90 degrees ahead
+ * of it in the plane of the orbit (Q), in the J2000 frame.
+ * Each is stored in its own contiguous array, as with
+ * gate_sat_store, so that the propagator streams through
+ * the whole catalog for each epoch without calling into
+ * SPICE. The propagator only reads the store and writes
+ * the caller's arrays, so it may be called from several
+ * threads at once.
+ */
+
+#ifndef GATE_SMALLBODIES_H
+#define GATE_SMALLBODIES_H
+
+#include <cspice/SpiceUsr.h>
+#include <stddef.h>
+#include "idindex.h"
+
+/**
+ * The maximum length of the ID of a small body, including
+ * the NULL terminator.
+ */
+#define GATE_SMALL_BODY_ID_MAX_LEN 16
+
+/**
+ * The maximum length of the readable designation of a
+ * small body, including the NULL terminator.
+ */
+#define GATE_SMALL_BODY_NAME_MAX_LEN 64
+
+/**
+ * A dense index of a small body in a gate_small_body_store,
+ * or -1 to represent no small body.
+ */
+typedef SpiceInt gate_small_body_handle;
+
+/**
+ * Infrequently accessed data describing a small body.
+ *
+ * Numbered minor planets are identified by their number
+ * and numbered periodic comets by their number and orbit
+ * type, such as "1P". Others are identified by their
+ * packed provisional designation, such as "K23A01B".
+ */
+typedef struct {
+    SpiceChar id[GATE_SMALL_BODY_ID_MAX_LEN];
+    SpiceChar name[GATE_SMALL_BODY_NAME_MAX_LEN];
+
+    /**
+     * The epoch of the osculating elements, as an
+     * ephemeris time.
+     */
+    SpiceDouble epoch;
+} gate_small_body_text;
+
+/**
+ * Represents a catalog of small bodies.
+ *
+ * The arrays may be read directly using a handle as the
+ * index, but should only be modified through the
+ * procedures in this file.
+ */
+typedef struct {
+    /**
+     * The number of small bodies in the store.
+     */
+    SpiceInt len;
+    /**
+     * The number of small bodies that the store has room
+     * for before needing to grow.
+     */
+    SpiceInt cap;
+
+    /**
+     * The perihelion distance in kilometers.
+     */
+    SpiceDouble *perihelion;
+    SpiceDouble *eccentricity;
+    /**
+     * The time of perihelion as an ephemeris time.
+     */
+    SpiceDouble *perihelion_et;
+    /**
+     * The components of the P and Q unit vectors, indexed
+     * first by axis and then by handle.
+     */
+    SpiceDouble *p_axis[3];
+    SpiceDouble *q_axis[3];
+
+    /**
+     * The absolute magnitude H and the slope parameter G
+     * of minor planets, or the total absolute magnitude
+     * and the activity index K of comets. The absolute
+     * magnitude is NaN if the element file has none.
+     */
+    SpiceDouble *magnitude;
+    SpiceDouble *slope;
+    SpiceBoolean *is_comet;
+
+    gate_small_body_text *text;
+
+    gate_id_index index;
+} gate_small_body_store;
+
+/**
+ * Initializes an empty small body store.
+ *
+ * @param store the store to initialize (output)
+ */
+void gate_small_body_store_init(gate_small_body_store *store);
+
+/**
+ * Parses every small body in a buffer holding the contents
+ * of an MPCORB.DAT or CometEls.txt file, or of any file
+ * with lines in either format, and adds them to the store.
+ *
+ * Lines which are in neither format, such as the header of
+ * MPCORB.DAT, are skipped. A small body replaces one with
+ * the same ID which is already in the store.
+ *
+ * @param store the store to add to (input/output)
+ * @param buffer the file contents, which need not be NULL
+ * terminated (input)
+ * @param len the number of characters in the buffer
+ * (input)
+ * @param added the number of small bodies added or
+ * replaced, or NULL if not desired (output)
+ * @param skipped the number of lines which were not small
+ * bodies, or NULL if not desired (output)
+ *
+ * @throws alloc if memory could not be allocated, in which
+ * case the small bodies parsed so far are kept
+ */
+void gate_small_body_store_append_buffer(gate_small_body_store *store, ConstSpiceChar *buffer, size_t len,
+                                         SpiceInt *added, SpiceInt *skipped);
+
+/**
+ * Finds the handle of the small body with the given ID.
+ *
+ * @param store the store to search (input)
+ * @param id the ID of the small body (input)
+ * @return the handle of the small body, or -1 if there is
+ * no small body with the given ID
+ */
+gate_small_body_handle gate_small_body_store_find(const gate_small_body_store *store, ConstSpiceChar *id);
+
+/**
+ * Computes the heliocentric position of a small body on
+ * its conic.
+ *
+ * @param store the store containing the small body (input)
+ * @param handle the handle of the small body (input)
+ * @param et the ephemeris time (input)
+ * @param position the position relative to the Sun in the
+ * J2000 frame in kilometers (output)
+ */
+void gate_small_body_position(const gate_small_body_store *store, gate_small_body_handle handle, SpiceDouble et,
+                              SpiceDouble position[3]);
+
+/**
+ * Computes the apparent positions of a range of small
+ * bodies relative to an observer at one epoch.
+ *
+ * Each light time iteration propagates every small body
+ * back to the time at which the light that reaches the
+ * observer left it, as the "LT" and "CN" corrections of
+ * spkezr_c() do for bodies with an SPK. Stellar aberration
+ * is applied to first order in the velocity of the
+ * observer, which is off by well under a milliarcsecond.
+ *
+ * @param store the store containing the small bodies
+ * (input)
+ * @param start the handle of the first small body (input)
+ * @param len the number of small bodies (input)
+ * @param et the ephemeris time (input)
+ * @param observer_state the state of the observer relative
+ * to the Sun in the J2000 frame (input)
+ * @param light_time_iterations the number of light time
+ * iterations, see gate_abcorr_light_time_iterations()
+ * (input)
+ * @param stellar whether to correct for stellar aberration
+ * (input)
+ * @param positions the apparent position of each small
+ * body relative to the observer in the J2000 frame in
+ * kilometers (output)
+ * @param sun_distances the distance of each small body
+ * from the Sun in kilometers at the time the light left
+ * it, or NULL if not desired (output)
+ */
+void gate_small_body_positions(const gate_small_body_store *store, gate_small_body_handle start, SpiceInt len,
+                               SpiceDouble et, ConstSpiceDouble observer_state[6], SpiceInt light_time_iterations,
+                               SpiceBoolean stellar, SpiceDouble (*positions)[3], SpiceDouble *sun_distances);
+
+/**
+ * Estimates the apparent visual magnitude of a small body.
+ *
+ * Minor planets follow the H, G magnitude system adopted by
+ * the IAU, and comets the total magnitude
+ * `H + 5 log(delta) + 2.5 K log(r)`.
+ *
+ * @param store the store containing the small body (input)
+ * @param handle the handle of the small body (input)
+ * @param observer_distance the distance of the small body
+ * from the observer in kilometers (input)
+ * @param sun_distance the distance of the small body from
+ * the Sun in kilometers (input)
+ * @param observer_sun_distance the distance of the
+ * observer from the Sun in kilometers (input)
+ * @return the apparent magnitude
+ */
+SpiceDouble gate_small_body_magnitude(const gate_small_body_store *store, gate_small_body_handle handle,
+                                      SpiceDouble observer_distance, SpiceDouble sun_distance,
+                                      SpiceDouble observer_sun_distance);
+
+/**
+ * Frees all memory held by the given store, leaving it
+ * empty.
+ *
+ * @param store the store to free (input/output)
+ */
+void gate_small_body_store_free(gate_small_body_store *store);
+
+#endif // GATE_SMALLBODIES_H
@@ -82,7 +82,7 @@ void gate_calc_star_pos(gate_star_info_spice1 info, SpiceDouble et,
 }
 
 void gate_calc_star_topo(gate_topo_frame observer_frame, gate_star_info_spice1 info, SpiceDouble et,
-                         SpiceDouble *range, SpiceDouble *azimuth, SpiceDouble *elevation) {
+                         gate_abcorr abcorr, SpiceDouble *range, SpiceDouble *azimuth, SpiceDouble *elevation) {
     SpiceDouble parallax_as;
     convrt_c(info.parallax, "DEGREES", "ARCSECONDS", &parallax_as);
     SpiceDouble dist_parsecs = 1 / parallax_as;
@@ -99,6 +99,15 @@ void gate_calc_star_topo(gate_topo_frame observer_frame, gate_star_info_spice1 i
     SpiceDouble star_pos_j2000_rec[3];
     radrec_c(dist_km, ra_rad, dec_rad, star_pos_j2000_rec);
 
+    if (gate_abcorr_stellar(abcorr)) {
+        SpiceDouble velocity[3];
+        gate_observer_velocity(observer_frame.body_id, et, velocity);
+
+        SpiceDouble apparent[3];
+        stelab_c(star_pos_j2000_rec, velocity, apparent);
+        vequ_c(apparent, star_pos_j2000_rec);
+    }
+
     SpiceDouble frame_transform_matrix[3][3];
     pxform_c("J2000", observer_frame.frame_name, et, frame_transform_matrix);
 
@@ -27,6 +27,7 @@
 #define GATE_STARS_H
 
 #include <cspice/SpiceUsr.h>
+#include "abcorr.h"
 #include "topo.h"
 
 /**
@@ -137,12 +138,26 @@ void gate_calc_star_pos(gate_star_info_spice1 info, SpiceDouble et,
  * system, and the topocentric position of the observer
  * when producing the output values.
  *
+ * Light time does not apply to catalog positions, so only
+ * the stellar aberration of a level of aberration
+ * correction is applied, using the velocity of the body of
+ * the observer from gate_observer_velocity().
+ *
+ * The abcorr parameter was added after this procedure was
+ * first published. GATE_ABCORR_NONE gives the positions
+ * computed before it was added. Any level with stellar
+ * aberration moves stars by up to about 20 seconds of arc
+ * for observers on the Earth, which changes the output of
+ * STAR AZEL in gatecli now that its default ABCORR is
+ * CN+S.
+ *
  * @param observer_frame the observer's topocentric
  * reference frame (input)
  * @param info the information represent the star for which
  * to produce the calculated values (input)
  * @param et the elapsed time in seconds past J2000,
  * retrievable from str2et_c() (input)
+ * @param abcorr the level of aberration correction (input)
  * @param range the distance of the star from the position
  * of the observer in kilometers, or NULL if not desired
  * (output)
@@ -153,6 +168,6 @@ void gate_calc_star_pos(gate_star_info_spice1 info, SpiceDouble et,
  * (output)
  */
 void gate_calc_star_topo(gate_topo_frame observer_frame, gate_star_info_spice1 info, SpiceDouble et,
-                         SpiceDouble *range, SpiceDouble *azimuth, SpiceDouble *elevation);
+                         gate_abcorr abcorr, SpiceDouble *range, SpiceDouble *azimuth, SpiceDouble *elevation);
 
 #endif // GATE_STARS_H
@@ -0,0 +1,398 @@
+#include "tle.h"
+#include <ctype.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define FIELD_MAX_LEN 16
+#define MIN_PER_DAY 1440.0
+#define SEC_PER_DAY 86400.0
+
+// Number of days from 0000-03-01 to 2000-01-01 in the
+// proleptic Gregorian calendar
+#define DAYS_TO_J2000_DATE 730425
+
+static SpiceBoolean is_blank(ConstSpiceChar *line, size_t len) {
+    for (size_t i = 0; i < len; ++i) {
+        if (!isspace((unsigned char) line[i])) {
+            return SPICEFALSE;
+        }
+    }
+
+    return SPICETRUE;
+}
+
+static SpiceBoolean checksum_matches(ConstSpiceChar *line) {
+    int sum = 0;
+    for (int i = 0; i < GATE_TLE_LINE_LEN - 1; ++i) {
+        char c = line[i];
+        if (c >= '0' && c <= '9') {
+            sum += c - '0';
+        } else if (c == '-') {
+            sum += 1;
+        }
+    }
+
+    return line[GATE_TLE_LINE_LEN - 1] - '0' == sum % 10;
+}
+
+/**
+ * Copies the 1-based inclusive column range of a line into
+ * a NULL terminated buffer without surrounding spaces.
+ */
+static void copy_field(ConstSpiceChar *line, int first_col, int last_col, SpiceChar *out) {
+    int start = first_col - 1;
+    int end = last_col;
+    while (start < end && line[start] == ' ') {
+        start++;
+    }
+    while (end > start && line[end - 1] == ' ') {
+        end--;
+    }
+
+    int len = end - start;
+    memcpy(out, line + start, len * sizeof(*out));
+    out[len] = '\0';
+}
+
+static SpiceBoolean parse_double(ConstSpiceChar *line, int first_col, int last_col, SpiceDouble *out) {
+    SpiceChar field[FIELD_MAX_LEN];
+    copy_field(line, first_col, last_col, field);
+
+    char *end;
+    *out = strtod(field, &end);
+    return end != field && *end == '\0';
+}
+
+static SpiceBoolean parse_int(ConstSpiceChar *line, int first_col, int last_col, SpiceInt *out) {
+    SpiceChar field[FIELD_MAX_LEN];
+    copy_field(line, first_col, last_col, field);
+
+    char *end;
+    *out = (SpiceInt) strtol(field, &end, 10);
+    return end != field && *end == '\0';
+}
+
+/**
+ * Parses a column with an assumed leading decimal point
+ * and an optional exponent, e.g. " 12345-3" is 0.12345e-3.
+ */
+static SpiceBoolean parse_assumed_decimal(ConstSpiceChar *line, int first_col, int last_col, SpiceDouble *out) {
+    SpiceChar field[FIELD_MAX_LEN];
+    copy_field(line, first_col, last_col, field);
+
+    SpiceChar *digits = field;
+    SpiceDouble sign = 1;
+    if (*digits == '-' || *digits == '+') {
+        sign = *digits == '-' ? -1 : 1;
+        digits++;
+    }
+
+    SpiceChar *exponent = digits;
+    while (*exponent >= '0' && *exponent <= '9') {
+        exponent++;
+    }
+
+    if (exponent == digits) {
+        return SPICEFALSE;
+    }
+
+    SpiceInt exponent_value = 0;
+    if (*exponent != '\0') {
+        char *end;
+        exponent_value = (SpiceInt) strtol(exponent, &end, 10);
+        if (end == exponent || *end != '\0') {
+            return SPICEFALSE;
+        }
+    }
+
+    SpiceDouble mantissa = 0;
+    SpiceDouble scale = 0.1;
+    for (SpiceChar *c = digits; c < exponent; ++c) {
+        mantissa += (*c - '0') * scale;
+        scale /= 10;
+    }
+
+    *out = sign * mantissa * pow(10, exponent_value);
+    return SPICETRUE;
+}
+
+/**
+ * Parses a catalog number, which may use the Alpha-5
+ * scheme where a leading letter (skipping I and O)
+ * represents the ten-thousands digit from 10 onwards.
+ */
+static SpiceBoolean parse_catalog_number(ConstSpiceChar *line, SpiceInt *out) {
+    char lead = line[2];
+    if (lead >= 'A' && lead <= 'Z' && lead != 'I' && lead != 'O') {
+        SpiceInt lead_value = 10 + (lead - 'A');
+        if (lead > 'I') {
+            lead_value--;
+        }
+        if (lead > 'O') {
+            lead_value--;
+        }
+
+        SpiceInt rest;
+        if (!parse_int(line, 4, 7, &rest)) {
+            return SPICEFALSE;
+        }
+
+        *out = lead_value * 10000 + rest;
+        return SPICETRUE;
+    }
+
+    return parse_int(line, 3, 7, out);
+}
+
+static long days_from_civil(long year, long month, long day) {
+    // https://howardhinnant.github.io/date_algorithms.html#days_from_civil
+    year -= month <= 2;
+    long era = (year >= 0 ? year : year - 399) / 400;
+    long yoe = year - era * 400;
+    long doy = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    long doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+
+    return era * 146097 + doe;
+}
+
+static SpiceBoolean epoch_to_et(SpiceInt two_digit_year, SpiceDouble day_of_year, SpiceDouble *et) {
+    SpiceInt year = 1900 + two_digit_year;
+    if (year < GATE_TLE_MIN_YEAR) {
+        year += 100;
+    }
+
+    // UTC seconds past J2000 (2000-01-01T12:00:00), with
+    // 86400 seconds per day, which is what deltet_c()
+    // expects as an input epoch
+    long days = days_from_civil(year, 1, 1) - DAYS_TO_J2000_DATE;
+    SpiceDouble utc = (days + day_of_year - 1) * SEC_PER_DAY - SEC_PER_DAY / 2;
+
+    SpiceDouble delta;
+    deltet_c(utc, "UTC", &delta);
+    if (failed_c()) {
+        return SPICEFALSE;
+    }
+
+    *et = utc + delta;
+    return SPICETRUE;
+}
+
+static void copy_name(ConstSpiceChar *name, SpiceChar *out) {
+    out[0] = '\0';
+    if (name == NULL) {
+        return;
+    }
+
+    if (name[0] == '0' && name[1] == ' ') {
+        name += 2;
+    }
+
+    size_t len = strlen(name);
+    while (len > 0 && isspace((unsigned char) name[len - 1])) {
+        len--;
+    }
+    if (len > GATE_TLE_NAME_MAX_LEN - 1) {
+        len = GATE_TLE_NAME_MAX_LEN - 1;
+    }
+
+    memcpy(out, name, len * sizeof(*out));
+    out[len] = '\0';
+}
+
+gate_tle_status gate_parse_tle(ConstSpiceChar *name, ConstSpiceChar *line1, ConstSpiceChar *line2,
+                               gate_tle *tle) {
+    if (strnlen(line1, GATE_TLE_LINE_LEN) < GATE_TLE_LINE_LEN ||
+        strnlen(line2, GATE_TLE_LINE_LEN) < GATE_TLE_LINE_LEN) {
+        return GATE_TLE_ERR_LENGTH;
+    }
+
+    if (line1[0] != '1' || line1[1] != ' ' || line2[0] != '2' || line2[1] != ' ') {
+        return GATE_TLE_ERR_LINE_NUMBER;
+    }
+
+    if (!checksum_matches(line1) || !checksum_matches(line2)) {
+        return GATE_TLE_ERR_CHECKSUM;
+    }
+
+    SpiceInt catalog_number;
+    SpiceInt catalog_number_2;
+    if (!parse_catalog_number(line1, &catalog_number) || !parse_catalog_number(line2, &catalog_number_2)) {
+        return GATE_TLE_ERR_FIELD;
+    }
+
+    if (catalog_number != catalog_number_2) {
+        return GATE_TLE_ERR_CATALOG_MISMATCH;
+    }
+
+    SpiceInt epoch_year;
+    SpiceDouble epoch_day;
+    SpiceDouble *elements = tle->elements;
+    if (!parse_int(line1, 19, 20, &epoch_year) ||
+        !parse_double(line1, 21, 32, &epoch_day) ||
+        !parse_double(line1, 34, 43, &elements[GATE_TLE_NDT2O]) ||
+        !parse_assumed_decimal(line1, 45, 52, &elements[GATE_TLE_NDD6O]) ||
+        !parse_assumed_decimal(line1, 54, 61, &elements[GATE_TLE_BSTAR]) ||
+        !parse_double(line2, 9, 16, &elements[GATE_TLE_INCL]) ||
+        !parse_double(line2, 18, 25, &elements[GATE_TLE_NODE0]) ||
+        !parse_assumed_decimal(line2, 27, 33, &elements[GATE_TLE_ECC]) ||
+        !parse_double(line2, 35, 42, &elements[GATE_TLE_OMEGA]) ||
+        !parse_double(line2, 44, 51, &elements[GATE_TLE_MO]) ||
+        !parse_double(line2, 53, 63, &elements[GATE_TLE_NO])) {
+        return GATE_TLE_ERR_FIELD;
+    }
+
+    if (elements[GATE_TLE_NO] <= 0) {
+        return GATE_TLE_ERR_FIELD;
+    }
+
+    SpiceDouble orbit_period = MIN_PER_DAY / elements[GATE_TLE_NO];
+    tle->is_deep_space = orbit_period >= GATE_TLE_DEEP_SPACE_PERIOD;
+
+    // Same unit conversions as getelm_c(): revolutions per
+    // day become radians per minute and degrees become
+    // radians
+    SpiceDouble rev_per_day = 2 * M_PI / MIN_PER_DAY;
+    SpiceDouble rad_per_deg = M_PI / 180;
+    elements[GATE_TLE_NDT2O] *= rev_per_day / MIN_PER_DAY;
+    elements[GATE_TLE_NDD6O] *= rev_per_day / (MIN_PER_DAY * MIN_PER_DAY);
+    elements[GATE_TLE_INCL] *= rad_per_deg;
+    elements[GATE_TLE_NODE0] *= rad_per_deg;
+    elements[GATE_TLE_OMEGA] *= rad_per_deg;
+    elements[GATE_TLE_MO] *= rad_per_deg;
+    elements[GATE_TLE_NO] *= rev_per_day;
+
+    if (!epoch_to_et(epoch_year, epoch_day, &tle->epoch)) {
+        return GATE_TLE_ERR_LEAPSECONDS;
+    }
+    elements[GATE_TLE_EPOCH] = tle->epoch;
+
+    tle->catalog_number = catalog_number;
+    copy_name(name, tle->name);
+    memcpy(tle->lines[0], line1, GATE_TLE_LINE_LEN * sizeof(*line1));
+    memcpy(tle->lines[1], line2, GATE_TLE_LINE_LEN * sizeof(*line2));
+    tle->lines[0][GATE_TLE_LINE_LEN] = '\0';
+    tle->lines[1][GATE_TLE_LINE_LEN] = '\0';
+
+    return GATE_TLE_OK;
+}
+
+/**
+ * Finds the next line in the buffer, copying at most
+ * GATE_TLE_LINE_LEN characters of it into `line` and
+ * returning the offset of the line following it.
+ */
+static size_t next_line(ConstSpiceChar *buffer, size_t len, size_t offset, SpiceChar *line, size_t *line_len) {
+    size_t end = offset;
+    while (end < len && buffer[end] != '\n') {
+        end++;
+    }
+
+    size_t content_end = end;
+    if (content_end > offset && buffer[content_end - 1] == '\r') {
+        content_end--;
+    }
+
+    *line_len = content_end - offset;
+    size_t copy_len = *line_len > GATE_TLE_LINE_LEN ? GATE_TLE_LINE_LEN : *line_len;
+    memcpy(line, buffer + offset, copy_len * sizeof(*line));
+    line[copy_len] = '\0';
+
+    return end < len ? end + 1 : len;
+}
+
+void gate_parse_tle_buffer(ConstSpiceChar *buffer, size_t len, gate_tle_callback callback, void *user_data,
+                           SpiceInt *parsed, SpiceInt *rejected) {
+    SpiceInt parsed_count = 0;
+    SpiceInt rejected_count = 0;
+
+    // Each record is read using a window of 3 lines, where
+    // the first is only a name if the second and third
+    // begin with the TLE line numbers
+    SpiceChar lines[3][GATE_TLE_LINE_LEN + 1];
+    int window = 0;
+
+    size_t offset = 0;
+    gate_tle tle;
+    while (offset < len || window > 0) {
+        while (window < 3 && offset < len) {
+            size_t line_len;
+            size_t next = next_line(buffer, len, offset, lines[window], &line_len);
+            if (!is_blank(buffer + offset, line_len)) {
+                window++;
+            }
+            offset = next;
+        }
+
+        if (window < 2) {
+            if (window == 1) {
+                rejected_count++;
+            }
+            break;
+        }
+
+        int consumed;
+        gate_tle_status status;
+        if (lines[0][0] == '1' && lines[1][0] == '2') {
+            status = gate_parse_tle(NULL, lines[0], lines[1], &tle);
+            consumed = 2;
+        } else if (window == 3 && lines[1][0] == '1' && lines[2][0] == '2') {
+            // Names may be longer than the copied portion of
+            // the line, but are truncated by the parser anyway
+            status = gate_parse_tle(lines[0], lines[1], lines[2], &tle);
+            consumed = 3;
+        } else {
+            // Resynchronize on the following line
+            status = GATE_TLE_ERR_LINE_NUMBER;
+            consumed = 1;
+        }
+
+        if (status == GATE_TLE_OK) {
+            parsed_count++;
+            if (!callback(&tle, user_data)) {
+                break;
+            }
+        } else {
+            rejected_count++;
+            if (status == GATE_TLE_ERR_LEAPSECONDS) {
+                break;
+            }
+        }
+
+        // Shift the unconsumed lines to the front of the
+        // window
+        for (int i = consumed; i < window; ++i) {
+            memcpy(lines[i - consumed], lines[i], sizeof(lines[i]));
+        }
+        window -= consumed;
+    }
+
+    if (parsed != NULL) {
+        *parsed = parsed_count;
+    }
+
+    if (rejected != NULL) {
+        *rejected = rejected_count;
+    }
+}
+
+ConstSpiceChar *gate_tle_status_string(gate_tle_status status) {
+    switch (status) {
+        case GATE_TLE_OK:
+            return "OK";
+        case GATE_TLE_ERR_LENGTH:
+            return "Line is too short";
+        case GATE_TLE_ERR_LINE_NUMBER:
+            return "Lines are not numbered 1 and 2";
+        case GATE_TLE_ERR_CHECKSUM:
+            return "Checksum mismatch";
+        case GATE_TLE_ERR_FIELD:
+            return "Malformed column";
+        case GATE_TLE_ERR_CATALOG_MISMATCH:
+            return "Lines have different catalog numbers";
+        case GATE_TLE_ERR_LEAPSECONDS:
+            return "Epoch could not be converted, is a leapseconds kernel loaded?";
+        default:
+            return "Unknown status";
+    }
+}
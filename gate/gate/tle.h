@@ -0,0 +1,247 @@
+/**
+ * @file
+ * Native parser for NORAD two-line element sets (TLEs).
+ *
+ * The SPICE Toolkit provides getelm_c() in order to parse
+ * a TLE into the set of elements expected by the ev2lin_()
+ * and dpspce_() propagators. However, it only parses one
+ * element set at a time, does not verify the checksums of
+ * either line and signals an error for each malformed
+ * line, which makes it a poor fit for loading whole
+ * catalogs where a few bad entries are to be expected.
+ *
+ * The parser in this file reads the fixed TLE columns
+ * directly and produces the same element layout as
+ * getelm_c(), so that the output may be passed directly to
+ * the SPICE propagators. Both the two-line (2LE) and the
+ * three-line (3LE) formats, where each element set is
+ * preceded by a name line, are supported.
+ *
+ * The TLE format is documented by CelesTrak [[1]].
+ *
+ * [1]: https://celestrak.org/NORAD/documentation/tle-fmt.php
+ */
+
+#ifndef GATE_TLE_H
+#define GATE_TLE_H
+
+#include <cspice/SpiceUsr.h>
+#include <stddef.h>
+
+/**
+ * The number of significant characters in each line of a
+ * TLE, not including the line terminator.
+ */
+#define GATE_TLE_LINE_LEN 69
+
+/**
+ * The maximum length of a satellite name in the name line
+ * of a 3LE, including the NULL terminator.
+ */
+#define GATE_TLE_NAME_MAX_LEN 25
+
+/**
+ * The number of elements produced for each TLE, laid out
+ * in the same way as the output of getelm_c().
+ */
+#define GATE_TLE_ELEMENTS_LEN 10
+
+/**
+ * The earliest year which is represented by the two digit
+ * years in the epoch of a TLE, i.e. the `frstyr` parameter
+ * of getelm_c(). No element set predates the launch of
+ * Sputnik 1 in 1957.
+ */
+#define GATE_TLE_MIN_YEAR 1957
+
+/**
+ * The orbital period in minutes at and beyond which
+ * objects must be propagated using the deep space model.
+ */
+#define GATE_TLE_DEEP_SPACE_PERIOD 225
+
+/**
+ * Indices into the elements array of a gate_tle, which
+ * follow the layout documented for getelm_c().
+ */
+typedef enum {
+    /**
+     * First derivative of the mean motion divided by 2, in
+     * radians per minute squared.
+     */
+    GATE_TLE_NDT2O = 0,
+    /**
+     * Second derivative of the mean motion divided by 6,
+     * in radians per minute cubed.
+     */
+    GATE_TLE_NDD6O,
+    /**
+     * The B* drag term, in inverse Earth radii.
+     */
+    GATE_TLE_BSTAR,
+    /**
+     * Inclination in radians.
+     */
+    GATE_TLE_INCL,
+    /**
+     * Right ascension of the ascending node in radians.
+     */
+    GATE_TLE_NODE0,
+    /**
+     * Eccentricity.
+     */
+    GATE_TLE_ECC,
+    /**
+     * Argument of perigee in radians.
+     */
+    GATE_TLE_OMEGA,
+    /**
+     * Mean anomaly in radians.
+     */
+    GATE_TLE_MO,
+    /**
+     * Mean motion in radians per minute.
+     */
+    GATE_TLE_NO,
+    /**
+     * Epoch of the elements in ephemeris time.
+     */
+    GATE_TLE_EPOCH
+} gate_tle_element;
+
+/**
+ * Result of parsing a single element set.
+ */
+typedef enum {
+    GATE_TLE_OK = 0,
+    /**
+     * A line is shorter than GATE_TLE_LINE_LEN.
+     */
+    GATE_TLE_ERR_LENGTH,
+    /**
+     * A line does not begin with the expected line
+     * number.
+     */
+    GATE_TLE_ERR_LINE_NUMBER,
+    /**
+     * The checksum in the last column of a line does not
+     * match the contents of that line.
+     */
+    GATE_TLE_ERR_CHECKSUM,
+    /**
+     * A numeric column could not be parsed.
+     */
+    GATE_TLE_ERR_FIELD,
+    /**
+     * The two lines refer to different catalog numbers.
+     */
+    GATE_TLE_ERR_CATALOG_MISMATCH,
+    /**
+     * The epoch could not be converted to ephemeris time,
+     * usually because no leapseconds kernel is loaded. The
+     * SPICE error is left signaled.
+     */
+    GATE_TLE_ERR_LEAPSECONDS
+} gate_tle_status;
+
+/**
+ * Represents a parsed TLE along with the original text
+ * from which it was parsed.
+ */
+typedef struct {
+    SpiceInt catalog_number;
+
+    /**
+     * The name of the object if it was parsed from a 3LE,
+     * or an empty string otherwise.
+     */
+    SpiceChar name[GATE_TLE_NAME_MAX_LEN];
+    SpiceChar lines[2][GATE_TLE_LINE_LEN + 1];
+
+    /**
+     * The epoch of the elements in ephemeris time, which
+     * is the same as elements[GATE_TLE_EPOCH].
+     */
+    SpiceDouble epoch;
+    SpiceDouble elements[GATE_TLE_ELEMENTS_LEN];
+
+    /**
+     * Whether the orbital period is long enough that the
+     * object must be propagated with dpspce_() rather than
+     * ev2lin_().
+     */
+    SpiceBoolean is_deep_space;
+} gate_tle;
+
+/**
+ * Callback invoked once for each element set parsed by
+ * gate_parse_tle_buffer().
+ *
+ * @param tle the parsed element set, which is overwritten
+ * once the callback returns (input)
+ * @param user_data the pointer passed to
+ * gate_parse_tle_buffer() (input)
+ * @return nonzero to continue parsing, 0 to stop
+ */
+typedef int (*gate_tle_callback)(const gate_tle *tle, void *user_data);
+
+/**
+ * Parses a single element set.
+ *
+ * Requires a leapseconds kernel to be loaded in order to
+ * convert the UTC epoch of the element set to ephemeris
+ * time.
+ *
+ * @param name the name line of a 3LE, or NULL if the
+ * element set has no name. Leading "0 " markers and
+ * trailing whitespace are removed (input)
+ * @param line1 the first line of the element set, which
+ * must be at least GATE_TLE_LINE_LEN characters long
+ * (input)
+ * @param line2 the second line of the element set, which
+ * must be at least GATE_TLE_LINE_LEN characters long
+ * (input)
+ * @param tle the parsed element set (output)
+ * @return GATE_TLE_OK if the element set was parsed,
+ * otherwise the reason it was rejected
+ */
+gate_tle_status gate_parse_tle(ConstSpiceChar *name, ConstSpiceChar *line1, ConstSpiceChar *line2,
+                               gate_tle *tle);
+
+/**
+ * Parses every element set in a buffer holding the
+ * contents of a 2LE or 3LE file, which may mix both
+ * formats.
+ *
+ * Element sets which fail to parse are skipped and
+ * counted, and parsing resumes on the following line.
+ * Parsing stops at the first element set whose epoch
+ * cannot be converted, since no other could be either, in
+ * which case the SPICE error is left signaled and that
+ * element set is counted as rejected.
+ *
+ * @param buffer the file contents, which need not be NULL
+ * terminated (input)
+ * @param len the number of characters in the buffer
+ * (input)
+ * @param callback the procedure to invoke for each parsed
+ * element set (input)
+ * @param user_data an arbitrary pointer passed to each
+ * invocation of the callback, or NULL (input)
+ * @param parsed the number of element sets passed to the
+ * callback, or NULL if not desired (output)
+ * @param rejected the number of element sets which failed
+ * to parse, or NULL if not desired (output)
+ */
+void gate_parse_tle_buffer(ConstSpiceChar *buffer, size_t len, gate_tle_callback callback, void *user_data,
+                           SpiceInt *parsed, SpiceInt *rejected);
+
+/**
+ * Obtains a human readable description of a status code.
+ *
+ * @param status the status code (input)
+ * @return a static string describing the status
+ */
+ConstSpiceChar *gate_tle_status_string(gate_tle_status status);
+
+#endif // GATE_TLE_H
@@ -0,0 +1,370 @@
+#include "tlehistory.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define INITIAL_CAP 16
+
+/**
+ * An element set parsed from an archive, along with its
+ * position in the archive so that the last of several
+ * element sets with the same epoch can be kept.
+ */
+typedef struct {
+    SpiceInt catalog_number;
+    SpiceInt order;
+    SpiceDouble elements[GATE_TLE_ELEMENTS_LEN];
+} staged_set;
+
+typedef struct {
+    SpiceInt len;
+    SpiceInt cap;
+    staged_set *sets;
+    SpiceBoolean out_of_memory;
+} staging;
+
+static void signal_alloc() {
+    setmsg_c("Failed to allocate memory for the TLE history");
+    sigerr_c("alloc");
+}
+
+/**
+ * Finds the index of the first track with a catalog number
+ * that is not less than the given one.
+ */
+static SpiceInt find_track(const gate_tle_history *history, SpiceInt catalog_number) {
+    SpiceInt low = 0;
+    SpiceInt high = history->len;
+    while (low < high) {
+        SpiceInt mid = low + (high - low) / 2;
+        if (history->tracks[mid].catalog_number < catalog_number) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+
+    return low;
+}
+
+/**
+ * Finds the index of the first element set of a track with
+ * an epoch that is not less than the given time.
+ */
+static SpiceInt find_epoch(const gate_tle_track *track, SpiceDouble et) {
+    SpiceInt low = 0;
+    SpiceInt high = track->len;
+    while (low < high) {
+        SpiceInt mid = low + (high - low) / 2;
+        if (track->epochs[mid] < et) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+
+    return low;
+}
+
+static SpiceBoolean reserve_track(gate_tle_track *track, SpiceInt cap) {
+    if (cap <= track->cap) {
+        return SPICETRUE;
+    }
+
+    SpiceDouble *epochs = realloc(track->epochs, cap * sizeof(*epochs));
+    if (epochs == NULL) {
+        return SPICEFALSE;
+    }
+    track->epochs = epochs;
+
+    SpiceDouble (*elements)[GATE_TLE_ELEMENTS_LEN] = realloc(track->elements, cap * sizeof(*elements));
+    if (elements == NULL) {
+        return SPICEFALSE;
+    }
+    track->elements = elements;
+
+    track->cap = cap;
+    return SPICETRUE;
+}
+
+void gate_tle_history_init(gate_tle_history *history) {
+    memset(history, 0, sizeof(*history));
+}
+
+SpiceBoolean gate_tle_history_add(gate_tle_history *history, const gate_tle *tle) {
+    SpiceInt t = find_track(history, tle->catalog_number);
+    if (t == history->len || history->tracks[t].catalog_number != tle->catalog_number) {
+        if (history->len == history->cap) {
+            SpiceInt cap = history->cap == 0 ? INITIAL_CAP : history->cap * 2;
+            gate_tle_track *tracks = realloc(history->tracks, cap * sizeof(*tracks));
+            if (tracks == NULL) {
+                signal_alloc();
+                return SPICEFALSE;
+            }
+            history->tracks = tracks;
+            history->cap = cap;
+        }
+
+        memmove(&history->tracks[t + 1], &history->tracks[t], (history->len - t) * sizeof(*history->tracks));
+        memset(&history->tracks[t], 0, sizeof(*history->tracks));
+        history->tracks[t].catalog_number = tle->catalog_number;
+        history->len++;
+    }
+
+    gate_tle_track *track = &history->tracks[t];
+    SpiceInt i = find_epoch(track, tle->epoch);
+    if (i == track->len || track->epochs[i] != tle->epoch) {
+        if (track->len == track->cap && !reserve_track(track, track->cap == 0 ? 1 : track->cap * 2)) {
+            signal_alloc();
+            return SPICEFALSE;
+        }
+
+        memmove(&track->epochs[i + 1], &track->epochs[i], (track->len - i) * sizeof(*track->epochs));
+        memmove(&track->elements[i + 1], &track->elements[i], (track->len - i) * sizeof(*track->elements));
+        track->len++;
+        history->sets_len++;
+    }
+
+    track->epochs[i] = tle->epoch;
+    memcpy(track->elements[i], tle->elements, sizeof(track->elements[i]));
+    return SPICETRUE;
+}
+
+static int stage_set(const gate_tle *tle, void *user_data) {
+    staging *stage = user_data;
+    if (stage->len == stage->cap) {
+        SpiceInt cap = stage->cap == 0 ? INITIAL_CAP : stage->cap * 2;
+        staged_set *sets = realloc(stage->sets, cap * sizeof(*sets));
+        if (sets == NULL) {
+            stage->out_of_memory = SPICETRUE;
+            return 0;
+        }
+        stage->sets = sets;
+        stage->cap = cap;
+    }
+
+    staged_set *set = &stage->sets[stage->len];
+    set->catalog_number = tle->catalog_number;
+    set->order = stage->len;
+    memcpy(set->elements, tle->elements, sizeof(set->elements));
+    stage->len++;
+
+    return 1;
+}
+
+static int compare_staged(const void *a, const void *b) {
+    const staged_set *set_a = a;
+    const staged_set *set_b = b;
+    if (set_a->catalog_number != set_b->catalog_number) {
+        return set_a->catalog_number < set_b->catalog_number ? -1 : 1;
+    }
+
+    SpiceDouble epoch_a = set_a->elements[GATE_TLE_EPOCH];
+    SpiceDouble epoch_b = set_b->elements[GATE_TLE_EPOCH];
+    if (epoch_a != epoch_b) {
+        return epoch_a < epoch_b ? -1 : 1;
+    }
+
+    return set_a->order < set_b->order ? -1 : set_a->order > set_b->order;
+}
+
+/**
+ * Merges a run of staged element sets of one satellite,
+ * sorted by epoch and without duplicate epochs, with the
+ * existing track of the satellite into newly allocated
+ * arrays.
+ */
+static SpiceBoolean merge_run(const gate_tle_track *old, const staged_set *run, SpiceInt run_len,
+                              gate_tle_track *merged) {
+    SpiceInt old_len = old == NULL ? 0 : old->len;
+
+    memset(merged, 0, sizeof(*merged));
+    merged->catalog_number = run[0].catalog_number;
+    if (!reserve_track(merged, old_len + run_len)) {
+        free(merged->epochs);
+        free(merged->elements);
+        return SPICEFALSE;
+    }
+
+    SpiceInt i = 0;
+    SpiceInt j = 0;
+    while (i < old_len || j < run_len) {
+        SpiceDouble *elements = merged->elements[merged->len];
+        if (j == run_len || (i < old_len && old->epochs[i] < run[j].elements[GATE_TLE_EPOCH])) {
+            merged->epochs[merged->len] = old->epochs[i];
+            memcpy(elements, old->elements[i], sizeof(old->elements[i]));
+            i++;
+        } else {
+            // The archive wins over an element set that is
+            // already stored with the same epoch
+            if (i < old_len && old->epochs[i] == run[j].elements[GATE_TLE_EPOCH]) {
+                i++;
+            }
+            merged->epochs[merged->len] = run[j].elements[GATE_TLE_EPOCH];
+            memcpy(elements, run[j].elements, sizeof(run[j].elements));
+            j++;
+        }
+        merged->len++;
+    }
+
+    return SPICETRUE;
+}
+
+void gate_tle_history_append_buffer(gate_tle_history *history, ConstSpiceChar *buffer, size_t len,
+                                    SpiceInt *added, SpiceInt *rejected) {
+    if (added != NULL) {
+        *added = 0;
+    }
+
+    staging stage = {0, 0, NULL, SPICEFALSE};
+    gate_parse_tle_buffer(buffer, len, stage_set, &stage, NULL, rejected);
+    if (stage.out_of_memory) {
+        free(stage.sets);
+        signal_alloc();
+        return;
+    }
+
+    qsort(stage.sets, stage.len, sizeof(*stage.sets), compare_staged);
+
+    // Keep only the last element set of each epoch, and
+    // count the satellites without an existing track
+    SpiceInt unique_len = 0;
+    SpiceInt new_tracks = 0;
+    for (SpiceInt k = 0; k < stage.len; ++k) {
+        staged_set *set = &stage.sets[k];
+        if (unique_len > 0) {
+            staged_set *prev = &stage.sets[unique_len - 1];
+            if (prev->catalog_number == set->catalog_number &&
+                prev->elements[GATE_TLE_EPOCH] == set->elements[GATE_TLE_EPOCH]) {
+                *prev = *set;
+                continue;
+            }
+        }
+
+        if (unique_len == 0 || stage.sets[unique_len - 1].catalog_number != set->catalog_number) {
+            SpiceInt t = find_track(history, set->catalog_number);
+            if (t == history->len || history->tracks[t].catalog_number != set->catalog_number) {
+                new_tracks++;
+            }
+        }
+        stage.sets[unique_len++] = *set;
+    }
+
+    SpiceInt tracks_len = history->len + new_tracks;
+    gate_tle_track *tracks = malloc(tracks_len * sizeof(*tracks) + 1);
+    SpiceBoolean *is_merged = calloc(tracks_len + 1, sizeof(*is_merged));
+    if (tracks == NULL || is_merged == NULL) {
+        free(tracks);
+        free(is_merged);
+        free(stage.sets);
+        signal_alloc();
+        return;
+    }
+
+    // Merge the runs of each satellite into the tracks,
+    // which are both sorted by catalog number
+    SpiceInt t = 0;
+    SpiceInt k = 0;
+    SpiceInt out = 0;
+    while (t < history->len || k < unique_len) {
+        if (k == unique_len || (t < history->len &&
+                                history->tracks[t].catalog_number < stage.sets[k].catalog_number)) {
+            tracks[out++] = history->tracks[t++];
+            continue;
+        }
+
+        SpiceInt run_len = 1;
+        while (k + run_len < unique_len && stage.sets[k + run_len].catalog_number == stage.sets[k].catalog_number) {
+            run_len++;
+        }
+
+        const gate_tle_track *old = NULL;
+        if (t < history->len && history->tracks[t].catalog_number == stage.sets[k].catalog_number) {
+            old = &history->tracks[t++];
+        }
+
+        if (!merge_run(old, &stage.sets[k], run_len, &tracks[out])) {
+            for (SpiceInt i = 0; i < out; ++i) {
+                if (is_merged[i]) {
+                    free(tracks[i].epochs);
+                    free(tracks[i].elements);
+                }
+            }
+            free(tracks);
+            free(is_merged);
+            free(stage.sets);
+            signal_alloc();
+            return;
+        }
+        is_merged[out++] = SPICETRUE;
+        k += run_len;
+    }
+
+    // Every allocation succeeded, so the tracks that were
+    // merged into new arrays can be released
+    SpiceInt sets_len = 0;
+    t = 0;
+    for (SpiceInt i = 0; i < out; ++i) {
+        if (is_merged[i]) {
+            while (t < history->len && history->tracks[t].catalog_number < tracks[i].catalog_number) {
+                t++;
+            }
+            if (t < history->len && history->tracks[t].catalog_number == tracks[i].catalog_number) {
+                free(history->tracks[t].epochs);
+                free(history->tracks[t].elements);
+            }
+        }
+        sets_len += tracks[i].len;
+    }
+
+    free(history->tracks);
+    history->tracks = tracks;
+    history->len = out;
+    history->cap = tracks_len;
+    if (added != NULL) {
+        *added = unique_len;
+    }
+    history->sets_len = sets_len;
+
+    free(is_merged);
+    free(stage.sets);
+}
+
+const gate_tle_track *gate_tle_history_find(const gate_tle_history *history, SpiceInt catalog_number) {
+    SpiceInt t = find_track(history, catalog_number);
+    if (t == history->len || history->tracks[t].catalog_number != catalog_number) {
+        return NULL;
+    }
+
+    return &history->tracks[t];
+}
+
+SpiceInt gate_tle_track_nearest(const gate_tle_track *track, SpiceDouble et) {
+    SpiceInt i = find_epoch(track, et);
+    if (i == track->len) {
+        return track->len - 1;
+    }
+
+    if (i > 0 && et - track->epochs[i - 1] <= track->epochs[i] - et) {
+        return i - 1;
+    }
+    return i;
+}
+
+SpiceDouble gate_tle_track_nearest_end(const gate_tle_track *track, SpiceInt index) {
+    if (index >= track->len - 1) {
+        return HUGE_VAL;
+    }
+
+    return (track->epochs[index] + track->epochs[index + 1]) / 2;
+}
+
+void gate_tle_history_free(gate_tle_history *history) {
+    for (SpiceInt t = 0; t < history->len; ++t) {
+        free(history->tracks[t].epochs);
+        free(history->tracks[t].elements);
+    }
+    free(history->tracks);
+
+    memset(history, 0, sizeof(*history));
+}
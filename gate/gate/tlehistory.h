@@ -0,0 +1,160 @@
+/**
+ * @file
+ * Histories of the element sets of satellites over time.
+ *
+ * A single element set is only accurate for a few days
+ * around its epoch, so replaying a satellite over weeks or
+ * months requires switching between the element sets that
+ * were published for it along the way. A gate_tle_history
+ * keeps every element set loaded for each catalog number,
+ * sorted by epoch, so that the element set whose epoch is
+ * nearest to any time can be found with a binary search.
+ *
+ * Only the numeric elements are kept, in the layout
+ * produced by getelm_c(), which is all that is needed to
+ * initialize a propagator with gate_sgp4_init(). The text
+ * of archived element sets is dropped, as it makes up most
+ * of the size of an archive.
+ *
+ * Archives are appended in bulk: the element sets of a
+ * buffer are parsed into a flat array, sorted once by
+ * catalog number and epoch, and then merged into the
+ * existing histories in a single pass, rather than being
+ * inserted into their history one at a time.
+ */
+
+#ifndef GATE_TLEHISTORY_H
+#define GATE_TLEHISTORY_H
+
+#include <cspice/SpiceUsr.h>
+#include <stddef.h>
+#include "tle.h"
+
+/**
+ * The element sets of a single satellite, sorted by
+ * epoch. No two element sets of a track share an epoch.
+ */
+typedef struct {
+    SpiceInt catalog_number;
+
+    SpiceInt len;
+    SpiceInt cap;
+
+    /**
+     * The epoch of each element set in ephemeris time,
+     * kept apart from the elements so that searches only
+     * touch the epochs.
+     */
+    SpiceDouble *epochs;
+    SpiceDouble (*elements)[GATE_TLE_ELEMENTS_LEN];
+} gate_tle_track;
+
+/**
+ * Represents the element set histories of a set of
+ * satellites.
+ */
+typedef struct {
+    /**
+     * The tracks, sorted by catalog number.
+     */
+    SpiceInt len;
+    SpiceInt cap;
+    gate_tle_track *tracks;
+
+    /**
+     * The total number of element sets in all tracks.
+     */
+    SpiceInt sets_len;
+} gate_tle_history;
+
+/**
+ * Initializes an empty history.
+ *
+ * @param history the history to initialize (output)
+ */
+void gate_tle_history_init(gate_tle_history *history);
+
+/**
+ * Adds a single element set to the history of its
+ * satellite, replacing the element set with the same
+ * epoch if there is one.
+ *
+ * @param history the history to add to (input/output)
+ * @param tle the element set (input)
+ * @return SPICETRUE if the element set was added
+ *
+ * @throws alloc if memory could not be allocated
+ */
+SpiceBoolean gate_tle_history_add(gate_tle_history *history, const gate_tle *tle);
+
+/**
+ * Parses every element set in a buffer holding a 2LE or
+ * 3LE archive, such as the full history of a catalog
+ * number downloaded from Space-Track, and adds them all to
+ * the history.
+ *
+ * An element set in the buffer replaces an element set
+ * with the same catalog number and epoch that is already
+ * in the history, or that appears earlier in the buffer.
+ *
+ * @param history the history to add to (input/output)
+ * @param buffer the file contents, which need not be NULL
+ * terminated (input)
+ * @param len the number of characters in the buffer
+ * (input)
+ * @param added the number of element sets added to the
+ * history, or NULL if not desired (output)
+ * @param rejected the number of element sets which failed
+ * to parse, or NULL if not desired (output)
+ *
+ * @throws alloc if memory could not be allocated, in which
+ * case the history is left unchanged
+ */
+void gate_tle_history_append_buffer(gate_tle_history *history, ConstSpiceChar *buffer, size_t len,
+                                    SpiceInt *added, SpiceInt *rejected);
+
+/**
+ * Finds the history of the satellite with the given
+ * catalog number.
+ *
+ * @param history the history to search (input)
+ * @param catalog_number the catalog number of the
+ * satellite (input)
+ * @return the track of the satellite, or NULL if it has
+ * no element sets in the history
+ */
+const gate_tle_track *gate_tle_history_find(const gate_tle_history *history, SpiceInt catalog_number);
+
+/**
+ * Finds the element set in a track whose epoch is nearest
+ * to the given time.
+ *
+ * @param track the track to search, which must not be
+ * empty (input)
+ * @param et the ephemeris time (input)
+ * @return the index of the element set in the track
+ */
+SpiceInt gate_tle_track_nearest(const gate_tle_track *track, SpiceDouble et);
+
+/**
+ * Obtains the ephemeris time at which the element set at
+ * the given index stops being the nearest one, i.e. the
+ * midpoint between its epoch and the next one.
+ *
+ * @param track the track (input)
+ * @param index the index of an element set in the track
+ * (input)
+ * @return the ephemeris time, or HUGE_VAL for the last
+ * element set of the track
+ */
+SpiceDouble gate_tle_track_nearest_end(const gate_tle_track *track, SpiceInt index);
+
+/**
+ * Frees all memory held by the given history, leaving it
+ * empty.
+ *
+ * @param history the history to free (input/output)
+ */
+void gate_tle_history_free(gate_tle_history *history);
+
+#endif // GATE_TLEHISTORY_H
@@ -0,0 +1,477 @@
+#include "visibility.h"
+#include <math.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sgp4batch.h"
+
+#define EARTH_BODY_ID 399
+#define FRAME_NAME_MAX_LEN 33
+#define REFINE_MAX_ITERATIONS 50
+#define INITIAL_CAP 64
+
+// Rotation rate of the Earth in radians per second
+#define EARTH_ROTATION_RATE 7.292115e-5
+
+/**
+ * The stations in a layout that the elevation check can
+ * vectorize over: the Earth-fixed position, the unit
+ * vector pointing up and the sine of the minimum
+ * elevation of each station.
+ */
+typedef struct {
+    SpiceDouble *px, *py, *pz;
+    SpiceDouble *ux, *uy, *uz;
+    SpiceDouble *sin_min;
+} station_arrays;
+
+typedef struct {
+    const gate_sgp4 *sats;
+    const gate_sgp4_batch *batch;
+    SpiceInt near_groups;
+
+    SpiceInt stations_len;
+    station_arrays stations;
+
+    SpiceDouble start_et;
+    SpiceDouble end_et;
+    SpiceDouble step;
+    SpiceInt steps_len;
+    SpiceDouble (*rotations)[3][3];
+
+    SpiceDouble (*states)[6];
+    gate_sgp4_status *status;
+
+    pthread_mutex_t lock;
+    gate_vis_table *table;
+    SpiceBoolean out_of_memory;
+} vis_job;
+
+/**
+ * Windows found by one chunk of work, which are merged
+ * into the table once the chunk is done.
+ */
+typedef struct {
+    SpiceInt len;
+    SpiceInt cap;
+    gate_vis_window *windows;
+} window_list;
+
+static SpiceBoolean append_window(window_list *list, SpiceInt sat, SpiceInt station, SpiceDouble rise,
+                                  SpiceDouble set, SpiceDouble start_et) {
+    if (list->len == list->cap) {
+        SpiceInt cap = list->cap == 0 ? INITIAL_CAP : list->cap * 2;
+        gate_vis_window *windows = realloc(list->windows, cap * sizeof(*windows));
+        if (windows == NULL) {
+            return SPICEFALSE;
+        }
+
+        list->cap = cap;
+        list->windows = windows;
+    }
+
+    gate_vis_window window = {sat, station, (float) (rise - start_et), (float) (set - start_et)};
+    list->windows[list->len++] = window;
+    return SPICETRUE;
+}
+
+static SpiceDouble step_et(const vis_job *job, SpiceInt k) {
+    SpiceDouble et = job->start_et + k * job->step;
+    return et < job->end_et ? et : job->end_et;
+}
+
+/**
+ * Rotates a J2000 position into the Earth-fixed frame,
+ * extrapolating the rotation at step k to the given time.
+ */
+static void to_earth_fixed(const vis_job *job, SpiceInt k, SpiceDouble et, ConstSpiceDouble pos[3],
+                           SpiceDouble out[3]) {
+    SpiceDouble rotated[3];
+    mxv_c(job->rotations[k], pos, rotated);
+
+    SpiceDouble theta = EARTH_ROTATION_RATE * (et - step_et(job, k));
+    SpiceDouble c = cos(theta);
+    SpiceDouble s = sin(theta);
+    out[0] = c * rotated[0] + s * rotated[1];
+    out[1] = -s * rotated[0] + c * rotated[1];
+    out[2] = rotated[2];
+}
+
+/**
+ * Computes how far above the minimum elevation a station
+ * sees a satellite, as the sine of the elevation minus the
+ * sine of the minimum elevation, scaled by the range.
+ */
+static SpiceDouble station_margin(const station_arrays *st, SpiceInt s, ConstSpiceDouble pos[3]) {
+    SpiceDouble dx = pos[0] - st->px[s];
+    SpiceDouble dy = pos[1] - st->py[s];
+    SpiceDouble dz = pos[2] - st->pz[s];
+    SpiceDouble range = sqrt(dx * dx + dy * dy + dz * dz);
+
+    return dx * st->ux[s] + dy * st->uy[s] + dz * st->uz[s] - st->sin_min[s] * range;
+}
+
+/**
+ * Computes the margin of a satellite over every station,
+ * in a loop without branches so that it is vectorized.
+ */
+static void station_margins(const station_arrays *st, SpiceInt stations_len, ConstSpiceDouble pos[3],
+                            SpiceDouble *margins) {
+    for (SpiceInt s = 0; s < stations_len; ++s) {
+        margins[s] = station_margin(st, s, pos);
+    }
+}
+
+/**
+ * Interpolates the position of a satellite between two
+ * states span seconds apart with a cubic Hermite spline,
+ * where s is the fraction of the span.
+ */
+static void interpolate_position(ConstSpiceDouble from[6], ConstSpiceDouble to[6], SpiceDouble span,
+                                 SpiceDouble s, SpiceDouble pos[3]) {
+    SpiceDouble s2 = s * s;
+    SpiceDouble s3 = s2 * s;
+    SpiceDouble h00 = 2.0 * s3 - 3.0 * s2 + 1.0;
+    SpiceDouble h10 = (s3 - 2.0 * s2 + s) * span;
+    SpiceDouble h01 = -2.0 * s3 + 3.0 * s2;
+    SpiceDouble h11 = (s3 - s2) * span;
+    for (int i = 0; i < 3; ++i) {
+        pos[i] = h00 * from[i] + h10 * from[i + 3] + h01 * to[i] + h11 * to[i + 3];
+    }
+}
+
+/**
+ * Locates the time between steps k - 1 and k at which the
+ * margin of a station changes sign.
+ *
+ * Rather than propagating the satellite again, the
+ * position is interpolated from the states at both steps,
+ * which is accurate to within a meter for steps of a
+ * minute in low Earth orbit.
+ */
+static SpiceDouble refine_crossing(const vis_job *job, ConstSpiceDouble from[6], ConstSpiceDouble to[6],
+                                   SpiceInt station, SpiceInt k, SpiceDouble m0, SpiceDouble m1) {
+    SpiceDouble t0 = step_et(job, k - 1);
+    SpiceDouble t1 = step_et(job, k);
+    SpiceDouble span = t1 - t0;
+    SpiceDouble t = t1;
+    int side = 0;
+
+    for (int i = 0; i < REFINE_MAX_ITERATIONS; ++i) {
+        SpiceDouble next = (t0 * m1 - t1 * m0) / (m1 - m0);
+        if (fabs(next - t) < GATE_VIS_TIME_TOLERANCE) {
+            return next;
+        }
+        t = next;
+
+        SpiceDouble inertial[3];
+        SpiceDouble pos[3];
+        interpolate_position(from, to, span, (t - step_et(job, k - 1)) / span, inertial);
+        to_earth_fixed(job, k - 1, t, inertial, pos);
+        SpiceDouble m = station_margin(&job->stations, station, pos);
+
+        // Halve the value kept at the end that did not move
+        // so that convergence is not one-sided
+        if ((m < 0.0) == (m1 < 0.0)) {
+            t1 = t;
+            m1 = m;
+            if (side == -1) {
+                m0 *= 0.5;
+            }
+            side = -1;
+        } else if ((m < 0.0) == (m0 < 0.0)) {
+            t0 = t;
+            m0 = m;
+            if (side == 1) {
+                m1 *= 0.5;
+            }
+            side = 1;
+        } else {
+            break;
+        }
+    }
+
+    return t;
+}
+
+/**
+ * Propagates the satellites of one item of work. Deep
+ * space satellites resume the integration of resonance
+ * effects from the previous step, which the caller keeps
+ * in the given checkpoint.
+ */
+static void propagate_item(const vis_job *job, SpiceInt item, SpiceDouble et, gate_sgp4_resonance *resonance) {
+    if (item < job->near_groups) {
+        gate_sgp4_batch_propagate_near(job->batch, item, item + 1, et, job->states, job->status);
+    } else {
+        SpiceInt sat = job->batch->deep_index[item - job->near_groups];
+        job->status[sat] = gate_sgp4_propagate_resume(&job->sats[sat], resonance, et, job->states[sat]);
+    }
+}
+
+static void visibility_chunk(void *user_data, SpiceInt begin, SpiceInt end) {
+    vis_job *job = user_data;
+    SpiceInt stations_len = job->stations_len;
+    window_list list = {0};
+
+    // The margins at the previous step and the rise time
+    // of each open window, for every lane and station
+    SpiceDouble *prev = malloc(GATE_SGP4_LANES * stations_len * sizeof(*prev) + 1);
+    SpiceDouble *cur = malloc(GATE_SGP4_LANES * stations_len * sizeof(*cur) + 1);
+    SpiceDouble *rise = malloc(GATE_SGP4_LANES * stations_len * sizeof(*rise) + 1);
+    SpiceBoolean ok = prev != NULL && cur != NULL && rise != NULL;
+
+    for (SpiceInt item = begin; ok && item < end; ++item) {
+        SpiceInt sats[GATE_SGP4_LANES];
+        SpiceDouble prev_states[GATE_SGP4_LANES][6];
+        SpiceBoolean prev_propagated[GATE_SGP4_LANES];
+        SpiceInt lanes = 1;
+        if (item < job->near_groups) {
+            lanes = GATE_SGP4_LANES;
+            memcpy(sats, &job->batch->near_index[item * GATE_SGP4_LANES], sizeof(sats));
+        } else {
+            sats[0] = job->batch->deep_index[item - job->near_groups];
+        }
+
+        // Each step resumes the resonance integration where
+        // the previous step left it instead of starting over
+        // from the epoch
+        gate_sgp4_resonance resonance = {0};
+
+        for (SpiceInt k = 0; ok && k < job->steps_len; ++k) {
+            SpiceDouble et = step_et(job, k);
+            propagate_item(job, item, et, &resonance);
+
+            for (SpiceInt l = 0; ok && l < lanes; ++l) {
+                SpiceInt sat = sats[l];
+                if (sat == -1) {
+                    continue;
+                }
+
+                SpiceDouble *lane_prev = &prev[l * stations_len];
+                SpiceDouble *lane_cur = &cur[l * stations_len];
+                SpiceDouble *lane_rise = &rise[l * stations_len];
+                SpiceBoolean propagated = job->status[sat] == GATE_SGP4_OK;
+                if (propagated) {
+                    SpiceDouble pos[3];
+                    to_earth_fixed(job, k, et, job->states[sat], pos);
+                    station_margins(&job->stations, stations_len, pos, lane_cur);
+                } else {
+                    for (SpiceInt s = 0; s < stations_len; ++s) {
+                        lane_cur[s] = -1.0;
+                    }
+                }
+
+                for (SpiceInt s = 0; s < stations_len; ++s) {
+                    SpiceBoolean visible = lane_cur[s] >= 0.0;
+                    if (k == 0) {
+                        lane_rise[s] = et;
+                        continue;
+                    }
+
+                    if (visible == (lane_prev[s] >= 0.0)) {
+                        continue;
+                    }
+
+                    // Without two states to interpolate between,
+                    // windows open or close at the step at which
+                    // the satellite was propagated
+                    SpiceDouble crossing = visible ? et : step_et(job, k - 1);
+                    if (propagated && prev_propagated[l]) {
+                        crossing = refine_crossing(job, prev_states[l], job->states[sat], s, k, lane_prev[s],
+                                                   lane_cur[s]);
+                    }
+
+                    if (visible) {
+                        lane_rise[s] = crossing;
+                    } else {
+                        ok = append_window(&list, sat, s, lane_rise[s], crossing, job->start_et);
+                    }
+                }
+                memcpy(lane_prev, lane_cur, stations_len * sizeof(*lane_cur));
+                memcpy(prev_states[l], job->states[sat], sizeof(prev_states[l]));
+                prev_propagated[l] = propagated;
+            }
+        }
+
+        // Close the windows that are still open at the end
+        for (SpiceInt l = 0; ok && l < lanes; ++l) {
+            if (sats[l] == -1) {
+                continue;
+            }
+
+            for (SpiceInt s = 0; ok && s < stations_len; ++s) {
+                if (prev[l * stations_len + s] >= 0.0) {
+                    ok = append_window(&list, sats[l], s, rise[l * stations_len + s], job->end_et, job->start_et);
+                }
+            }
+        }
+    }
+
+    pthread_mutex_lock(&job->lock);
+    gate_vis_table *table = job->table;
+    if (ok && table->len + list.len > table->cap) {
+        SpiceInt cap = table->cap == 0 ? INITIAL_CAP : table->cap;
+        while (cap < table->len + list.len) {
+            cap *= 2;
+        }
+
+        gate_vis_window *windows = realloc(table->windows, cap * sizeof(*windows));
+        if (windows != NULL) {
+            table->cap = cap;
+            table->windows = windows;
+        } else {
+            ok = SPICEFALSE;
+        }
+    }
+    if (ok) {
+        memcpy(&table->windows[table->len], list.windows, list.len * sizeof(*list.windows));
+        table->len += list.len;
+    } else {
+        job->out_of_memory = SPICETRUE;
+    }
+    pthread_mutex_unlock(&job->lock);
+
+    free(list.windows);
+    free(prev);
+    free(cur);
+    free(rise);
+}
+
+static int compare_windows(const void *a, const void *b) {
+    const gate_vis_window *wa = a;
+    const gate_vis_window *wb = b;
+    if (wa->sat != wb->sat) {
+        return wa->sat < wb->sat ? -1 : 1;
+    }
+    if (wa->station != wb->station) {
+        return wa->station < wb->station ? -1 : 1;
+    }
+    if (wa->rise != wb->rise) {
+        return wa->rise < wb->rise ? -1 : 1;
+    }
+    return 0;
+}
+
+/**
+ * Computes the Earth-fixed position and up vector of each
+ * station from its geodetic coordinates.
+ */
+static void load_stations(SpiceInt stations_len, const gate_station *stations, station_arrays *st) {
+    SpiceInt returned_count;
+    SpiceDouble radii[3];
+    bodvcd_c(EARTH_BODY_ID, "RADII", 3, &returned_count, radii);
+    SpiceDouble f = (radii[0] - radii[2]) / radii[0];
+
+    for (SpiceInt s = 0; s < stations_len; ++s) {
+        SpiceDouble lon = stations[s].longitude * rpd_c();
+        SpiceDouble lat = stations[s].latitude * rpd_c();
+        SpiceDouble pos[3];
+        georec_c(lon, lat, stations[s].altitude, radii[0], f, pos);
+
+        st->px[s] = pos[0];
+        st->py[s] = pos[1];
+        st->pz[s] = pos[2];
+        st->ux[s] = cos(lat) * cos(lon);
+        st->uy[s] = cos(lat) * sin(lon);
+        st->uz[s] = sin(lat);
+        st->sin_min[s] = sin(stations[s].min_elevation * rpd_c());
+    }
+}
+
+void gate_compute_visibility(gate_pool *pool, SpiceInt sats_len, const gate_sgp4 *sats,
+                             const gate_sgp4_status *init_status, SpiceInt stations_len,
+                             const gate_station *stations, SpiceDouble start_et, SpiceDouble end_et,
+                             SpiceDouble step, gate_vis_table *table) {
+    memset(table, 0, sizeof(*table));
+    table->start_et = start_et;
+    table->end_et = end_et;
+    if (stations_len <= 0 || end_et <= start_et) {
+        return;
+    }
+
+    SpiceInt earth_frame_id;
+    SpiceChar earth_frame[FRAME_NAME_MAX_LEN];
+    SpiceBoolean earth_frame_found;
+    cidfrm_c(EARTH_BODY_ID, FRAME_NAME_MAX_LEN, &earth_frame_id, earth_frame, &earth_frame_found);
+    if (!earth_frame_found) {
+        setmsg_c("Earth fixed frame cannot be found");
+        sigerr_c("resolve_rel_frame");
+        return;
+    }
+
+    gate_sgp4_batch batch;
+    gate_sgp4_batch_init(sats_len, sats, init_status, &batch);
+    if (failed_c()) {
+        return;
+    }
+
+    SpiceInt steps_len = (SpiceInt) ceil((end_et - start_et) / step) + 1;
+    vis_job job = {
+            .sats = sats,
+            .batch = &batch,
+            .near_groups = batch.lane_cap / GATE_SGP4_LANES,
+            .stations_len = stations_len,
+            .start_et = start_et,
+            .end_et = end_et,
+            .step = step,
+            .steps_len = steps_len,
+            .table = table,
+            .out_of_memory = SPICEFALSE
+    };
+
+    SpiceDouble *station_data = malloc(7 * stations_len * sizeof(*station_data));
+    job.rotations = malloc(steps_len * sizeof(*job.rotations));
+    job.states = malloc(sats_len * sizeof(*job.states) + 1);
+    job.status = malloc(sats_len * sizeof(*job.status) + 1);
+    if (station_data == NULL || job.rotations == NULL || job.states == NULL || job.status == NULL) {
+        free(station_data);
+        free(job.rotations);
+        free(job.states);
+        free(job.status);
+        gate_sgp4_batch_free(&batch);
+        setmsg_c("Failed to allocate memory for the visibility job");
+        sigerr_c("alloc");
+        return;
+    }
+
+    SpiceDouble **arrays[] = {&job.stations.px, &job.stations.py, &job.stations.pz,
+                              &job.stations.ux, &job.stations.uy, &job.stations.uz, &job.stations.sin_min};
+    for (int i = 0; i < 7; ++i) {
+        *arrays[i] = &station_data[i * stations_len];
+    }
+    load_stations(stations_len, stations, &job.stations);
+
+    // SPICE may only be called from this thread
+    for (SpiceInt k = 0; k < steps_len; ++k) {
+        pxform_c("J2000", earth_frame, step_et(&job, k), job.rotations[k]);
+    }
+
+    if (!failed_c()) {
+        pthread_mutex_init(&job.lock, NULL);
+        gate_pool_run(pool, job.near_groups + batch.deep_len, 1, visibility_chunk, &job);
+        pthread_mutex_destroy(&job.lock);
+
+        qsort(table->windows, table->len, sizeof(*table->windows), compare_windows);
+    }
+
+    free(station_data);
+    free(job.rotations);
+    free(job.states);
+    free(job.status);
+    gate_sgp4_batch_free(&batch);
+
+    if (job.out_of_memory) {
+        gate_vis_table_free(table);
+        setmsg_c("Failed to allocate memory for the visibility windows");
+        sigerr_c("alloc");
+    }
+}
+
+void gate_vis_table_free(gate_vis_table *table) {
+    free(table->windows);
+
+    table->len = 0;
+    table->cap = 0;
+    table->windows = NULL;
+}
@@ -0,0 +1,138 @@
+/**
+ * @file
+ * Visibility of a whole satellite catalog from a network
+ * of ground stations.
+ *
+ * Every satellite is propagated once per time step, using
+ * the batched kernel of sgp4batch.h for near-Earth
+ * satellites, and its position is then checked against
+ * every station at once in a loop that the compiler can
+ * vectorize. Whenever a satellite rises above or sets
+ * below the minimum elevation of a station between two
+ * steps, the time of the crossing is refined with the
+ * Illinois variant of regula falsi. The satellites are
+ * split across the threads of a gate_pool.
+ *
+ * The Earth-fixed frame is only looked up through SPICE
+ * once per step, on the calling thread. Between steps it
+ * is extrapolated by the rotation of the Earth, which is
+ * accurate to well within a meter over a few minutes.
+ *
+ * Unlike the topographic frames of topo.h, the elevation
+ * is measured from the geodetic position of the station on
+ * the reference ellipsoid.
+ *
+ * A pass which starts and ends between two steps is not
+ * found, so the step should be shorter than the shortest
+ * pass of interest.
+ */
+
+#ifndef GATE_VISIBILITY_H
+#define GATE_VISIBILITY_H
+
+#include <cspice/SpiceUsr.h>
+#include "pool.h"
+#include "sgp4.h"
+
+/**
+ * The precision in seconds to which rise and set times are
+ * located.
+ */
+#define GATE_VIS_TIME_TOLERANCE 1e-2
+
+/**
+ * A ground station.
+ */
+typedef struct {
+    /**
+     * The geodetic latitude and longitude in degrees.
+     */
+    SpiceDouble latitude;
+    SpiceDouble longitude;
+
+    /**
+     * The height above the reference ellipsoid in
+     * kilometers.
+     */
+    SpiceDouble altitude;
+
+    /**
+     * The elevation in degrees above which a satellite is
+     * visible from the station.
+     */
+    SpiceDouble min_elevation;
+} gate_station;
+
+/**
+ * A span of time during which a satellite is visible from
+ * a station.
+ *
+ * To keep windows at 16 bytes, times are single precision
+ * seconds since the start of the table, which resolves
+ * times to within 10 ms over a day. Windows which are
+ * already open at the start of the table rise at 0, and
+ * windows still open at the end set at the end.
+ */
+typedef struct {
+    SpiceInt sat;
+    SpiceInt station;
+    float rise;
+    float set;
+} gate_vis_window;
+
+/**
+ * Visibility windows, sorted by satellite, then by
+ * station, then by rise time.
+ */
+typedef struct {
+    SpiceDouble start_et;
+    SpiceDouble end_et;
+
+    SpiceInt len;
+    SpiceInt cap;
+    gate_vis_window *windows;
+} gate_vis_table;
+
+/**
+ * Finds every window in which each satellite of a catalog
+ * is visible from each station of a network.
+ *
+ * Requires a PCK defining the Earth-fixed frame and the
+ * radii of the Earth to be loaded.
+ *
+ * Satellites which failed to initialize are skipped. A
+ * satellite which fails to propagate partway through is
+ * treated as invisible from then on.
+ *
+ * @param pool the threads to compute on, or NULL to use
+ * the calling thread (input)
+ * @param sats_len the number of satellites (input)
+ * @param sats the initialized propagator states (input)
+ * @param init_status the initialization status of each
+ * satellite (input)
+ * @param stations_len the number of stations (input)
+ * @param stations the stations (input)
+ * @param start_et the ephemeris time at which to start
+ * (input)
+ * @param end_et the ephemeris time at which to end
+ * (input)
+ * @param step the time step in seconds (input)
+ * @param table the windows found, with satellites
+ * identified by their index in sats and stations by their
+ * index in stations (output)
+ *
+ * @throws alloc if memory could not be allocated
+ */
+void gate_compute_visibility(gate_pool *pool, SpiceInt sats_len, const gate_sgp4 *sats,
+                             const gate_sgp4_status *init_status, SpiceInt stations_len,
+                             const gate_station *stations, SpiceDouble start_et, SpiceDouble end_et,
+                             SpiceDouble step, gate_vis_table *table);
+
+/**
+ * Frees all memory held by a visibility table.
+ *
+ * @param table the table to free (input/output)
+ */
+void gate_vis_table_free(gate_vis_table *table);
+
+#endif // GATE_VISIBILITY_H
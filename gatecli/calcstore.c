@@ -0,0 +1,180 @@
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "calcstore.h"
+
+static const int INITIAL_CAP = 16;
+
+static void *handle_to_value(int handle) {
+    return (void *) (intptr_t) (handle + 1);
+}
+
+static int value_to_handle(void *value) {
+    return (int) (intptr_t) value - 1;
+}
+
+gatecli_calc_store gatecli_calc_store_new() {
+    gatecli_calc_store store;
+    memset(&store, 0, sizeof(store));
+    store.index = gatecli_table_new();
+    return store;
+}
+
+static int grow_column(SpiceDouble **column, int cap) {
+    SpiceDouble *new_column = realloc(*column, cap * sizeof(**column));
+    if (new_column == NULL) {
+        return 0;
+    }
+
+    *column = new_column;
+    return 1;
+}
+
+int gatecli_calc_store_reserve(gatecli_calc_store *store, int cap) {
+    if (cap <= store->cap) {
+        return 1;
+    }
+
+    if (!grow_column(&store->ra, cap) || !grow_column(&store->dec, cap) || !grow_column(&store->r, cap) ||
+        !grow_column(&store->ra_pm, cap) || !grow_column(&store->dec_pm, cap)) {
+        return 0;
+    }
+
+    char **ids = realloc(store->ids, cap * sizeof(*ids));
+    if (ids == NULL) {
+        return 0;
+    }
+    store->ids = ids;
+
+    store->cap = cap;
+    gatecli_table_reserve(&store->index, cap);
+    return 1;
+}
+
+int gatecli_calc_store_put(gatecli_calc_store *store, const char *id, calc_data data, int *replaced) {
+    int handle = gatecli_calc_store_find(store, id);
+    if (replaced != NULL) {
+        *replaced = handle != -1;
+    }
+
+    if (handle == -1) {
+        if (store->len == store->cap &&
+            !gatecli_calc_store_reserve(store, store->cap == 0 ? INITIAL_CAP : store->cap * 2)) {
+            return -1;
+        }
+
+        char *id_copy = strdup(id);
+        if (id_copy == NULL) {
+            return -1;
+        }
+
+        handle = store->len++;
+        store->ids[handle] = id_copy;
+        gatecli_table_put(&store->index, id, handle_to_value(handle));
+    }
+
+    store->ra[handle] = data.ra;
+    store->dec[handle] = data.dec;
+    store->r[handle] = data.r;
+    store->ra_pm[handle] = data.ra_pm;
+    store->dec_pm[handle] = data.dec_pm;
+    return handle;
+}
+
+int gatecli_calc_store_find(const gatecli_calc_store *store, const char *id) {
+    void *value = gatecli_table_get(&store->index, id);
+    if (value == NULL) {
+        return -1;
+    }
+
+    return value_to_handle(value);
+}
+
+calc_data gatecli_calc_store_get(const gatecli_calc_store *store, int handle) {
+    calc_data data = {
+            .ra = store->ra[handle],
+            .dec = store->dec[handle],
+            .r = store->r[handle],
+            .ra_pm = store->ra_pm[handle],
+            .dec_pm = store->dec_pm[handle]
+    };
+    return data;
+}
+
+int gatecli_calc_store_rem(gatecli_calc_store *store, const char *id) {
+    void *value = gatecli_table_rem(&store->index, id);
+    if (value == NULL) {
+        return 0;
+    }
+
+    int handle = value_to_handle(value);
+    free(store->ids[handle]);
+
+    int last = store->len - 1;
+    if (handle != last) {
+        store->ra[handle] = store->ra[last];
+        store->dec[handle] = store->dec[last];
+        store->r[handle] = store->r[last];
+        store->ra_pm[handle] = store->ra_pm[last];
+        store->dec_pm[handle] = store->dec_pm[last];
+        store->ids[handle] = store->ids[last];
+        gatecli_table_put(&store->index, store->ids[handle], handle_to_value(handle));
+    }
+
+    store->len--;
+    return 1;
+}
+
+void gatecli_calc_store_azel(const gatecli_calc_store *store, SpiceDouble et, ConstSpiceDouble rotation[3][3],
+                             SpiceDouble radius, SpiceDouble *azimuths, SpiceDouble *elevations) {
+    // Proper motions are in degrees per Julian year since
+    // J2000, see calc_cur_pos()
+    SpiceDouble dt = et / jyear_c();
+    SpiceDouble rpd = rpd_c();
+    SpiceDouble dpr = dpr_c();
+    SpiceDouble two_pi = twopi_c();
+
+    SpiceDouble r00 = rotation[0][0], r01 = rotation[0][1], r02 = rotation[0][2];
+    SpiceDouble r10 = rotation[1][0], r11 = rotation[1][1], r12 = rotation[1][2];
+    SpiceDouble r20 = rotation[2][0], r21 = rotation[2][1], r22 = rotation[2][2];
+
+    // Every iteration is independent and free of calls
+    // into SPICE, which lets the compiler vectorize it
+    for (int i = 0; i < store->len; ++i) {
+        SpiceDouble ra = (store->ra[i] + dt * store->ra_pm[i]) * rpd;
+        SpiceDouble dec = (store->dec[i] + dt * store->dec_pm[i]) * rpd;
+
+        SpiceDouble r = store->r[i];
+        SpiceDouble x = r * cos(dec) * cos(ra);
+        SpiceDouble y = r * cos(dec) * sin(ra);
+        SpiceDouble z = r * sin(dec);
+
+        SpiceDouble north = r00 * x + r01 * y + r02 * z;
+        SpiceDouble west = r10 * x + r11 * y + r12 * z;
+        SpiceDouble up = r20 * x + r21 * y + r22 * z - radius;
+
+        // The same conventions as gate_conv_rec_azel()
+        SpiceDouble angle = atan2(west, north);
+        angle = angle < 0 ? angle + two_pi : angle;
+        azimuths[i] = 360 - angle * dpr;
+        elevations[i] = atan2(up, sqrt(north * north + west * west)) * dpr;
+    }
+}
+
+void gatecli_calc_store_free(gatecli_calc_store *store) {
+    for (int i = 0; i < store->len; ++i) {
+        free(store->ids[i]);
+    }
+
+    free(store->ra);
+    free(store->dec);
+    free(store->r);
+    free(store->ra_pm);
+    free(store->dec_pm);
+    free(store->ids);
+    gatecli_table_free(&store->index, NULL);
+
+    *store = gatecli_calc_store_new();
+}
@@ -0,0 +1,151 @@
+/**
+ * Compact storage for the custom objects added with CALC
+ * ADD or LOAD CALC.
+ *
+ * Objects are referred to by dense integer handles from 0
+ * up to the number of stored objects. Each coordinate is
+ * stored in its own contiguous array, so that evaluating
+ * every object at the same epoch streams through memory
+ * and can be vectorized by the compiler, rather than
+ * chasing a pointer per object. A hashtable maps IDs to
+ * handles.
+ *
+ * Removing an object moves the last object of the store
+ * into the freed handle, so handles should not be held
+ * across removals.
+ */
+
+#ifndef GATE_CALCSTORE_H
+#define GATE_CALCSTORE_H
+
+#include <cspice/SpiceUsr.h>
+#include "commands.h"
+#include "table.h"
+
+/**
+ * Represents a store of custom objects.
+ *
+ * The arrays may be read directly using a handle as the
+ * index, but should only be modified through the
+ * procedures in this file.
+ */
+typedef struct {
+    /**
+     * The number of objects in the store.
+     */
+    int len;
+    /**
+     * The number of objects that the store has room for
+     * before needing to grow.
+     */
+    int cap;
+
+    SpiceDouble *ra;
+    SpiceDouble *dec;
+    SpiceDouble *r;
+    SpiceDouble *ra_pm;
+    SpiceDouble *dec_pm;
+
+    /**
+     * The ID of each object, owned by the store.
+     */
+    char **ids;
+
+    /**
+     * Maps each ID to its handle plus one, so that no
+     * handle is stored as a NULL value.
+     */
+    gatecli_table index;
+} gatecli_calc_store;
+
+/**
+ * Creates a new, empty store.
+ *
+ * @return a new, empty store
+ */
+gatecli_calc_store gatecli_calc_store_new();
+
+/**
+ * Ensures that the given store can hold at least the given
+ * number of objects without needing to grow.
+ *
+ * @param store the store for which to reserve space
+ * @param cap the total number of objects to make room for
+ * @return 1 if there is room, 0 if memory could not be
+ * allocated
+ */
+int gatecli_calc_store_reserve(gatecli_calc_store *store, int cap);
+
+/**
+ * Adds an object to the store, or replaces the object with
+ * the same ID if one is already stored.
+ *
+ * @param store the store to add the object to
+ * @param id the ID of the object, which is copied
+ * @param data the position and proper motion of the object
+ * @param replaced set to whether an object with the same
+ * ID was replaced, or NULL if not desired
+ * @return the handle of the object, or -1 if memory could
+ * not be allocated
+ */
+int gatecli_calc_store_put(gatecli_calc_store *store, const char *id, calc_data data, int *replaced);
+
+/**
+ * Finds the handle of the object with the given ID.
+ *
+ * @param store the store to search
+ * @param id the ID of the object
+ * @return the handle of the object, or -1 if there is no
+ * object with the given ID
+ */
+int gatecli_calc_store_find(const gatecli_calc_store *store, const char *id);
+
+/**
+ * Gathers the columns of an object.
+ *
+ * @param store the store containing the object
+ * @param handle the handle of the object
+ * @return the position and proper motion of the object
+ */
+calc_data gatecli_calc_store_get(const gatecli_calc_store *store, int handle);
+
+/**
+ * Removes the object with the given ID.
+ *
+ * The last object in the store takes over the handle of
+ * the removed object.
+ *
+ * @param store the store to remove the object from
+ * @param id the ID of the object
+ * @return 1 if an object was removed, 0 otherwise
+ */
+int gatecli_calc_store_rem(gatecli_calc_store *store, const char *id);
+
+/**
+ * Computes the azimuth and elevation of every object in
+ * the store at one epoch, in the same way as CALC AZEL
+ * does for a single object.
+ *
+ * @param store the store containing the objects
+ * @param et the ephemeris time
+ * @param rotation the rotation from the J2000 frame into
+ * the topographic frame of the observer at the epoch
+ * @param radius the radius of the observer, see
+ * gate_adjust_topo_rec()
+ * @param azimuths the azimuth of each object in degrees,
+ * indexed by handle
+ * @param elevations the elevation of each object in
+ * degrees, indexed by handle
+ */
+void gatecli_calc_store_azel(const gatecli_calc_store *store, SpiceDouble et, ConstSpiceDouble rotation[3][3],
+                             SpiceDouble radius, SpiceDouble *azimuths, SpiceDouble *elevations);
+
+/**
+ * Frees all memory held by the given store, leaving it
+ * empty.
+ *
+ * @param store the store to free
+ */
+void gatecli_calc_store_free(gatecli_calc_store *store);
+
+#endif // GATECLI_CALCSTORE_H
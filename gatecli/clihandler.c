@@ -2,13 +2,51 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <time.h>
 #include <cspice/SpiceUsr.h>
 #include "clihandler.h"
 #include "dispatcher.h"
 #include "util.h"
 
+#define BATCH_STDOUT_BUFFER_LEN 65536
+#define BATCH_SHORT_MSG_LEN 26
+#define BATCH_LONG_MSG_LEN 1841
+
 static volatile int is_running = 1;
 
+/**
+ * Splits a line into tokens separated by the given
+ * delimiters, in place.
+ *
+ * @return the argument vector, which must be freed, or
+ * NULL if it could not be allocated
+ */
+static char **split_tokens(char *line, const char *delimiters, int *argc) {
+    *argc = 0;
+    char **argv = malloc(1 * sizeof(*argv));
+    if (argv == NULL) {
+        return NULL;
+    }
+
+    for (char *token = strtok(line, delimiters);
+         token != NULL;
+         token = strtok(NULL, delimiters)) {
+        int idx = (*argc)++;
+
+        char **argv_new = realloc(argv, *argc * sizeof(*argv));
+        if (argv_new == NULL) {
+            free(argv);
+            return NULL;
+        } else {
+            argv = argv_new;
+        }
+
+        argv[idx] = token;
+    }
+
+    return argv;
+}
+
 void handle_cli() {
     struct sigaction signal_handler = {handle_signal};
     sigaction(SIGINT, &signal_handler, NULL);
@@ -28,24 +66,13 @@ void handle_input() {
         return;
     }
 
-    int argc = 0;
-    char **argv = malloc(1 * sizeof(*argv));
-    for (char *token = strtok(input_buffer, " ");
-         token != NULL;
-         token = strtok(NULL, " ")) {
-        int idx = argc++;
-
-        char **argv_new = realloc(argv, argc * sizeof(*argv));
-        if (argv_new == NULL) {
-            setmsg_c("Error allocating args vector");
-            sigerr_c("alloc");
-            handle_signal(SIGINT);
-            return;
-        } else {
-            argv = argv_new;
-        }
-
-        argv[idx] = token;
+    int argc;
+    char **argv = split_tokens(input_buffer, " ", &argc);
+    if (argv == NULL) {
+        setmsg_c("Error allocating args vector");
+        sigerr_c("alloc");
+        handle_signal(SIGINT);
+        return;
     }
 
     if (argc == 0) {
@@ -63,9 +90,173 @@ void handle_tokens(int argc, char **argv) {
         exit(0);
     }
 
+    // Errors are reported as they are signalled, so one
+    // left over from the previous command must not make
+    // this one appear to fail
+    reset_c();
     dispatch(argc, argv, &is_running);
 }
 
 void handle_signal(int signal) {
     is_running = 0;
 }
+
+/**
+ * Replaces the characters which separate batch records and
+ * their fields with spaces.
+ */
+static void flatten_record_field(char *field) {
+    for (char *c = field; *c != '\0'; ++c) {
+        if (*c == '\t' || *c == '\n' || *c == '\r') {
+            *c = ' ';
+        }
+    }
+}
+
+/**
+ * Runs one batch command, writing its output to the given
+ * stream as OUT records followed by an OK or ERROR record.
+ *
+ * @return 1 if the command succeeded, 0 otherwise
+ */
+static int run_batch_command(FILE *out, long seq, char *line) {
+    flatten_record_field(line);
+    fprintf(out, "%ld\tCMD\t%s\n", seq, line);
+
+    int argc;
+    char **argv = split_tokens(line, " \t", &argc);
+    if (argv == NULL) {
+        fprintf(out, "%ld\tERROR\talloc\tError allocating args vector\n", seq);
+        return 0;
+    }
+
+    // Commands print to stdout, so it is swapped for an
+    // in-memory stream while the command runs so that each
+    // line can be written as a record
+    char *captured = NULL;
+    size_t captured_len = 0;
+    FILE *capture = open_memstream(&captured, &captured_len);
+    if (capture == NULL) {
+        free(argv);
+        fprintf(out, "%ld\tERROR\talloc\tError allocating output buffer\n", seq);
+        return 0;
+    }
+
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    FILE *real_stdout = stdout;
+    stdout = capture;
+    reset_c();
+    int succeeded = dispatch(argc, argv, &is_running);
+    stdout = real_stdout;
+    fclose(capture);
+
+    struct timespec end;
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double elapsed_ms = (end.tv_sec - start.tv_sec) * 1e3 + (end.tv_nsec - start.tv_nsec) / 1e6;
+
+    free(argv);
+
+    for (char *out_line = captured; out_line < captured + captured_len;) {
+        char *newline = memchr(out_line, '\n', captured + captured_len - out_line);
+        size_t out_line_len = newline == NULL ? (size_t) (captured + captured_len - out_line)
+                                              : (size_t) (newline - out_line);
+
+        for (size_t i = 0; i < out_line_len; ++i) {
+            out_line[i] = out_line[i] == '\t' ? ' ' : out_line[i];
+        }
+
+        // Blank lines only separate output for people
+        if (out_line_len > 0) {
+            fprintf(out, "%ld\tOUT\t%.*s\n", seq, (int) out_line_len, out_line);
+        }
+
+        out_line += out_line_len + 1;
+    }
+    free(captured);
+
+    if (failed_c()) {
+        SpiceChar short_msg[BATCH_SHORT_MSG_LEN];
+        SpiceChar long_msg[BATCH_LONG_MSG_LEN];
+        getmsg_c("SHORT", BATCH_SHORT_MSG_LEN, short_msg);
+        getmsg_c("LONG", BATCH_LONG_MSG_LEN, long_msg);
+        reset_c();
+
+        flatten_record_field(short_msg);
+        flatten_record_field(long_msg);
+        fprintf(out, "%ld\tERROR\t%s\t%s\n", seq, short_msg, long_msg);
+        return 0;
+    }
+
+    if (!succeeded) {
+        char failure[COMMAND_FAILURE_MAX_LEN];
+        strcpy(failure, command_failure());
+        flatten_record_field(failure);
+        fprintf(out, "%ld\tERROR\tcommand failed\t%s\n", seq, failure);
+        return 0;
+    }
+
+    fprintf(out, "%ld\tOK\t%.3f\n", seq, elapsed_ms);
+    return 1;
+}
+
+int handle_batch(int file_count, char **file_names) {
+    // Errors are reported in ERROR records rather than by
+    // SPICE, and nothing is written until the buffer fills
+    // or the batch ends
+    errprt_c("SET", 0, "NONE");
+    setvbuf(stdout, NULL, _IOFBF, BATCH_STDOUT_BUFFER_LEN);
+    set_batch_mode(1);
+
+    int exit_code = BATCH_EXIT_OK;
+    long seq = 0;
+    int file_idx = 0;
+    do {
+        FILE *in = stdin;
+        if (file_count > 0) {
+            in = fopen(file_names[file_idx], "r");
+            if (in == NULL) {
+                fprintf(stderr, "No such file with name: %s\n", file_names[file_idx]);
+                fflush(stdout);
+                return BATCH_EXIT_UNREADABLE;
+            }
+        }
+
+        char *line = NULL;
+        size_t line_cap = 0;
+        while (getline(&line, &line_cap, in) != -1) {
+            size_t command_len = strcspn(line, "\r\n");
+            while (command_len > 0 && (line[command_len - 1] == ' ' || line[command_len - 1] == '\t')) {
+                command_len--;
+            }
+            line[command_len] = '\0';
+
+            char *command = line + strspn(line, " \t");
+            if (*command == '\0' || *command == '#') {
+                continue;
+            }
+
+            if (eq_ignore_case("exit", command)) {
+                free(line);
+                if (in != stdin) {
+                    fclose(in);
+                }
+                fflush(stdout);
+                return exit_code;
+            }
+
+            if (!run_batch_command(stdout, ++seq, command)) {
+                exit_code = BATCH_EXIT_FAILED;
+            }
+        }
+
+        free(line);
+        if (in != stdin) {
+            fclose(in);
+        }
+    } while (++file_idx < file_count);
+
+    fflush(stdout);
+    return exit_code;
+}
@@ -8,6 +8,10 @@
 
 #define MAX_BUFFER_LEN 1000
 
+#define BATCH_EXIT_OK 0
+#define BATCH_EXIT_FAILED 1
+#define BATCH_EXIT_UNREADABLE 2
+
 /**
  * Called by a program to initiate the CLI handler loop,
  * which only exits when a SIGINT is received and is not
@@ -37,6 +41,38 @@ void handle_input();
  */
 void handle_tokens(int argc, char **argv);
 
+/**
+ * Runs commands from the given files in order, or from
+ * stdin if there are none, without prompting, for use by
+ * other programs.
+ *
+ * Each line holds one command, as with LOAD CMD. Blank
+ * lines and lines starting with '#' are skipped, and EXIT
+ * stops the batch. Only tab-separated records are written
+ * to stdout, each starting with the sequence number of the
+ * command it belongs to and the kind of record:
+ * - `<seq> CMD <command>` before the command runs
+ * - `<seq> OUT <line>` for each line the command prints
+ * - `<seq> OK <elapsed ms>` if the command succeeded
+ * - `<seq> ERROR <short message> <long message>` if the
+ *   command signaled a SPICE error, or with the short
+ *   message "command failed" and the reason it printed if
+ *   it failed otherwise, see fail_command()
+ *
+ * stdout is fully buffered, so output is only written as
+ * the buffer fills and when the batch ends. A failing
+ * command does not stop the batch. Commands given CONT
+ * instead of a count fail, since they would never end.
+ *
+ * @param file_count the number of files
+ * @param file_names the names of the files to read
+ * commands from
+ * @return BATCH_EXIT_OK if every command succeeded,
+ * BATCH_EXIT_FAILED if any failed or BATCH_EXIT_UNREADABLE
+ * if a file could not be opened
+ */
+int handle_batch(int file_count, char **file_names);
+
 /**
  * Handles a signal, such as SIGKILL, SIGINT, etc if
  * desired.
@@ -1,17 +1,42 @@
 #include "commands.h"
+#include <math.h>
+#include <stdarg.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 #include <unistd.h>
 
 #include <cspice/SpiceUsr.h>
 #include <cspice/SpiceZfc.h>
 
+#include <gate/abcorr.h>
+#include <gate/bodies.h>
+#include <gate/bodystates.h>
+#include <gate/bodytrack.h>
+#include <gate/catalog.h>
+#include <gate/conjunction.h>
+#include <gate/ephcache.h>
+#include <gate/events.h>
+#include <gate/groundtrack.h>
+#include <gate/illumination.h>
+#include <gate/passes.h>
+#include <gate/pool.h>
+#include <gate/propagator.h>
+#include <gate/satstore.h>
+#include <gate/sgp4.h>
+#include <gate/skyfilter.h>
+#include <gate/smallbodies.h>
 #include <gate/stars.h>
 #include <gate/timeconv.h>
+#include <gate/tle.h>
+#include <gate/tlehistory.h>
 #include <gate/topo.h>
+#include <gate/visibility.h>
 #include <gatesnm/snm.h>
 
+#include "calcstore.h"
 #include "options.h"
 #include "util.h"
 #include "dispatcher.h"
@@ -21,22 +46,126 @@
 #define FILTER_MAX_LEN 100
 #define TIME_OUT_MAX_LEN 30
 #define BODY_NAME_MAX_LEN 100
-#define NAIF_ID_MIN -100000     // These are arbitrary
-#define NAIF_ID_MAX 100000000
 #define FRAME_NAME_MAX_LEN 33
 #define KERNEL_FRAMES_MAX_LEN 500
-#define TLE_MIN_YEAR 1960
-#define TLE_LINE_LEN 70
-
-static int csn_data_len = -1;
-static csn_data *csn_data_array;
+#define TLE_INPUT_MAX_LEN 100
+#define VERIFY_SPAN_MIN 1440
+#define VERIFY_STEP_MIN 180
+#define BENCH_STEP_SEC 60
+#define PASSES_BUFFER_LEN 64
+#define STATION_NAME_MAX_LEN 32
+#define STATION_LINE_MAX_LEN 256
+#define OVERHEAD_FILTER_SPAN_SEC 120
+#define CACHE_BENCH_STEPS 64
+#define CACHE_BENCH_SAMPLES 100000
+#define TRACK_BLOCK_EPOCHS 32
+#define TRACK_MAGIC "GATETRK1"
+#define SUN_TABLE_STEP_SEC 600
+#define VISIBLE_MAX_SUN_ELEVATION -6
+#define BODY_TRACK_WINDOW_SEC 3600
+#define BODY_TRACK_TOLERANCE_DEG 1e-7
+#define BODY_AZEL_MAX_TARGETS 32
+#define BODY_BENCH_STEP_SEC 3600
+#define EVENTS_BUFFER_LEN 64
+#define EVENTS_CONTINUE_SEC 1
+#define EVENTS_HORIZON_DEG -0.5667
+#define EVENTS_BODY_TRACK_WINDOW_SEC 691200
+#define EVENTS_BODY_TRACK_TOLERANCE_DEG 1e-6
+#define OBSERVER_FRAME_NAME "OBSERVER_TOPO"
+#define WATCH_MAX_TARGETS 64
+#define WATCH_ID_MAX_LEN 32
+#define WATCH_LABEL_MAX_LEN 80
+#define WATCH_LINE_MAX_LEN 160
+#define CALC_LINE_MAX_LEN 256
+#define MPC_SUN_ID 10
+#define MPC_AU_KM 149597870.7
+#define MPC_SCREEN_CHUNK 4096
+
+/**
+ * The only columns of a CSN row that are needed to look up
+ * star names.
+ */
+typedef struct {
+    int hip;
+    char *name;
+} csn_name;
+
+/**
+ * A named observing site added with SITE ADD, which sets
+ * the OBSERVER_* options when it is used.
+ */
+typedef struct {
+    SpiceChar body[BODY_NAME_MAX_LEN];
+    SpiceDouble latitude;
+    SpiceDouble longitude;
+} observer_site;
+
+/**
+ * The kinds of targets that may be added to the watch list.
+ */
+typedef enum {
+    WATCH_STAR = 0,
+    WATCH_BODY,
+    WATCH_SAT,
+    WATCH_CALC,
+    WATCH_MPC,
+    WATCH_KIND_LEN
+} watch_kind;
+
+static const char *WATCH_KIND_STRINGS[WATCH_KIND_LEN] = {"STAR", "BODY", "SAT", "CALC", "MPC"};
+
+/**
+ * A target added with WATCH ADD, which is only resolved
+ * when the watch list is run so that it may be added
+ * before its catalog or kernel is loaded.
+ */
+typedef struct {
+    watch_kind kind;
+    SpiceChar id[WATCH_ID_MAX_LEN];
+} watch_target;
+
+static int csn_names_len = -1;
+static int csn_names_cap = 0;
+static csn_name *csn_names;
 
 // https://naif.jpl.nasa.gov/pub/naif/toolkit_docs/FORTRAN/spicelib/ev2lin.html
 static const SpiceDouble GEO_CONSTANTS[] =
         {1.082616e-3, -2.53881e-6, -1.65597e-6, 7.43669161e-2, 120.0, 78.0, 6378.135, 1.0};
-static gatecli_table sat_data_array;
+static gate_sat_store sat_store;
+static gate_pool *sat_pool;
+
+// The ephemeris cache built by SAT CACHE, indexed by
+// satellite handle, and the propagator states it was built
+// from. Changing the store clears the cache.
+static gate_eph_cache sat_cache;
+static gate_sgp4 *sat_cache_sats;
+static gate_sgp4_status *sat_cache_init_status;
+
+// Archived element sets loaded with LOAD HISTORY, which
+// take precedence over the stored element set of a
+// satellite when tracking it
+static gate_tle_history sat_history;
+
+// The bodies listed by SHOW BODIES, which only change when
+// a kernel is loaded
+static gate_body_list body_list;
+static SpiceBoolean body_list_valid = SPICEFALSE;
+
+// The topographic frame of the observer shared by every
+// command, which is loaded on first use and kept until an
+// OBSERVER_* option changes or a kernel is loaded
+static gate_topo_frame session_observer;
+static SpiceBoolean session_observer_valid = SPICEFALSE;
+
+static gatecli_calc_store calc_store;
+
+// Minor planets and comets loaded with LOAD MPC
+static gate_small_body_store small_body_store;
+
+static gatecli_table site_array;
 
-static gatecli_table calc_data_array;
+static watch_target watch_list[WATCH_MAX_TARGETS];
+static int watch_list_len = 0;
 
 void help() {
     puts("You can Ctrl+C any time to halt continuous output");
@@ -45,22 +174,48 @@ void help() {
     puts("--- HELP ---");
     puts("EXIT - Quits the command line");
     puts("HELP - prints this message");
-    puts("LOAD <CMD | KERNEL | CSN> <filename> - loads a set of commands or a kernel or CSN from file");
+    puts("LOAD <CMD | KERNEL | CSN | TLE | HISTORY | CALC | MPC> <filename> - loads a set of commands or a kernel or CSN or 2LE/3LE satellite catalog or archive of past element sets or CSV of custom calc objects or MPCORB/CometEls orbital elements from file");
     puts("SET <option> <value> - sets the value of a particular option");
     puts("GET <option> - prints the value of a particular option");
-    puts("SHOW <TABLES | FRAMES | CSN | BODIES | CALC> - prints the available table, frame, named star, body, or custom calc object names");
+    puts("SHOW <TABLES | FRAMES | CSN | BODIES | CALC | SITES | WATCH> - prints the available table, frame, named star, body, custom calc object, site or watched target names");
     puts("STAR INFO <catalog number> - prints information for a star with the given catalog number");
     puts("STAR AZEL <catalog number> <CONT | count> <ISO time | NOW> - prints the observation position for the star with the given catalog number");
+    puts("STAR EVENTS <catalog number> <ISO start time | NOW> <ISO end time | NOW> - prints the rises, transits and sets of the star with the given catalog number");
     puts("BODY INFO <naif id> - prints information for a body with the given NAIF ID");
     puts("BODY AZEL <naif id> <CONT | count> <ISO time | NOW> - prints the observation position for the satellite with the given NAIF ID");
+    puts("BODY AZEL <ALL | naif id,naif id,...> <CONT | count> <ISO time | NOW> - prints the observation positions for the Sun, Moon and planets or the listed NAIF IDs at once");
+    puts("BODY BENCH <naif id> <ISO time | NOW> <samples> - times every level of aberration correction for a body and compares it against CN+S");
+    puts("BODY EVENTS <naif id> <ISO start time | NOW> <ISO end time | NOW> - prints the rises, transits and sets of the body with the given NAIF ID");
     puts("SAT ADD <id> - adds a satellite with the given ID to the internal database (non persistent)");
     puts("SAT REM <id> - removes the satellite with the given ID from the internal database");
     puts("SAT INFO <id> - prints information for a satellite added with the given ID");
-    puts("SAT AZEL <id> <CONT | count> <ISO time | NOW> - prints the observation position for the satellite added with the given ID");
+    puts("SAT HISTORY <id> <ISO time | NOW> - prints the archived element sets of the satellite added with the given ID and the one nearest to the time");
+    puts("SAT AZEL <id> <CONT | count> <ISO time | NOW> - prints the observation position for the satellite added with the given ID, using the nearest archived element set if any, and whether it is visible by eye");
+    puts("SAT PASSES <id> <ISO start time | NOW> <ISO end time | NOW> <min elevation deg> - predicts the passes of the satellite added with the given ID above the given elevation");
+    puts("SAT OVERHEAD <count | CONT> <ISO time | NOW> <min elevation> - lists the satellites above the min elevation, highest first, and whether each is lit by the Sun");
+    puts("SAT VISIBILITY <stations file> <ISO start time | NOW> <ISO end time | NOW> <step sec> <output file> - writes the windows in which each satellite is visible from each station in the file");
+    puts("SAT CONJUNCTIONS <ISO start time | NOW> <ISO end time | NOW> <step sec> <distance km> - prints every approach between two satellites closer than the distance as it is found");
+    puts("SAT TRACK <ISO start time | NOW> <ISO end time | NOW> <step sec> <min elevation deg | NONE> <CSV | BIN> <output file> - writes the ground track of every satellite, with the footprint radius above the min elevation");
+    puts("SAT CACHE <ISO start time | NOW> <ISO end time | NOW> <tolerance km> <budget MB> - fits the satellites over the span for faster lookups, used by SAT OVERHEAD");
+    puts("SAT CACHE CLEAR - frees the ephemeris cache");
+    puts("SAT PROP <ISO time | NOW> - propagates every satellite in the database on all cores, with and without the batched kernel, and prints the time taken");
+    puts("SAT VERIFY <id | ALL> - compares the native propagator against the SPICE propagators for one or all satellites");
+    puts("SAT BENCH <count> <steps> - times tracking the first count satellites side by side using the SPICE propagators and the native propagator");
     puts("CALC ADD <id> <RANGE> <RA deg> <DEC deg> [<RA_PM deg/yr> <DEC_PM deg/yr>] - adds a body with the given ID to the internal database (non persistent)");
     puts("CALC REM <id> - removes a body with the given ID from the internal database");
     puts("CALC INFO <id> - prints information for a custom calculated body with the given ID");
     puts("CALC AZEL <id> <CONT | count> <ISO time | NOW> - prints the observation for position the calculated body added with the given ID");
+    puts("CALC AZEL ALL <CONT | count> <ISO time | NOW> - prints the observation positions of every calculated body at once");
+    puts("CALC EVENTS <id> <ISO start time | NOW> <ISO end time | NOW> - prints the rises, transits and sets of the calculated body added with the given ID");
+    puts("MPC INFO <id> - prints the orbital elements of a minor planet or comet loaded with the given ID");
+    puts("MPC AZEL <id> <CONT | count> <ISO time | NOW> - prints the observation position and magnitude of the minor planet or comet loaded with the given ID");
+    puts("MPC SCREEN <ISO time | NOW> <min elevation> <max magnitude> - lists every loaded minor planet and comet above the min elevation and brighter than the max magnitude, brightest first");
+    puts("SITE ADD <name> <latitude> <longitude> [<body>] - adds a named observing site on the given body, or on OBSERVER_BODY (non persistent)");
+    puts("SITE REM <name> - removes the site with the given name");
+    puts("SITE USE <name> - sets the OBSERVER_* options to the site with the given name");
+    puts("WATCH ADD <STAR | BODY | SAT | CALC | MPC> <id> - adds a star, body, satellite, custom calc object or minor planet or comet to the watch list");
+    puts("WATCH REM <STAR | BODY | SAT | CALC | MPC> <id> - removes a target from the watch list");
+    puts("WATCH RUN <CONT | count> <ISO time | NOW> - prints the observation positions of every target in the watch list together");
 
     puts("");
 
@@ -70,6 +225,17 @@ void help() {
     }
 }
 
+/**
+ * Unloads the shared observer frame so that it is loaded
+ * again from the OBSERVER_* options when it is next used.
+ */
+static void invalidate_observer() {
+    if (session_observer_valid) {
+        gate_unload_topo_frame(session_observer);
+        session_observer_valid = SPICEFALSE;
+    }
+}
+
 static char *set_option_string(option_key key, char **argv) {
     char *value_copy = strdup(argv[2]);
     set_option(key, value_copy);
@@ -81,7 +247,7 @@ static SpiceDouble *set_option_double(option_key key, char **argv) {
     char *end;
     heap_double[0] = strtod(argv[2], &end);
     if (argv[2] == end) {
-        printf("Not a valid number: '%s'\n", argv[2]);
+        fail_command("Not a valid number: '%s'", argv[2]);
         return NULL;
     }
     set_option(key, heap_double);
@@ -109,13 +275,13 @@ SpiceBoolean is_table_valid(char *table_name) {
 
 void set(int argc, char **argv) {
     if (argc != 3) {
-        puts("This command requires 2 arguments");
+        fail_command("This command requires 2 arguments");
         return;
     }
 
     option_key key = string_to_key(argv[1]);
     if (key == -1) {
-        printf("No such option for key '%s'\n", argv[1]);
+        fail_command("No such option for key '%s'", argv[1]);
         return;
     }
 
@@ -123,9 +289,13 @@ void set(int argc, char **argv) {
     switch (key) {
         case OBSERVER_BODY:
         case STAR_TABLE: {
+            if (key == OBSERVER_BODY) {
+                invalidate_observer();
+            }
+
             char *option = set_option_string(key, argv);
             if (key == STAR_TABLE && !is_table_valid(option)) {
-                printf("Table '%s' could not be found. Try SHOW TABLES?\n", option);
+                fail_command("Table '%s' could not be found. Try SHOW TABLES?", option);
                 set_option(key, NULL);
                 break;
             }
@@ -135,6 +305,8 @@ void set(int argc, char **argv) {
         }
         case OBSERVER_LATITUDE:
         case OBSERVER_LONGITUDE: {
+            invalidate_observer();
+
             SpiceDouble *option = set_option_double(key, argv);
             if (option != NULL) {
                 printf("%s = %f\n", key_name, *option);
@@ -142,24 +314,37 @@ void set(int argc, char **argv) {
 
             break;
         }
+        case ABCORR: {
+            gate_abcorr abcorr;
+            if (!gate_abcorr_parse(argv[2], &abcorr)) {
+                fail_command("Not a valid aberration correction: '%s'. Try NONE, ANNUAL, LT, LT+S, CN or CN+S?",
+                             argv[2]);
+                break;
+            }
+
+            char *option = set_option_string(key, argv);
+            printf("%s = %s\n", key_name, option);
+
+            break;
+        }
         case OPTION_KEY_LENGTH:
-            puts("Internal option cannot be set.");
+            fail_command("Internal option cannot be set.");
             break;
         default:
-            puts("Unhandled option.");
+            fail_command("Unhandled option.");
             break;
     }
 }
 
 void get(int argc, char **argv) {
     if (argc != 2) {
-        puts("This command requires 1 argument");
+        fail_command("This command requires 1 argument");
         return;
     }
 
     option_key key = string_to_key(argv[1]);
     if (key == -1) {
-        printf("No such option for key '%s'\n", argv[1]);
+        fail_command("No such option for key '%s'", argv[1]);
         return;
     }
 
@@ -190,13 +375,283 @@ void get(int argc, char **argv) {
 
             break;
         }
+        case ABCORR: {
+            char *option = (char *) get_option(key);
+            printf("Aberration correction is set to '%s'\n", option);
+
+            break;
+        }
         case OPTION_KEY_LENGTH:
-            puts("Internal option cannot be retrieved.");
+            fail_command("Internal option cannot be retrieved.");
             break;
         default:
-            puts("Unhandled option.");
+            fail_command("Unhandled option.");
+            break;
+    }
+}
+
+static double wall_ms() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+static void free_csn_names() {
+    for (int i = 0; i < csn_names_len; ++i) {
+        free(csn_names[i].name);
+    }
+    free(csn_names);
+
+    csn_names_len = -1;
+    csn_names_cap = 0;
+    csn_names = NULL;
+}
+
+static int index_csn_row(const csn_data *row, void *user_data) {
+    if (csn_names_len == csn_names_cap) {
+        int new_cap = csn_names_cap == 0 ? 64 : csn_names_cap * 2;
+        csn_name *new_names = realloc(csn_names, new_cap * sizeof(*new_names));
+        if (new_names == NULL) {
+            return 0;
+        }
+
+        csn_names = new_names;
+        csn_names_cap = new_cap;
+    }
+
+    char *name = strdup(row->name);
+    if (name == NULL) {
+        return 0;
+    }
+
+    csn_name entry = {row->hip, name};
+    csn_names[csn_names_len++] = entry;
+    return 1;
+}
+
+typedef struct {
+    SpiceInt added;
+    SpiceInt replaced;
+} tle_load_counts;
+
+static void clear_sat_cache() {
+    gate_eph_cache_free(&sat_cache);
+    free(sat_cache_sats);
+    free(sat_cache_init_status);
+    sat_cache_sats = NULL;
+    sat_cache_init_status = NULL;
+}
+
+static int store_tle(const gate_tle *tle, void *user_data) {
+    tle_load_counts *counts = user_data;
+
+    SpiceChar id[GATE_SAT_ID_MAX_LEN];
+    snprintf(id, GATE_SAT_ID_MAX_LEN, "%d", tle->catalog_number);
+
+    SpiceBoolean replaced;
+    if (gate_sat_store_put(&sat_store, id, tle, &replaced) == -1) {
+        return 0;
+    }
+    clear_sat_cache();
+
+    if (replaced) {
+        counts->replaced++;
+    } else {
+        counts->added++;
+    }
+
+    return 1;
+}
+
+/**
+ * Reads the whole contents of a file into memory.
+ *
+ * @return the contents, which are not NULL terminated, or
+ * NULL if the file could not be read, in which case the
+ * reason has already been printed
+ */
+static char *read_file(char *file_name, long *file_len) {
+    FILE *file = fopen(file_name, "rb");
+    if (file == NULL) {
+        fail_command("No such file with name: %s", file_name);
+        return NULL;
+    }
+
+    fseek(file, 0, SEEK_END);
+    *file_len = ftell(file);
+    rewind(file);
+
+    char *buffer = malloc(*file_len > 0 ? *file_len : 1);
+    size_t read_len = buffer == NULL ? 0 : fread(buffer, 1, *file_len, file);
+    fclose(file);
+    if (buffer == NULL || (long) read_len != *file_len) {
+        fail_command("Error reading file '%s'", file_name);
+        free(buffer);
+        return NULL;
+    }
+
+    return buffer;
+}
+
+static void load_tle(char *file_name) {
+    clock_t start = clock();
+
+    long file_len;
+    char *buffer = read_file(file_name, &file_len);
+    if (buffer == NULL) {
+        return;
+    }
+
+    // Every element set takes at least 2 lines, which
+    // bounds the number of satellites in the file
+    int max_sats = 1;
+    for (long i = 0; i < file_len; ++i) {
+        if (buffer[i] == '\n') {
+            max_sats++;
+        }
+    }
+    max_sats = max_sats / 2 + 1;
+
+    reset_c();
+    gate_sat_store_reserve(&sat_store, sat_store.len + max_sats);
+    if (failed_c()) {
+        free(buffer);
+        return;
+    }
+
+    tle_load_counts counts = {0, 0};
+    SpiceInt rejected;
+    gate_parse_tle_buffer(buffer, file_len, store_tle, &counts, NULL, &rejected);
+    free(buffer);
+    if (failed_c()) {
+        fail_command("Failed to load satellites from '%s' after %d were loaded", file_name,
+                     counts.added + counts.replaced);
+        return;
+    }
+
+    double elapsed_ms = (double) (clock() - start) * 1000 / CLOCKS_PER_SEC;
+    printf("Loaded %d satellites (%d replaced, %d rejected) from '%s' in %.1f ms\n",
+           counts.added + counts.replaced, counts.replaced, rejected, file_name, elapsed_ms);
+}
+
+static void load_history(char *file_name) {
+    clock_t start = clock();
+
+    long file_len;
+    char *buffer = read_file(file_name, &file_len);
+    if (buffer == NULL) {
+        return;
+    }
+
+    SpiceInt added;
+    SpiceInt rejected;
+    reset_c();
+    gate_tle_history_append_buffer(&sat_history, buffer, file_len, &added, &rejected);
+    free(buffer);
+    if (failed_c()) {
+        return;
+    }
+
+    double elapsed_ms = (double) (clock() - start) * 1000 / CLOCKS_PER_SEC;
+    printf("Loaded %d archived element sets (%d rejected) from '%s' in %.1f ms, "
+           "%d element sets for %d satellites in total\n",
+           added, rejected, file_name, elapsed_ms, sat_history.sets_len, sat_history.len);
+}
+
+/**
+ * Loads custom objects from a CSV file with one object per
+ * line, in the form
+ * `<id>,<range>,<RA deg>,<DEC deg>[,<RA_PM deg/yr>,<DEC_PM deg/yr>]`.
+ * Blank lines and lines starting with '#' are ignored, as
+ * is a header line before the first object.
+ */
+static void load_calc(char *file_name) {
+    clock_t start = clock();
+
+    FILE *file = fopen(file_name, "r");
+    if (file == NULL) {
+        fail_command("No such file with name: %s", file_name);
+        return;
+    }
+
+    int added = 0;
+    int replaced = 0;
+    int rejected = 0;
+    SpiceBoolean has_rows = SPICEFALSE;
+
+    char line[CALC_LINE_MAX_LEN];
+    while (fgets(line, sizeof(line), file) != NULL) {
+        line[strcspn(line, "\r\n")] = '\0';
+
+        char *id = line + strspn(line, " \t");
+        if (*id == '\0' || *id == '#') {
+            continue;
+        }
+
+        char *comma = strchr(id, ',');
+        calc_data calc = {0};
+        int fields = 0;
+        if (comma != NULL) {
+            *comma = '\0';
+            fields = sscanf(comma + 1, " %lf , %lf , %lf , %lf , %lf", &calc.r, &calc.ra, &calc.dec, &calc.ra_pm,
+                            &calc.dec_pm);
+        }
+
+        if (fields != 3 && fields != 5) {
+            if (has_rows) {
+                rejected++;
+            }
+            has_rows = SPICETRUE;
+            continue;
+        }
+        has_rows = SPICETRUE;
+
+        size_t id_len = strlen(id);
+        while (id_len > 0 && (id[id_len - 1] == ' ' || id[id_len - 1] == '\t')) {
+            id[--id_len] = '\0';
+        }
+
+        int was_replaced;
+        if (gatecli_calc_store_put(&calc_store, id, calc, &was_replaced) == -1) {
+            fail_command("Not enough memory to load the custom objects");
             break;
+        }
+
+        if (was_replaced) {
+            replaced++;
+        } else {
+            added++;
+        }
+    }
+
+    fclose(file);
+
+    double elapsed_ms = (double) (clock() - start) * 1000 / CLOCKS_PER_SEC;
+    printf("Loaded %d custom objects (%d replaced, %d rejected) from '%s' in %.1f ms\n", added + replaced, replaced,
+           rejected, file_name, elapsed_ms);
+}
+
+static void load_mpc(char *file_name) {
+    clock_t start = clock();
+
+    long file_len;
+    char *buffer = read_file(file_name, &file_len);
+    if (buffer == NULL) {
+        return;
+    }
+
+    SpiceInt added;
+    SpiceInt skipped;
+    reset_c();
+    gate_small_body_store_append_buffer(&small_body_store, buffer, file_len, &added, &skipped);
+    free(buffer);
+    if (failed_c()) {
+        return;
     }
+
+    double elapsed_ms = (double) (clock() - start) * 1000 / CLOCKS_PER_SEC;
+    printf("Loaded %d minor planets and comets (%d lines skipped) from '%s' in %.1f ms, %d in total\n", added,
+           skipped, file_name, elapsed_ms, small_body_store.len);
 }
 
 static void file_read_free(FILE *file, int argc, char **argv) {
@@ -212,12 +667,18 @@ static void file_read_free(FILE *file, int argc, char **argv) {
 
 void load(int argc, char **argv, volatile int *is_running) {
     if (argc != 3) {
-        puts("This command requires 2 arguments");
+        fail_command("This command requires 2 arguments");
         return;
     }
 
     if (eq_ignore_case("KERNEL", argv[1])) {
         furnsh_c(argv[2]);
+        invalidate_observer();
+        if (body_list_valid) {
+            gate_body_list_free(&body_list);
+            body_list_valid = SPICEFALSE;
+        }
+
         printf("Loaded kernel for file '%s'\n", argv[2]);
         return;
     }
@@ -225,7 +686,7 @@ void load(int argc, char **argv, volatile int *is_running) {
     if (eq_ignore_case("CMD", argv[1])) {
         FILE *cmd_file = fopen(argv[2], "r");
         if (cmd_file == NULL) {
-            printf("Error occurred opening file handle for '%s'\n", argv[2]);
+            fail_command("Error occurred opening file handle for '%s'", argv[2]);
             return;
         }
 
@@ -310,23 +771,52 @@ void load(int argc, char **argv, volatile int *is_running) {
         return;
     }
 
+    if (eq_ignore_case("TLE", argv[1])) {
+        load_tle(argv[2]);
+        return;
+    }
+
+    if (eq_ignore_case("HISTORY", argv[1])) {
+        load_history(argv[2]);
+        return;
+    }
+
+    if (eq_ignore_case("CALC", argv[1])) {
+        load_calc(argv[2]);
+        return;
+    }
+
+    if (eq_ignore_case("MPC", argv[1])) {
+        load_mpc(argv[2]);
+        return;
+    }
+
     if (eq_ignore_case("CSN", argv[1])) {
         FILE *file = fopen(argv[2], "r");
         if (file == NULL) {
-            printf("No such file with name: %s\n", argv[2]);
-            fclose(file);
+            fail_command("No such file with name: %s", argv[2]);
             return;
         }
 
-        snm_parse_data(file, &csn_data_len, &csn_data_array);
+        free_csn_names();
+        csn_names_len = 0;
 
+        snm_status status = snm_parse_stream(file, index_csn_row, NULL);
         fclose(file);
-        printf("Parsed CSN file '%s'\n", argv[2]);
+
+        if (status != SNM_OK) {
+            fail_command("Error parsing CSN file '%s': %s", argv[2],
+                         status == SNM_STOPPED ? "failed to allocate star names" : snm_status_string(status));
+            free_csn_names();
+            return;
+        }
+
+        printf("Parsed %d star names from CSN file '%s'\n", csn_names_len, argv[2]);
 
         return;
     }
 
-    printf("Unrecognized option: '%s'\n", argv[1]);
+    fail_command("Unrecognized option: '%s'", argv[1]);
 }
 
 static void print_frames(SpiceCell *frame_id_cells, char *frame_type) {
@@ -347,7 +837,7 @@ static void print_frames(SpiceCell *frame_id_cells, char *frame_type) {
 
 void show(int argc, char **argv, volatile int *is_running) {
     if (argc != 2) {
-        puts("This command requires 1 argument");
+        fail_command("This command requires 1 argument");
         return;
     }
 
@@ -384,14 +874,14 @@ void show(int argc, char **argv, volatile int *is_running) {
     }
 
     if (eq_ignore_case("CSN", argv[1])) {
-        if (csn_data_len == -1) {
+        if (csn_names_len == -1) {
             puts("No CSN file loaded. Try LOAD CSN?");
             return;
         }
 
-        printf("Showing names for %d named stars:\n", csn_data_len);
-        for (int i = 0; i < csn_data_len; ++i) {
-            csn_data data = csn_data_array[i];
+        printf("Showing names for %d named stars:\n", csn_names_len);
+        for (int i = 0; i < csn_names_len; ++i) {
+            csn_name data = csn_names[i];
             printf("%s (HIP %d)\n", data.name, data.hip);
         }
 
@@ -399,38 +889,50 @@ void show(int argc, char **argv, volatile int *is_running) {
     }
 
     if (eq_ignore_case("BODIES", argv[1])) {
-        puts("Showing loaded body NAIF IDs and their respective names...");
-        puts("(This might take a while)");
-        for (int i = NAIF_ID_MIN; i < NAIF_ID_MAX; ++i) {
+        double start_ms = wall_ms();
+        if (!body_list_valid) {
+            reset_c();
+            gate_list_bodies(&body_list);
+            if (failed_c()) {
+                return;
+            }
+
+            body_list_valid = SPICETRUE;
+        }
+        double elapsed_ms = wall_ms() - start_ms;
+
+        printf("Showing %d loaded body NAIF IDs and their respective names:\n", body_list.len);
+        for (SpiceInt i = 0; i < body_list.len; ++i) {
             if (!*is_running) {
                 *is_running = SPICETRUE;
                 return;
             }
 
-            SpiceChar body_name[BODY_NAME_MAX_LEN];
-            SpiceBoolean found;
-            bodc2n_c(i, BODY_NAME_MAX_LEN, body_name, &found);
-
-            if (found) {
-                printf("%d: %s\n", i, body_name);
+            const gate_body *body = &body_list.bodies[i];
+            if (body->name[0] != '\0') {
+                printf("%d: %s\n", body->code, body->name);
+            } else {
+                printf("%d\n", body->code);
             }
         }
+        printf("Listed in %.3f ms\n", elapsed_ms);
 
         return;
     }
 
     if (eq_ignore_case("SAT", argv[1])) {
-        if (sat_data_array.size == 0) {
+        if (sat_store.len == 0) {
             printf("No satellites added\n");
             return;
         }
 
-        printf("Showing %d satellite IDs:\n", sat_data_array.size);
-        for (int i = 0; i < sat_data_array.buckets_len; ++i) {
-            for (gatecli_table_entry *entry = sat_data_array.buckets[i];
-                 entry != NULL;
-                 entry = entry->next) {
-                printf("%s\n", entry->key);
+        printf("Showing %d satellite IDs:\n", sat_store.len);
+        for (gate_sat_handle handle = 0; handle < sat_store.len; ++handle) {
+            gate_sat_text *text = &sat_store.text[handle];
+            if (text->name[0] != '\0') {
+                printf("%s (%s)\n", text->id, text->name);
+            } else {
+                printf("%s\n", text->id);
             }
         }
 
@@ -438,24 +940,50 @@ void show(int argc, char **argv, volatile int *is_running) {
     }
 
     if (eq_ignore_case("CALC", argv[1])) {
-        if (calc_data_array.size == 0) {
+        if (calc_store.len == 0) {
             printf("No custom objects added\n");
             return;
         }
 
-        printf("Showing %d custom body IDs:\n", calc_data_array.size);
-        for (int i = 0; i < calc_data_array.buckets_len; ++i) {
-            for (gatecli_table_entry *entry = calc_data_array.buckets[i];
-                 entry != NULL;
-                 entry = entry->next) {
-                printf("%s\n", entry->key);
-            }
+        printf("Showing %d custom body IDs:\n", calc_store.len);
+        for (int i = 0; i < calc_store.len; ++i) {
+            printf("%s\n", calc_store.ids[i]);
+        }
+
+        return;
+    }
+
+    if (eq_ignore_case("WATCH", argv[1])) {
+        if (watch_list_len == 0) {
+            printf("No targets are being watched\n");
+            return;
+        }
+
+        printf("Showing %d watched targets:\n", watch_list_len);
+        for (int i = 0; i < watch_list_len; ++i) {
+            printf("%s %s\n", WATCH_KIND_STRINGS[watch_list[i].kind], watch_list[i].id);
+        }
+
+        return;
+    }
+
+    if (eq_ignore_case("SITES", argv[1])) {
+        if (site_array.size == 0) {
+            printf("No sites added\n");
+            return;
+        }
+
+        printf("Showing %d sites:\n", site_array.size);
+        gatecli_table_iter iter = gatecli_table_iter_new(&site_array);
+        while (gatecli_table_iter_next(&iter)) {
+            observer_site *site = iter.value;
+            printf("%s: %s, latitude %f, longitude %f\n", iter.key, site->body, site->latitude, site->longitude);
         }
 
         return;
     }
 
-    printf("Unrecognized option: '%s'\n", argv[1]);
+    fail_command("Unrecognized option: '%s'", argv[1]);
 }
 
 static void *check_and_get_option(option_key key) {
@@ -473,6 +1001,162 @@ static void *check_and_get_option(option_key key) {
     return option;
 }
 
+/**
+ * Obtains the level of aberration correction set with
+ * SET ABCORR, which is validated when it is set.
+ */
+static gate_abcorr get_abcorr() {
+    gate_abcorr abcorr = GATE_ABCORR_CN_S;
+    gate_abcorr_parse((char *) get_option(ABCORR), &abcorr);
+    return abcorr;
+}
+
+/**
+ * Obtains the topographic frame of the observer configured
+ * by the OBSERVER_BODY, OBSERVER_LATITUDE and
+ * OBSERVER_LONGITUDE options.
+ *
+ * The frame is shared by every command and is only loaded
+ * again after one of the options changes or a kernel is
+ * loaded, so callers must not unload it.
+ *
+ * @return SPICETRUE if the frame is loaded, otherwise
+ * the reason has already been printed
+ */
+static SpiceBoolean get_observer_frame(gate_topo_frame *observer_frame) {
+    if (!session_observer_valid) {
+        char *observer_body = (char *) check_and_get_option(OBSERVER_BODY);
+        if (observer_body == NULL) {
+            return SPICEFALSE;
+        }
+
+        SpiceInt observer_body_id;
+        SpiceBoolean observer_body_id_found;
+        bodn2c_c(observer_body, &observer_body_id, &observer_body_id_found);
+        if (!observer_body_id_found) {
+            fail_command("No NAIF ID was found for body '%s'! Try LOAD KERNEL?", observer_body);
+            return SPICEFALSE;
+        }
+
+        SpiceDouble *observer_latitude_opt = (double *) check_and_get_option(OBSERVER_LATITUDE);
+        SpiceDouble *observer_longitude_opt = (double *) check_and_get_option(OBSERVER_LONGITUDE);
+        if (observer_latitude_opt == NULL || observer_longitude_opt == NULL) {
+            return SPICEFALSE;
+        }
+
+        reset_c();
+        gate_load_topo_frame(OBSERVER_FRAME_NAME, observer_body_id, *observer_latitude_opt,
+                             *observer_longitude_opt, 0, &session_observer);
+        if (failed_c()) {
+            return SPICEFALSE;
+        }
+        session_observer_valid = SPICETRUE;
+    }
+
+    *observer_frame = session_observer;
+    return SPICETRUE;
+}
+
+/**
+ * Parses the number of positions to print, or CONT to
+ * print them until interrupted. CONT is refused in batch
+ * mode, where nothing can interrupt the command.
+ *
+ * @return SPICETRUE if the count is valid, otherwise the
+ * command has already been failed
+ */
+static SpiceBoolean parse_count(const char *arg, SpiceBoolean *is_cont, SpiceInt *count) {
+    *is_cont = SPICEFALSE;
+    *count = 0;
+    if (eq_ignore_case("CONT", arg)) {
+        if (is_batch_mode()) {
+            fail_command("CONT never stops in batch mode. Try a count?");
+            return SPICEFALSE;
+        }
+
+        *is_cont = SPICETRUE;
+        return SPICETRUE;
+    }
+
+    char *end;
+    *count = strtol(arg, &end, 10);
+    if (arg == end) {
+        fail_command("Not a valid number: %s", arg);
+        return SPICEFALSE;
+    }
+
+    return SPICETRUE;
+}
+
+/**
+ * Finds the events of the object of an EVENTS command,
+ * following gate_fixed_events() and gate_body_events().
+ */
+typedef SpiceInt (*event_finder)(void *target, SpiceDouble start_et, SpiceDouble end_et, SpiceInt events_len,
+                                 gate_event *events);
+
+/**
+ * Parses the span of time of an EVENTS command.
+ *
+ * @return SPICETRUE if the span is valid, otherwise the
+ * reason has already been printed
+ */
+static SpiceBoolean parse_event_span(char *start, char *end, SpiceDouble *start_et, SpiceDouble *end_et) {
+    if (eq_ignore_case("NOW", start)) {
+        gate_et_now(start_et);
+    } else {
+        str2et_c(start, start_et);
+    }
+
+    if (eq_ignore_case("NOW", end)) {
+        gate_et_now(end_et);
+    } else {
+        str2et_c(end, end_et);
+    }
+
+    if (*end_et <= *start_et) {
+        fail_command("The end time must be after the start time");
+        return SPICEFALSE;
+    }
+
+    return SPICETRUE;
+}
+
+/**
+ * Prints every event of an object over a span of time,
+ * continuing the search a buffer of events at a time.
+ */
+static void print_events(event_finder find, void *target, SpiceDouble start_et, SpiceDouble end_et) {
+    gate_event events[EVENTS_BUFFER_LEN];
+    SpiceInt total = 0;
+    double elapsed_ms = 0;
+
+    SpiceDouble search_et = start_et;
+    while (search_et < end_et) {
+        double start = wall_ms();
+        SpiceInt found = find(target, search_et, end_et, EVENTS_BUFFER_LEN, events);
+        elapsed_ms += wall_ms() - start;
+        if (failed_c()) {
+            break;
+        }
+
+        for (SpiceInt i = 0; i < found; ++i) {
+            SpiceChar event_time_out[TIME_OUT_MAX_LEN];
+            timout_c(events[i].et, "YYYY-MM-DD HR:MN:SC.#### UTC ::UTC", TIME_OUT_MAX_LEN, event_time_out);
+            printf("%-7s %s: Azimuth=%f Elevation=%f\n", gate_event_kind_string(events[i].kind), event_time_out,
+                   events[i].azimuth, events[i].elevation);
+        }
+        total += found;
+
+        if (found < EVENTS_BUFFER_LEN) {
+            break;
+        }
+        search_et = events[found - 1].et + EVENTS_CONTINUE_SEC;
+    }
+
+    printf("\nFound %d events in %.3f ms\n", total, elapsed_ms);
+}
+
 static void star_info(char *catalog_number) {
     char *table_name = (char *) check_and_get_option(STAR_TABLE);
     if (table_name == NULL) {
@@ -485,7 +1169,7 @@ static void star_info(char *catalog_number) {
     SpiceInt rows;
     gate_load_stars(table_name, filter, &rows);
     if (rows == 0) {
-        printf("No stars found in table '%s' with catalog number '%s'\n", table_name, catalog_number);
+        fail_command("No stars found in table '%s' with catalog number '%s'", table_name, catalog_number);
         return;
     }
 
@@ -499,8 +1183,8 @@ static void star_info(char *catalog_number) {
 
         char *name = NULL;
         if (strcmp("HIPPARCOS", table_name) == 0) {
-            for (int j = 0; j < csn_data_len; ++j) {
-                csn_data data = csn_data_array[j];
+            for (int j = 0; j < csn_names_len; ++j) {
+                csn_name data = csn_names[j];
                 if (data.hip == info.catalog_number) {
                     name = data.name;
                     break;
@@ -555,21 +1239,14 @@ static void star_azel(char **argv, volatile int *is_running) {
     SpiceInt rows;
     gate_load_stars(table_name, filter, &rows);
     if (rows == 0) {
-        printf("No stars found in table '%s' with catalog number '%s'\n", table_name, argv[2]);
+        fail_command("No stars found in table '%s' with catalog number '%s'", table_name, argv[2]);
         return;
     }
 
-    SpiceBoolean is_cont = SPICEFALSE;
+    SpiceBoolean is_cont;
     SpiceInt count;
-    if (eq_ignore_case("CONT", argv[3])) {
-        is_cont = SPICETRUE;
-    } else {
-        char *end;
-        count = strtol(argv[3], &end, 10);
-        if (argv[3] == end) {
-            printf("Not a valid number: %s\n", argv[3]);
-            return;
-        }
+    if (!parse_count(argv[3], &is_cont, &count)) {
+        return;
     }
 
     SpiceDouble calc_et;
@@ -579,33 +1256,14 @@ static void star_azel(char **argv, volatile int *is_running) {
         str2et_c(argv[4], &calc_et);
     }
 
-    char *observer_body = (char *) check_and_get_option(OBSERVER_BODY);
-    if (observer_body == NULL) {
-        return;
-    }
-
-    SpiceInt body_id;
-    SpiceBoolean body_id_found;
-    bodn2c_c(observer_body, &body_id, &body_id_found);
-    if (!body_id_found) {
-        printf("No NAIF ID was found for body '%s'! Try LOAD KERNEL?\n", observer_body);
-        return;
-    }
-
-    SpiceDouble *observer_latitude_opt = (double *) check_and_get_option(OBSERVER_LATITUDE);
-    SpiceDouble *observer_longitude_opt = (double *) check_and_get_option(OBSERVER_LONGITUDE);
-    if (observer_latitude_opt == NULL || observer_longitude_opt == NULL) {
+    gate_topo_frame observer_frame;
+    if (!get_observer_frame(&observer_frame)) {
         return;
     }
 
-    SpiceDouble observer_latitude = *observer_latitude_opt;
-    SpiceDouble observer_longitude = *observer_longitude_opt;
-
-    gate_topo_frame observer_frame;
-    gate_load_topo_frame("STAR_AZEL_TOPO", body_id, observer_latitude, observer_longitude, 0, &observer_frame);
-
     gate_star_info_spice1 stars[rows];
     gate_parse_stars(rows, stars);
+    gate_abcorr abcorr = get_abcorr();
 
     printf("Printing azimuth/elevation for star '%s' in table '%s'\n\n", argv[2], table_name);
 
@@ -624,7 +1282,7 @@ static void star_azel(char **argv, volatile int *is_running) {
 
             SpiceDouble azimuth;
             SpiceDouble elevation;
-            gate_calc_star_topo(observer_frame, info, calc_et, NULL, &azimuth, &elevation);
+            gate_calc_star_topo(observer_frame, info, calc_et, abcorr, NULL, &azimuth, &elevation);
             printf("Azimuth=%f Elevation=%f\n", azimuth, elevation);
         }
 
@@ -651,40 +1309,103 @@ static void star_azel(char **argv, volatile int *is_running) {
 
         calc_et += elapsed;
     }
+}
+
+typedef struct {
+    gate_topo_frame observer;
+    gate_star_info_spice1 info;
+    gate_abcorr abcorr;
+} star_event_target;
 
-    gate_unload_topo_frame(observer_frame);
+static void star_radec(void *user_data, SpiceDouble et, SpiceDouble *ra, SpiceDouble *dec) {
+    gate_calc_star_pos(*(gate_star_info_spice1 *) user_data, et, ra, dec, NULL, NULL);
 }
 
-void star(int argc, char **argv, volatile int *is_running) {
-    if (argc < 2) {
-        puts("This command requires at least 1 argument");
+static SpiceInt find_star_events(void *target, SpiceDouble start_et, SpiceDouble end_et, SpiceInt events_len,
+                                 gate_event *events) {
+    star_event_target *star = target;
+    return gate_fixed_events(star->observer, star_radec, &star->info, star->abcorr, start_et, end_et,
+                             EVENTS_HORIZON_DEG, events_len, events);
+}
+
+static void star_events(char **argv) {
+    SpiceChar filter[FILTER_MAX_LEN];
+    snprintf(filter, FILTER_MAX_LEN, "WHERE CATALOG_NUMBER = %s", argv[2]);
+
+    char *table_name = (char *) check_and_get_option(STAR_TABLE);
+    if (table_name == NULL) {
         return;
     }
 
-    if (eq_ignore_case("INFO", argv[1])) {
-        if (argc != 3) {
-            puts("This command requires 1 argument");
-            return;
-        }
-        return star_info(argv[2]);
+    SpiceInt rows;
+    gate_load_stars(table_name, filter, &rows);
+    if (rows == 0) {
+        fail_command("No stars found in table '%s' with catalog number '%s'", table_name, argv[2]);
+        return;
     }
 
-    if (eq_ignore_case("AZEL", argv[1])) {
-        if (argc != 5) {
-            puts("This command requires 3 arguments");
-            return;
-        }
-        return star_azel(argv, is_running);
+    SpiceDouble start_et;
+    SpiceDouble end_et;
+    if (!parse_event_span(argv[3], argv[4], &start_et, &end_et)) {
+        return;
     }
 
-    printf("Unrecognized option: '%s'\n", argv[1]);
-}
+    star_event_target target;
+    if (!get_observer_frame(&target.observer)) {
+        return;
+    }
+    target.abcorr = get_abcorr();
 
-static void body_info(char *naif_id_string) {
+    gate_star_info_spice1 stars[rows];
+    gate_parse_stars(rows, stars);
+
+    printf("Printing rises, transits and sets for star '%s' in table '%s'\n\n", argv[2], table_name);
+
+    reset_c();
+    for (int i = 0; i < rows; ++i) {
+        target.info = stars[i];
+        print_events(find_star_events, &target, start_et, end_et);
+    }
+}
+
+void star(int argc, char **argv, volatile int *is_running) {
+    if (argc < 2) {
+        fail_command("This command requires at least 1 argument");
+        return;
+    }
+
+    if (eq_ignore_case("INFO", argv[1])) {
+        if (argc != 3) {
+            fail_command("This command requires 1 argument");
+            return;
+        }
+        return star_info(argv[2]);
+    }
+
+    if (eq_ignore_case("AZEL", argv[1])) {
+        if (argc != 5) {
+            fail_command("This command requires 3 arguments");
+            return;
+        }
+        return star_azel(argv, is_running);
+    }
+
+    if (eq_ignore_case("EVENTS", argv[1])) {
+        if (argc != 5) {
+            fail_command("This command requires 3 arguments");
+            return;
+        }
+        return star_events(argv);
+    }
+
+    fail_command("Unrecognized option: '%s'", argv[1]);
+}
+
+static void body_info(char *naif_id_string) {
     char *naif_id_string_end;
     SpiceInt naif_id = strtol(naif_id_string, &naif_id_string_end, 10);
     if (naif_id_string == naif_id_string_end) {
-        printf("'%s' is not a valid NAIF ID\n", naif_id_string);
+        fail_command("'%s' is not a valid NAIF ID", naif_id_string);
         return;
     }
 
@@ -693,7 +1414,7 @@ static void body_info(char *naif_id_string) {
     bodc2n_c(naif_id, BODY_NAME_MAX_LEN, body_name, &found);
 
     if (!found) {
-        printf("No body with NAIF ID '%s'. Try LOAD KERNEL?\n", naif_id_string);
+        fail_command("No body with NAIF ID '%s'. Try LOAD KERNEL?", naif_id_string);
         return;
     }
 
@@ -702,35 +1423,52 @@ static void body_info(char *naif_id_string) {
 }
 
 static void body_azel(char **argv, volatile int *is_running) {
-    char *naif_id_string_end;
-    SpiceInt naif_id = strtol(argv[2], &naif_id_string_end, 10);
-    if (argv[2] == naif_id_string_end) {
-        printf("'%s' is not a valid NAIF ID\n", argv[2]);
-        return;
-    }
+    SpiceInt targets_len = 0;
+    SpiceInt targets[BODY_AZEL_MAX_TARGETS];
+    if (eq_ignore_case("ALL", argv[2])) {
+        targets_len = GATE_SOLAR_SYSTEM_BODIES_LEN;
+        memcpy(targets, GATE_SOLAR_SYSTEM_BODIES, sizeof(GATE_SOLAR_SYSTEM_BODIES));
+    } else {
+        char *naif_id_string = argv[2];
+        while (SPICETRUE) {
+            if (targets_len == BODY_AZEL_MAX_TARGETS) {
+                fail_command("At most %d bodies may be listed", BODY_AZEL_MAX_TARGETS);
+                return;
+            }
 
-    SpiceChar body_name[BODY_NAME_MAX_LEN];
-    SpiceBoolean found;
-    bodc2n_c(naif_id, BODY_NAME_MAX_LEN, body_name, &found);
+            char *naif_id_string_end;
+            targets[targets_len] = strtol(naif_id_string, &naif_id_string_end, 10);
+            if (naif_id_string == naif_id_string_end ||
+                (*naif_id_string_end != ',' && *naif_id_string_end != '\0')) {
+                fail_command("'%s' is not a valid NAIF ID", argv[2]);
+                return;
+            }
+            targets_len++;
 
-    if (!found) {
-        printf("No body with NAIF ID '%s'. Try LOAD KERNEL?\n", argv[2]);
-        return;
+            if (*naif_id_string_end == '\0') {
+                break;
+            }
+            naif_id_string = naif_id_string_end + 1;
+        }
     }
 
-    SpiceBoolean is_cont = SPICEFALSE;
-    SpiceInt count;
-    if (eq_ignore_case("CONT", argv[3])) {
-        is_cont = SPICETRUE;
-    } else {
-        char *end;
-        count = strtol(argv[3], &end, 10);
-        if (argv[3] == end) {
-            printf("Not a valid number: %s\n", argv[3]);
+    SpiceChar body_names[BODY_AZEL_MAX_TARGETS][BODY_NAME_MAX_LEN];
+    for (SpiceInt i = 0; i < targets_len; ++i) {
+        SpiceBoolean found;
+        bodc2n_c(targets[i], BODY_NAME_MAX_LEN, body_names[i], &found);
+
+        if (!found) {
+            fail_command("No body with NAIF ID '%d'. Try LOAD KERNEL?", targets[i]);
             return;
         }
     }
 
+    SpiceBoolean is_cont;
+    SpiceInt count;
+    if (!parse_count(argv[3], &is_cont, &count)) {
+        return;
+    }
+
     SpiceDouble calc_et;
     if (eq_ignore_case("NOW", argv[4])) {
         gate_et_now(&calc_et);
@@ -743,32 +1481,29 @@ static void body_azel(char **argv, volatile int *is_running) {
         return;
     }
 
-    SpiceInt observer_body_id;
-    SpiceBoolean observer_body_id_found;
-    bodn2c_c(observer_body, &observer_body_id, &observer_body_id_found);
-    if (!observer_body_id_found) {
-        printf("No NAIF ID was found for body '%s'! Try LOAD KERNEL?\n", observer_body);
+    gate_topo_frame observer_frame;
+    if (!get_observer_frame(&observer_frame)) {
         return;
     }
 
-    SpiceDouble *observer_latitude_opt = (double *) check_and_get_option(OBSERVER_LATITUDE);
-    SpiceDouble *observer_longitude_opt = (double *) check_and_get_option(OBSERVER_LONGITUDE);
-    if (observer_latitude_opt == NULL || observer_longitude_opt == NULL) {
-        return;
+    if (targets_len == 1) {
+        printf("Printing azimuth/elevation for body '%d' (%s)\n\n", targets[0], body_names[0]);
+    } else {
+        printf("Printing azimuth/elevation for %d bodies\n\n", targets_len);
     }
 
-    SpiceDouble observer_latitude = *observer_latitude_opt;
-    SpiceDouble observer_longitude = *observer_longitude_opt;
-
-    gate_topo_frame observer_frame;
-    gate_load_topo_frame("BODY_AZEL_TOPO", observer_body_id, observer_latitude, observer_longitude, 0,
-                         &observer_frame);
-
-    printf("Printing azimuth/elevation for body '%s' (%s)\n\n", argv[2], body_name);
+    // A single body is tracked by interpolating its state,
+    // while several bodies share the work that only
+    // depends on the observer instead
+    gate_abcorr abcorr = get_abcorr();
+    gate_body_track track;
+    gate_body_track_init(body_names[0], observer_frame.frame_name, abcorr, observer_body, BODY_TRACK_WINDOW_SEC,
+                         BODY_TRACK_TOLERANCE_DEG, &track);
 
     SpiceDouble loop_start_et;
     gate_et_now(&loop_start_et);
 
+    reset_c();
     int rounds = 0;
     while (SPICETRUE) {
         SpiceChar calc_time_out[TIME_OUT_MAX_LEN];
@@ -776,15 +1511,27 @@ static void body_azel(char **argv, volatile int *is_running) {
 
         printf("%s:\n", calc_time_out);
 
-        SpiceDouble state_vector[6];
-        SpiceDouble lt;
-        spkezr_c(body_name, calc_et, observer_frame.frame_name, "CN+S", observer_body,
-                 state_vector, &lt);
+        SpiceDouble states[BODY_AZEL_MAX_TARGETS][6];
+        if (targets_len == 1) {
+            gate_body_track_state(&track, calc_et, states[0]);
+        } else {
+            gate_body_states(targets_len, targets, observer_frame.body_id, observer_frame.frame_name, abcorr, calc_et,
+                             states, NULL);
+        }
+        if (failed_c()) {
+            break;
+        }
 
-        SpiceDouble azimuth;
-        SpiceDouble elevation;
-        gate_conv_rec_azel(state_vector, NULL, &azimuth, &elevation);
-        printf("Azimuth=%f Elevation=%f\n", azimuth, elevation);
+        for (SpiceInt i = 0; i < targets_len; ++i) {
+            SpiceDouble azimuth;
+            SpiceDouble elevation;
+            gate_conv_rec_azel(states[i], NULL, &azimuth, &elevation);
+            if (targets_len == 1) {
+                printf("Azimuth=%f Elevation=%f\n", azimuth, elevation);
+            } else {
+                printf("%s: Azimuth=%f Elevation=%f\n", body_names[i], azimuth, elevation);
+            }
+        }
 
         if (!is_cont) {
             rounds++;
@@ -809,19 +1556,184 @@ static void body_azel(char **argv, volatile int *is_running) {
 
         calc_et += elapsed;
     }
+}
+
+/**
+ * Compares the cost and the error in direction of every
+ * level of aberration correction for a body, taking
+ * CN+S as the reference.
+ */
+static void body_bench(char **argv) {
+    char *naif_id_string_end;
+    SpiceInt naif_id = strtol(argv[2], &naif_id_string_end, 10);
+    if (argv[2] == naif_id_string_end) {
+        fail_command("'%s' is not a valid NAIF ID", argv[2]);
+        return;
+    }
+
+    SpiceChar body_name[BODY_NAME_MAX_LEN];
+    SpiceBoolean found;
+    bodc2n_c(naif_id, BODY_NAME_MAX_LEN, body_name, &found);
+    if (!found) {
+        fail_command("No body with NAIF ID '%s'. Try LOAD KERNEL?", argv[2]);
+        return;
+    }
+
+    SpiceDouble start_et;
+    if (eq_ignore_case("NOW", argv[3])) {
+        gate_et_now(&start_et);
+    } else {
+        str2et_c(argv[3], &start_et);
+    }
+
+    char *end;
+    SpiceInt samples = strtol(argv[4], &end, 10);
+    if (argv[4] == end || samples <= 0) {
+        fail_command("Not a valid number: %s", argv[4]);
+        return;
+    }
+
+    char *observer_body = (char *) check_and_get_option(OBSERVER_BODY);
+    if (observer_body == NULL) {
+        return;
+    }
+
+    gate_topo_frame observer_frame;
+    if (!get_observer_frame(&observer_frame)) {
+        return;
+    }
+
+    SpiceDouble (*reference)[6] = malloc(samples * sizeof(*reference));
+    SpiceDouble (*states)[6] = malloc(samples * sizeof(*states));
+    if (reference == NULL || states == NULL) {
+        fail_command("Not enough memory to run the benchmark");
+        free(reference);
+        free(states);
+        return;
+    }
+
+    printf("Comparing aberration corrections for body '%d' (%s) over %d samples %d seconds apart\n\n", naif_id,
+           body_name, samples, BODY_BENCH_STEP_SEC);
+
+    // The reference is timed as the CN+S level, and the
+    // other levels are compared against it
+    reset_c();
+    for (int level = GATE_ABCORR_CN_S; level >= 0; --level) {
+        SpiceDouble (*out)[6] = level == GATE_ABCORR_CN_S ? reference : states;
+
+        double start = wall_ms();
+        for (SpiceInt i = 0; i < samples; ++i) {
+            gate_apparent_state(body_name, start_et + i * BODY_BENCH_STEP_SEC, observer_frame.frame_name, level,
+                                observer_body, out[i]);
+        }
+        double elapsed_ms = wall_ms() - start;
+        if (failed_c()) {
+            break;
+        }
+
+        SpiceDouble max_error = 0;
+        SpiceDouble total_error = 0;
+        for (SpiceInt i = 0; i < samples; ++i) {
+            SpiceDouble error = vsep_c(out[i], reference[i]) * dpr_c() * 3600;
+            total_error += error;
+            if (error > max_error) {
+                max_error = error;
+            }
+        }
+
+        printf("%-6s %8.2f us per state, error max %.4f mean %.4f arcsec\n", gate_abcorr_string(level),
+               elapsed_ms * 1000 / samples, max_error, total_error / samples);
+    }
+
+    free(reference);
+    free(states);
+}
+
+typedef struct {
+    gate_topo_frame observer;
+    gate_body_track track;
+    SpiceDouble horizon;
+} body_event_target;
+
+static SpiceInt find_body_events(void *target, SpiceDouble start_et, SpiceDouble end_et, SpiceInt events_len,
+                                 gate_event *events) {
+    body_event_target *body = target;
+    return gate_body_events(&body->track, body->observer, start_et, end_et, body->horizon, events_len, events);
+}
+
+/**
+ * Prints the rises, transits and sets of a body. Rises and
+ * sets are taken at the upper limb of the body, allowing
+ * for refraction.
+ */
+static void body_events(char **argv) {
+    char *naif_id_string_end;
+    SpiceInt naif_id = strtol(argv[2], &naif_id_string_end, 10);
+    if (argv[2] == naif_id_string_end) {
+        fail_command("'%s' is not a valid NAIF ID", argv[2]);
+        return;
+    }
+
+    SpiceChar body_name[BODY_NAME_MAX_LEN];
+    SpiceBoolean found;
+    bodc2n_c(naif_id, BODY_NAME_MAX_LEN, body_name, &found);
+    if (!found) {
+        fail_command("No body with NAIF ID '%s'. Try LOAD KERNEL?", argv[2]);
+        return;
+    }
+
+    SpiceDouble start_et;
+    SpiceDouble end_et;
+    if (!parse_event_span(argv[3], argv[4], &start_et, &end_et)) {
+        return;
+    }
 
-    gate_unload_topo_frame(observer_frame);
+    char *observer_body = (char *) check_and_get_option(OBSERVER_BODY);
+    if (observer_body == NULL) {
+        return;
+    }
+
+    body_event_target target;
+    if (!get_observer_frame(&target.observer)) {
+        return;
+    }
+
+    reset_c();
+    gate_body_track_init(body_name, "J2000", get_abcorr(), observer_body, EVENTS_BODY_TRACK_WINDOW_SEC,
+                         EVENTS_BODY_TRACK_TOLERANCE_DEG, &target.track);
+
+    // The semidiameter hardly changes over the span for the
+    // Sun and the Moon, so it is taken once at the start
+    target.horizon = EVENTS_HORIZON_DEG;
+    if (bodfnd_c(naif_id, "RADII")) {
+        SpiceInt dim;
+        SpiceDouble radii[3];
+        bodvcd_c(naif_id, "RADII", 3, &dim, radii);
+
+        SpiceDouble state[6];
+        gate_body_track_state(&target.track, start_et, state);
+        if (!failed_c()) {
+            target.horizon -= asin(radii[0] / vnorm_c(state)) * dpr_c();
+        }
+    }
+
+    printf("Printing rises, transits and sets for body '%d' (%s)\n\n", naif_id, body_name);
+
+    if (!failed_c()) {
+        print_events(find_body_events, &target, start_et, end_et);
+    }
+    printf("Looked up %d states in %d windows\n", target.track.lookups, target.track.refreshes);
 }
 
 void body(int argc, char **argv, volatile int *is_running) {
     if (argc < 2) {
-        puts("This command requires at least 1 argument");
+        fail_command("This command requires at least 1 argument");
         return;
     }
 
     if (eq_ignore_case("INFO", argv[1])) {
         if (argc != 3) {
-            puts("This command requires 1 argument");
+            fail_command("This command requires 1 argument");
             return;
         }
         return body_info(argv[2]);
@@ -829,112 +1741,304 @@ void body(int argc, char **argv, volatile int *is_running) {
 
     if (eq_ignore_case("AZEL", argv[1])) {
         if (argc != 5) {
-            puts("This command requires 3 arguments");
+            fail_command("This command requires 3 arguments");
             return;
         }
         return body_azel(argv, is_running);
     }
 
-    printf("Unrecognized option: '%s'\n", argv[1]);
+    if (eq_ignore_case("BENCH", argv[1])) {
+        if (argc != 5) {
+            fail_command("This command requires 3 arguments");
+            return;
+        }
+        return body_bench(argv);
+    }
+
+    if (eq_ignore_case("EVENTS", argv[1])) {
+        if (argc != 5) {
+            fail_command("This command requires 3 arguments");
+            return;
+        }
+        return body_events(argv);
+    }
+
+    fail_command("Unrecognized option: '%s'", argv[1]);
+}
+
+static gate_pool *get_sat_pool() {
+    if (sat_pool == NULL) {
+        sat_pool = gate_pool_new(0);
+    }
+
+    return sat_pool;
 }
 
-static char *read_line(int line_len, SpiceChar *line) {
-    for (int i = 0; i < line_len; ++i) {
-        line[i] = fgetc(stdin);
+static SpiceBoolean read_line(int line_len, SpiceChar *line) {
+    if (fgets(line, line_len, stdin) == NULL) {
+        return SPICEFALSE;
     }
 
-    // Overwrite the new line char with NULL
-    line[line_len - 1] = '\0';
+    size_t len = strcspn(line, "\r\n");
+    if (line[len] == '\0') {
+        // Discard the rest of an overly long line
+        int c;
+        while ((c = fgetc(stdin)) != '\n' && c != EOF);
+    }
+    line[len] = '\0';
 
-    return line;
+    return SPICETRUE;
 }
 
 static void sat_add(char *arg) {
     printf("Paste TLE data below:\n");
 
-    SpiceChar lines[2][TLE_LINE_LEN];
-    read_line(TLE_LINE_LEN, lines[0]);
-    read_line(TLE_LINE_LEN, lines[1]);
-    if (lines[0] == NULL || lines[1] == NULL) {
-        printf("Invalid input\n");
+    SpiceChar lines[2][TLE_INPUT_MAX_LEN];
+    if (!read_line(TLE_INPUT_MAX_LEN, lines[0]) || !read_line(TLE_INPUT_MAX_LEN, lines[1])) {
+        fail_command("Invalid input");
         return;
     }
 
-    char *id = strdup(arg);
-    sat_data *data = malloc(sizeof(*data));
-
-    data->lines[0] = strdup(lines[0]);
-    data->lines[1] = strdup(lines[1]);
-    getelm_c(TLE_MIN_YEAR, TLE_LINE_LEN, lines, &data->epoch, data->elements);
-
-    char orbit_freq_str[12];
-    memcpy(orbit_freq_str, lines[1] + 52, 11 * sizeof(*orbit_freq_str));
-    orbit_freq_str[11] = '\0';
-
-    char *end;
-    double orbit_freq = strtod(orbit_freq_str, &end);
-    if (end == orbit_freq_str) {
-        printf("Error parsing orbit frequency '%s'\n", orbit_freq_str);
+    gate_tle tle;
+    gate_tle_status status = gate_parse_tle(NULL, lines[0], lines[1], &tle);
+    if (status != GATE_TLE_OK) {
+        fail_command("Error parsing TLE: %s", gate_tle_status_string(status));
         return;
     }
 
-    double orbit_period = 24 * 60 / orbit_freq;
-    data->is_deep_space = orbit_period >= 225;
+    SpiceBoolean replaced;
+    if (gate_sat_store_put(&sat_store, arg, &tle, &replaced) == -1) {
+        return;
+    }
+    clear_sat_cache();
 
-    gatecli_table_put(&sat_data_array, id, data);
-    printf("Added satellite '%s' to the database\n", arg);
+    if (replaced) {
+        printf("Replaced satellite '%s' in the database\n", arg);
+    } else {
+        printf("Added satellite '%s' to the database\n", arg);
+    }
 }
 
 static void sat_rem(char *arg) {
-    sat_data *data = gatecli_table_rem(&sat_data_array, arg);
-    if (data != NULL) {
-        free(data->lines[0]);
-        free(data->lines[1]);
-        free(data);
-
+    if (gate_sat_store_rem(&sat_store, arg)) {
+        clear_sat_cache();
         printf("Successfully removed satellite '%s'\n", arg);
     } else {
-        printf("No satellite in database called '%s'\n", arg);
+        fail_command("No satellite in database called '%s'", arg);
     }
 }
 
 static void sat_info(char *arg) {
-    sat_data *data = gatecli_table_get(&sat_data_array, arg);
-    if (data == NULL) {
-        printf("No object in database called '%s'\n", arg);
+    gate_sat_handle handle = gate_sat_store_find(&sat_store, arg);
+    if (handle == -1) {
+        fail_command("No object in database called '%s'", arg);
         return;
     }
 
+    gate_sat_text *text = &sat_store.text[handle];
     printf("ID: %s\n"
+           "Name: %s\n"
+           "Catalog number: %d\n"
            "Epoch: %f seconds\n"
            "Deep space: %s\n"
            "\n"
            "TLE:\n"
            "%s\n"
            "%s\n",
-           arg, data->epoch, data->is_deep_space ? "yes" : "no", data->lines[0], data->lines[1]);
+           arg, text->name[0] != '\0' ? text->name : "(Unnamed)", text->catalog_number,
+           sat_store.elements[GATE_TLE_EPOCH][handle], sat_store.is_deep_space[handle] ? "yes" : "no",
+           text->lines[0], text->lines[1]);
 }
 
-static void sat_azel(char **argv, volatile int *is_running) {
-    sat_data *sat = gatecli_table_get(&sat_data_array, argv[2]);
-    if (sat == NULL) {
-        printf("No satellite with ID '%s'. Try SAT ADD?\n", argv[2]);
+static void sat_history_info(char **argv) {
+    gate_sat_handle handle = gate_sat_store_find(&sat_store, argv[2]);
+    if (handle == -1) {
+        fail_command("No satellite with ID '%s'. Try SAT ADD?", argv[2]);
         return;
     }
 
-    SpiceBoolean is_cont = SPICEFALSE;
-    SpiceInt count;
-    if (eq_ignore_case("CONT", argv[3])) {
-        is_cont = SPICETRUE;
+    SpiceInt catalog_number = sat_store.text[handle].catalog_number;
+    const gate_tle_track *track = gate_tle_history_find(&sat_history, catalog_number);
+    if (track == NULL) {
+        fail_command("No archived element sets for catalog number %d. Try LOAD HISTORY?", catalog_number);
+        return;
+    }
+
+    SpiceDouble et;
+    if (eq_ignore_case("NOW", argv[3])) {
+        gate_et_now(&et);
     } else {
-        char *end;
-        count = strtol(argv[3], &end, 10);
-        if (argv[3] == end) {
-            printf("Not a valid number: %s\n", argv[3]);
-            return;
+        str2et_c(argv[3], &et);
+    }
+
+    SpiceChar first_out[TIME_OUT_MAX_LEN];
+    SpiceChar last_out[TIME_OUT_MAX_LEN];
+    timout_c(track->epochs[0], "YYYY-MM-DD HR:MN:SC.#### UTC ::UTC", TIME_OUT_MAX_LEN, first_out);
+    timout_c(track->epochs[track->len - 1], "YYYY-MM-DD HR:MN:SC.#### UTC ::UTC", TIME_OUT_MAX_LEN, last_out);
+    printf("%d archived element sets for catalog number %d from %s to %s\n", track->len, catalog_number,
+           first_out, last_out);
+
+    SpiceInt nearest = gate_tle_track_nearest(track, et);
+    SpiceChar nearest_out[TIME_OUT_MAX_LEN];
+    timout_c(track->epochs[nearest], "YYYY-MM-DD HR:MN:SC.#### UTC ::UTC", TIME_OUT_MAX_LEN, nearest_out);
+    printf("Nearest epoch: %s (%f days away)\n", nearest_out, (et - track->epochs[nearest]) / spd_c());
+}
+
+/**
+ * Creates a propagator for a satellite which is accurate
+ * at the given time. If archived element sets were loaded
+ * for its catalog number with LOAD HISTORY, the one with
+ * the epoch nearest to the time is used, otherwise the
+ * element set in the store.
+ *
+ * @param track set to the archived element sets of the
+ * satellite, or NULL if there are none
+ * @param history_index set to the index of the element set
+ * used in the track, or -1 if there is no track
+ */
+static gate_sgp4_status init_sat_propagator(gate_sat_handle handle, SpiceDouble et, const gate_tle_track **track,
+                                            SpiceInt *history_index, gate_sat_propagator *propagator) {
+    *track = gate_tle_history_find(&sat_history, sat_store.text[handle].catalog_number);
+    if (*track == NULL) {
+        *history_index = -1;
+        return gate_sat_propagator_init(&sat_store, handle, propagator);
+    }
+
+    *history_index = gate_tle_track_nearest(*track, et);
+    return gate_sat_propagator_init_elements((*track)->elements[*history_index], propagator);
+}
+
+static void print_history_epoch(const gate_tle_track *track, SpiceInt history_index) {
+    SpiceChar epoch_out[TIME_OUT_MAX_LEN];
+    timout_c(track->epochs[history_index], "YYYY-MM-DD HR:MN:SC.#### UTC ::UTC", TIME_OUT_MAX_LEN, epoch_out);
+    printf("Using the archived element set from %s\n", epoch_out);
+}
+
+/**
+ * Looks up the position of the Sun, which is used to
+ * determine whether satellites can be seen by eye.
+ *
+ * @return SPICETRUE if the position was found, otherwise
+ * no SPK covering the Sun is loaded and the error has
+ * already been reported
+ */
+static SpiceBoolean find_sun(SpiceDouble et, SpiceDouble sun[3]) {
+    reset_c();
+    gate_sun_position(et, sun);
+    if (failed_c()) {
+        reset_c();
+        puts("Illumination is not shown without an SPK covering the Sun. Try LOAD KERNEL?");
+        return SPICEFALSE;
+    }
+
+    return SPICETRUE;
+}
+
+/**
+ * Prints whether a satellite can be seen by eye, which is
+ * when it is above the horizon and lit by the Sun while
+ * the Sun is far enough below the horizon of the observer.
+ */
+static void print_lighting(ConstSpiceChar *prefix, gate_topo_frame observer_frame, SpiceDouble et,
+                           ConstSpiceDouble sun[3], ConstSpiceDouble sat_pos[3], SpiceDouble sat_elevation) {
+    gate_illumination illumination = gate_sat_illumination(sat_pos, sun);
+
+    SpiceDouble frame_transform_matrix[3][3];
+    pxform_c("J2000", observer_frame.frame_name, et, frame_transform_matrix);
+
+    SpiceDouble sun_rec[3];
+    mxv_c(frame_transform_matrix, sun, sun_rec);
+    gate_adjust_topo_rec(observer_frame, sun_rec);
+
+    SpiceDouble sun_elevation;
+    gate_conv_rec_azel(sun_rec, NULL, NULL, &sun_elevation);
+
+    SpiceBoolean is_visible = sat_elevation > 0 && illumination != GATE_UMBRA &&
+                              sun_elevation < VISIBLE_MAX_SUN_ELEVATION;
+    printf("%sIllumination=%s SunElevation=%f Visible=%s\n", prefix, gate_illumination_string(illumination),
+           sun_elevation, is_visible ? "yes" : "no");
+}
+
+/**
+ * Computes the topocentric position of a satellite at a
+ * level of aberration correction, given the quantities
+ * which only depend on the observer and the epoch.
+ *
+ * A satellite shares the orbital motion of the Earth, and
+ * the light time and annual aberration due to that motion
+ * cancel to first order, so both corrections are made
+ * relative to the center of the Earth instead: the light
+ * time with the motion of the satellite about it, and the
+ * stellar aberration with the rotation of the observer
+ * about it. GATE_ABCORR_ANNUAL thus applies the latter.
+ *
+ * @param observer_state the state of the observer relative
+ * to the center of its body in the J2000 frame
+ * @param rotation the rotation from the J2000 frame into
+ * the topocentric frame of the observer
+ * @param state the geometric state of the satellite in the
+ * J2000 frame at the given time
+ * @param rec set to the apparent position of the satellite
+ * in the topocentric frame of the observer
+ */
+static gate_sgp4_status sat_apparent_rec_shared(gate_sat_propagator *propagator, ConstSpiceDouble observer_state[6],
+                                                ConstSpiceDouble rotation[3][3], SpiceDouble et, gate_abcorr abcorr,
+                                                ConstSpiceDouble state[6], SpiceDouble rec[3]) {
+    SpiceDouble emitted_state[6];
+    memcpy(emitted_state, state, sizeof(emitted_state));
+    for (SpiceInt i = 0; i < gate_abcorr_light_time_iterations(abcorr); ++i) {
+        SpiceDouble lt = vdist_c(emitted_state, observer_state) / clight_c();
+        gate_sgp4_status status = gate_sat_propagate(propagator, et - lt, emitted_state);
+        if (status != GATE_SGP4_OK) {
+            return status;
         }
     }
 
+    SpiceDouble relative[3];
+    vsub_c(emitted_state, observer_state, relative);
+    if (gate_abcorr_stellar(abcorr)) {
+        SpiceDouble apparent[3];
+        stelab_c(relative, &observer_state[3], apparent);
+        vequ_c(apparent, relative);
+    }
+
+    mxv_c(rotation, relative, rec);
+    return GATE_SGP4_OK;
+}
+
+/**
+ * Computes the topocentric position of a satellite at a
+ * level of aberration correction, see
+ * sat_apparent_rec_shared().
+ */
+static gate_sgp4_status sat_apparent_rec(gate_sat_propagator *propagator, gate_topo_frame observer_frame,
+                                         SpiceDouble et, gate_abcorr abcorr, ConstSpiceDouble state[6],
+                                         SpiceDouble rec[3]) {
+    SpiceDouble xform[6][6];
+    sxform_c(observer_frame.frame_name, "J2000", et, xform);
+
+    SpiceDouble observer_topo_state[6] = {0, 0, observer_frame.radius, 0, 0, 0};
+    SpiceDouble observer_state[6];
+    mxvg_c(xform, observer_topo_state, 6, 6, observer_state);
+
+    SpiceDouble frame_transform_matrix[3][3];
+    pxform_c("J2000", observer_frame.frame_name, et, frame_transform_matrix);
+    return sat_apparent_rec_shared(propagator, observer_state, frame_transform_matrix, et, abcorr, state, rec);
+}
+
+static void sat_azel(char **argv, volatile int *is_running) {
+    gate_sat_handle handle = gate_sat_store_find(&sat_store, argv[2]);
+    if (handle == -1) {
+        fail_command("No satellite with ID '%s'. Try SAT ADD?", argv[2]);
+        return;
+    }
+
+    SpiceBoolean is_cont;
+    SpiceInt count;
+    if (!parse_count(argv[3], &is_cont, &count)) {
+        return;
+    }
+
     SpiceDouble calc_et;
     if (eq_ignore_case("NOW", argv[4])) {
         gate_et_now(&calc_et);
@@ -942,33 +2046,28 @@ static void sat_azel(char **argv, volatile int *is_running) {
         str2et_c(argv[4], &calc_et);
     }
 
-    char *observer_body = (char *) check_and_get_option(OBSERVER_BODY);
-    if (observer_body == NULL) {
+    const gate_tle_track *track;
+    SpiceInt history_index;
+    gate_sat_propagator propagator;
+    gate_sgp4_status status = init_sat_propagator(handle, calc_et, &track, &history_index, &propagator);
+    if (status != GATE_SGP4_OK) {
+        fail_command("Satellite '%s' cannot be propagated: %s", argv[2], gate_sgp4_status_string(status));
         return;
     }
 
-    SpiceInt observer_body_id;
-    SpiceBoolean observer_body_id_found;
-    bodn2c_c(observer_body, &observer_body_id, &observer_body_id_found);
-    if (!observer_body_id_found) {
-        printf("No NAIF ID was found for body '%s'! Try LOAD KERNEL?\n", observer_body);
+    gate_topo_frame observer_frame;
+    if (!get_observer_frame(&observer_frame)) {
         return;
     }
 
-    SpiceDouble *observer_latitude_opt = (double *) check_and_get_option(OBSERVER_LATITUDE);
-    SpiceDouble *observer_longitude_opt = (double *) check_and_get_option(OBSERVER_LONGITUDE);
-    if (observer_latitude_opt == NULL || observer_longitude_opt == NULL) {
-        return;
+    printf("Printing azimuth/elevation for custom ID '%s' (%s)\n", argv[2], argv[2]);
+    if (track != NULL) {
+        print_history_epoch(track, history_index);
     }
-
-    SpiceDouble observer_latitude = *observer_latitude_opt;
-    SpiceDouble observer_longitude = *observer_longitude_opt;
-
-    gate_topo_frame observer_frame;
-    gate_load_topo_frame("SAT_AZEL_TOPO", observer_body_id, observer_latitude, observer_longitude, 0,
-                         &observer_frame);
-
-    printf("Printing azimuth/elevation for custom ID '%s' (%s)\n\n", argv[2], argv[2]);
+    SpiceDouble sun[3];
+    SpiceBoolean has_sun = find_sun(calc_et, sun);
+    gate_abcorr abcorr = get_abcorr();
+    puts("");
 
     SpiceDouble loop_start_et;
     gate_et_now(&loop_start_et);
@@ -980,25 +2079,37 @@ static void sat_azel(char **argv, volatile int *is_running) {
 
         printf("%s:\n", calc_time_out);
 
-        SpiceDouble frame_transform_matrix[3][3];
-        pxform_c("J2000", observer_frame.frame_name, calc_et, frame_transform_matrix);
+        if (track != NULL && gate_tle_track_nearest(track, calc_et) != history_index) {
+            // A failure to initialize is reported when
+            // propagating below
+            init_sat_propagator(handle, calc_et, &track, &history_index, &propagator);
+            print_history_epoch(track, history_index);
+        }
 
         SpiceDouble cur_rec_j2000[6];
-        if (!sat->is_deep_space) {
-            ev2lin_(&calc_et, GEO_CONSTANTS, sat->elements, cur_rec_j2000);
-        } else {
-            dpspce_(&calc_et, GEO_CONSTANTS, sat->elements, cur_rec_j2000);
+        status = gate_sat_propagate(&propagator, calc_et, cur_rec_j2000);
+        if (status != GATE_SGP4_OK) {
+            fail_command("Failed to propagate: %s", gate_sgp4_status_string(status));
+            break;
         }
 
         SpiceDouble rec[3];
-        mxv_c(frame_transform_matrix, cur_rec_j2000, rec);
-        gate_adjust_topo_rec(observer_frame, rec);
+        status = sat_apparent_rec(&propagator, observer_frame, calc_et, abcorr, cur_rec_j2000, rec);
+        if (status != GATE_SGP4_OK) {
+            fail_command("Failed to propagate: %s", gate_sgp4_status_string(status));
+            break;
+        }
 
         SpiceDouble azimuth;
         SpiceDouble elevation;
         gate_conv_rec_azel(rec, NULL, &azimuth, &elevation);
         printf("Azimuth=%f Elevation=%f\n", azimuth, elevation);
 
+        if (has_sun) {
+            gate_sun_position(calc_et, sun);
+            print_lighting("", observer_frame, calc_et, sun, cur_rec_j2000, elevation);
+        }
+
         if (!is_cont) {
             rounds++;
             if (rounds == count) {
@@ -1022,237 +2133,2525 @@ static void sat_azel(char **argv, volatile int *is_running) {
 
         calc_et += elapsed;
     }
+}
 
-    gate_unload_topo_frame(observer_frame);
+static void print_pass_event(ConstSpiceChar *event, SpiceDouble et, SpiceDouble azimuth, SpiceDouble elevation,
+                             SpiceBoolean is_bound) {
+    SpiceChar time_out[TIME_OUT_MAX_LEN];
+    timout_c(et, "YYYY-MM-DD HR:MN:SC.#### UTC ::UTC", TIME_OUT_MAX_LEN, time_out);
+    printf("    %s: %s Azimuth=%f Elevation=%f%s\n", event, time_out, azimuth, elevation,
+           is_bound ? " (search bound)" : "");
 }
 
-void sat(int argc, char **argv, volatile int *is_running) {
-    if (argc < 2) {
-        puts("This command requires at least 1 argument");
+static void sat_passes(char **argv) {
+    gate_sat_handle handle = gate_sat_store_find(&sat_store, argv[2]);
+    if (handle == -1) {
+        fail_command("No satellite with ID '%s'. Try SAT ADD?", argv[2]);
         return;
     }
 
-    if (eq_ignore_case("ADD", argv[1])) {
-        if (argc != 3) {
-            puts("This command requires 1 argument");
-            return;
-        }
-        return sat_add(argv[2]);
+    SpiceDouble start_et;
+    if (eq_ignore_case("NOW", argv[3])) {
+        gate_et_now(&start_et);
+    } else {
+        str2et_c(argv[3], &start_et);
     }
 
-    if (eq_ignore_case("REM", argv[1])) {
-        if (argc != 3) {
-            puts("This command requires 1 argument");
-            return;
-        }
-        return sat_rem(argv[2]);
+    SpiceDouble end_et;
+    if (eq_ignore_case("NOW", argv[4])) {
+        gate_et_now(&end_et);
+    } else {
+        str2et_c(argv[4], &end_et);
+    }
+
+    char *end;
+    SpiceDouble min_elevation = strtod(argv[5], &end);
+    if (argv[5] == end) {
+        fail_command("Not a valid number: %s", argv[5]);
+        return;
+    }
+
+    if (end_et <= start_et) {
+        fail_command("The end time must be after the start time");
+        return;
+    }
+
+    const gate_tle_track *track;
+    SpiceInt history_index;
+    gate_sat_propagator propagator;
+    gate_sgp4_status status = init_sat_propagator(handle, start_et, &track, &history_index, &propagator);
+    if (status != GATE_SGP4_OK) {
+        fail_command("Satellite '%s' cannot be propagated: %s", argv[2], gate_sgp4_status_string(status));
+        return;
+    }
+
+    gate_topo_frame observer_frame;
+    if (!get_observer_frame(&observer_frame)) {
+        return;
+    }
+
+    printf("Passes of '%s' above %f degrees elevation\n", argv[2], min_elevation);
+    if (track != NULL) {
+        print_history_epoch(track, history_index);
+    }
+
+    // The Sun is interpolated rather than looked up for
+    // every pass
+    SpiceDouble sun[3];
+    gate_sun_table sun_table = {0};
+    if (find_sun(start_et, sun)) {
+        gate_sun_table_build(start_et, end_et, SUN_TABLE_STEP_SEC, &sun_table);
+        if (failed_c()) {
+            reset_c();
+        }
+    }
+    puts("");
+
+    // With archived element sets, the span is searched in
+    // pieces over which each element set is the nearest
+    // one, so a pass that crosses from one piece to the
+    // next is reported in two parts
+    SpiceDouble piece_end_et = track == NULL ? end_et : gate_tle_track_nearest_end(track, history_index);
+    if (piece_end_et > end_et) {
+        piece_end_et = end_et;
+    }
+
+    double start = wall_ms();
+    int total = 0;
+    gate_sat_pass passes[PASSES_BUFFER_LEN];
+    SpiceDouble search_et = start_et;
+    while (SPICETRUE) {
+        SpiceInt found = gate_sat_find_passes(&propagator, observer_frame, search_et, piece_end_et, min_elevation,
+                                              PASSES_BUFFER_LEN, passes, &status);
+        for (SpiceInt i = 0; i < found; ++i) {
+            gate_sat_pass *pass = &passes[i];
+            printf("Pass %d:\n", ++total);
+            print_pass_event("AOS", pass->aos_et, pass->aos_azimuth, min_elevation, pass->aos_at_start);
+            print_pass_event("MAX", pass->culmination_et, pass->culmination_azimuth, pass->culmination_elevation,
+                             SPICEFALSE);
+            print_pass_event("LOS", pass->los_et, pass->los_azimuth, min_elevation, pass->los_at_end);
+
+            SpiceDouble culmination_state[6];
+            if (sun_table.len > 0 &&
+                gate_sat_propagate(&propagator, pass->culmination_et, culmination_state) == GATE_SGP4_OK) {
+                gate_sun_table_position(&sun_table, pass->culmination_et, sun);
+                print_lighting("    At MAX: ", observer_frame, pass->culmination_et, sun, culmination_state,
+                               pass->culmination_elevation);
+            }
+        }
+
+        if (status != GATE_SGP4_OK) {
+            break;
+        }
+
+        // Continue a second after the last pass if the
+        // buffer filled up before the end of the piece. A
+        // last pass cut off by the end of the piece already
+        // reaches it
+        if (found == PASSES_BUFFER_LEN && !passes[found - 1].los_at_end) {
+            search_et = passes[found - 1].los_et + 1;
+            continue;
+        }
+
+        if (piece_end_et >= end_et) {
+            break;
+        }
+
+        search_et = piece_end_et;
+        history_index++;
+        piece_end_et = gate_tle_track_nearest_end(track, history_index);
+        if (piece_end_et > end_et) {
+            piece_end_et = end_et;
+        }
+        status = gate_sat_propagator_init_elements(track->elements[history_index], &propagator);
+        print_history_epoch(track, history_index);
+    }
+    double search_ms = wall_ms() - start;
+
+    if (status != GATE_SGP4_OK) {
+        fail_command("Stopped early, failed to propagate: %s", gate_sgp4_status_string(status));
+    }
+    printf("\nFound %d passes in %.1f ms\n", total, search_ms);
+
+    gate_sun_table_free(&sun_table);
+}
+
+/**
+ * Reads a ground station network from a file with one
+ * station per line, in the form
+ * `<name> <latitude deg> <longitude deg> <altitude km> <min elevation deg>`.
+ * Blank lines and lines starting with '#' are ignored.
+ *
+ * @return the number of stations read, or -1 if the file
+ * could not be read
+ */
+static int read_stations(char *file_name, char (**names)[STATION_NAME_MAX_LEN], gate_station **stations) {
+    FILE *file = fopen(file_name, "r");
+    if (file == NULL) {
+        fail_command("No such file with name: %s", file_name);
+        return -1;
+    }
+
+    int len = 0;
+    int cap = 0;
+    *names = NULL;
+    *stations = NULL;
+
+    char line[STATION_LINE_MAX_LEN];
+    int line_number = 0;
+    while (fgets(line, sizeof(line), file) != NULL) {
+        line_number++;
+
+        char name[STATION_NAME_MAX_LEN];
+        gate_station station;
+        if (sscanf(line, " %31s", name) != 1 || name[0] == '#') {
+            continue;
+        }
+        if (sscanf(line, " %*s %lf %lf %lf %lf", &station.latitude, &station.longitude, &station.altitude,
+                   &station.min_elevation) != 4) {
+            printf("Skipping malformed station on line %d of '%s'\n", line_number, file_name);
+            continue;
+        }
+
+        if (len == cap) {
+            cap = cap == 0 ? 16 : cap * 2;
+            char (*new_names)[STATION_NAME_MAX_LEN] = realloc(*names, cap * sizeof(**names));
+            gate_station *new_stations = realloc(*stations, cap * sizeof(**stations));
+            if (new_names != NULL) {
+                *names = new_names;
+            }
+            if (new_stations != NULL) {
+                *stations = new_stations;
+            }
+            if (new_names == NULL || new_stations == NULL) {
+                fail_command("Not enough memory to read the stations");
+                free(*names);
+                free(*stations);
+                fclose(file);
+                return -1;
+            }
+        }
+
+        strcpy((*names)[len], name);
+        (*stations)[len] = station;
+        len++;
+    }
+
+    fclose(file);
+    return len;
+}
+
+static void sat_visibility(char **argv) {
+    if (sat_store.len == 0) {
+        fail_command("No satellites in the database. Try LOAD TLE?");
+        return;
+    }
+
+    SpiceDouble start_et;
+    if (eq_ignore_case("NOW", argv[3])) {
+        gate_et_now(&start_et);
+    } else {
+        str2et_c(argv[3], &start_et);
+    }
+
+    SpiceDouble end_et;
+    if (eq_ignore_case("NOW", argv[4])) {
+        gate_et_now(&end_et);
+    } else {
+        str2et_c(argv[4], &end_et);
+    }
+
+    char *end;
+    SpiceDouble step = strtod(argv[5], &end);
+    if (argv[5] == end || step <= 0) {
+        fail_command("Not a valid step: %s", argv[5]);
+        return;
+    }
+
+    if (end_et <= start_et) {
+        fail_command("The end time must be after the start time");
+        return;
+    }
+
+    char (*station_names)[STATION_NAME_MAX_LEN];
+    gate_station *stations;
+    int stations_len = read_stations(argv[2], &station_names, &stations);
+    if (stations_len <= 0) {
+        if (stations_len == 0) {
+            fail_command("No stations in '%s'", argv[2]);
+        }
+        return;
+    }
+
+    FILE *out = fopen(argv[6], "w");
+    if (out == NULL) {
+        fail_command("Cannot open '%s' for writing", argv[6]);
+        free(station_names);
+        free(stations);
+        return;
+    }
+
+    gate_pool *pool = get_sat_pool();
+    SpiceInt len = sat_store.len;
+    gate_sgp4 *sats = malloc(len * sizeof(*sats));
+    gate_sgp4_status *init_status = malloc(len * sizeof(*init_status));
+    if (pool == NULL || sats == NULL || init_status == NULL) {
+        fail_command("Not enough memory to compute visibility");
+        fclose(out);
+        free(station_names);
+        free(stations);
+        free(sats);
+        free(init_status);
+        return;
+    }
+
+    double start = wall_ms();
+    gate_catalog_init(&sat_store, sats, init_status);
+
+    reset_c();
+    gate_vis_table table;
+    gate_compute_visibility(pool, len, sats, init_status, stations_len, stations, start_et, end_et, step, &table);
+    double compute_ms = wall_ms() - start;
+    if (failed_c()) {
+        fclose(out);
+        free(station_names);
+        free(stations);
+        free(sats);
+        free(init_status);
+        return;
+    }
+
+    // Times are written as seconds from the start to keep
+    // the table compact
+    SpiceChar time_out[TIME_OUT_MAX_LEN];
+    timout_c(start_et, "YYYY-MM-DD HR:MN:SC.#### UTC ::UTC", TIME_OUT_MAX_LEN, time_out);
+    fprintf(out, "# Seconds from %s\n", time_out);
+    fputs("satellite,station,rise,set\n", out);
+    for (SpiceInt i = 0; i < table.len; ++i) {
+        gate_vis_window *window = &table.windows[i];
+        fprintf(out, "%s,%s,%.2f,%.2f\n", sat_store.text[window->sat].id, station_names[window->station],
+                window->rise, window->set);
+    }
+    fclose(out);
+
+    printf("Found %d windows for %d satellites and %d stations in %.1f ms using %d threads\n",
+           table.len, len, stations_len, compute_ms, gate_pool_threads(pool));
+    printf("Wrote windows to '%s'\n", argv[6]);
+
+    gate_vis_table_free(&table);
+    free(station_names);
+    free(stations);
+    free(sats);
+    free(init_status);
+}
+
+/**
+ * Writes the header of a binary ground track file, see
+ * sat().
+ */
+static void write_track_header(FILE *out, SpiceInt len, SpiceInt ets_len, SpiceDouble start_et, SpiceDouble step) {
+    int32_t counts[2] = {len, ets_len};
+    double times[2] = {start_et, step};
+    fwrite(TRACK_MAGIC, 1, sizeof(TRACK_MAGIC) - 1, out);
+    fwrite(counts, sizeof(counts[0]), 2, out);
+    fwrite(times, sizeof(times[0]), 2, out);
+
+    for (gate_sat_handle handle = 0; handle < len; ++handle) {
+        char id[GATE_SAT_ID_MAX_LEN] = {0};
+        strncpy(id, sat_store.text[handle].id, GATE_SAT_ID_MAX_LEN - 1);
+        fwrite(id, 1, GATE_SAT_ID_MAX_LEN, out);
+    }
+}
+
+static void sat_track(char **argv, volatile int *is_running) {
+    if (sat_store.len == 0) {
+        fail_command("No satellites in the database. Try LOAD TLE?");
+        return;
+    }
+
+    SpiceDouble start_et;
+    if (eq_ignore_case("NOW", argv[2])) {
+        gate_et_now(&start_et);
+    } else {
+        str2et_c(argv[2], &start_et);
+    }
+
+    SpiceDouble end_et;
+    if (eq_ignore_case("NOW", argv[3])) {
+        gate_et_now(&end_et);
+    } else {
+        str2et_c(argv[3], &end_et);
+    }
+
+    char *end;
+    SpiceDouble step = strtod(argv[4], &end);
+    if (argv[4] == end || step <= 0) {
+        fail_command("Not a valid step: %s", argv[4]);
+        return;
+    }
+
+    SpiceBoolean footprint = !eq_ignore_case("NONE", argv[5]);
+    SpiceDouble min_elevation = 0;
+    if (footprint) {
+        min_elevation = strtod(argv[5], &end);
+        if (argv[5] == end) {
+            fail_command("Not a valid number: %s", argv[5]);
+            return;
+        }
+    }
+
+    SpiceBoolean is_binary;
+    if (eq_ignore_case("BIN", argv[6])) {
+        is_binary = SPICETRUE;
+    } else if (eq_ignore_case("CSV", argv[6])) {
+        is_binary = SPICEFALSE;
+    } else {
+        fail_command("Unrecognized format: '%s'", argv[6]);
+        return;
+    }
+
+    if (end_et <= start_et) {
+        fail_command("The end time must be after the start time");
+        return;
+    }
+
+    FILE *out = fopen(argv[7], is_binary ? "wb" : "w");
+    if (out == NULL) {
+        fail_command("Cannot open '%s' for writing", argv[7]);
+        return;
+    }
+
+    // The grid is computed in blocks of epochs, each
+    // written out before the next is computed, so that the
+    // memory used does not grow with the length of the span
+    gate_pool *pool = get_sat_pool();
+    SpiceInt len = sat_store.len;
+    SpiceInt ets_len = (SpiceInt) ((end_et - start_et) / step) + 1;
+    gate_sgp4 *sats = malloc(len * sizeof(*sats));
+    gate_sgp4_status *init_status = malloc(len * sizeof(*init_status));
+    gate_ground_point *points = malloc(len * TRACK_BLOCK_EPOCHS * sizeof(*points));
+    gate_sgp4_status *status = malloc(len * TRACK_BLOCK_EPOCHS * sizeof(*status));
+    if (pool == NULL || sats == NULL || init_status == NULL || points == NULL || status == NULL) {
+        fail_command("Not enough memory to compute ground tracks");
+        fclose(out);
+        free(sats);
+        free(init_status);
+        free(points);
+        free(status);
+        return;
+    }
+    gate_catalog_init(&sat_store, sats, init_status);
+
+    SpiceChar time_out[TIME_OUT_MAX_LEN];
+    if (is_binary) {
+        write_track_header(out, len, ets_len, start_et, step);
+    } else {
+        // Times are written as seconds from the start to
+        // keep the file compact
+        timout_c(start_et, "YYYY-MM-DD HR:MN:SC.#### UTC ::UTC", TIME_OUT_MAX_LEN, time_out);
+        fprintf(out, "# Seconds from %s\n", time_out);
+        fputs("satellite,time,latitude,longitude,altitude,footprint\n", out);
+    }
+
+    double start = wall_ms();
+    double compute_ms = 0;
+    SpiceInt written = 0;
+    SpiceInt failed = 0;
+    SpiceBoolean track_failed = SPICEFALSE;
+    for (SpiceInt first = 0; first < ets_len; first += TRACK_BLOCK_EPOCHS) {
+        if (!*is_running) {
+            *is_running = SPICETRUE;
+            puts("Stopped early");
+            break;
+        }
+
+        SpiceInt block_len = ets_len - first < TRACK_BLOCK_EPOCHS ? ets_len - first : TRACK_BLOCK_EPOCHS;
+        SpiceDouble ets[TRACK_BLOCK_EPOCHS];
+        for (SpiceInt j = 0; j < block_len; ++j) {
+            ets[j] = start_et + (first + j) * step;
+        }
+
+        double block_start = wall_ms();
+        reset_c();
+        failed += gate_ground_tracks(pool, len, sats, init_status, block_len, ets, footprint, min_elevation,
+                                     points, status);
+        compute_ms += wall_ms() - block_start;
+        if (failed_c()) {
+            reset_c();
+            track_failed = SPICETRUE;
+            break;
+        }
+
+        // Written epoch by epoch, while the points are laid
+        // out satellite by satellite
+        for (SpiceInt j = 0; j < block_len; ++j) {
+            for (gate_sat_handle handle = 0; handle < len; ++handle) {
+                gate_ground_point *point = &points[handle * block_len + j];
+                gate_sgp4_status point_status = status[handle * block_len + j];
+
+                if (is_binary) {
+                    float values[4] = {NAN, NAN, NAN, NAN};
+                    if (point_status == GATE_SGP4_OK) {
+                        values[0] = (float) point->latitude;
+                        values[1] = (float) point->longitude;
+                        values[2] = (float) point->altitude;
+                        values[3] = (float) point->footprint_radius;
+                    }
+                    fwrite(values, sizeof(values[0]), 4, out);
+                } else if (point_status == GATE_SGP4_OK) {
+                    fprintf(out, "%s,%.1f,%.5f,%.5f,%.3f,%.3f\n", sat_store.text[handle].id, ets[j] - start_et,
+                            point->latitude, point->longitude, point->altitude, point->footprint_radius);
+                }
+            }
+        }
+        written += block_len;
+    }
+
+    // The header promised every epoch, so it is patched to
+    // match the records if the grid was cut short
+    if (is_binary && written != ets_len) {
+        int32_t written_count = written;
+        fseek(out, sizeof(TRACK_MAGIC) - 1 + sizeof(int32_t), SEEK_SET);
+        fwrite(&written_count, sizeof(written_count), 1, out);
+    }
+    fclose(out);
+
+    printf("Computed %d epochs for %d satellites (%d points failed) in %.1f ms (%.1f ms total) using %d threads\n",
+           written, len, failed, compute_ms, wall_ms() - start, gate_pool_threads(pool));
+    if (track_failed) {
+        fail_command("Failed to compute ground tracks, wrote %d of %d epochs to '%s'", written, ets_len, argv[7]);
+    } else {
+        printf("Wrote ground tracks to '%s'\n", argv[7]);
+    }
+
+    free(sats);
+    free(init_status);
+    free(points);
+    free(status);
+}
+
+typedef struct {
+    gate_sat_handle handle;
+    SpiceDouble azimuth;
+    SpiceDouble elevation;
+    gate_illumination illumination;
+} overhead_sat;
+
+static int compare_overhead(const void *a, const void *b) {
+    const overhead_sat *sa = a;
+    const overhead_sat *sb = b;
+    return sa->elevation < sb->elevation ? 1 : sa->elevation > sb->elevation ? -1 : 0;
+}
+
+static void sat_overhead(char **argv, volatile int *is_running) {
+    if (sat_store.len == 0) {
+        fail_command("No satellites in the database. Try LOAD TLE?");
+        return;
+    }
+
+    SpiceBoolean is_cont;
+    SpiceInt count;
+    if (!parse_count(argv[2], &is_cont, &count)) {
+        return;
+    }
+
+    SpiceDouble calc_et;
+    if (eq_ignore_case("NOW", argv[3])) {
+        gate_et_now(&calc_et);
+    } else {
+        str2et_c(argv[3], &calc_et);
+    }
+
+    char *end;
+    SpiceDouble min_elevation = strtod(argv[4], &end);
+    if (argv[4] == end) {
+        fail_command("Not a valid number: %s", argv[4]);
+        return;
+    }
+
+    gate_topo_frame observer_frame;
+    if (!get_observer_frame(&observer_frame)) {
+        return;
+    }
+    gate_station observer = {observer_frame.latitude, observer_frame.longitude, 0, min_elevation};
+
+    gate_pool *pool = get_sat_pool();
+    SpiceInt len = sat_store.len;
+    gate_sgp4 *sats = malloc(len * sizeof(*sats));
+    gate_sgp4_status *init_status = malloc(len * sizeof(*init_status));
+    overhead_sat *overhead = malloc(len * sizeof(*overhead));
+    SpiceDouble (*overhead_states)[6] = malloc(len * sizeof(*overhead_states));
+    gate_illumination *illumination = malloc(len * sizeof(*illumination));
+    if (pool == NULL || sats == NULL || init_status == NULL || overhead == NULL || overhead_states == NULL ||
+        illumination == NULL) {
+        fail_command("Not enough memory to find satellites overhead");
+        free(sats);
+        free(init_status);
+        free(overhead);
+        free(overhead_states);
+        free(illumination);
+        return;
+    }
+    gate_catalog_init(&sat_store, sats, init_status);
+
+    SpiceDouble sun[3];
+    SpiceBoolean has_sun = find_sun(calc_et, sun);
+
+    if (sat_cache.entries != NULL) {
+        puts("Using the ephemeris cache from SAT CACHE");
+    }
+
+    // The filter is rebuilt whenever the time moves past
+    // the span that it was built for
+    gate_sky_filter filter = {0};
+
+    SpiceDouble loop_start_et;
+    gate_et_now(&loop_start_et);
+
+    int rounds = 0;
+    while (SPICETRUE) {
+        SpiceChar calc_time_out[TIME_OUT_MAX_LEN];
+        timout_c(calc_et, "YYYY-MM-DD HR:MN:SC.#### UTC ::UTC", TIME_OUT_MAX_LEN, calc_time_out);
+
+        printf("%s:\n", calc_time_out);
+
+        double start = wall_ms();
+        if (!gate_sky_filter_covers(&filter, calc_et)) {
+            gate_sky_filter_free(&filter);
+
+            reset_c();
+            gate_sky_filter_build(pool, len, sats, init_status, &observer, calc_et,
+                                  calc_et + OVERHEAD_FILTER_SPAN_SEC, &filter);
+            if (failed_c()) {
+                break;
+            }
+        }
+        double filter_ms = wall_ms() - start;
+
+        start = wall_ms();
+        SpiceDouble frame_transform_matrix[3][3];
+        pxform_c("J2000", observer_frame.frame_name, calc_et, frame_transform_matrix);
+
+        SpiceInt overhead_len = 0;
+        SpiceInt failed = 0;
+        for (SpiceInt k = 0; k < filter.len; ++k) {
+            gate_sat_handle handle = filter.candidates[k];
+
+            SpiceDouble cur_rec_j2000[6];
+            gate_sgp4_status status = sat_cache.entries != NULL
+                                      ? gate_eph_cache_state(&sat_cache, handle, calc_et, cur_rec_j2000)
+                                      : gate_sgp4_propagate(&sats[handle], calc_et, cur_rec_j2000);
+            if (status != GATE_SGP4_OK) {
+                failed++;
+                continue;
+            }
+
+            SpiceDouble rec[3];
+            mxv_c(frame_transform_matrix, cur_rec_j2000, rec);
+            gate_adjust_topo_rec(observer_frame, rec);
+
+            overhead_sat *sat = &overhead[overhead_len];
+            gate_conv_rec_azel(rec, NULL, &sat->azimuth, &sat->elevation);
+            if (sat->elevation >= min_elevation) {
+                sat->handle = handle;
+                memcpy(overhead_states[overhead_len], cur_rec_j2000, sizeof(cur_rec_j2000));
+                overhead_len++;
+            }
+        }
+        double propagate_ms = wall_ms() - start;
+
+        // One Sun position shared by every satellite
+        if (has_sun) {
+            gate_sun_position(calc_et, sun);
+            gate_illumination_batch(overhead_len, (ConstSpiceDouble (*)[6]) overhead_states, NULL, sun,
+                                    illumination);
+            for (SpiceInt i = 0; i < overhead_len; ++i) {
+                overhead[i].illumination = illumination[i];
+            }
+        }
+
+        qsort(overhead, overhead_len, sizeof(*overhead), compare_overhead);
+        for (SpiceInt i = 0; i < overhead_len; ++i) {
+            gate_sat_text *text = &sat_store.text[overhead[i].handle];
+            printf("    %s (%s): Azimuth=%f Elevation=%f%s%s\n", text->id, text->name, overhead[i].azimuth,
+                   overhead[i].elevation, has_sun ? " Illumination=" : "",
+                   has_sun ? gate_illumination_string(overhead[i].illumination) : "");
+        }
+
+        printf("%d satellites overhead, %d of %d propagated after prefiltering (%d by elements) in %.3f ms, "
+               "filter %.3f ms\n", overhead_len, filter.len, len, filter.static_len, propagate_ms, filter_ms);
+        if (failed > 0) {
+            printf("%d satellites failed to propagate\n", failed);
+        }
+
+        if (!is_cont) {
+            rounds++;
+            if (rounds == count) {
+                break;
+            }
+        } else {
+            if (!*is_running) {
+                *is_running = SPICETRUE;
+                break;
+            }
+        }
+
+        puts("");
+        sleep(1);
+
+        SpiceDouble current_et;
+        gate_et_now(&current_et);
+
+        SpiceDouble elapsed = current_et - loop_start_et;
+        loop_start_et = current_et;
+
+        calc_et += elapsed;
+    }
+
+    gate_sky_filter_free(&filter);
+    free(sats);
+    free(init_status);
+    free(overhead);
+    free(overhead_states);
+    free(illumination);
+}
+
+typedef struct {
+    volatile int *is_running;
+    SpiceInt printed;
+} conjunction_printer;
+
+static SpiceBoolean print_conjunctions(void *user_data, SpiceInt len, const gate_conjunction *conjunctions) {
+    conjunction_printer *printer = user_data;
+    for (SpiceInt i = 0; i < len; ++i) {
+        const gate_conjunction *conjunction = &conjunctions[i];
+
+        SpiceChar time_out[TIME_OUT_MAX_LEN];
+        timout_c(conjunction->tca, "YYYY-MM-DD HR:MN:SC.#### UTC ::UTC", TIME_OUT_MAX_LEN, time_out);
+        printf("%s: %s - %s Miss=%f km RelativeSpeed=%f km/s\n", time_out, sat_store.text[conjunction->sat_a].id,
+               sat_store.text[conjunction->sat_b].id, conjunction->miss_distance, conjunction->relative_speed);
+    }
+    printer->printed += len;
+    fflush(stdout);
+
+    if (!*printer->is_running) {
+        *printer->is_running = SPICETRUE;
+        puts("Stopping the screening");
+        return SPICEFALSE;
+    }
+    return SPICETRUE;
+}
+
+static void sat_conjunctions(char **argv, volatile int *is_running) {
+    if (sat_store.len == 0) {
+        fail_command("No satellites in the database. Try LOAD TLE?");
+        return;
+    }
+
+    SpiceDouble start_et;
+    if (eq_ignore_case("NOW", argv[2])) {
+        gate_et_now(&start_et);
+    } else {
+        str2et_c(argv[2], &start_et);
+    }
+
+    SpiceDouble end_et;
+    if (eq_ignore_case("NOW", argv[3])) {
+        gate_et_now(&end_et);
+    } else {
+        str2et_c(argv[3], &end_et);
+    }
+
+    char *end;
+    SpiceDouble step = strtod(argv[4], &end);
+    if (argv[4] == end || step <= 0) {
+        fail_command("Not a valid step: %s", argv[4]);
+        return;
+    }
+
+    SpiceDouble threshold = strtod(argv[5], &end);
+    if (argv[5] == end || threshold <= 0) {
+        fail_command("Not a valid distance: %s", argv[5]);
+        return;
+    }
+
+    if (end_et <= start_et) {
+        fail_command("The end time must be after the start time");
+        return;
+    }
+
+    gate_pool *pool = get_sat_pool();
+    SpiceInt len = sat_store.len;
+    gate_sgp4 *sats = malloc(len * sizeof(*sats));
+    gate_sgp4_status *init_status = malloc(len * sizeof(*init_status));
+    if (pool == NULL || sats == NULL || init_status == NULL) {
+        fail_command("Not enough memory to screen for conjunctions");
+        free(sats);
+        free(init_status);
+        return;
+    }
+    gate_catalog_init(&sat_store, sats, init_status);
+
+    printf("Screening %d satellites for approaches within %f km\n\n", len, threshold);
+
+    double start = wall_ms();
+    conjunction_printer printer = {is_running, 0};
+    gate_conjunction_stats stats;
+    reset_c();
+    gate_screen_conjunctions(pool, len, sats, init_status, start_et, end_et, step, threshold, print_conjunctions,
+                             &printer, &stats);
+    double screen_ms = wall_ms() - start;
+    if (!failed_c()) {
+        printf("\nFound %d conjunctions over %d steps in %.1f ms using %d threads\n", printer.printed, stats.steps,
+               screen_ms, gate_pool_threads(pool));
+        printf("Compared %.0f pairs by distance and refined %d\n", stats.pairs, stats.candidates);
+    }
+
+    free(sats);
+    free(init_status);
+}
+
+static void sat_cache_build(char **argv) {
+    if (sat_store.len == 0) {
+        fail_command("No satellites in the database. Try LOAD TLE?");
+        return;
+    }
+
+    SpiceDouble start_et;
+    if (eq_ignore_case("NOW", argv[2])) {
+        gate_et_now(&start_et);
+    } else {
+        str2et_c(argv[2], &start_et);
+    }
+
+    SpiceDouble end_et;
+    if (eq_ignore_case("NOW", argv[3])) {
+        gate_et_now(&end_et);
+    } else {
+        str2et_c(argv[3], &end_et);
+    }
+
+    char *end;
+    SpiceDouble tolerance = strtod(argv[4], &end);
+    if (argv[4] == end || tolerance <= 0) {
+        fail_command("Not a valid tolerance: %s", argv[4]);
+        return;
+    }
+
+    SpiceDouble budget_mb = strtod(argv[5], &end);
+    if (argv[5] == end || budget_mb <= 0) {
+        fail_command("Not a valid memory budget: %s", argv[5]);
+        return;
+    }
+
+    if (end_et <= start_et) {
+        fail_command("The end time must be after the start time");
+        return;
+    }
+
+    clear_sat_cache();
+
+    gate_pool *pool = get_sat_pool();
+    SpiceInt len = sat_store.len;
+    sat_cache_sats = malloc(len * sizeof(*sat_cache_sats));
+    sat_cache_init_status = malloc(len * sizeof(*sat_cache_init_status));
+    if (pool == NULL || sat_cache_sats == NULL || sat_cache_init_status == NULL) {
+        fail_command("Not enough memory to build the cache");
+        clear_sat_cache();
+        return;
+    }
+    gate_catalog_init(&sat_store, sat_cache_sats, sat_cache_init_status);
+
+    double start = wall_ms();
+    reset_c();
+    gate_eph_cache_build(pool, len, sat_cache_sats, sat_cache_init_status, start_et, end_et, tolerance,
+                         (size_t) (budget_mb * 1024 * 1024), &sat_cache);
+    double build_ms = wall_ms() - start;
+    if (failed_c()) {
+        clear_sat_cache();
+        return;
+    }
+
+    printf("Cached %d of %d satellites in %.2f MB in %.1f ms using %d threads\n", sat_cache.cached_len, len,
+           sat_cache.bytes / (1024.0 * 1024.0), build_ms, gate_pool_threads(pool));
+    if (sat_cache.cached_len == 0) {
+        return;
+    }
+
+    // Compare the cache against propagation at times spread
+    // over the span, one satellite after another
+    SpiceDouble span = end_et - start_et;
+    SpiceDouble max_error = 0;
+    SpiceInt samples = 0;
+    double cache_ms = 0;
+    double propagate_ms = 0;
+    for (gate_sat_handle handle = 0; handle < len && samples < CACHE_BENCH_SAMPLES; ++handle) {
+        if (sat_cache.entries[handle].segments == 0) {
+            continue;
+        }
+
+        SpiceDouble cached[CACHE_BENCH_STEPS][6];
+        SpiceDouble propagated[CACHE_BENCH_STEPS][6];
+        start = wall_ms();
+        for (int i = 0; i < CACHE_BENCH_STEPS; ++i) {
+            gate_eph_cache_state(&sat_cache, handle, start_et + span * i / CACHE_BENCH_STEPS, cached[i]);
+        }
+        cache_ms += wall_ms() - start;
+
+        start = wall_ms();
+        for (int i = 0; i < CACHE_BENCH_STEPS; ++i) {
+            gate_sgp4_propagate(&sat_cache_sats[handle], start_et + span * i / CACHE_BENCH_STEPS, propagated[i]);
+        }
+        propagate_ms += wall_ms() - start;
+
+        for (int i = 0; i < CACHE_BENCH_STEPS; ++i) {
+            SpiceDouble error = vdist_c(cached[i], propagated[i]);
+            if (error > max_error) {
+                max_error = error;
+            }
+        }
+        samples += CACHE_BENCH_STEPS;
+    }
+
+    printf("Cache lookup %.1f ns, propagation %.1f ns over %d samples, largest difference %f km\n",
+           cache_ms * 1e6 / samples, propagate_ms * 1e6 / samples, samples, max_error);
+}
+
+static void sat_cache_command(int argc, char **argv) {
+    if (argc == 3 && eq_ignore_case("CLEAR", argv[2])) {
+        clear_sat_cache();
+        puts("Cleared the ephemeris cache");
+        return;
+    }
+
+    if (argc != 6) {
+        fail_command("This command requires 4 arguments");
+        return;
+    }
+    sat_cache_build(argv);
+}
+
+static void sat_prop(char *time) {
+    if (sat_store.len == 0) {
+        fail_command("No satellites in the database. Try LOAD TLE?");
+        return;
+    }
+
+    SpiceDouble et;
+    if (eq_ignore_case("NOW", time)) {
+        gate_et_now(&et);
+    } else {
+        str2et_c(time, &et);
+    }
+
+    gate_pool *pool = get_sat_pool();
+    if (pool == NULL) {
+        return;
+    }
+
+    SpiceInt len = sat_store.len;
+    gate_sgp4 *sats = malloc(len * sizeof(*sats));
+    gate_sgp4_status *init_status = malloc(len * sizeof(*init_status));
+    gate_sgp4_status *status = malloc(len * sizeof(*status));
+    SpiceDouble (*states)[6] = malloc(len * sizeof(*states));
+    gate_sgp4_status *batch_status = malloc(len * sizeof(*batch_status));
+    SpiceDouble (*batch_states)[6] = malloc(len * sizeof(*batch_states));
+    if (sats == NULL || init_status == NULL || status == NULL || states == NULL ||
+        batch_status == NULL || batch_states == NULL) {
+        fail_command("Not enough memory to propagate the catalog");
+        free(sats);
+        free(init_status);
+        free(status);
+        free(states);
+        free(batch_status);
+        free(batch_states);
+        return;
+    }
+
+    double start = wall_ms();
+    SpiceInt init_failed = gate_catalog_init(&sat_store, sats, init_status);
+    double init_ms = wall_ms() - start;
+
+    start = wall_ms();
+    SpiceInt failed = gate_catalog_propagate(pool, len, sats, init_status, et, states, status);
+    double prop_ms = wall_ms() - start;
+
+    reset_c();
+    gate_sgp4_batch batch;
+    gate_sgp4_batch_init(len, sats, init_status, &batch);
+    if (failed_c()) {
+        free(sats);
+        free(init_status);
+        free(status);
+        free(states);
+        free(batch_status);
+        free(batch_states);
+        return;
+    }
+
+    start = wall_ms();
+    gate_catalog_propagate_batch(pool, len, sats, init_status, &batch, et, batch_states, batch_status);
+    double batch_ms = wall_ms() - start;
+
+    SpiceDouble max_diff = 0;
+    for (gate_sat_handle handle = 0; handle < len; ++handle) {
+        if (status[handle] == GATE_SGP4_OK && batch_status[handle] == GATE_SGP4_OK) {
+            SpiceDouble diff = vdist_c(states[handle], batch_states[handle]);
+            if (diff > max_diff) {
+                max_diff = diff;
+            }
+        }
+    }
+
+    SpiceChar time_out[TIME_OUT_MAX_LEN];
+    timout_c(et, "YYYY-MM-DD HR:MN:SC.#### UTC ::UTC", TIME_OUT_MAX_LEN, time_out);
+    printf("Propagated %d satellites to %s using %d threads\n", len, time_out, gate_pool_threads(pool));
+    printf("Initialized in %.1f ms, propagated in %.1f ms (%.2f us per satellite)\n",
+           init_ms, prop_ms, prop_ms * 1000 / len);
+    printf("Batched %d near-Earth and %d deep space satellites, propagated in %.1f ms (%.2f us per satellite)\n",
+           batch.near_len, batch.deep_len, batch_ms, batch_ms * 1000 / len);
+    printf("Largest difference between batched and single propagation: %.3e km %s\n", max_diff,
+           max_diff > GATE_SGP4_BATCH_TOLERANCE ? "EXCEEDS TOLERANCE" : "OK");
+    if (failed > 0) {
+        printf("%d satellites could not be propagated (%d at initialization):\n", failed, init_failed);
+        for (gate_sat_handle handle = 0; handle < len; ++handle) {
+            if (status[handle] != GATE_SGP4_OK) {
+                printf("    %s: %s\n", sat_store.text[handle].id, gate_sgp4_status_string(status[handle]));
+            }
+        }
+    }
+
+    gate_sgp4_batch_free(&batch);
+    free(sats);
+    free(init_status);
+    free(status);
+    free(states);
+    free(batch_status);
+    free(batch_states);
+}
+
+/**
+ * Propagates the first count satellites in the database
+ * side by side over steps epochs, as when tracking them,
+ * once by calling ev2lin_() and dpspce_() in turn and once
+ * with a gate_sat_propagator per satellite.
+ */
+static void sat_bench(char *count_arg, char *steps_arg) {
+    char *end;
+    SpiceInt count = strtol(count_arg, &end, 10);
+    if (count_arg == end || count <= 0) {
+        fail_command("Not a valid number: %s", count_arg);
+        return;
+    }
+
+    SpiceInt steps = strtol(steps_arg, &end, 10);
+    if (steps_arg == end || steps <= 0) {
+        fail_command("Not a valid number: %s", steps_arg);
+        return;
+    }
+
+    if (count > sat_store.len) {
+        count = sat_store.len;
+    }
+    if (count == 0) {
+        fail_command("No satellites in the database. Try LOAD TLE?");
+        return;
+    }
+
+    SpiceDouble (*elements)[GATE_TLE_ELEMENTS_LEN] = malloc(count * sizeof(*elements));
+    gate_sat_propagator *propagators = malloc(count * sizeof(*propagators));
+    if (elements == NULL || propagators == NULL) {
+        fail_command("Not enough memory to run the benchmark");
+        free(elements);
+        free(propagators);
+        return;
+    }
+
+    SpiceInt deep_space = 0;
+    for (gate_sat_handle handle = 0; handle < count; ++handle) {
+        gate_sat_store_get_elements(&sat_store, handle, elements[handle]);
+        if (sat_store.is_deep_space[handle]) {
+            deep_space++;
+        }
+    }
+
+    SpiceDouble start_et;
+    gate_et_now(&start_et);
+
+    // The SPICE propagators see a different element set on
+    // every call, so each call repeats the initialization
+    reset_c();
+    double start = wall_ms();
+    for (SpiceInt step = 0; step < steps && !failed_c(); ++step) {
+        SpiceDouble et = start_et + step * BENCH_STEP_SEC;
+        for (gate_sat_handle handle = 0; handle < count; ++handle) {
+            SpiceDouble state[6];
+            if (!sat_store.is_deep_space[handle]) {
+                ev2lin_(&et, GEO_CONSTANTS, elements[handle], state);
+            } else {
+                dpspce_(&et, GEO_CONSTANTS, elements[handle], state);
+            }
+        }
+    }
+    double spice_ms = wall_ms() - start;
+    if (failed_c()) {
+        reset_c();
+        fail_command("The SPICE propagators failed, remove the offending satellite and try again");
+        free(elements);
+        free(propagators);
+        return;
+    }
+
+    start = wall_ms();
+    for (gate_sat_handle handle = 0; handle < count; ++handle) {
+        gate_sat_propagator_init(&sat_store, handle, &propagators[handle]);
+    }
+    double init_ms = wall_ms() - start;
+
+    start = wall_ms();
+    for (SpiceInt step = 0; step < steps; ++step) {
+        SpiceDouble et = start_et + step * BENCH_STEP_SEC;
+        for (gate_sat_handle handle = 0; handle < count; ++handle) {
+            SpiceDouble state[6];
+            gate_sat_propagate(&propagators[handle], et, state);
+        }
+    }
+    double native_ms = wall_ms() - start;
+
+    SpiceInt calls = count * steps;
+    printf("Interleaved %d satellites (%d deep space) over %d steps of %d seconds\n",
+           count, deep_space, steps, BENCH_STEP_SEC);
+    printf("ev2lin/dpspce: %.1f ms (%.2f us per call)\n", spice_ms, spice_ms * 1000 / calls);
+    printf("gate_sat_propagator: %.1f ms to initialize, %.1f ms (%.2f us per call) to propagate\n",
+           init_ms, native_ms, native_ms * 1000 / calls);
+    printf("Speedup: %.1fx\n", spice_ms / (init_ms + native_ms));
+
+    free(elements);
+    free(propagators);
+}
+
+/**
+ * Finds the largest position difference between the native
+ * propagator and the SPICE propagators for a satellite
+ * over a span of time around its epoch.
+ *
+ * @return the status of the native propagator, in which
+ * case max_diff is only valid if it is GATE_SGP4_OK
+ */
+static gate_sgp4_status verify_sat(gate_sat_handle handle, SpiceDouble *max_diff) {
+    SpiceDouble elements[GATE_TLE_ELEMENTS_LEN];
+    gate_sat_store_get_elements(&sat_store, handle, elements);
+    SpiceBoolean is_deep_space = sat_store.is_deep_space[handle];
+
+    gate_sgp4 sat;
+    gate_sgp4_status status = gate_sgp4_init(elements, &sat);
+    if (status != GATE_SGP4_OK) {
+        return status;
+    }
+
+    *max_diff = 0;
+    for (int min = -VERIFY_SPAN_MIN; min <= VERIFY_SPAN_MIN; min += VERIFY_STEP_MIN) {
+        SpiceDouble et = elements[GATE_TLE_EPOCH] + min * 60.0;
+
+        SpiceDouble native[6];
+        status = gate_sgp4_propagate(&sat, et, native);
+        if (status != GATE_SGP4_OK) {
+            return status;
+        }
+
+        SpiceDouble expected[6];
+        if (!is_deep_space) {
+            ev2lin_(&et, GEO_CONSTANTS, elements, expected);
+        } else {
+            dpspce_(&et, GEO_CONSTANTS, elements, expected);
+        }
+
+        SpiceDouble diff = vdist_c(native, expected);
+        if (diff > *max_diff) {
+            *max_diff = diff;
+        }
+    }
+
+    return GATE_SGP4_OK;
+}
+
+static void sat_verify(char *arg) {
+    gate_sat_handle first = 0;
+    gate_sat_handle last = sat_store.len - 1;
+    if (!eq_ignore_case("ALL", arg)) {
+        first = last = gate_sat_store_find(&sat_store, arg);
+        if (first == -1) {
+            fail_command("No satellite with ID '%s'. Try SAT ADD?", arg);
+            return;
+        }
+    }
+
+    printf("Comparing native SGP4/SDP4 against ev2lin/dpspce within %d minutes of each epoch\n",
+           VERIFY_SPAN_MIN);
+    printf("Tolerance: %.3f km near-Earth, %.3f km deep space\n\n",
+           GATE_SGP4_NEAR_EARTH_TOLERANCE, GATE_SGP4_DEEP_SPACE_TOLERANCE);
+
+    int checked = 0;
+    int exceeded = 0;
+    int errors = 0;
+    SpiceDouble worst = 0;
+    for (gate_sat_handle handle = first; handle <= last; ++handle) {
+        gate_sat_text *text = &sat_store.text[handle];
+        SpiceBoolean is_deep_space = sat_store.is_deep_space[handle];
+
+        // The SPICE propagators signal errors for elements
+        // that they cannot handle, which have already been
+        // reported by the time they are detected here
+        reset_c();
+        SpiceDouble max_diff;
+        gate_sgp4_status status = verify_sat(handle, &max_diff);
+        if (failed_c()) {
+            reset_c();
+            errors++;
+            continue;
+        }
+
+        if (status != GATE_SGP4_OK) {
+            printf("%s: %s\n", text->id, gate_sgp4_status_string(status));
+            errors++;
+            continue;
+        }
+
+        checked++;
+        if (max_diff > worst) {
+            worst = max_diff;
+        }
+
+        SpiceDouble tolerance = is_deep_space ? GATE_SGP4_DEEP_SPACE_TOLERANCE : GATE_SGP4_NEAR_EARTH_TOLERANCE;
+        if (max_diff > tolerance) {
+            exceeded++;
+        }
+
+        if (first == last || max_diff > tolerance) {
+            printf("%s (%s): max difference %.6f km %s\n", text->id, is_deep_space ? "deep space" : "near-Earth",
+                   max_diff, max_diff > tolerance ? "EXCEEDS TOLERANCE" : "OK");
+        }
+    }
+
+    printf("\nChecked %d satellites, %d exceeded tolerance, %d could not be propagated, worst %.6f km\n",
+           checked, exceeded, errors, worst);
+}
+
+void sat(int argc, char **argv, volatile int *is_running) {
+    if (argc < 2) {
+        fail_command("This command requires at least 1 argument");
+        return;
+    }
+
+    if (eq_ignore_case("ADD", argv[1])) {
+        if (argc != 3) {
+            fail_command("This command requires 1 argument");
+            return;
+        }
+        return sat_add(argv[2]);
+    }
+
+    if (eq_ignore_case("REM", argv[1])) {
+        if (argc != 3) {
+            fail_command("This command requires 1 argument");
+            return;
+        }
+        return sat_rem(argv[2]);
+    }
+
+    if (eq_ignore_case("INFO", argv[1])) {
+        if (argc != 3) {
+            fail_command("This command requires 1 argument");
+            return;
+        }
+        return sat_info(argv[2]);
+    }
+
+    if (eq_ignore_case("HISTORY", argv[1])) {
+        if (argc != 4) {
+            fail_command("This command requires 2 arguments");
+            return;
+        }
+        return sat_history_info(argv);
+    }
+
+    if (eq_ignore_case("AZEL", argv[1])) {
+        if (argc != 5) {
+            fail_command("This command requires 3 arguments");
+            return;
+        }
+        return sat_azel(argv, is_running);
+    }
+
+    if (eq_ignore_case("PASSES", argv[1])) {
+        if (argc != 6) {
+            fail_command("This command requires 4 arguments");
+            return;
+        }
+        return sat_passes(argv);
+    }
+
+    if (eq_ignore_case("OVERHEAD", argv[1])) {
+        if (argc != 5) {
+            fail_command("This command requires 3 arguments");
+            return;
+        }
+        return sat_overhead(argv, is_running);
+    }
+
+    if (eq_ignore_case("CONJUNCTIONS", argv[1])) {
+        if (argc != 6) {
+            fail_command("This command requires 4 arguments");
+            return;
+        }
+        return sat_conjunctions(argv, is_running);
+    }
+
+    if (eq_ignore_case("VISIBILITY", argv[1])) {
+        if (argc != 7) {
+            fail_command("This command requires 5 arguments");
+            return;
+        }
+        return sat_visibility(argv);
+    }
+
+    if (eq_ignore_case("TRACK", argv[1])) {
+        if (argc != 8) {
+            fail_command("This command requires 6 arguments");
+            return;
+        }
+        return sat_track(argv, is_running);
+    }
+
+    if (eq_ignore_case("CACHE", argv[1])) {
+        return sat_cache_command(argc, argv);
+    }
+
+    if (eq_ignore_case("PROP", argv[1])) {
+        if (argc != 3) {
+            fail_command("This command requires 1 argument");
+            return;
+        }
+        return sat_prop(argv[2]);
+    }
+
+    if (eq_ignore_case("VERIFY", argv[1])) {
+        if (argc != 3) {
+            fail_command("This command requires 1 argument");
+            return;
+        }
+        return sat_verify(argv[2]);
+    }
+
+    if (eq_ignore_case("BENCH", argv[1])) {
+        if (argc != 4) {
+            fail_command("This command requires 2 arguments");
+            return;
+        }
+        return sat_bench(argv[2], argv[3]);
+    }
+
+    fail_command("Unrecognized option: '%s'", argv[1]);
+}
+
+static void calc_add(int argc, char **argv) {
+    if (gatecli_calc_store_find(&calc_store, argv[2]) != -1) {
+        printf("WARNING: Replacing existing data entry '%s'\n", argv[2]);
+    }
+
+    char *end;
+    double r;
+    double ra;
+    double dec;
+    double ra_pm = 0;
+    double dec_pm = 0;
+    if (argc >= 6) {
+        r = strtod(argv[3], &end);
+        if (end == argv[3]) {
+            fail_command("Range '%s' is not a number", argv[3]);
+            return;
+        }
+
+        ra = strtod(argv[4], &end);
+        if (end == argv[4]) {
+            fail_command("Right ascension '%s' is not a number", argv[4]);
+            return;
+        }
+
+        dec = strtod(argv[5], &end);
+        if (end == argv[5]) {
+            fail_command("Declination '%s' is not a number", argv[5]);
+            return;
+        }
+    } else {
+        fail_command("Unrecognized command format");
+        return;
+    }
+
+    if (argc == 8) {
+        ra_pm = strtod(argv[6], &end);
+        if (end == argv[6]) {
+            fail_command("Right ascension '%s' is not a number", argv[6]);
+            return;
+        }
+
+        dec_pm = strtod(argv[7], &end);
+        if (end == argv[7]) {
+            fail_command("Declination '%s' is not a number", argv[7]);
+            return;
+        }
+    } else if (argc != 6) {
+        fail_command("Unrecognized command format");
+        return;
+    }
+
+    calc_data calc = {
+            .ra = ra,
+            .dec = dec,
+            .r = r,
+            .ra_pm = ra_pm,
+            .dec_pm = dec_pm
+    };
+    if (gatecli_calc_store_put(&calc_store, argv[2], calc, NULL) == -1) {
+        fail_command("Not enough memory to add the custom object");
+        return;
+    }
+
+    printf("Added '%s' to the custom object database\n", argv[2]);
+}
+
+static void calc_rem(char *arg) {
+    if (gatecli_calc_store_rem(&calc_store, arg)) {
+        printf("Successfully removed custom object '%s'\n", arg);
+    } else {
+        fail_command("No object in database called '%s'", arg);
+    }
+}
+
+static void calc_info(char *arg) {
+    int handle = gatecli_calc_store_find(&calc_store, arg);
+    if (handle == -1) {
+        fail_command("No object in database called '%s'", arg);
+        return;
+    }
+    calc_data data = gatecli_calc_store_get(&calc_store, handle);
+
+    printf("ID: %s\n"
+           "Range: %f units\n"
+           "Right ascension: %f deg\n"
+           "Declination: %f deg\n"
+           "Right ascension proper motion: %f deg/yr\n"
+           "Declination proper motion: %f deg/yr\n",
+           arg, data.r, data.ra, data.dec, data.ra_pm, data.dec_pm);
+}
+
+void calc_cur_pos(calc_data data, SpiceDouble et, SpiceDouble *ra, SpiceDouble *dec) {
+    SpiceDouble dt = et / jyear_c();
+
+    if (ra != NULL) {
+        *ra = data.ra + (dt * data.ra_pm);
+    }
+
+    if (dec != NULL) {
+        *dec = data.dec + (dt * data.dec_pm);
+    }
+}
+
+static void calc_azel(char **argv, volatile int *is_running) {
+    int handle = gatecli_calc_store_find(&calc_store, argv[2]);
+    if (handle == -1) {
+        fail_command("No custom body with ID '%s'. Try CALC ADD?", argv[2]);
+        return;
+    }
+    calc_data body = gatecli_calc_store_get(&calc_store, handle);
+
+    SpiceBoolean is_cont;
+    SpiceInt count;
+    if (!parse_count(argv[3], &is_cont, &count)) {
+        return;
+    }
+
+    SpiceDouble calc_et;
+    if (eq_ignore_case("NOW", argv[4])) {
+        gate_et_now(&calc_et);
+    } else {
+        str2et_c(argv[4], &calc_et);
+    }
+
+    gate_topo_frame observer_frame;
+    if (!get_observer_frame(&observer_frame)) {
+        return;
+    }
+
+    printf("Printing azimuth/elevation for custom ID '%s' (%s)\n\n", argv[2], argv[2]);
+
+    SpiceDouble loop_start_et;
+    gate_et_now(&loop_start_et);
+
+    int rounds = 0;
+    while (SPICETRUE) {
+        SpiceChar calc_time_out[TIME_OUT_MAX_LEN];
+        timout_c(calc_et, "YYYY-MM-DD HR:MN:SC.#### UTC ::UTC", TIME_OUT_MAX_LEN, calc_time_out);
+
+        printf("%s:\n", calc_time_out);
+
+        SpiceDouble ra;
+        SpiceDouble dec;
+        calc_cur_pos(body, calc_et, &ra, &dec);
+
+        SpiceDouble cur_rec_j2000[3];
+        SpiceDouble ra_rad = ra * rpd_c();
+        SpiceDouble dec_rad = dec * rpd_c();
+        radrec_c(body.r, ra_rad, dec_rad, cur_rec_j2000);
+
+        SpiceDouble frame_transform_matrix[3][3];
+        pxform_c("J2000", observer_frame.frame_name, calc_et, frame_transform_matrix);
+
+        SpiceDouble rec[3];
+        mxv_c(frame_transform_matrix, cur_rec_j2000, rec);
+        gate_adjust_topo_rec(observer_frame, rec);
+
+        SpiceDouble azimuth;
+        SpiceDouble elevation;
+        gate_conv_rec_azel(rec, NULL, &azimuth, &elevation);
+        printf("Azimuth=%f Elevation=%f\n", azimuth, elevation);
+
+        if (!is_cont) {
+            rounds++;
+            if (rounds == count) {
+                break;
+            }
+        } else {
+            if (!*is_running) {
+                *is_running = SPICETRUE;
+                break;
+            }
+        }
+
+        puts("");
+        sleep(1);
+
+        SpiceDouble current_et;
+        gate_et_now(&current_et);
+
+        SpiceDouble elapsed = current_et - loop_start_et;
+        loop_start_et = current_et;
+
+        calc_et += elapsed;
+    }
+}
+
+/**
+ * Prints the azimuth and elevation of every custom object,
+ * evaluating them all at once with one frame transform per
+ * epoch.
+ */
+static void calc_azel_all(char **argv, volatile int *is_running) {
+    if (calc_store.len == 0) {
+        fail_command("No custom objects added. Try CALC ADD or LOAD CALC?");
+        return;
+    }
+
+    SpiceBoolean is_cont;
+    SpiceInt count;
+    if (!parse_count(argv[3], &is_cont, &count)) {
+        return;
+    }
+
+    SpiceDouble calc_et;
+    if (eq_ignore_case("NOW", argv[4])) {
+        gate_et_now(&calc_et);
+    } else {
+        str2et_c(argv[4], &calc_et);
+    }
+
+    gate_topo_frame observer_frame;
+    if (!get_observer_frame(&observer_frame)) {
+        return;
+    }
+
+    SpiceDouble *azimuths = malloc(calc_store.len * sizeof(*azimuths));
+    SpiceDouble *elevations = malloc(calc_store.len * sizeof(*elevations));
+    if (azimuths == NULL || elevations == NULL) {
+        fail_command("Not enough memory to evaluate the custom objects");
+        free(azimuths);
+        free(elevations);
+        return;
+    }
+
+    printf("Printing azimuth/elevation for %d custom objects\n\n", calc_store.len);
+
+    SpiceDouble loop_start_et;
+    gate_et_now(&loop_start_et);
+
+    int rounds = 0;
+    while (SPICETRUE) {
+        SpiceChar calc_time_out[TIME_OUT_MAX_LEN];
+        timout_c(calc_et, "YYYY-MM-DD HR:MN:SC.#### UTC ::UTC", TIME_OUT_MAX_LEN, calc_time_out);
+
+        printf("%s:\n", calc_time_out);
+
+        double start = wall_ms();
+        SpiceDouble frame_transform_matrix[3][3];
+        pxform_c("J2000", observer_frame.frame_name, calc_et, frame_transform_matrix);
+        gatecli_calc_store_azel(&calc_store, calc_et, frame_transform_matrix, observer_frame.radius, azimuths,
+                                elevations);
+        double elapsed_ms = wall_ms() - start;
+
+        for (int i = 0; i < calc_store.len; ++i) {
+            printf("%s: Azimuth=%f Elevation=%f\n", calc_store.ids[i], azimuths[i], elevations[i]);
+        }
+        printf("Evaluated %d objects in %.3f ms\n", calc_store.len, elapsed_ms);
+
+        if (!is_cont) {
+            rounds++;
+            if (rounds == count) {
+                break;
+            }
+        } else {
+            if (!*is_running) {
+                *is_running = SPICETRUE;
+                break;
+            }
+        }
+
+        puts("");
+        sleep(1);
+
+        SpiceDouble current_et;
+        gate_et_now(&current_et);
+
+        SpiceDouble elapsed = current_et - loop_start_et;
+        loop_start_et = current_et;
+
+        calc_et += elapsed;
+    }
+
+    free(azimuths);
+    free(elevations);
+}
+
+
+typedef struct {
+    gate_topo_frame observer;
+    calc_data data;
+} calc_event_target;
+
+static void calc_radec(void *user_data, SpiceDouble et, SpiceDouble *ra, SpiceDouble *dec) {
+    calc_cur_pos(*(calc_data *) user_data, et, ra, dec);
+}
+
+static SpiceInt find_calc_events(void *target, SpiceDouble start_et, SpiceDouble end_et, SpiceInt events_len,
+                                 gate_event *events) {
+    calc_event_target *calc = target;
+    return gate_fixed_events(calc->observer, calc_radec, &calc->data, GATE_ABCORR_NONE, start_et, end_et,
+                             EVENTS_HORIZON_DEG, events_len, events);
+}
+
+static void calc_events(char **argv) {
+    int handle = gatecli_calc_store_find(&calc_store, argv[2]);
+    if (handle == -1) {
+        fail_command("No custom body with ID '%s'. Try CALC ADD?", argv[2]);
+        return;
+    }
+    calc_data body = gatecli_calc_store_get(&calc_store, handle);
+
+    SpiceDouble start_et;
+    SpiceDouble end_et;
+    if (!parse_event_span(argv[3], argv[4], &start_et, &end_et)) {
+        return;
+    }
+
+    calc_event_target target;
+    if (!get_observer_frame(&target.observer)) {
+        return;
+    }
+    target.data = body;
+
+    printf("Printing rises, transits and sets for custom ID '%s'\n\n", argv[2]);
+
+    reset_c();
+    print_events(find_calc_events, &target, start_et, end_et);
+}
+
+void calc(int argc, char **argv, volatile int *is_running) {
+    if (argc < 2) {
+        fail_command("This command requires at least 1 argument");
+        return;
+    }
+
+    if (eq_ignore_case("ADD", argv[1])) {
+        if (argc < 6) {
+            fail_command("This command at least 4 arguments");
+            return;
+        }
+        return calc_add(argc, argv);
+    }
+
+    if (eq_ignore_case("REM", argv[1])) {
+        if (argc != 3) {
+            fail_command("This command requires 1 argument");
+            return;
+        }
+        return calc_rem(argv[2]);
+    }
+
+    if (eq_ignore_case("INFO", argv[1])) {
+        if (argc != 3) {
+            fail_command("This command requires 1 argument");
+            return;
+        }
+        return calc_info(argv[2]);
+    }
+
+    if (eq_ignore_case("AZEL", argv[1])) {
+        if (argc != 5) {
+            fail_command("This command requires 3 arguments");
+            return;
+        }
+        if (eq_ignore_case("ALL", argv[2])) {
+            return calc_azel_all(argv, is_running);
+        }
+        return calc_azel(argv, is_running);
+    }
+
+    if (eq_ignore_case("EVENTS", argv[1])) {
+        if (argc != 5) {
+            fail_command("This command requires 3 arguments");
+            return;
+        }
+        return calc_events(argv);
+    }
+
+    fail_command("Unrecognized option: '%s'", argv[1]);
+}
+
+/**
+ * Computes what only depends on the epoch when placing
+ * small bodies in the sky of the observer.
+ *
+ * @param rotation the rotation from the J2000 frame into
+ * the frame of the observer
+ * @param observer_state the state of the observer relative
+ * to the Sun in the J2000 frame
+ */
+static void small_body_observer(gate_topo_frame observer_frame, SpiceDouble et, SpiceDouble rotation[3][3],
+                                SpiceDouble observer_state[6]) {
+    SpiceDouble to_topo[6][6];
+    SpiceDouble from_topo[6][6];
+    sxform_c("J2000", observer_frame.frame_name, et, to_topo);
+    invstm_c(to_topo, from_topo);
+
+    for (int i = 0; i < 3; ++i) {
+        for (int j = 0; j < 3; ++j) {
+            rotation[i][j] = to_topo[i][j];
+        }
+    }
+
+    SpiceDouble observer_topo_state[6] = {0, 0, observer_frame.radius, 0, 0, 0};
+    SpiceDouble surface_state[6];
+    mxvg_c(from_topo, observer_topo_state, 6, 6, surface_state);
+
+    SpiceDouble body_state[6];
+    SpiceDouble lt;
+    spkgeo_c(observer_frame.body_id, et, "J2000", MPC_SUN_ID, body_state, &lt);
+
+    for (int i = 0; i < 6; ++i) {
+        observer_state[i] = body_state[i] + surface_state[i];
+    }
+}
+
+static gate_small_body_handle find_small_body(const char *id) {
+    gate_small_body_handle handle = gate_small_body_store_find(&small_body_store, id);
+    if (handle == -1) {
+        fail_command("No minor planet or comet with ID '%s'. Try LOAD MPC?", id);
+    }
+
+    return handle;
+}
+
+static void mpc_info(char *id) {
+    gate_small_body_handle handle = find_small_body(id);
+    if (handle == -1) {
+        return;
+    }
+
+    const gate_small_body_text *text = &small_body_store.text[handle];
+    SpiceBoolean is_comet = small_body_store.is_comet[handle];
+
+    SpiceChar epoch_out[TIME_OUT_MAX_LEN];
+    SpiceChar perihelion_out[TIME_OUT_MAX_LEN];
+    timout_c(text->epoch, "YYYY-MM-DD HR:MN:SC.#### UTC ::UTC", TIME_OUT_MAX_LEN, epoch_out);
+    timout_c(small_body_store.perihelion_et[handle], "YYYY-MM-DD HR:MN:SC.#### UTC ::UTC", TIME_OUT_MAX_LEN,
+             perihelion_out);
+
+    printf("ID: %s\n"
+           "Name: %s\n"
+           "Type: %s\n"
+           "Epoch: %s\n"
+           "Perihelion distance: %f AU\n"
+           "Eccentricity: %f\n"
+           "Time of perihelion: %s\n"
+           "Absolute magnitude: %.2f\n"
+           "%s: %.2f\n",
+           text->id, text->name, is_comet ? "Comet" : "Minor planet", epoch_out,
+           small_body_store.perihelion[handle] / MPC_AU_KM, small_body_store.eccentricity[handle], perihelion_out,
+           small_body_store.magnitude[handle], is_comet ? "Activity index K" : "Slope parameter G",
+           small_body_store.slope[handle]);
+}
+
+static void mpc_azel(char **argv, volatile int *is_running) {
+    gate_small_body_handle handle = find_small_body(argv[2]);
+    if (handle == -1) {
+        return;
+    }
+
+    SpiceBoolean is_cont;
+    SpiceInt count;
+    if (!parse_count(argv[3], &is_cont, &count)) {
+        return;
+    }
+
+    SpiceDouble calc_et;
+    if (eq_ignore_case("NOW", argv[4])) {
+        gate_et_now(&calc_et);
+    } else {
+        str2et_c(argv[4], &calc_et);
+    }
+
+    gate_topo_frame observer_frame;
+    if (!get_observer_frame(&observer_frame)) {
+        return;
+    }
+
+    gate_abcorr abcorr = get_abcorr();
+    printf("Printing azimuth/elevation for small body ID '%s' (%s)\n\n", argv[2],
+           small_body_store.text[handle].name);
+
+    SpiceDouble loop_start_et;
+    gate_et_now(&loop_start_et);
+
+    reset_c();
+    int rounds = 0;
+    while (SPICETRUE) {
+        SpiceChar calc_time_out[TIME_OUT_MAX_LEN];
+        timout_c(calc_et, "YYYY-MM-DD HR:MN:SC.#### UTC ::UTC", TIME_OUT_MAX_LEN, calc_time_out);
+
+        printf("%s:\n", calc_time_out);
+
+        SpiceDouble rotation[3][3];
+        SpiceDouble observer_state[6];
+        small_body_observer(observer_frame, calc_et, rotation, observer_state);
+        if (failed_c()) {
+            break;
+        }
+
+        SpiceDouble j2000[1][3];
+        SpiceDouble sun_distance;
+        gate_small_body_positions(&small_body_store, handle, 1, calc_et, observer_state,
+                                  gate_abcorr_light_time_iterations(abcorr), gate_abcorr_stellar(abcorr), j2000,
+                                  &sun_distance);
+
+        SpiceDouble rec[3];
+        mxv_c(rotation, j2000[0], rec);
+
+        SpiceDouble azimuth;
+        SpiceDouble elevation;
+        gate_conv_rec_azel(rec, NULL, &azimuth, &elevation);
+
+        SpiceDouble distance = vnorm_c(rec);
+        SpiceDouble magnitude = gate_small_body_magnitude(&small_body_store, handle, distance, sun_distance,
+                                                          vnorm_c(observer_state));
+        printf("Azimuth=%f Elevation=%f Magnitude=%.1f Distance=%f AU\n", azimuth, elevation, magnitude,
+               distance / MPC_AU_KM);
+
+        if (!is_cont) {
+            rounds++;
+            if (rounds == count) {
+                break;
+            }
+        } else {
+            if (!*is_running) {
+                *is_running = SPICETRUE;
+                break;
+            }
+        }
+
+        puts("");
+        sleep(1);
+
+        SpiceDouble current_et;
+        gate_et_now(&current_et);
+
+        SpiceDouble elapsed = current_et - loop_start_et;
+        loop_start_et = current_et;
+
+        calc_et += elapsed;
+    }
+}
+
+/**
+ * A small body which passed MPC SCREEN.
+ */
+typedef struct {
+    gate_small_body_handle handle;
+    SpiceDouble azimuth;
+    SpiceDouble elevation;
+    SpiceDouble magnitude;
+    SpiceDouble distance;
+} mpc_screen_row;
+
+static int compare_screen_magnitude(const void *a, const void *b) {
+    SpiceDouble magnitude_a = ((const mpc_screen_row *) a)->magnitude;
+    SpiceDouble magnitude_b = ((const mpc_screen_row *) b)->magnitude;
+    return (magnitude_a > magnitude_b) - (magnitude_a < magnitude_b);
+}
+
+/**
+ * Lists every small body above the elevation and brighter
+ * than the magnitude.
+ *
+ * The store is propagated in chunks which stay in cache,
+ * and only the small bodies above the elevation have their
+ * azimuth and magnitude computed.
+ */
+static void mpc_screen(char **argv) {
+    if (small_body_store.len == 0) {
+        fail_command("No minor planets or comets loaded. Try LOAD MPC?");
+        return;
+    }
+
+    SpiceDouble calc_et;
+    if (eq_ignore_case("NOW", argv[2])) {
+        gate_et_now(&calc_et);
+    } else {
+        str2et_c(argv[2], &calc_et);
+    }
+
+    char *end;
+    SpiceDouble min_elevation = strtod(argv[3], &end);
+    if (end == argv[3]) {
+        fail_command("Not a valid elevation: %s", argv[3]);
+        return;
+    }
+
+    SpiceDouble max_magnitude = strtod(argv[4], &end);
+    if (end == argv[4]) {
+        fail_command("Not a valid magnitude: %s", argv[4]);
+        return;
+    }
+
+    gate_topo_frame observer_frame;
+    if (!get_observer_frame(&observer_frame)) {
+        return;
+    }
+
+    reset_c();
+    SpiceDouble rotation[3][3];
+    SpiceDouble observer_state[6];
+    small_body_observer(observer_frame, calc_et, rotation, observer_state);
+    if (failed_c()) {
+        return;
+    }
+
+    SpiceDouble (*positions)[3] = malloc(MPC_SCREEN_CHUNK * sizeof(*positions));
+    SpiceDouble *sun_distances = malloc(MPC_SCREEN_CHUNK * sizeof(*sun_distances));
+    int rows_len = 0;
+    int rows_cap = MPC_SCREEN_CHUNK;
+    mpc_screen_row *rows = malloc(rows_cap * sizeof(*rows));
+    if (positions == NULL || sun_distances == NULL || rows == NULL) {
+        fail_command("Not enough memory to screen the small bodies");
+        free(positions);
+        free(sun_distances);
+        free(rows);
+        return;
+    }
+
+    gate_abcorr abcorr = get_abcorr();
+    SpiceInt light_time_iterations = gate_abcorr_light_time_iterations(abcorr);
+    SpiceBoolean stellar = gate_abcorr_stellar(abcorr);
+    SpiceDouble observer_sun_distance = vnorm_c(observer_state);
+    SpiceDouble sin_min_elevation = sin(min_elevation * rpd_c());
+
+    double start = wall_ms();
+    for (gate_small_body_handle chunk = 0; chunk < small_body_store.len; chunk += MPC_SCREEN_CHUNK) {
+        SpiceInt chunk_len = small_body_store.len - chunk < MPC_SCREEN_CHUNK ? small_body_store.len - chunk
+                                                                             : MPC_SCREEN_CHUNK;
+        gate_small_body_positions(&small_body_store, chunk, chunk_len, calc_et, observer_state,
+                                  light_time_iterations, stellar, positions, sun_distances);
+
+        for (SpiceInt i = 0; i < chunk_len; ++i) {
+            // Compare the sine of the elevation first, which
+            // rejects most of the catalog without any
+            // trigonometry
+            SpiceDouble distance = vnorm_c(positions[i]);
+            SpiceDouble up = vdot_c(rotation[2], positions[i]);
+            if (up < sin_min_elevation * distance) {
+                continue;
+            }
+
+            gate_small_body_handle handle = chunk + i;
+            SpiceDouble magnitude = gate_small_body_magnitude(&small_body_store, handle, distance, sun_distances[i],
+                                                              observer_sun_distance);
+            if (!(magnitude <= max_magnitude)) {
+                continue;
+            }
+
+            if (rows_len == rows_cap) {
+                mpc_screen_row *new_rows = realloc(rows, rows_cap * 2 * sizeof(*rows));
+                if (new_rows == NULL) {
+                    fail_command("Not enough memory to list every small body found");
+                    chunk = small_body_store.len;
+                    break;
+                }
+                rows = new_rows;
+                rows_cap *= 2;
+            }
+
+            SpiceDouble rec[3];
+            mxv_c(rotation, positions[i], rec);
+
+            mpc_screen_row *row = &rows[rows_len++];
+            row->handle = handle;
+            row->magnitude = magnitude;
+            row->distance = distance;
+            gate_conv_rec_azel(rec, NULL, &row->azimuth, &row->elevation);
+        }
+    }
+    double elapsed_ms = wall_ms() - start;
+
+    qsort(rows, rows_len, sizeof(*rows), compare_screen_magnitude);
+    for (int i = 0; i < rows_len; ++i) {
+        const mpc_screen_row *row = &rows[i];
+        printf("%s (%s): Azimuth=%f Elevation=%f Magnitude=%.1f Distance=%f AU\n",
+               small_body_store.text[row->handle].id, small_body_store.text[row->handle].name, row->azimuth,
+               row->elevation, row->magnitude, row->distance / MPC_AU_KM);
+    }
+    printf("Found %d of %d minor planets and comets in %.1f ms\n", rows_len, small_body_store.len, elapsed_ms);
+
+    free(positions);
+    free(sun_distances);
+    free(rows);
+}
+
+void mpc(int argc, char **argv, volatile int *is_running) {
+    if (argc < 2) {
+        fail_command("This command requires at least 1 argument");
+        return;
     }
 
     if (eq_ignore_case("INFO", argv[1])) {
         if (argc != 3) {
-            puts("This command requires 1 argument");
+            fail_command("This command requires 1 argument");
             return;
         }
-        return sat_info(argv[2]);
+        return mpc_info(argv[2]);
     }
 
     if (eq_ignore_case("AZEL", argv[1])) {
         if (argc != 5) {
-            puts("This command requires 3 arguments");
+            fail_command("This command requires 3 arguments");
             return;
         }
-        return sat_azel(argv, is_running);
+        return mpc_azel(argv, is_running);
+    }
+
+    if (eq_ignore_case("SCREEN", argv[1])) {
+        if (argc != 5) {
+            fail_command("This command requires 3 arguments");
+            return;
+        }
+        return mpc_screen(argv);
     }
 
-    printf("Unrecognized option: '%s'\n", argv[1]);
+    fail_command("Unrecognized option: '%s'", argv[1]);
 }
 
-static void calc_add(int argc, char **argv) {
-    if (gatecli_table_get(&calc_data_array, argv[2]) != NULL) {
-        printf("WARNING: Replacing existing data entry '%s'\n", argv[2]);
+static void site_add(int argc, char **argv) {
+    char *end;
+    SpiceDouble latitude = strtod(argv[3], &end);
+    if (end == argv[3]) {
+        fail_command("Latitude '%s' is not a number", argv[3]);
+        return;
     }
 
-    char *end;
-    double r;
-    double ra;
-    double dec;
-    double ra_pm = 0;
-    double dec_pm = 0;
-    if (argc >= 6) {
-        r = strtod(argv[3], &end);
-        if (end == argv[3]) {
-            printf("Range '%s' is not a number\n", argv[3]);
+    SpiceDouble longitude = strtod(argv[4], &end);
+    if (end == argv[4]) {
+        fail_command("Longitude '%s' is not a number", argv[4]);
+        return;
+    }
+
+    char *body = argc == 6 ? argv[5] : (char *) get_option(OBSERVER_BODY);
+    if (strlen(body) >= BODY_NAME_MAX_LEN) {
+        fail_command("Body name '%s' is too long", body);
+        return;
+    }
+
+    if (gatecli_table_get(&site_array, argv[2]) != NULL) {
+        printf("WARNING: Replacing existing site '%s'\n", argv[2]);
+    }
+
+    observer_site *site = malloc(sizeof(*site));
+    strcpy(site->body, body);
+    site->latitude = latitude;
+    site->longitude = longitude;
+    free(gatecli_table_put(&site_array, argv[2], site));
+
+    printf("Added site '%s' on %s at latitude %f, longitude %f\n", argv[2], site->body, latitude, longitude);
+}
+
+static void site_rem(char *arg) {
+    observer_site *site = gatecli_table_rem(&site_array, arg);
+    if (site != NULL) {
+        free(site);
+        printf("Successfully removed site '%s'\n", arg);
+    } else {
+        fail_command("No site called '%s'", arg);
+    }
+}
+
+static void site_use(char *arg) {
+    observer_site *site = gatecli_table_get(&site_array, arg);
+    if (site == NULL) {
+        fail_command("No site called '%s'. Try SITE ADD?", arg);
+        return;
+    }
+
+    SpiceDouble *latitude = malloc(sizeof(*latitude));
+    SpiceDouble *longitude = malloc(sizeof(*longitude));
+    *latitude = site->latitude;
+    *longitude = site->longitude;
+
+    invalidate_observer();
+    set_option(OBSERVER_BODY, strdup(site->body));
+    set_option(OBSERVER_LATITUDE, latitude);
+    set_option(OBSERVER_LONGITUDE, longitude);
+
+    printf("Using site '%s' on %s at latitude %f, longitude %f\n", arg, site->body, site->latitude,
+           site->longitude);
+}
+
+void site(int argc, char **argv) {
+    if (argc < 2) {
+        fail_command("This command requires at least 1 argument");
+        return;
+    }
+
+    if (eq_ignore_case("ADD", argv[1])) {
+        if (argc != 5 && argc != 6) {
+            fail_command("This command requires 3 or 4 arguments");
             return;
         }
+        return site_add(argc, argv);
+    }
 
-        ra = strtod(argv[4], &end);
-        if (end == argv[4]) {
-            printf("Right ascension '%s' is not a number\n", argv[4]);
+    if (eq_ignore_case("REM", argv[1])) {
+        if (argc != 3) {
+            fail_command("This command requires 1 argument");
             return;
         }
+        return site_rem(argv[2]);
+    }
 
-        dec = strtod(argv[5], &end);
-        if (end == argv[5]) {
-            printf("Declination '%s' is not a number\n", argv[5]);
+    if (eq_ignore_case("USE", argv[1])) {
+        if (argc != 3) {
+            fail_command("This command requires 1 argument");
             return;
         }
-    } else {
-        printf("Unrecognized command format\n");
-        return;
+        return site_use(argv[2]);
     }
 
-    if (argc == 8) {
-        ra_pm = strtod(argv[6], &end);
-        if (end == argv[6]) {
-            printf("Right ascension '%s' is not a number\n", argv[6]);
-            return;
+    fail_command("Unrecognized option: '%s'", argv[1]);
+}
+
+/**
+ * A watch target resolved for one run of the watch list.
+ */
+typedef struct {
+    watch_kind kind;
+    SpiceChar label[WATCH_LABEL_MAX_LEN];
+
+    gate_star_info_spice1 star;
+
+    // The index of the body into the targets shared by
+    // every body with gate_body_states()
+    SpiceInt body_index;
+
+    gate_sat_handle sat;
+    const gate_tle_track *track;
+    SpiceInt history_index;
+    gate_sat_propagator propagator;
+
+    calc_data calc;
+
+    gate_small_body_handle small_body;
+} watch_entry;
+
+static SpiceBoolean parse_watch_kind(char *string, watch_kind *kind) {
+    for (int i = 0; i < WATCH_KIND_LEN; ++i) {
+        if (eq_ignore_case(WATCH_KIND_STRINGS[i], string)) {
+            *kind = i;
+            return SPICETRUE;
         }
+    }
 
-        dec_pm = strtod(argv[7], &end);
-        if (end == argv[7]) {
-            printf("Declination '%s' is not a number\n", argv[7]);
-            return;
+    fail_command("Not a valid kind of target: '%s'. Try STAR, BODY, SAT, CALC or MPC?", string);
+    return SPICEFALSE;
+}
+
+static int find_watch_target(watch_kind kind, const char *id) {
+    for (int i = 0; i < watch_list_len; ++i) {
+        if (watch_list[i].kind == kind && strcmp(watch_list[i].id, id) == 0) {
+            return i;
         }
-    } else if (argc != 6) {
-        printf("Unrecognized command format\n");
+    }
+
+    return -1;
+}
+
+static void watch_add(char **argv) {
+    watch_kind kind;
+    if (!parse_watch_kind(argv[2], &kind)) {
         return;
     }
 
-    char *id = strdup(argv[2]);
-    calc_data *calc = malloc(sizeof(*calc));
-    calc->r = r;
-    calc->ra = ra;
-    calc->dec = dec;
-    calc->ra_pm = ra_pm;
-    calc->dec_pm = dec_pm;
-    gatecli_table_put(&calc_data_array, id, calc);
+    if (strlen(argv[3]) >= WATCH_ID_MAX_LEN) {
+        fail_command("ID '%s' is too long", argv[3]);
+        return;
+    }
 
-    printf("Added '%s' to the custom object database\n", argv[2]);
-}
+    if (find_watch_target(kind, argv[3]) != -1) {
+        fail_command("%s '%s' is already being watched", WATCH_KIND_STRINGS[kind], argv[3]);
+        return;
+    }
 
-static void calc_rem(char *arg) {
-    calc_data *data = gatecli_table_rem(&calc_data_array, arg);
-    if (data != NULL) {
-        free(data);
-        printf("Successfully removed custom object '%s'\n", arg);
-    } else {
-        printf("No object in database called '%s'\n", arg);
+    if (watch_list_len == WATCH_MAX_TARGETS) {
+        fail_command("At most %d targets may be watched", WATCH_MAX_TARGETS);
+        return;
     }
+
+    watch_target *target = &watch_list[watch_list_len++];
+    target->kind = kind;
+    strcpy(target->id, argv[3]);
+
+    printf("Added %s '%s' to the watch list\n", WATCH_KIND_STRINGS[kind], argv[3]);
 }
 
-static void calc_info(char *arg) {
-    calc_data *data = gatecli_table_get(&calc_data_array, arg);
-    if (data == NULL) {
-        printf("No object in database called '%s'\n", arg);
+static void watch_rem(char **argv) {
+    watch_kind kind;
+    if (!parse_watch_kind(argv[2], &kind)) {
         return;
     }
 
-    printf("ID: %s\n"
-           "Range: %f units\n"
-           "Right ascension: %f deg\n"
-           "Declination: %f deg\n"
-           "Right ascension proper motion: %f deg/yr\n"
-           "Declination proper motion: %f deg/yr\n",
-           arg, data->r, data->ra, data->dec, data->ra_pm, data->dec_pm);
+    int index = find_watch_target(kind, argv[3]);
+    if (index == -1) {
+        fail_command("No %s called '%s' in the watch list", WATCH_KIND_STRINGS[kind], argv[3]);
+        return;
+    }
+
+    memmove(&watch_list[index], &watch_list[index + 1], (watch_list_len - index - 1) * sizeof(*watch_list));
+    watch_list_len--;
+
+    printf("Successfully removed %s '%s' from the watch list\n", WATCH_KIND_STRINGS[kind], argv[3]);
 }
 
-void calc_cur_pos(calc_data data, SpiceDouble et, SpiceDouble *ra, SpiceDouble *dec) {
-    SpiceDouble dt = et / jyear_c();
+/**
+ * Looks up what is needed to compute the position of a
+ * watched target at every tick.
+ *
+ * @return SPICETRUE if the target was found, otherwise the
+ * reason has already been printed
+ */
+static SpiceBoolean resolve_watch_target(const watch_target *target, SpiceDouble et, SpiceInt *bodies_len,
+                                         SpiceInt *bodies, watch_entry *entry) {
+    entry->kind = target->kind;
+    snprintf(entry->label, WATCH_LABEL_MAX_LEN, "%s %s", WATCH_KIND_STRINGS[target->kind], target->id);
+
+    switch (target->kind) {
+        case WATCH_STAR: {
+            char *table_name = (char *) check_and_get_option(STAR_TABLE);
+            if (table_name == NULL) {
+                return SPICEFALSE;
+            }
 
-    if (ra != NULL) {
-        *ra = data.ra + (dt * data.ra_pm);
+            SpiceChar filter[FILTER_MAX_LEN];
+            snprintf(filter, FILTER_MAX_LEN, "WHERE CATALOG_NUMBER = %s", target->id);
+
+            SpiceInt rows;
+            gate_load_stars(table_name, filter, &rows);
+            if (rows == 0) {
+                fail_command("No stars found in table '%s' with catalog number '%s'", table_name, target->id);
+                return SPICEFALSE;
+            }
+
+            gate_star_info_spice1 stars[rows];
+            gate_parse_stars(rows, stars);
+            entry->star = stars[0];
+            return SPICETRUE;
+        }
+        case WATCH_BODY: {
+            char *naif_id_string_end;
+            SpiceInt naif_id = strtol(target->id, &naif_id_string_end, 10);
+            if (target->id == naif_id_string_end) {
+                fail_command("'%s' is not a valid NAIF ID", target->id);
+                return SPICEFALSE;
+            }
+
+            SpiceChar body_name[BODY_NAME_MAX_LEN];
+            SpiceBoolean found;
+            bodc2n_c(naif_id, BODY_NAME_MAX_LEN, body_name, &found);
+            if (!found) {
+                fail_command("No body with NAIF ID '%s'. Try LOAD KERNEL?", target->id);
+                return SPICEFALSE;
+            }
+
+            snprintf(entry->label, WATCH_LABEL_MAX_LEN, "BODY %s (%s)", target->id, body_name);
+            entry->body_index = *bodies_len;
+            bodies[(*bodies_len)++] = naif_id;
+            return SPICETRUE;
+        }
+        case WATCH_SAT: {
+            entry->sat = gate_sat_store_find(&sat_store, target->id);
+            if (entry->sat == -1) {
+                fail_command("No satellite with ID '%s'. Try SAT ADD?", target->id);
+                return SPICEFALSE;
+            }
+
+            gate_sgp4_status status = init_sat_propagator(entry->sat, et, &entry->track, &entry->history_index,
+                                                          &entry->propagator);
+            if (status != GATE_SGP4_OK) {
+                fail_command("Satellite '%s' cannot be propagated: %s", target->id, gate_sgp4_status_string(status));
+                return SPICEFALSE;
+            }
+            return SPICETRUE;
+        }
+        case WATCH_CALC: {
+            int handle = gatecli_calc_store_find(&calc_store, target->id);
+            if (handle == -1) {
+                fail_command("No custom body with ID '%s'. Try CALC ADD?", target->id);
+                return SPICEFALSE;
+            }
+
+            entry->calc = gatecli_calc_store_get(&calc_store, handle);
+            return SPICETRUE;
+        }
+        case WATCH_MPC: {
+            entry->small_body = find_small_body(target->id);
+            if (entry->small_body == -1) {
+                return SPICEFALSE;
+            }
+
+            snprintf(entry->label, WATCH_LABEL_MAX_LEN, "MPC %s (%s)", target->id,
+                     small_body_store.text[entry->small_body].name);
+            return SPICETRUE;
+        }
+        default:
+            return SPICEFALSE;
     }
+}
 
-    if (dec != NULL) {
-        *dec = data.dec + (dt * data.dec_pm);
+/**
+ * Appends a line to the output of a tick, truncating it to
+ * WATCH_LINE_MAX_LEN characters.
+ *
+ * @return the new length of the output
+ */
+static size_t append_watch_line(char *batch, size_t len, const char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    int written = vsnprintf(batch + len, WATCH_LINE_MAX_LEN, format, args);
+    va_end(args);
+
+    if (written < 0) {
+        return len;
     }
+    return len + (written < WATCH_LINE_MAX_LEN ? written : WATCH_LINE_MAX_LEN - 1);
 }
 
-static void calc_azel(char **argv, volatile int *is_running) {
-    calc_data *body = gatecli_table_get(&calc_data_array, argv[2]);
-    if (body == NULL) {
-        printf("No custom body with ID '%s'. Try CALC ADD?\n", argv[2]);
+/**
+ * Prints the positions of every watched target, one tick
+ * at a time.
+ *
+ * Everything which only depends on the epoch is computed
+ * once per tick and shared between the targets: the
+ * rotation into the frame of the observer, the state of
+ * the observer, the velocity of the Earth for stellar
+ * aberration, the states of every body in one call to
+ * gate_body_states(), the state of the observer relative to
+ * the Sun for small bodies and the formatted time. The
+ * output of each tick is written at once.
+ */
+static void watch_run(char **argv, volatile int *is_running) {
+    if (watch_list_len == 0) {
+        fail_command("No targets are being watched. Try WATCH ADD?");
         return;
     }
 
-    SpiceBoolean is_cont = SPICEFALSE;
+    SpiceBoolean is_cont;
     SpiceInt count;
-    if (eq_ignore_case("CONT", argv[3])) {
-        is_cont = SPICETRUE;
-    } else {
-        char *end;
-        count = strtol(argv[3], &end, 10);
-        if (argv[3] == end) {
-            printf("Not a valid number: %s\n", argv[3]);
-            return;
-        }
+    if (!parse_count(argv[2], &is_cont, &count)) {
+        return;
     }
 
     SpiceDouble calc_et;
-    if (eq_ignore_case("NOW", argv[4])) {
+    if (eq_ignore_case("NOW", argv[3])) {
         gate_et_now(&calc_et);
     } else {
-        str2et_c(argv[4], &calc_et);
+        str2et_c(argv[3], &calc_et);
     }
 
-    char *observer_body = (char *) check_and_get_option(OBSERVER_BODY);
-    if (observer_body == NULL) {
+    gate_topo_frame observer_frame;
+    if (!get_observer_frame(&observer_frame)) {
         return;
     }
 
-    SpiceInt observer_body_id;
-    SpiceBoolean observer_body_id_found;
-    bodn2c_c(observer_body, &observer_body_id, &observer_body_id_found);
-    if (!observer_body_id_found) {
-        printf("No NAIF ID was found for body '%s'! Try LOAD KERNEL?\n", observer_body);
+    watch_entry *entries = malloc(watch_list_len * sizeof(*entries));
+    char *batch = malloc((watch_list_len + 1) * WATCH_LINE_MAX_LEN);
+    if (entries == NULL || batch == NULL) {
+        fail_command("Not enough memory to run the watch list");
+        free(entries);
+        free(batch);
         return;
     }
 
-    SpiceDouble *observer_latitude_opt = (double *) check_and_get_option(OBSERVER_LATITUDE);
-    SpiceDouble *observer_longitude_opt = (double *) check_and_get_option(OBSERVER_LONGITUDE);
-    if (observer_latitude_opt == NULL || observer_longitude_opt == NULL) {
-        return;
+    SpiceInt bodies_len = 0;
+    SpiceInt bodies[WATCH_MAX_TARGETS];
+    SpiceBoolean has_small_bodies = SPICEFALSE;
+    for (int i = 0; i < watch_list_len; ++i) {
+        if (!resolve_watch_target(&watch_list[i], calc_et, &bodies_len, bodies, &entries[i])) {
+            free(entries);
+            free(batch);
+            return;
+        }
+        has_small_bodies |= entries[i].kind == WATCH_MPC;
     }
 
-    SpiceDouble observer_latitude = *observer_latitude_opt;
-    SpiceDouble observer_longitude = *observer_longitude_opt;
-
-    gate_topo_frame observer_frame;
-    gate_load_topo_frame("CALC_AZEL_TOPO", observer_body_id, observer_latitude, observer_longitude, 0,
-                         &observer_frame);
-
-    printf("Printing azimuth/elevation for custom ID '%s' (%s)\n\n", argv[2], argv[2]);
+    gate_abcorr abcorr = get_abcorr();
+    printf("Printing azimuth/elevation for %d watched targets\n\n", watch_list_len);
 
     SpiceDouble loop_start_et;
     gate_et_now(&loop_start_et);
 
+    reset_c();
     int rounds = 0;
     while (SPICETRUE) {
-        SpiceChar calc_time_out[TIME_OUT_MAX_LEN];
-        timout_c(calc_et, "YYYY-MM-DD HR:MN:SC.#### UTC ::UTC", TIME_OUT_MAX_LEN, calc_time_out);
+        SpiceDouble to_topo[6][6];
+        SpiceDouble from_topo[6][6];
+        sxform_c("J2000", observer_frame.frame_name, calc_et, to_topo);
+        invstm_c(to_topo, from_topo);
+
+        SpiceDouble rotation[3][3];
+        for (int i = 0; i < 3; ++i) {
+            for (int j = 0; j < 3; ++j) {
+                rotation[i][j] = to_topo[i][j];
+            }
+        }
 
-        printf("%s:\n", calc_time_out);
+        SpiceDouble observer_topo_state[6] = {0, 0, observer_frame.radius, 0, 0, 0};
+        SpiceDouble observer_state[6];
+        mxvg_c(from_topo, observer_topo_state, 6, 6, observer_state);
 
-        SpiceDouble ra;
-        SpiceDouble dec;
-        calc_cur_pos(*body, calc_et, &ra, &dec);
+        SpiceDouble observer_velocity[3] = {0, 0, 0};
+        if (gate_abcorr_stellar(abcorr)) {
+            gate_observer_velocity(observer_frame.body_id, calc_et, observer_velocity);
+        }
 
-        SpiceDouble cur_rec_j2000[3];
-        SpiceDouble ra_rad = ra * rpd_c();
-        SpiceDouble dec_rad = dec * rpd_c();
-        radrec_c(body->r, ra_rad, dec_rad, cur_rec_j2000);
+        SpiceDouble body_states[WATCH_MAX_TARGETS][6];
+        if (bodies_len > 0) {
+            gate_body_states(bodies_len, bodies, observer_frame.body_id, "J2000", abcorr, calc_et, body_states,
+                             NULL);
+        }
 
-        SpiceDouble frame_transform_matrix[3][3];
-        pxform_c("J2000", observer_frame.frame_name, calc_et, frame_transform_matrix);
+        SpiceDouble observer_sun_state[6];
+        if (has_small_bodies) {
+            SpiceDouble body_sun_state[6];
+            SpiceDouble lt;
+            spkgeo_c(observer_frame.body_id, calc_et, "J2000", MPC_SUN_ID, body_sun_state, &lt);
+            for (int i = 0; i < 6; ++i) {
+                observer_sun_state[i] = body_sun_state[i] + observer_state[i];
+            }
+        }
+        if (failed_c()) {
+            break;
+        }
 
-        SpiceDouble rec[3];
-        mxv_c(frame_transform_matrix, cur_rec_j2000, rec);
-        gate_adjust_topo_rec(observer_frame, rec);
+        SpiceChar calc_time_out[TIME_OUT_MAX_LEN];
+        timout_c(calc_et, "YYYY-MM-DD HR:MN:SC.#### UTC ::UTC", TIME_OUT_MAX_LEN, calc_time_out);
+        size_t batch_len = append_watch_line(batch, 0, "%s:\n", calc_time_out);
+
+        for (int i = 0; i < watch_list_len; ++i) {
+            watch_entry *entry = &entries[i];
+
+            SpiceDouble j2000[3];
+            SpiceDouble rec[3];
+            switch (entry->kind) {
+                case WATCH_STAR: {
+                    SpiceDouble ra;
+                    SpiceDouble dec;
+                    gate_calc_star_pos(entry->star, calc_et, &ra, &dec, NULL, NULL);
+                    radrec_c(1, ra * rpd_c(), dec * rpd_c(), j2000);
+                    if (gate_abcorr_stellar(abcorr)) {
+                        SpiceDouble apparent[3];
+                        stelab_c(j2000, observer_velocity, apparent);
+                        vequ_c(apparent, j2000);
+                    }
+                    mxv_c(rotation, j2000, rec);
+                    break;
+                }
+                case WATCH_BODY:
+                    mxv_c(rotation, body_states[entry->body_index], rec);
+                    gate_adjust_topo_rec(observer_frame, rec);
+                    break;
+                case WATCH_SAT: {
+                    if (entry->track != NULL && gate_tle_track_nearest(entry->track, calc_et) != entry->history_index) {
+                        // A failure to initialize is reported
+                        // when propagating below
+                        init_sat_propagator(entry->sat, calc_et, &entry->track, &entry->history_index,
+                                            &entry->propagator);
+                    }
 
-        SpiceDouble azimuth;
-        SpiceDouble elevation;
-        gate_conv_rec_azel(rec, NULL, &azimuth, &elevation);
-        printf("Azimuth=%f Elevation=%f\n", azimuth, elevation);
+                    SpiceDouble state[6];
+                    gate_sgp4_status status = gate_sat_propagate(&entry->propagator, calc_et, state);
+                    if (status == GATE_SGP4_OK) {
+                        status = sat_apparent_rec_shared(&entry->propagator, observer_state, rotation, calc_et,
+                                                         abcorr, state, rec);
+                    }
+                    if (status != GATE_SGP4_OK) {
+                        batch_len = append_watch_line(batch, batch_len, "%s: Failed to propagate: %s\n",
+                                                      entry->label, gate_sgp4_status_string(status));
+                        continue;
+                    }
+                    break;
+                }
+                case WATCH_CALC: {
+                    SpiceDouble ra;
+                    SpiceDouble dec;
+                    calc_cur_pos(entry->calc, calc_et, &ra, &dec);
+                    radrec_c(entry->calc.r, ra * rpd_c(), dec * rpd_c(), j2000);
+                    mxv_c(rotation, j2000, rec);
+                    gate_adjust_topo_rec(observer_frame, rec);
+                    break;
+                }
+                case WATCH_MPC: {
+                    SpiceDouble positions[1][3];
+                    gate_small_body_positions(&small_body_store, entry->small_body, 1, calc_et, observer_sun_state,
+                                              gate_abcorr_light_time_iterations(abcorr),
+                                              gate_abcorr_stellar(abcorr), positions, NULL);
+                    mxv_c(rotation, positions[0], rec);
+                    break;
+                }
+                default:
+                    continue;
+            }
+
+            SpiceDouble azimuth;
+            SpiceDouble elevation;
+            gate_conv_rec_azel(rec, NULL, &azimuth, &elevation);
+            batch_len = append_watch_line(batch, batch_len, "%s: Azimuth=%f Elevation=%f\n", entry->label,
+                                          azimuth, elevation);
+        }
+
+        fwrite(batch, 1, batch_len, stdout);
 
         if (!is_cont) {
             rounds++;
@@ -1278,47 +4677,39 @@ static void calc_azel(char **argv, volatile int *is_running) {
         calc_et += elapsed;
     }
 
-    gate_unload_topo_frame(observer_frame);
+    free(entries);
+    free(batch);
 }
 
-
-void calc(int argc, char **argv, volatile int *is_running) {
+void watch(int argc, char **argv, volatile int *is_running) {
     if (argc < 2) {
-        puts("This command requires at least 1 argument");
+        fail_command("This command requires at least 1 argument");
         return;
     }
 
     if (eq_ignore_case("ADD", argv[1])) {
-        if (argc < 6) {
-            puts("This command at least 4 arguments");
+        if (argc != 4) {
+            fail_command("This command requires 2 arguments");
             return;
         }
-        return calc_add(argc, argv);
+        return watch_add(argv);
     }
 
     if (eq_ignore_case("REM", argv[1])) {
-        if (argc != 3) {
-            puts("This command requires 1 argument");
-            return;
-        }
-        return calc_rem(argv[2]);
-    }
-
-    if (eq_ignore_case("INFO", argv[1])) {
-        if (argc != 3) {
-            puts("This command requires 1 argument");
+        if (argc != 4) {
+            fail_command("This command requires 2 arguments");
             return;
         }
-        return calc_info(argv[2]);
+        return watch_rem(argv);
     }
 
-    if (eq_ignore_case("AZEL", argv[1])) {
-        if (argc != 5) {
-            puts("This command requires 3 arguments");
+    if (eq_ignore_case("RUN", argv[1])) {
+        if (argc != 4) {
+            fail_command("This command requires 2 arguments");
             return;
         }
-        return calc_azel(argv, is_running);
+        return watch_run(argv, is_running);
     }
 
-    printf("Unrecognized option: '%s'\n", argv[1]);
+    fail_command("Unrecognized option: '%s'", argv[1]);
 }
@@ -8,20 +8,6 @@
 
 #include <cspice/SpiceUsr.h>
 
-/**
- * Represents a satellite that has been added to the
- * gatecli database using orbital elements such as the
- * NORAD Keplerian TLE format.
- */
-typedef struct {
-    char *lines[2];
-
-    SpiceDouble epoch;
-    SpiceDouble elements[10];
-
-    int is_deep_space;
-} sat_data;
-
 /**
  * Represents an object that has been added to the gatecli
  * database for the purpose of computing the position of an
@@ -57,6 +43,12 @@ void help();
  *     (default=NULL)
  *   - STAR_TABLE <table name>
  *     (default=NULL)
+ *   - ABCORR <NONE | ANNUAL | LT | LT+S | CN | CN+S>
+ *     (default='CN+S')
+ *
+ * ABCORR is the level of aberration correction applied by
+ * STAR AZEL, STAR EVENTS, BODY AZEL, BODY EVENTS and
+ * SAT AZEL, see gate_abcorr.
  *
  * @param argc the number of arguments
  * @param argv the argument vector
@@ -77,12 +69,36 @@ void get(int argc, char **argv);
 
 /**
  * Handles a command to load a file to obtain options or
- * kernels or an IAU Catalog of Star Names.
+ * kernels or an IAU Catalog of Star Names or a catalog of
+ * satellite TLEs.
  *
  * The CSN file can be found at
  * https://www.pas.rochester.edu/~emamajek/WGSN/IAU-CSN.txt
  *
- * Usage: LOAD <CMD | KERNEL | CSN> <filename>
+ * TLE files may be in either the 2LE or 3LE format, such
+ * as those provided by https://celestrak.org. Satellites
+ * are added to the database using their catalog number as
+ * their ID.
+ *
+ * HISTORY files are 2LE or 3LE archives holding any number
+ * of element sets per satellite, such as those provided by
+ * https://www.space-track.org. They are kept apart from the
+ * database, and SAT AZEL and SAT PASSES use the archived
+ * element set with the epoch nearest to the time being
+ * computed for satellites with the same catalog number.
+ *
+ * CALC files are CSV files of custom objects with one
+ * object per line, in the form
+ * `<id>,<range>,<RA deg>,<DEC deg>[,<RA_PM deg/yr>,<DEC_PM deg/yr>]`,
+ * which are added as if by CALC ADD.
+ *
+ * MPC files hold the orbital elements of minor planets or
+ * comets in the formats of MPCORB.DAT or CometEls.txt from
+ * https://www.minorplanetcenter.net/iau/MPCORB.html, see
+ * gate_small_body_store_append_buffer().
+ *
+ * Usage: LOAD <CMD | KERNEL | CSN | TLE | HISTORY | CALC |
+ *   MPC> <filename>
  *
  * @param argc the number of arguments
  * @param argv the argument vector
@@ -94,7 +110,8 @@ void load(int argc, char **argv, volatile int *is_running);
 /**
  * Handles a command to show tables.
  *
- * Usage: SHOW <TABLES | FRAMES | CSN | BODIES | CALC>
+ * Usage: SHOW <TABLES | FRAMES | CSN | BODIES | CALC | SITES |
+ *   WATCH>
  *
  * @param argc the number of arguments
  * @param argv the argument vector
@@ -111,6 +128,13 @@ void show(int argc, char **argv, volatile int *is_running);
  * - STAR INFO <catalog number>
  * - STAR AZEL <catalog number> <CONT | count>
  *   <ISO time | NOW>
+ * - STAR EVENTS <catalog number> <ISO time | NOW>
+ *   <ISO time | NOW>
+ *
+ * STAR EVENTS prints the rises, transits and sets of the
+ * star between the two times, see gate_fixed_events().
+ * Rises and sets are taken at an elevation of -34
+ * arcminutes to allow for refraction.
  *
  * @param argc the number of arguments
  * @param argv the argument vector
@@ -127,6 +151,25 @@ void star(int argc, char **argv, volatile int *is_running);
  * - BODY INFO <naif id>
  * - BODY AZEL <naif id> <CONT | count>
  *   <ISO time | NOW>
+ * - BODY AZEL <ALL | naif id,naif id,...>
+ *   <CONT | count> <ISO time | NOW>
+ *
+ * - BODY BENCH <naif id> <ISO time | NOW> <samples>
+ * - BODY EVENTS <naif id> <ISO time | NOW>
+ *   <ISO time | NOW>
+ *
+ * ALL shows the Sun, the Moon, the planets and Pluto, see
+ * GATE_SOLAR_SYSTEM_BODIES.
+ *
+ * BODY BENCH looks up the body once an hour for the given
+ * number of samples at every level of aberration
+ * correction, and prints the cost of each level along with
+ * how far it is off from CN+S.
+ *
+ * BODY EVENTS prints the rises, transits and sets of the
+ * body between the two times, see gate_body_events().
+ * Rises and sets are taken when the upper limb of the body
+ * is at an elevation of -34 arcminutes.
  *
  * @param argc the number of arguments
  * @param argv the argument vector
@@ -139,7 +182,43 @@ void body(int argc, char **argv, volatile int *is_running);
  * Handles a command to show satellite info or observation
  * position of a satellite given a TLE element set.
  *
- * Usage: TBD
+ * Usage:
+ * - SAT ADD <id>
+ * - SAT REM <id>
+ * - SAT INFO <id>
+ * - SAT HISTORY <id> <ISO time | NOW>
+ * - SAT AZEL <id> <CONT | count> <ISO time | NOW>
+ * - SAT PASSES <id> <ISO time | NOW> <ISO time | NOW>
+ *   <min elevation>
+ * - SAT OVERHEAD <count | CONT> <ISO time | NOW>
+ *   <min elevation>
+ * - SAT VISIBILITY <stations file> <ISO time | NOW>
+ *   <ISO time | NOW> <step> <output file>
+ * - SAT CONJUNCTIONS <ISO time | NOW> <ISO time | NOW>
+ *   <step> <distance>
+ * - SAT TRACK <ISO time | NOW> <ISO time | NOW> <step>
+ *   <min elevation | NONE> <CSV | BIN> <output file>
+ * - SAT CACHE <ISO time | NOW> <ISO time | NOW>
+ *   <tolerance> <budget MB>
+ * - SAT CACHE CLEAR
+ * - SAT PROP <ISO time | NOW>
+ * - SAT VERIFY <id | ALL>
+ * - SAT BENCH <count> <steps>
+ *
+ * SAT TRACK writes the sub-satellite point of every
+ * satellite at each step, epoch by epoch. The BIN format is
+ * in native byte order and consists of:
+ * - the 8 characters "GATETRK1"
+ * - the number of satellites and of epochs written as
+ *   32-bit integers, which is fewer than requested if the
+ *   command was stopped early or failed
+ * - the ephemeris time of the first epoch and the step in
+ *   seconds as doubles
+ * - the ID of each satellite, NULL padded to 32 characters
+ * - for each epoch and each satellite, the latitude and
+ *   longitude in degrees, the altitude in kilometers and
+ *   the footprint radius in kilometers as floats, which
+ *   are NaN if the satellite could not be propagated
  *
  * @param argc the number of arguments
  * @param argv the argument vector
@@ -159,6 +238,11 @@ void sat(int argc, char **argv, volatile int *is_running);
  * - CALC REM <id>
  * - CALC INFO <id>
  * - CALC AZEL <id> <CONT | count> <ISO time | NOW>
+ * - CALC AZEL ALL <CONT | count> <ISO time | NOW>
+ * - CALC EVENTS <id> <ISO time | NOW> <ISO time | NOW>
+ *
+ * CALC AZEL ALL evaluates every object at once, see
+ * gatecli_calc_store_azel().
  *
  * @param argc the number of arguments
  * @param argv the argument vector
@@ -167,4 +251,72 @@ void sat(int argc, char **argv, volatile int *is_running);
  */
 void calc(int argc, char **argv, volatile int *is_running);
 
+/**
+ * Computes the observation position of minor planets and
+ * comets loaded with LOAD MPC, which are propagated on
+ * their heliocentric conics.
+ *
+ * Usage:
+ * - MPC INFO <id>
+ * - MPC AZEL <id> <CONT | count> <ISO time | NOW>
+ * - MPC SCREEN <ISO time | NOW> <min elevation> <max magnitude>
+ *
+ * Numbered minor planets are identified by their number,
+ * numbered comets by their number and type such as 1P and
+ * others by their packed provisional designation. MPC
+ * SCREEN propagates every loaded small body at once and
+ * lists those above the elevation and brighter than the
+ * magnitude, brightest first.
+ *
+ * @param argc the number of arguments
+ * @param argv the argument vector
+ * @param is_running whether or not the program is or
+ * should be running
+ */
+void mpc(int argc, char **argv, volatile int *is_running);
+
+/**
+ * Manages named observing sites, which save having to set
+ * each of the OBSERVER_* options when switching between
+ * observers.
+ *
+ * Usage:
+ * - SITE ADD <name> <latitude> <longitude> [<body>]
+ * - SITE REM <name>
+ * - SITE USE <name>
+ *
+ * The body defaults to the current OBSERVER_BODY. Every
+ * command shares one topographic frame for the observer,
+ * which is only loaded again after SITE USE, SET of an
+ * OBSERVER_* option or LOAD KERNEL.
+ *
+ * @param argc the number of arguments
+ * @param argv the argument vector
+ */
+void site(int argc, char **argv);
+
+/**
+ * Manages a list of stars, bodies, satellites, custom
+ * calc objects and small bodies which are tracked
+ * together.
+ *
+ * Usage:
+ * - WATCH ADD <STAR | BODY | SAT | CALC | MPC> <id>
+ * - WATCH REM <STAR | BODY | SAT | CALC | MPC> <id>
+ * - WATCH RUN <CONT | count> <ISO time | NOW>
+ *
+ * Targets are identified as they are by STAR AZEL, BODY
+ * AZEL, SAT AZEL, CALC AZEL and MPC AZEL, and are looked
+ * up when the
+ * list is run. WATCH RUN prints every target at each tick,
+ * computing what only depends on the time and the observer
+ * once per tick.
+ *
+ * @param argc the number of arguments
+ * @param argv the argument vector
+ * @param is_running whether or not the program is or
+ * should be running
+ */
+void watch(int argc, char **argv, volatile int *is_running);
+
 #endif // GATECLI_COMMANDS_H
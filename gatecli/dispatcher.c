@@ -1,8 +1,36 @@
+#include "dispatcher.h"
 #include "commands.h"
 #include "util.h"
+#include <stdarg.h>
 #include <stdio.h>
 
-void dispatch(int argc, char **argv, volatile int *is_running) {
+static int is_batch = 0;
+static int is_failed = 0;
+static char failure[COMMAND_FAILURE_MAX_LEN];
+
+void set_batch_mode(int batch) {
+    is_batch = batch;
+}
+
+int is_batch_mode() {
+    return is_batch;
+}
+
+void fail_command(const char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    vsnprintf(failure, COMMAND_FAILURE_MAX_LEN, format, args);
+    va_end(args);
+
+    puts(failure);
+    is_failed = 1;
+}
+
+const char *command_failure() {
+    return failure;
+}
+
+static void route(int argc, char **argv, volatile int *is_running) {
     char *label = argv[0];
 
     if (eq_ignore_case("HELP", label)) {
@@ -41,5 +69,29 @@ void dispatch(int argc, char **argv, volatile int *is_running) {
         return calc(argc, argv, is_running);
     }
 
-    puts("Command not recognized. Try typing 'HELP'");
+    if (eq_ignore_case("MPC", label)) {
+        return mpc(argc, argv, is_running);
+    }
+
+    if (eq_ignore_case("SITE", label)) {
+        return site(argc, argv);
+    }
+
+    if (eq_ignore_case("WATCH", label)) {
+        return watch(argc, argv, is_running);
+    }
+
+    fail_command("Command not recognized. Try typing 'HELP'");
+}
+
+int dispatch(int argc, char **argv, volatile int *is_running) {
+    // Commands such as LOAD CMD dispatch others, which must
+    // not clear a failure of the command that is running
+    int was_failed = is_failed;
+    is_failed = 0;
+    route(argc, argv, is_running);
+
+    int succeeded = !is_failed;
+    is_failed |= was_failed;
+    return succeeded;
 }
@@ -10,6 +10,47 @@
 #ifndef GATE_DISPATCHER_H
 #define GATE_DISPATCHER_H
 
+/**
+ * The maximum length of the message passed to
+ * fail_command(), including the NULL terminator.
+ */
+#define COMMAND_FAILURE_MAX_LEN 512
+
+/**
+ * Prints a message explaining why the command being
+ * dispatched failed, formatted as with printf() and
+ * followed by a newline, and marks the command as failed.
+ *
+ * @param format the format of the message
+ * @param ... the values to format
+ */
+void fail_command(const char *format, ...);
+
+/**
+ * Obtains the message of the last command which failed.
+ *
+ * @return the message passed to the last call of
+ * fail_command()
+ */
+const char *command_failure();
+
+/**
+ * Sets whether commands are run in batch mode, where there
+ * is no one to interrupt them, so commands which only stop
+ * when interrupted must be refused.
+ *
+ * @param batch 1 if commands are run in batch mode
+ */
+void set_batch_mode(int batch);
+
+/**
+ * Checks whether commands are run in batch mode, see
+ * set_batch_mode().
+ *
+ * @return 1 if commands are run in batch mode, 0 otherwise
+ */
+int is_batch_mode();
+
 /**
  * Dispatches commands to be handled by the individual
  * handlers.
@@ -24,7 +65,11 @@
  * separated by a space character
  * @param is_running 1 to represent the fact that a SIGINT
  * has not been received yet
+ * @return 1 if the command succeeded, 0 if the handler
+ * called fail_command(), including for any command that it
+ * dispatched in turn. Errors signalled through SPICE are
+ * not included, use failed_c() to check for them
  */
-void dispatch(int argc, char **argv, volatile int *is_running);
+int dispatch(int argc, char **argv, volatile int *is_running);
 
 #endif // GATECLI_DISPATCHER_H
@@ -1,5 +1,6 @@
 #include <cspice/SpiceUsr.h>
 #include <stdio.h>
+#include <string.h>
 
 #include "clihandler.h"
 #include "table.h"
@@ -22,6 +23,10 @@ void load_cmd_files(int argc, char **argv) {
 int main(int argc, char **argv) {
     erract_c("SET", 0, "REPORT");
 
+    if (argc > 1 && strcmp(argv[1], "--batch") == 0) {
+        return handle_batch(argc - 2, argv + 2);
+    }
+
     load_cmd_files(argc, argv);
     handle_cli();
 
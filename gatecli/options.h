@@ -11,6 +11,7 @@
         to_key(OBSERVER_LATITUDE)         \
         to_key(OBSERVER_LONGITUDE)        \
         to_key(STAR_TABLE)                \
+        to_key(ABCORR)                    \
         to_key(OPTION_KEY_LENGTH)
 #define ENUM_TO_CONSTANT(ENUM) ENUM,
 
@@ -27,6 +28,12 @@ typedef enum {
  */
 static char *const OBSERVER_BODY_EARTH = "EARTH";
 
+/**
+ * Default aberration correction constant, for the same
+ * reason as OBSERVER_BODY_EARTH.
+ */
+static char *const ABCORR_CN_S = "CN+S";
+
 /**
  * Converts a string value into an option_key enum value.
  *
@@ -1,189 +1,215 @@
 #include <stdlib.h>
 #include <string.h>
+#include <gate/idindex.h>
 
 #include "table.h"
 
-static const int INITIAL_SIZE = 2;
+static const int INITIAL_SIZE = 8;
+
+// Grow once more than 7/8ths of the slots are occupied
+static const int MAX_LOAD_NUM = 7;
+static const int MAX_LOAD_DEN = 8;
 
 gatecli_table gatecli_table_new() {
     gatecli_table tab = {0, 0, NULL};
     return tab;
 }
 
-static int hash_key(const char *key) {
-    // java.lang.String hashCode()
+static uint64_t hash_key(const char *key) {
+    uint64_t h = gate_id_index_hash(key);
+
+    // 0 marks an empty slot
+    return h == 0 ? 1 : h;
+}
+
+static int probe_distance(const gatecli_table *tab, uint64_t hash, int idx) {
+    int mask = tab->capacity - 1;
+    return (idx - (int) (hash & mask)) & mask;
+}
+
+static int find_idx(const gatecli_table *tab, const char *key, uint64_t hash) {
+    if (tab->capacity == 0) {
+        return -1;
+    }
+
+    int mask = tab->capacity - 1;
+    for (int idx = (int) (hash & mask), dist = 0;; idx = (idx + 1) & mask, ++dist) {
+        const gatecli_table_entry *entry = &tab->entries[idx];
 
-    int h = 0;
-    for (int i = 0;; ++i) {
-        char c = key[i];
-        if (c == '\0') {
-            break;
+        // Robin Hood invariant: the key would have displaced
+        // any entry closer to its home slot than we are
+        if (entry->hash == 0 || probe_distance(tab, entry->hash, idx) < dist) {
+            return -1;
         }
 
-        h = 31 * h + c;
+        if (entry->hash == hash && strcmp(entry->key, key) == 0) {
+            return idx;
+        }
     }
-    return h;
 }
 
-static int key_matches(char *key_one, char *key_two) {
-    return strcmp(key_one, key_two) == 0;
+static void insert_entry(gatecli_table *tab, gatecli_table_entry entry) {
+    int mask = tab->capacity - 1;
+    int idx = (int) (entry.hash & mask);
+    int dist = 0;
+    while (1) {
+        gatecli_table_entry *slot = &tab->entries[idx];
+        if (slot->hash == 0) {
+            *slot = entry;
+            return;
+        }
+
+        int slot_dist = probe_distance(tab, slot->hash, idx);
+        if (slot_dist < dist) {
+            gatecli_table_entry displaced = *slot;
+            *slot = entry;
+            entry = displaced;
+            dist = slot_dist;
+        }
+
+        idx = (idx + 1) & mask;
+        dist++;
+    }
 }
 
-static gatecli_table_entry *gatecli_table_entry_new(char *key, void *value) {
-    gatecli_table_entry *entry = malloc(sizeof(*entry));
-    if (entry == NULL) {
+static void resize(gatecli_table *tab, int new_capacity) {
+    gatecli_table_entry *old_entries = tab->entries;
+    int old_capacity = tab->capacity;
+
+    gatecli_table_entry *new_entries = calloc(new_capacity, sizeof(*new_entries));
+    if (new_entries == NULL) {
         exit(1);
     }
 
-    entry->key = key;
-    entry->value = value;
-    entry->next = NULL;
+    tab->capacity = new_capacity;
+    tab->entries = new_entries;
 
-    return entry;
-}
+    // Entries are moved as-is, keys are not copied again
+    for (int i = 0; i < old_capacity; ++i) {
+        if (old_entries[i].hash != 0) {
+            insert_entry(tab, old_entries[i]);
+        }
+    }
 
-static void *insert(gatecli_table *tab, char *key, void *value) {
-    int hash = hash_key(key);
-    int idx = hash % tab->buckets_len;
-    gatecli_table_entry *head = tab->buckets[idx];
+    free(old_entries);
+}
 
-    // Null bucket head: Start a new bucket here
-    if (head == NULL) {
-        gatecli_table_entry *entry = gatecli_table_entry_new(key, value);
-        tab->buckets[idx] = entry;
-        tab->size++;
+void gatecli_table_reserve(gatecli_table *tab, int count) {
+    int new_capacity = tab->capacity == 0 ? INITIAL_SIZE : tab->capacity;
+    while ((long) count * MAX_LOAD_DEN > (long) new_capacity * MAX_LOAD_NUM) {
+        new_capacity *= 2;
+    }
 
-        return NULL;
+    if (new_capacity != tab->capacity) {
+        resize(tab, new_capacity);
     }
+}
 
-    // Non-null bucket head: link to first matching key
-    // else link to the last non-null node
-    gatecli_table_entry *prev_node;
-    gatecli_table_entry *node = head;
-    do {
-        if (key_matches(node->key, key)) {
-            void *old_value = node->value;
-            node->value = value;
+void *gatecli_table_put(gatecli_table *tab, const char *key, void *value) {
+    uint64_t hash = hash_key(key);
+    int idx = find_idx(tab, key, hash);
+    if (idx != -1) {
+        void *old_value = tab->entries[idx].value;
+        tab->entries[idx].value = value;
 
-            return old_value;
-        }
+        return old_value;
+    }
 
-        prev_node = node;
-        node = node->next;
-    } while (node != NULL);
+    gatecli_table_reserve(tab, tab->size + 1);
 
-    gatecli_table_entry *entry = gatecli_table_entry_new(key, value);
-    prev_node->next = entry;
+    char *key_copy = strdup(key);
+    if (key_copy == NULL) {
+        exit(1);
+    }
+
+    gatecli_table_entry entry = {hash, key_copy, value};
+    insert_entry(tab, entry);
     tab->size++;
 
     return NULL;
 }
 
-static void ensure_size(gatecli_table *tab, int required) {
-    int old_len = tab->buckets_len;
-    if (old_len < required) {
-        int new_len;
-        if (old_len == 0) {
-            new_len = INITIAL_SIZE;
-        } else {
-            new_len = old_len * 2;
-        }
-
-        gatecli_table_entry **old_buckets = tab->buckets;
-        gatecli_table_entry **new_buckets = calloc(new_len, sizeof(**new_buckets));
-        if (new_buckets == NULL) {
-            exit(1);
-        }
+void gatecli_table_put_all(gatecli_table *tab, int count, char *const *keys, void *const *values,
+                           void **replaced) {
+    gatecli_table_reserve(tab, tab->size + count);
 
-        tab->size = 0;
-        tab->buckets_len = new_len;
-        tab->buckets = new_buckets;
-
-        // Go through each bucket and relink all of the entries
-        // in each bucket to their new position
-        for (int i = 0; i < old_len; ++i) {
-            for (gatecli_table_entry *node = old_buckets[i];
-                 node != NULL;
-                 node = node->next) {
-                insert(tab, node->key, node->value);
-            }
+    for (int i = 0; i < count; ++i) {
+        void *old_value = gatecli_table_put(tab, keys[i], values[i]);
+        if (replaced != NULL) {
+            replaced[i] = old_value;
         }
     }
 }
 
-void *gatecli_table_put(gatecli_table *tab, char *key, void *value) {
-    int new_size = tab->size + 1;
-    ensure_size(tab, new_size);
+void *gatecli_table_get(const gatecli_table *tab, const char *key) {
+    int idx = find_idx(tab, key, hash_key(key));
+    if (idx == -1) {
+        return NULL;
+    }
 
-    void *prev_value = insert(tab, key, value);
-    return prev_value;
+    return tab->entries[idx].value;
 }
 
-void *gatecli_table_get(gatecli_table *tab, char *key) {
-    if (tab->buckets_len == 0) {
+void *gatecli_table_rem(gatecli_table *tab, const char *key) {
+    int idx = find_idx(tab, key, hash_key(key));
+    if (idx == -1) {
         return NULL;
     }
 
-    int hash = hash_key(key);
-    int idx = hash % tab->buckets_len;
-
-    for (gatecli_table_entry *node = tab->buckets[idx];
-         node != NULL;
-         node = node->next) {
-        if (key_matches(node->key, key)) {
-            return node->value;
-        }
+    void *prev_value = tab->entries[idx].value;
+    free(tab->entries[idx].key);
+    tab->size--;
+
+    // Backward shift deletion: pull the following entries
+    // of the probe sequence one slot closer to home
+    int mask = tab->capacity - 1;
+    int next = (idx + 1) & mask;
+    while (tab->entries[next].hash != 0 && probe_distance(tab, tab->entries[next].hash, next) > 0) {
+        tab->entries[idx] = tab->entries[next];
+        idx = next;
+        next = (next + 1) & mask;
     }
 
-    return NULL;
-}
+    gatecli_table_entry empty = {0, NULL, NULL};
+    tab->entries[idx] = empty;
 
-void *gatecli_table_rem(gatecli_table *tab, char *key) {
-    if (tab->buckets_len == 0) {
-        return NULL;
-    }
+    return prev_value;
+}
 
-    int hash = hash_key(key);
-    int idx = hash % tab->buckets_len;
-
-    for (gatecli_table_entry *prev_node = NULL, *node = tab->buckets[idx];
-         node != NULL;
-         prev_node = node, node = node->next) {
-        if (key_matches(node->key, key)) {
-            if (prev_node == NULL) {
-                // Bucket head removed, shift next node into head
-                tab->buckets[idx] = node->next;
-            } else {
-                // Middle of bucket is removed, orphan current node
-                prev_node->next = node->next;
+void gatecli_table_free(gatecli_table *tab, void (*free_value)(void *)) {
+    for (int i = 0; i < tab->capacity; ++i) {
+        gatecli_table_entry *entry = &tab->entries[i];
+        if (entry->hash != 0) {
+            free(entry->key);
+            if (free_value != NULL) {
+                free_value(entry->value);
             }
-            
-            void *prev_value = node->value;
-            tab->size--;
-
-            free(node->key);
-            free(node);
-            return prev_value;
         }
     }
+    free(tab->entries);
 
-    return NULL;
+    tab->size = 0;
+    tab->capacity = 0;
+    tab->entries = NULL;
 }
 
-void gatecli_table_free(gatecli_table *tab) {
-    gatecli_table_entry **entries = tab->buckets;
-    for (int i = 0; i < tab->buckets_len; ++i) {
-        for (gatecli_table_entry *entry = entries[i];
-             entry != NULL;
-                ) {
-            gatecli_table_entry *cur_entry = entry;
-            entry = entry->next;
-            free(cur_entry);
+gatecli_table_iter gatecli_table_iter_new(const gatecli_table *tab) {
+    gatecli_table_iter iter = {tab, -1, NULL, NULL};
+    return iter;
+}
+
+int gatecli_table_iter_next(gatecli_table_iter *iter) {
+    const gatecli_table *tab = iter->tab;
+    for (iter->idx++; iter->idx < tab->capacity; iter->idx++) {
+        const gatecli_table_entry *entry = &tab->entries[iter->idx];
+        if (entry->hash != 0) {
+            iter->key = entry->key;
+            iter->value = entry->value;
+            return 1;
         }
     }
-    free(entries);
 
-    tab->size = 0;
-    tab->buckets_len = 0;
-    tab->buckets = NULL;
+    iter->key = NULL;
+    iter->value = NULL;
+    return 0;
 }
@@ -4,31 +4,41 @@
  * keys to values. String keys mapping to pointer values
  * are supported, which allows quick access to values given
  * a key.
+ *
+ * The hashtable uses open addressing with Robin Hood
+ * probing: entries live inline in a single array and
+ * cache the full 64-bit hash of their key, so lookups
+ * only compare strings when the hashes already match and
+ * probe sequences stay short even at high load factors.
+ *
+ * The table owns its keys, which are copied on insertion
+ * and freed on removal. Values are owned by the caller.
  */
 
 #ifndef GATE_PARENT_TABLE_H
 #define GATE_PARENT_TABLE_H
 
-typedef struct gatecli_table_entry gatecli_table_entry;
+#include <stdint.h>
 
 /**
  * Represents a key-value pair contained in a hashtable's
  * entries data.
  */
-struct gatecli_table_entry {
+typedef struct {
+    /**
+     * The cached hash of the key, or 0 if this slot is
+     * empty.
+     */
+    uint64_t hash;
     /**
-     * The string key.
+     * The string key, owned by the hashtable.
      */
     char *key;
     /**
      * The value mapped to the key.
      */
     void *value;
-    /**
-     * The next entry in the bucket
-     */
-    gatecli_table_entry *next;
-};
+} gatecli_table_entry;
 
 /**
  * Represents a hashtable mapping string keys to void *
@@ -41,16 +51,36 @@ typedef struct {
      */
     int size;
     /**
-     * The number of buckets in this hashtable.
+     * The number of slots in this hashtable, always 0 or a
+     * power of 2.
      */
-    int buckets_len;
+    int capacity;
     /**
-     * The data contained in this hashtable, in the form of
-     * an array of buckets.
+     * The slots of this hashtable.
      */
-    gatecli_table_entry **buckets;
+    gatecli_table_entry *entries;
 } gatecli_table;
 
+/**
+ * Iterates over the mappings of a hashtable in no
+ * particular order.
+ *
+ * The hashtable must not be modified while an iterator
+ * is in use.
+ */
+typedef struct {
+    const gatecli_table *tab;
+    int idx;
+    /**
+     * The key of the current mapping.
+     */
+    const char *key;
+    /**
+     * The value of the current mapping.
+     */
+    void *value;
+} gatecli_table_iter;
+
 /**
  * Creates a new, empty hashtable.
  *
@@ -58,15 +88,38 @@ typedef struct {
  */
 gatecli_table gatecli_table_new();
 
+/**
+ * Ensures that the given hashtable can hold at least the
+ * given number of mappings without needing to grow.
+ *
+ * @param tab the table for which to reserve space
+ * @param count the number of mappings to make room for
+ */
+void gatecli_table_reserve(gatecli_table *tab, int count);
+
 /**
  * Puts a key-value pair into the given hashtable.
  *
  * @param tab the table into which to put the mapping
- * @param key the key
+ * @param key the key, which is copied by the table
  * @param value the value
  * @return the old mapping, or NULL if there was none
  */
-void *gatecli_table_put(gatecli_table *tab, char *key, void *value);
+void *gatecli_table_put(gatecli_table *tab, const char *key, void *value);
+
+/**
+ * Puts many key-value pairs into the given hashtable,
+ * growing it at most once.
+ *
+ * @param tab the table into which to put the mappings
+ * @param count the number of mappings
+ * @param keys the keys, which are copied by the table
+ * @param values the values for each key
+ * @param replaced set to the old mapping of each key, or
+ * NULL if there was none. May be NULL if not desired
+ */
+void gatecli_table_put_all(gatecli_table *tab, int count, char *const *keys, void *const *values,
+                           void **replaced);
 
 /**
  * Gets the value mapped to the given key in the given
@@ -76,7 +129,7 @@ void *gatecli_table_put(gatecli_table *tab, char *key, void *value);
  * @param key the key for which to obtain the value
  * @return the value, or NULL if the key isn't mapped
  */
-void *gatecli_table_get(gatecli_table *tab, char *key);
+void *gatecli_table_get(const gatecli_table *tab, const char *key);
 
 /**
  * Removes a mapping from the given hashtable.
@@ -86,14 +139,34 @@ void *gatecli_table_get(gatecli_table *tab, char *key);
  * @return the value removed, or NULL if nothing was
  * removed
  */
-void *gatecli_table_rem(gatecli_table *tab, char *key);
+void *gatecli_table_rem(gatecli_table *tab, const char *key);
 
 /**
  * Clears and removes all data associated with the given
  * hashtable.
  *
  * @param tab the hashtable to clear
+ * @param free_value called with each value still mapped
+ * in the table, or NULL if values should not be freed
+ */
+void gatecli_table_free(gatecli_table *tab, void (*free_value)(void *));
+
+/**
+ * Creates an iterator positioned before the first mapping
+ * of the given hashtable.
+ *
+ * @param tab the hashtable to iterate over
+ * @return the new iterator
+ */
+gatecli_table_iter gatecli_table_iter_new(const gatecli_table *tab);
+
+/**
+ * Advances the given iterator to the next mapping.
+ *
+ * @param iter the iterator to advance
+ * @return 1 if the iterator now points to a mapping, 0 if
+ * there are no more mappings
  */
-void gatecli_table_free(gatecli_table *tab);
+int gatecli_table_iter_next(gatecli_table_iter *iter);
 
 #endif // GATECLI_TABLE_H
@@ -1,14 +1,40 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include "snm.h"
 
 #define FMT_COLUMN_LEN 13
+#define SCRATCH_INITIAL_LEN 32
 
 static const int utf8_ctl_layout_len = 3;
 static const int utf8_ctl_layout[] = {
         0b11000000, 0b11100000, 0b11110000
 };
 
+/**
+ * Growable string buffer which is reused for every row
+ * parsed so that parsing does not allocate once the
+ * buffers have grown to fit the longest column value.
+ */
+typedef struct {
+    char *data;
+    int cap;
+} scratch_str;
+
+/**
+ * Scratch record reused across each row of the file.
+ */
+typedef struct {
+    scratch_str name;
+    scratch_str fd;
+    scratch_str id;
+    scratch_str id_utf8;
+    scratch_str constellation;
+    scratch_str wds_comp_id;
+    scratch_str wds_j;
+    scratch_str number;
+} scratch_record;
+
 static void intlbuf_append(long *buf, int buf_size, long item) {
     for (int i = 1; i < buf_size; ++i) {
         buf[i - 1] = buf[i];
@@ -20,13 +46,13 @@ static void intlbuf_append(long *buf, int buf_size, long item) {
 static void skip_line(FILE *file) {
     while (1) {
         int c = fgetc(file);
-        if (c == '\n') {
+        if (c == '\n' || c == EOF) {
             break;
         }
     }
 }
 
-static int parse_fmt(int *data_fmt, FILE *file, long fmt_off) {
+static snm_status parse_fmt(int *data_fmt, FILE *file, long fmt_off) {
     long cur = ftell(file);
     fseek(file, fmt_off, SEEK_SET);
 
@@ -39,9 +65,8 @@ static int parse_fmt(int *data_fmt, FILE *file, long fmt_off) {
         }
 
         if (c == '(') {
-            if (fmt_column > FMT_COLUMN_LEN) {
-                printf("More columns than expected (%d), try updating\n", FMT_COLUMN_LEN);
-                return 0;
+            if (fmt_column >= FMT_COLUMN_LEN) {
+                return SNM_ERR_FORMAT;
             }
 
             data_fmt[fmt_column] = column;
@@ -51,115 +76,191 @@ static int parse_fmt(int *data_fmt, FILE *file, long fmt_off) {
         column++;
     }
 
+    if (fmt_column != FMT_COLUMN_LEN) {
+        return SNM_ERR_FORMAT;
+    }
+
     // First column is offset by the preceding # comment symbol
     data_fmt[0] -= 1;
 
     fseek(file, cur, SEEK_SET);
+    return SNM_OK;
+}
+
+static int scratch_reserve(scratch_str *str, int len) {
+    if (str->cap >= len) {
+        return 1;
+    }
+
+    int new_cap = str->cap == 0 ? SCRATCH_INITIAL_LEN : str->cap;
+    while (new_cap < len) {
+        new_cap *= 2;
+    }
+
+    char *new_data = realloc(str->data, new_cap * sizeof(*new_data));
+    if (new_data == NULL) {
+        return 0;
+    }
+
+    str->data = new_data;
+    str->cap = new_cap;
     return 1;
 }
 
-static void read_utf8(FILE *file, int start, int until, char **out, int *len) {
+static void scratch_free(scratch_record *record) {
+    scratch_str *strs[] = {&record->name, &record->fd, &record->id, &record->id_utf8,
+                           &record->constellation, &record->wds_comp_id, &record->wds_j, &record->number};
+    for (int i = 0; i < (int) (sizeof(strs) / sizeof(*strs)); ++i) {
+        free(strs[i]->data);
+        strs[i]->data = NULL;
+        strs[i]->cap = 0;
+    }
+}
+
+static snm_status read_utf8(FILE *file, int start, int until, scratch_str *out, int *len) {
+    // Columns are measured in characters, so each multi-byte
+    // UTF-8 sequence extends the number of bytes to read
     *len = until - start + 1;
-    *out = malloc(*len * sizeof(char));
-    if (*out == NULL) {
-        puts("Failed to allocate string");
-        return;
+    if (!scratch_reserve(out, *len)) {
+        return SNM_ERR_ALLOC;
     }
 
     int trailing = 0;
     for (int i = 0; i < *len - 1; ++i) {
         int c = fgetc(file);
+        if (c == EOF) {
+            *len = i + 1;
+            break;
+        }
+
         if (c == ' ') {
             trailing++;
         } else {
             trailing = 0;
         }
 
-        (*out)[i] = (char) c;
+        out->data[i] = (char) c;
 
+        int additional_bytes = 0;
         for (int ctl_idx = 0; ctl_idx < utf8_ctl_layout_len; ++ctl_idx) {
             int mask = utf8_ctl_layout[ctl_idx];
             if ((c & mask) == mask) {
-                int additional_bytes = ctl_idx + 1;
-                *len += additional_bytes;
-
-                char *new_out = realloc(*out, *len * sizeof(char));
-                if (new_out == NULL) {
-                    puts("Failed to reallocate for extra bytes");
-                    return;
-                }
+                additional_bytes = ctl_idx + 1;
             }
         }
-    }
 
-    if (trailing > 0) {
-        *len -= trailing;
-        char *new_out = realloc(*out, *len * sizeof(char));
-        if (new_out == NULL) {
-            puts("Failed to trim string");
-            return;
+        if (additional_bytes > 0) {
+            *len += additional_bytes;
+            if (!scratch_reserve(out, *len)) {
+                return SNM_ERR_ALLOC;
+            }
         }
-
-        *out = new_out;
     }
 
-    (*out)[*len - 1] = '\0';
+    *len -= trailing;
+    out->data[*len - 1] = '\0';
+
+    return SNM_OK;
 }
 
-static void read_double(FILE *file, int start, int until, double *out) {
-    char *string;
+static snm_status read_double(FILE *file, int start, int until, scratch_str *scratch, double *out) {
     int string_len;
-    read_utf8(file, start, until, &string, &string_len);
+    snm_status status = read_utf8(file, start, until, scratch, &string_len);
+    if (status != SNM_OK) {
+        return status;
+    }
 
     char *end;
-    double result = strtod(string, &end);
-    if (string == end) {
+    double result = strtod(scratch->data, &end);
+    if (scratch->data == end) {
         // This is due to unassigned values
-        // printf("Error decoding double: %s\n", string);
-        free(string);
         *out = 0;
-        return;
+        return SNM_OK;
     }
 
     *out = result;
-    free(string);
+    return SNM_OK;
 }
 
-static void read_int(FILE *file, int start, int until, int *out) {
-    char *string;
+static snm_status read_int(FILE *file, int start, int until, scratch_str *scratch, int *out) {
     int string_len;
-    read_utf8(file, start, until, &string, &string_len);
+    snm_status status = read_utf8(file, start, until, scratch, &string_len);
+    if (status != SNM_OK) {
+        return status;
+    }
 
     char *end;
-    long result = strtol(string, &end, 10);
-    if (string == end) {
+    long result = strtol(scratch->data, &end, 10);
+    if (scratch->data == end) {
         // This is due to unassigned values
-        // printf("Error decoding integer: %s\n", string);
-        free(string);
         *out = 0;
-        return;
+        return SNM_OK;
     }
 
     *out = (int) result;
-    free(string);
+    return SNM_OK;
 }
 
-static void read_date(FILE *file, int start, int until, int *year, int *month, int *day) {
-    char *string;
+static snm_status read_date(FILE *file, int start, int until, scratch_str *scratch,
+                            int *year, int *month, int *day) {
     int string_len;
-    read_utf8(file, start, until, &string, &string_len);
+    snm_status status = read_utf8(file, start, until, scratch, &string_len);
+    if (status != SNM_OK) {
+        return status;
+    }
 
-    sscanf(string, "%d-%d-%d", year, month, day);
+    *year = 0;
+    *month = 0;
+    *day = 0;
+    sscanf(scratch->data, "%d-%d-%d", year, month, day);
 
-    free(string);
+    return SNM_OK;
 }
 
-void snm_parse_data(FILE *file, int *parsed_data_len, csn_data **parsed_data) {
-    long prev_comment_offsets[2];
+static snm_status read_row(FILE *file, const int *data_fmt, scratch_record *scratch, csn_data *csn) {
+    snm_status status;
+    if ((status = read_utf8(file, data_fmt[0], data_fmt[1], &scratch->name, &csn->name_len)) != SNM_OK ||
+        (status = read_utf8(file, data_fmt[1], data_fmt[2], &scratch->fd, &csn->fd_len)) != SNM_OK ||
+        (status = read_utf8(file, data_fmt[2], data_fmt[3], &scratch->id, &csn->id_len)) != SNM_OK ||
+        (status = read_utf8(file, data_fmt[3], data_fmt[4], &scratch->id_utf8, &csn->id_utf8_len)) != SNM_OK ||
+        (status = read_utf8(file, data_fmt[4], data_fmt[5], &scratch->constellation,
+                            &csn->constellation_len)) != SNM_OK ||
+        (status = read_utf8(file, data_fmt[5], data_fmt[6], &scratch->wds_comp_id,
+                            &csn->wds_comp_id_len)) != SNM_OK ||
+        (status = read_utf8(file, data_fmt[6], data_fmt[7], &scratch->wds_j, &csn->wds_j_len)) != SNM_OK ||
+        (status = read_double(file, data_fmt[7], data_fmt[8], &scratch->number,
+                              &csn->visual_magnitude)) != SNM_OK ||
+        (status = read_int(file, data_fmt[8], data_fmt[9], &scratch->number, &csn->hip)) != SNM_OK ||
+        (status = read_int(file, data_fmt[9], data_fmt[10], &scratch->number, &csn->hd)) != SNM_OK ||
+        (status = read_double(file, data_fmt[10], data_fmt[11], &scratch->number, &csn->ra)) != SNM_OK ||
+        (status = read_double(file, data_fmt[11], data_fmt[12], &scratch->number, &csn->dec)) != SNM_OK ||
+        (status = read_date(file, data_fmt[12], data_fmt[12] + 10, &scratch->number,
+                            &csn->date_year, &csn->date_month, &csn->date_day)) != SNM_OK) {
+        return status;
+    }
+
+    // Buffers may have moved while growing, so only point
+    // into them once every column has been read
+    csn->name = scratch->name.data;
+    csn->fd = scratch->fd.data;
+    csn->id = scratch->id.data;
+    csn->id_utf8 = scratch->id_utf8.data;
+    csn->constellation = scratch->constellation.data;
+    csn->wds_comp_id = scratch->wds_comp_id.data;
+    csn->wds_j = scratch->wds_j.data;
+
+    return SNM_OK;
+}
+
+snm_status snm_parse_stream(FILE *file, snm_row_callback callback, void *user_data) {
+    long prev_comment_offsets[2] = {-1, -1};
     int data_fmt[FMT_COLUMN_LEN];
 
     while (1) {
         int c = fgetc(file);
+        if (c == EOF) {
+            return SNM_ERR_FORMAT;
+        }
 
         // Skip comments
         if (c == '#') {
@@ -168,27 +269,33 @@ void snm_parse_data(FILE *file, int *parsed_data_len, csn_data **parsed_data) {
             continue;
         }
 
-        if (!parse_fmt(data_fmt, file, prev_comment_offsets[0])) {
-            return;
-        } else {
-            break;
+        if (prev_comment_offsets[0] == -1) {
+            return SNM_ERR_FORMAT;
+        }
+
+        snm_status status = parse_fmt(data_fmt, file, prev_comment_offsets[0]);
+        if (status != SNM_OK) {
+            return status;
         }
+
+        break;
     }
 
     // Move cursor behind the first line of actual data
     fseek(file, -1, SEEK_CUR);
 
-    *parsed_data_len = 0;
+    scratch_record scratch = {0};
+    snm_status status = SNM_OK;
     while (1) {
         int c = fgetc(file);
 
         // Bottom comment block starts again
-        if (c == '#') {
-            return;
+        if (c == '#' || c == EOF) {
+            break;
         }
 
         // End of line artifacts
-        if (c == ' ' || c == '\n') {
+        if (c == ' ' || c == '\n' || c == '\r') {
             continue;
         }
 
@@ -196,28 +303,111 @@ void snm_parse_data(FILE *file, int *parsed_data_len, csn_data **parsed_data) {
         fseek(file, -1, SEEK_CUR);
 
         csn_data csn;
-        read_utf8(file, data_fmt[0], data_fmt[1], &csn.name, &csn.name_len);
-        read_utf8(file, data_fmt[1], data_fmt[2], &csn.fd, &csn.fd_len);
-        read_utf8(file, data_fmt[2], data_fmt[3], &csn.id, &csn.id_len);
-        read_utf8(file, data_fmt[3], data_fmt[4], &csn.id_utf8, &csn.id_utf8_len);
-        read_utf8(file, data_fmt[4], data_fmt[5], &csn.constellation, &csn.constellation_len);
-        read_utf8(file, data_fmt[5], data_fmt[6], &csn.wds_comp_id, &csn.wds_comp_id_len);
-        read_utf8(file, data_fmt[6], data_fmt[7], &csn.wds_j, &csn.wds_j_len);
-        read_double(file, data_fmt[7], data_fmt[8], &csn.visual_magnitude);
-        read_int(file, data_fmt[8], data_fmt[9], &csn.hip);
-        read_int(file, data_fmt[9], data_fmt[10], &csn.hd);
-        read_double(file, data_fmt[10], data_fmt[11], &csn.ra);
-        read_double(file, data_fmt[11], data_fmt[12], &csn.dec);
-        read_date(file, data_fmt[12], data_fmt[12] + 10, &csn.date_year, &csn.date_month, &csn.date_day);
-
-        csn_data *new_parsed_data = realloc(*parsed_data, (*parsed_data_len + 1) * sizeof(*new_parsed_data));
+        status = read_row(file, data_fmt, &scratch, &csn);
+        if (status != SNM_OK) {
+            break;
+        }
+
+        if (!callback(&csn, user_data)) {
+            status = SNM_STOPPED;
+            break;
+        }
+    }
+
+    scratch_free(&scratch);
+    return status;
+}
+
+static char *copy_column(const char *column, int len) {
+    char *copy = malloc(len * sizeof(*copy));
+    if (copy != NULL) {
+        memcpy(copy, column, len * sizeof(*copy));
+    }
+
+    return copy;
+}
+
+typedef struct {
+    int *parsed_data_len;
+    csn_data **parsed_data;
+    int parsed_data_cap;
+    snm_status status;
+} collect_state;
+
+static int collect_row(const csn_data *row, void *user_data) {
+    collect_state *state = user_data;
+    int len = *state->parsed_data_len;
+
+    if (len == state->parsed_data_cap) {
+        int new_cap = state->parsed_data_cap == 0 ? SCRATCH_INITIAL_LEN : state->parsed_data_cap * 2;
+        csn_data *new_parsed_data = realloc(*state->parsed_data, new_cap * sizeof(*new_parsed_data));
         if (new_parsed_data == NULL) {
-            puts("Failed to reallocate extra memory for CSN data");
-            return;
+            state->status = SNM_ERR_ALLOC;
+            return 0;
         }
 
-        *parsed_data = new_parsed_data;
-        (*parsed_data)[*parsed_data_len] = csn;
-        (*parsed_data_len)++;
+        *state->parsed_data = new_parsed_data;
+        state->parsed_data_cap = new_cap;
+    }
+
+    csn_data csn = *row;
+    csn.name = copy_column(row->name, row->name_len);
+    csn.fd = copy_column(row->fd, row->fd_len);
+    csn.id = copy_column(row->id, row->id_len);
+    csn.id_utf8 = copy_column(row->id_utf8, row->id_utf8_len);
+    csn.constellation = copy_column(row->constellation, row->constellation_len);
+    csn.wds_comp_id = copy_column(row->wds_comp_id, row->wds_comp_id_len);
+    csn.wds_j = copy_column(row->wds_j, row->wds_j_len);
+    if (csn.name == NULL || csn.fd == NULL || csn.id == NULL || csn.id_utf8 == NULL ||
+        csn.constellation == NULL || csn.wds_comp_id == NULL || csn.wds_j == NULL) {
+        snm_free_data(1, &csn);
+        state->status = SNM_ERR_ALLOC;
+        return 0;
+    }
+
+    (*state->parsed_data)[len] = csn;
+    (*state->parsed_data_len)++;
+
+    return 1;
+}
+
+snm_status snm_parse_data(FILE *file, int *parsed_data_len, csn_data **parsed_data) {
+    *parsed_data_len = 0;
+    *parsed_data = NULL;
+
+    collect_state state = {parsed_data_len, parsed_data, 0, SNM_OK};
+    snm_status status = snm_parse_stream(file, collect_row, &state);
+    if (state.status != SNM_OK) {
+        return state.status;
+    }
+
+    return status;
+}
+
+void snm_free_data(int parsed_data_len, csn_data *parsed_data) {
+    for (int i = 0; i < parsed_data_len; ++i) {
+        csn_data *csn = &parsed_data[i];
+        free(csn->name);
+        free(csn->fd);
+        free(csn->id);
+        free(csn->id_utf8);
+        free(csn->constellation);
+        free(csn->wds_comp_id);
+        free(csn->wds_j);
+    }
+}
+
+const char *snm_status_string(snm_status status) {
+    switch (status) {
+        case SNM_OK:
+            return "OK";
+        case SNM_STOPPED:
+            return "Parsing stopped by callback";
+        case SNM_ERR_FORMAT:
+            return "Unrecognized CSN column format, try updating";
+        case SNM_ERR_ALLOC:
+            return "Failed to allocate memory for CSN data";
+        default:
+            return "Unknown status";
     }
 }
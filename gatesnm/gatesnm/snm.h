@@ -57,17 +57,99 @@ typedef struct {
     int date_day;
 } csn_data;
 
+/**
+ * Status codes returned by the parsing procedures.
+ */
+typedef enum {
+    SNM_OK = 0,
+    /**
+     * The row callback asked for parsing to stop before
+     * the end of the file was reached.
+     */
+    SNM_STOPPED,
+    /**
+     * The column format header could not be found or has
+     * a different number of columns than expected.
+     */
+    SNM_ERR_FORMAT,
+    SNM_ERR_ALLOC
+} snm_status;
+
+/**
+ * Callback invoked once for each row parsed by
+ * snm_parse_stream().
+ *
+ * The row and the strings it points to are owned by the
+ * parser and are overwritten by the next row, so anything
+ * that needs to outlive the callback must be copied.
+ *
+ * @param row the parsed row (input)
+ * @param user_data the pointer passed to
+ * snm_parse_stream() (input)
+ * @return nonzero to continue parsing, 0 to stop
+ */
+typedef int (*snm_row_callback)(const csn_data *row, void *user_data);
+
+/**
+ * Parses the IAU-CSN.txt file one row at a time, handing
+ * each row to the given callback as soon as it is read.
+ *
+ * A single scratch record is reused for every row, so the
+ * memory used stays constant regardless of the size of the
+ * file. This allows callers to filter, index or forward
+ * rows without materializing the whole catalog.
+ *
+ * @param file the file which to parse the data from
+ * (input)
+ * @param callback the procedure to invoke for each row
+ * (input)
+ * @param user_data an arbitrary pointer passed to each
+ * invocation of the callback, or NULL (input)
+ * @return SNM_OK if the whole file was parsed, otherwise
+ * the reason parsing stopped
+ */
+snm_status snm_parse_stream(FILE *file, snm_row_callback callback, void *user_data);
+
 /**
  * Parses the IAU-CSN.txt file into an array of
  * {@code csn_data}.
  *
+ * This is a convenience wrapper around snm_parse_stream()
+ * which copies every row. The strings in each row are
+ * owned by the caller and can be released with
+ * snm_free_data().
+ *
  * @param file the file which to parse the data from
  * (input)
  * @param parsed_data_len the length of the
  * {@code parsed_data} array (output)
  * @param parsed_data the array populated with the
- * parsed star data (output)
+ * parsed star data, which should be passed to free() once
+ * it is no longer needed (output)
+ * @return SNM_OK if the whole file was parsed, otherwise
+ * the reason parsing stopped. Rows parsed before an error
+ * are still returned
+ */
+snm_status snm_parse_data(FILE *file, int *parsed_data_len, csn_data **parsed_data);
+
+/**
+ * Frees the strings held by each row in an array
+ * produced by snm_parse_data().
+ *
+ * The array itself is not freed.
+ *
+ * @param parsed_data_len the length of the
+ * {@code parsed_data} array (input)
+ * @param parsed_data the rows to free (input)
+ */
+void snm_free_data(int parsed_data_len, csn_data *parsed_data);
+
+/**
+ * Obtains a human readable description of a status code.
+ *
+ * @param status the status code (input)
+ * @return a static string describing the status
  */
-void snm_parse_data(FILE *file, int *parsed_data_len, csn_data **parsed_data);
+const char *snm_status_string(snm_status status);
 
 #endif // GATESNM_SNM_H